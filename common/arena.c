@@ -0,0 +1,243 @@
+#define _GNU_SOURCE
+#include "arena.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+#define HUGE_PAGE (2UL * 1024 * 1024)
+#define ARENA_ALIGN 64
+
+static double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void ArenaOptionsFromEnv(struct ArenaOptions *opts) {
+  opts->pages = ARENA_PAGES_AUTO;
+  opts->prefault = ARENA_PREFAULT_TOUCH;
+  opts->threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+  const char *pages = getenv("ARENA_PAGES");
+  if (pages != NULL) {
+    if (strcmp(pages, "hugetlb") == 0) opts->pages = ARENA_PAGES_HUGETLB;
+    else if (strcmp(pages, "thp") == 0) opts->pages = ARENA_PAGES_THP;
+    else if (strcmp(pages, "normal") == 0) opts->pages = ARENA_PAGES_NORMAL;
+  }
+  const char *prefault = getenv("ARENA_PREFAULT");
+  if (prefault != NULL) {
+    if (strcmp(prefault, "populate") == 0)
+      opts->prefault = ARENA_PREFAULT_POPULATE;
+    else if (strcmp(prefault, "none") == 0)
+      opts->prefault = ARENA_PREFAULT_NONE;
+  }
+  const char *threads = getenv("ARENA_THREADS");
+  if (threads != NULL && atoi(threads) > 0) opts->threads = atoi(threads);
+  if (opts->threads <= 0) opts->threads = 1;
+}
+
+const char *ArenaPagesName(enum ArenaPages kind) {
+  switch (kind) {
+    case ARENA_PAGES_HUGETLB: return "hugetlb 2M";
+    case ARENA_PAGES_THP: return "thp";
+    case ARENA_PAGES_NORMAL: return "4K";
+    default: return "auto";
+  }
+}
+
+static void *MapHugetlb(size_t size) {
+  void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  return p == MAP_FAILED ? NULL : p;
+}
+
+// Отображает size байт, выровненных по 2 МиБ, чтобы THP мог покрыть всё.
+static void *MapAligned(size_t size) {
+  size_t span = size + HUGE_PAGE;
+  char *p = mmap(NULL, span, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) return NULL;
+  uintptr_t start = ((uintptr_t)p + HUGE_PAGE - 1) & ~(uintptr_t)(HUGE_PAGE - 1);
+  size_t head = start - (uintptr_t)p;
+  if (head > 0) munmap(p, head);
+  size_t tail = span - head - size;
+  if (tail > 0) munmap((char *)start + size, tail);
+  return (void *)start;
+}
+
+struct TouchArgs {
+  char *begin;
+  char *end;
+  size_t step;
+};
+
+static void *TouchRange(void *arg) {
+  struct TouchArgs *t = arg;
+  for (volatile char *p = t->begin; p < t->end; p += t->step) *p = 0;
+  return NULL;
+}
+
+// Каждый поток касается своей части, страницы отображаются параллельно.
+static void ParallelTouch(char *base, size_t size, size_t step, int threads) {
+  size_t pages = (size + step - 1) / step;
+  if ((size_t)threads > pages) threads = pages > 0 ? (int)pages : 1;
+  pthread_t *tids = malloc(sizeof(pthread_t) * threads);
+  struct TouchArgs *args = malloc(sizeof(struct TouchArgs) * threads);
+  if (tids == NULL || args == NULL) {
+    struct TouchArgs all = {base, base + size, step};
+    TouchRange(&all);
+    free(tids);
+    free(args);
+    return;
+  }
+
+  size_t per = pages / threads;
+  size_t rem = pages % threads;
+  size_t page = 0;
+  int started = 0;
+  for (int i = 0; i < threads; i++) {
+    size_t count = per + ((size_t)i < rem ? 1 : 0);
+    args[i].begin = base + page * step;
+    args[i].end = base + (page + count) * step;
+    if (args[i].end > base + size) args[i].end = base + size;
+    args[i].step = step;
+    page += count;
+    if (pthread_create(&tids[i], NULL, TouchRange, &args[i]) != 0) {
+      TouchRange(&args[i]);
+      continue;
+    }
+    tids[started++] = tids[i];
+  }
+  for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+  free(tids);
+  free(args);
+}
+
+// Сколько байт отображения с адресом base покрыто огромными страницами
+// THP (AnonHugePages из /proc/self/smaps). -1 - smaps недоступен.
+static long long AnonHugeBytes(const void *base) {
+  FILE *f = fopen("/proc/self/smaps", "r");
+  if (f == NULL) return -1;
+  char line[512];
+  int inside = 0;
+  long long bytes = -1;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    unsigned long lo, hi;
+    if (sscanf(line, "%lx-%lx ", &lo, &hi) == 2) {  // заголовок отображения
+      inside = (uintptr_t)base >= lo && (uintptr_t)base < hi;
+      continue;
+    }
+    long long kb;
+    if (inside && sscanf(line, "AnonHugePages: %lld kB", &kb) == 1) {
+      bytes = kb * 1024;
+      break;
+    }
+  }
+  fclose(f);
+  return bytes;
+}
+
+int ArenaInit(struct Arena *arena, size_t capacity,
+              const struct ArenaOptions *opts) {
+  memset(arena, 0, sizeof(*arena));
+  if (capacity == 0) capacity = 1;
+
+  double start = Now();
+  size_t huge_size = (capacity + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+  void *p = NULL;
+
+  if (opts->pages == ARENA_PAGES_AUTO || opts->pages == ARENA_PAGES_HUGETLB) {
+    p = MapHugetlb(huge_size);
+    if (p != NULL) {
+      arena->kind = ARENA_PAGES_HUGETLB;
+      arena->size = huge_size;
+    } else if (opts->pages == ARENA_PAGES_HUGETLB) {
+      fprintf(stderr, "arena: MAP_HUGETLB failed (%s), falling back to THP\n",
+              strerror(errno));
+    }
+  }
+  if (p == NULL && opts->pages != ARENA_PAGES_NORMAL) {
+    p = MapAligned(huge_size);
+    if (p != NULL) {
+      arena->size = huge_size;
+      arena->kind = madvise(p, huge_size, MADV_HUGEPAGE) == 0
+                        ? ARENA_PAGES_THP
+                        : ARENA_PAGES_NORMAL;
+    }
+  }
+  if (p == NULL) {
+    p = mmap(NULL, capacity, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return -1;
+    arena->size = capacity;
+    arena->kind = ARENA_PAGES_NORMAL;
+  }
+  arena->base = p;
+  arena->alloc_seconds = Now() - start;
+
+  start = Now();
+  size_t step = arena->kind == ARENA_PAGES_NORMAL
+                    ? (size_t)sysconf(_SC_PAGESIZE)
+                    : HUGE_PAGE;
+  switch (opts->prefault) {
+    case ARENA_PREFAULT_POPULATE:
+      // ядра до 5.14 не знают MADV_POPULATE_WRITE - касаемся сами
+      if (madvise(arena->base, arena->size, MADV_POPULATE_WRITE) != 0)
+        ParallelTouch(arena->base, arena->size, step, 1);
+      break;
+    case ARENA_PREFAULT_TOUCH:
+      ParallelTouch(arena->base, arena->size, step, opts->threads);
+      break;
+    case ARENA_PREFAULT_NONE:
+      break;
+  }
+  if (arena->kind == ARENA_PAGES_THP && opts->prefault != ARENA_PREFAULT_NONE) {
+    // madvise(MADV_HUGEPAGE) проходит и при THP "never" или без свободных
+    // 2 МиБ: тогда касание раз в 2 МиБ отобразило по одной 4 КиБ странице,
+    // и остальные fault'ы достались бы свёртке. Проверяем по smaps и
+    // досчитываем все страницы.
+    long long huge = AnonHugeBytes(arena->base);
+    if (huge < (long long)arena->size) {
+      ParallelTouch(arena->base, arena->size, (size_t)sysconf(_SC_PAGESIZE),
+                    opts->threads);
+      if (huge <= 0) arena->kind = ARENA_PAGES_NORMAL;
+    }
+  }
+  arena->fault_seconds = Now() - start;
+  return 0;
+}
+
+void *ArenaAlloc(struct Arena *arena, size_t bytes) {
+  size_t offset = (arena->used + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+  if (offset > arena->size || bytes > arena->size - offset) return NULL;
+  arena->used = offset + bytes;
+  return arena->base + offset;
+}
+
+void ArenaDestroy(struct Arena *arena) {
+  if (arena->base != NULL) munmap(arena->base, arena->size);
+  arena->base = NULL;
+  arena->size = arena->used = 0;
+}
+
+void ArenaReportTimes(const struct Arena *arena, double reduce_seconds) {
+  ArenaReportPhase(arena, "reduce", reduce_seconds);
+}
+
+void ArenaReportPhase(const struct Arena *arena, const char *phase,
+                      double seconds) {
+  fprintf(stderr, "[arena %s] alloc: %.6f s, fault: %.6f s, %s: %.6f s\n",
+          ArenaPagesName(arena->kind), arena->alloc_seconds,
+          arena->fault_seconds, phase, seconds);
+}
@@ -0,0 +1,60 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Арена для больших массивов бенчмарков на огромных страницах.
+// Порядок попыток: MAP_HUGETLB (2 МиБ из пула hugetlbfs) -> прозрачные
+// огромные страницы (THP, madvise) -> обычные 4 КиБ страницы.
+// Страницы можно заранее отобразить (MADV_POPULATE_WRITE или параллельным
+// касанием), чтобы page fault'ы не попадали во время генерации и свёртки.
+// Получились ли огромные страницы THP, проверяется по /proc/self/smaps:
+// если нет, касание идёт по каждой 4 КиБ странице.
+//
+// Режимы задаются переменными окружения, чтобы не менять интерфейс программ:
+//   ARENA_PAGES    = auto | hugetlb | thp | normal     (по умолчанию auto)
+//   ARENA_PREFAULT = touch | populate | none           (по умолчанию touch)
+//   ARENA_THREADS  = число потоков для touch           (по умолчанию все ядра)
+
+enum ArenaPages { ARENA_PAGES_AUTO, ARENA_PAGES_HUGETLB, ARENA_PAGES_THP,
+                  ARENA_PAGES_NORMAL };
+enum ArenaPrefault { ARENA_PREFAULT_TOUCH, ARENA_PREFAULT_POPULATE,
+                     ARENA_PREFAULT_NONE };
+
+struct ArenaOptions {
+  enum ArenaPages pages;
+  enum ArenaPrefault prefault;
+  int threads;
+};
+
+struct Arena {
+  char *base;
+  size_t size;      // отображённый размер
+  size_t used;
+  enum ArenaPages kind;  // что в итоге получилось
+  double alloc_seconds;
+  double fault_seconds;
+};
+
+void ArenaOptionsFromEnv(struct ArenaOptions *opts);
+
+// Отображает capacity байт и при необходимости заранее их касается.
+// 0 - успех, -1 - не удалось даже с обычными страницами.
+int ArenaInit(struct Arena *arena, size_t capacity,
+              const struct ArenaOptions *opts);
+
+// Выделение из арены, выравнивание по 64 байта. NULL, если места нет.
+void *ArenaAlloc(struct Arena *arena, size_t bytes);
+
+void ArenaDestroy(struct Arena *arena);
+
+const char *ArenaPagesName(enum ArenaPages kind);
+
+// Печатает в stderr раздельно: выделение, page fault'ы и свёртку.
+void ArenaReportTimes(const struct Arena *arena, double reduce_seconds);
+// То же, но последняя фаза подписана phase (например, когда чтение и
+// свёртка идут конвейером и отдельного времени свёртки нет).
+void ArenaReportPhase(const struct Arena *arena, const char *phase,
+                      double seconds);
+
+#endif
@@ -0,0 +1,636 @@
+#define _GNU_SOURCE
+#include "async_log.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#define LOG_CACHE_LINE 64
+#define LOG_IDLE_NS 200000  // пустые кольца - поток записи спит 0.2 мс
+#define LOG_ALIGN 8
+#define LOG_PAD_LEVEL 0xff  // заглушка до конца кольца перед переходом в начало
+#define LOG_MIN_RING 4096
+
+// Запись в кольце: заголовок, nargs * struct LogArg, затем байты строк.
+struct LogRecord {
+  uint32_t size;  // вся запись, кратно LOG_ALIGN
+  uint8_t level;
+  uint8_t nargs;
+  uint16_t reserved;
+  uint64_t time_ns;
+  const char *fmt;
+};
+
+// Кольцо одного потока. head двигает только владелец, tail - только
+// поток записи; каждый держит копию чужого счётчика, чтобы не ходить
+// за кэш-линией соседа на каждой записи.
+struct LogRing {
+  _Alignas(LOG_CACHE_LINE) atomic_uint_fast64_t head;
+  uint64_t cached_tail;
+  atomic_uint_fast64_t dropped;  // пишет только владелец
+  _Alignas(LOG_CACHE_LINE) atomic_uint_fast64_t tail;
+  _Alignas(LOG_CACHE_LINE) char *buf;
+  size_t size;
+  int id;
+  atomic_int in_use;
+  struct LogRing *next;
+};
+
+// Кольца не освобождаются: поток, завершаясь, отдаёт своё следующему.
+static _Atomic(struct LogRing *) g_rings;
+static atomic_int g_ring_count;
+static _Thread_local struct LogRing *t_ring;
+static pthread_key_t g_ring_key;
+static pthread_once_t g_ring_once = PTHREAD_ONCE_INIT;
+
+atomic_int async_log_level = LOG_LEVEL_INFO;
+
+static struct {
+  struct AsyncLogOptions opts;
+  pthread_t writer;
+  atomic_int running;
+  atomic_uint flush_requested;  // AsyncLogFlush просит сбросить буфер stdio
+  atomic_uint flush_done;
+  uint64_t dropped_reported;
+  uint64_t dropped_report_ns;
+} g_log;
+
+static const char *const kLevelNames[] = {"TRACE", "DEBUG", "INFO",
+                                          "WARN",  "ERROR", "OFF"};
+
+int ParseLogLevel(const char *name, int *level) {
+  for (int i = LOG_LEVEL_TRACE; i <= LOG_LEVEL_OFF; i++) {
+    if (strcasecmp(name, kLevelNames[i]) == 0) {
+      *level = i;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+void AsyncLogSetLevel(int level) {
+  atomic_store_explicit(&async_log_level, level, memory_order_relaxed);
+}
+
+void AsyncLogDefaultOptions(struct AsyncLogOptions *opts) {
+  opts->out = stdout;
+  opts->ring_bytes = 64 * 1024;
+  opts->level = LOG_LEVEL_INFO;
+  opts->flags = 0;
+  const char *env = getenv("ASYNC_LOG_LEVEL");
+  if (env != NULL && ParseLogLevel(env, &opts->level) != 0)
+    fprintf(stderr, "ASYNC_LOG_LEVEL=%s is not a log level\n", env);
+}
+
+static uint64_t NowNs(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Форматирование. Строка собирается в буфере и выводится одним fwrite.
+
+struct LineBuf {
+  char *data;
+  size_t len;
+  size_t cap;
+  char local[512];
+};
+
+static void BufInit(struct LineBuf *b) {
+  b->data = b->local;
+  b->len = 0;
+  b->cap = sizeof(b->local);
+}
+
+static void BufFree(struct LineBuf *b) {
+  if (b->data != b->local) free(b->data);
+}
+
+// Гарантирует место ещё под n байт (и '\0'); при нехватке памяти - 0.
+static int BufReserve(struct LineBuf *b, size_t n) {
+  if (b->len + n + 1 <= b->cap) return 1;
+  size_t cap = b->cap * 2;
+  while (cap < b->len + n + 1) cap *= 2;
+  char *data = b->data == b->local ? malloc(cap) : realloc(b->data, cap);
+  if (data == NULL) return 0;
+  if (b->data == b->local) memcpy(data, b->local, b->len);
+  b->data = data;
+  b->cap = cap;
+  return 1;
+}
+
+static void BufAppend(struct LineBuf *b, const char *s, size_t n) {
+  if (!BufReserve(b, n)) return;
+  memcpy(b->data + b->len, s, n);
+  b->len += n;
+}
+
+static void BufPrintf(struct LineBuf *b, const char *spec, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void BufPrintf(struct LineBuf *b, const char *spec, ...) {
+  va_list ap;
+  va_start(ap, spec);
+  int n = vsnprintf(b->data + b->len, b->cap - b->len, spec, ap);
+  va_end(ap);
+  if (n < 0) return;
+  if (b->len + (size_t)n >= b->cap) {
+    if (!BufReserve(b, (size_t)n)) return;
+    va_start(ap, spec);
+    vsnprintf(b->data + b->len, b->cap - b->len, spec, ap);
+    va_end(ap);
+  }
+  b->len += (size_t)n;
+}
+
+// Без флагов и ширины целые печатаются вручную: это самый частый случай,
+// и он в разы дешевле vsnprintf.
+static void BufUnsigned(struct LineBuf *b, unsigned long long v, int base,
+                        int negative) {
+  char tmp[24];
+  char *p = tmp + sizeof(tmp);
+  do {
+    *--p = "0123456789abcdef"[v % (unsigned)base];
+    v /= (unsigned)base;
+  } while (v != 0);
+  if (negative) *--p = '-';
+  BufAppend(b, p, (size_t)(tmp + sizeof(tmp) - p));
+}
+
+// Один спецификатор %...: флаги, ширина, точность, длина, преобразование.
+// Тип аргумента приводится по модификатору длины, как его привёл бы сам
+// printf.
+static const char *FormatSpec(struct LineBuf *b, const char *p,
+                              const struct LogArg *args, int nargs, int *next) {
+  char spec[48];
+  size_t n = 0;
+  spec[n++] = '%';
+  p++;
+  while (*p != '\0' && strchr("-+ #0'", *p) != NULL && n < 8) spec[n++] = *p++;
+  for (int part = 0; part < 2; part++) {
+    if (part == 1) {
+      if (*p != '.') break;
+      spec[n++] = *p++;
+    }
+    if (*p == '*') {
+      int value = *next < nargs ? (int)args[(*next)++].v.i : 0;
+      n += (size_t)snprintf(spec + n, sizeof(spec) - n - 8, "%d", value);
+      p++;
+    } else {
+      while (*p >= '0' && *p <= '9' && n < 24) spec[n++] = *p++;
+    }
+  }
+  int plain = n == 1;
+  char length[3] = {0};
+  size_t length_len = 0;
+  while (*p != '\0' && strchr("hljztLq", *p) != NULL && length_len < 2)
+    length[length_len++] = *p++;
+  char conv = *p;
+  if (conv == '\0') return p;
+  p++;
+
+  const struct LogArg *arg = *next < nargs ? &args[(*next)++] : NULL;
+  if (arg == NULL) {
+    BufAppend(b, "(missing)", 9);
+    return p;
+  }
+  switch (conv) {
+    case 'd':
+    case 'i': {
+      long long value = arg->v.i;
+      if (length_len == 0) value = (int)value;
+      else if (strcmp(length, "h") == 0) value = (short)value;
+      else if (strcmp(length, "hh") == 0) value = (signed char)value;
+      else if (strcmp(length, "l") == 0) value = (long)value;
+      if (plain) {
+        BufUnsigned(b, value < 0 ? 0ull - (unsigned long long)value
+                                 : (unsigned long long)value,
+                    10, value < 0);
+        break;
+      }
+      memcpy(spec + n, "lld", 4);
+      BufPrintf(b, spec, value);
+      break;
+    }
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X': {
+      unsigned long long value = arg->v.u;
+      if (length_len == 0) value = (unsigned int)value;
+      else if (strcmp(length, "h") == 0) value = (unsigned short)value;
+      else if (strcmp(length, "hh") == 0) value = (unsigned char)value;
+      else if (strcmp(length, "l") == 0) value = (unsigned long)value;
+      if (plain && conv != 'X') {
+        BufUnsigned(b, value, conv == 'u' ? 10 : conv == 'x' ? 16 : 8, 0);
+        break;
+      }
+      memcpy(spec + n, "ll", 2);
+      spec[n + 2] = conv;
+      spec[n + 3] = '\0';
+      BufPrintf(b, spec, value);
+      break;
+    }
+    case 'c':
+      if (plain) {
+        char ch = (char)arg->v.i;
+        BufAppend(b, &ch, 1);
+        break;
+      }
+      memcpy(spec + n, "c", 2);
+      BufPrintf(b, spec, (int)arg->v.i);
+      break;
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      spec[n] = conv;
+      spec[n + 1] = '\0';
+      BufPrintf(b, spec, arg->type == LOG_ARG_DOUBLE ? arg->v.d : (double)arg->v.i);
+      break;
+    case 's': {
+      if (arg->type != LOG_ARG_STR || arg->v.s == NULL) {
+        BufAppend(b, "(null)", 6);
+        break;
+      }
+      size_t len = arg->len != UINT32_MAX
+                       ? arg->len
+                       : strnlen(arg->v.s, LOG_MAX_STRING);  // без кольца
+      if (plain) {
+        BufAppend(b, arg->v.s, len);
+        break;
+      }
+      // точность из формата не может превысить длину скопированной строки
+      char *dot = memchr(spec, '.', n);
+      if (dot != NULL) {
+        size_t precision = (size_t)atoi(dot + 1);
+        if (precision < len) len = precision;
+        n = (size_t)(dot - spec);
+      }
+      snprintf(spec + n, sizeof(spec) - n, ".%ds", (int)len);
+      BufPrintf(b, spec, arg->v.s);
+      break;
+    }
+    case 'p':
+      memcpy(spec + n, "p", 2);
+      BufPrintf(b, spec, arg->v.p);
+      break;
+    default:  // %n и незнакомые преобразования не печатаются
+      break;
+  }
+  return p;
+}
+
+static void FormatLine(struct LineBuf *b, const char *fmt,
+                       const struct LogArg *args, int nargs) {
+  int next = 0;
+  const char *p = fmt;
+  while (*p != '\0') {
+    const char *percent = strchr(p, '%');
+    if (percent == NULL) {
+      BufAppend(b, p, strlen(p));
+      break;
+    }
+    BufAppend(b, p, (size_t)(percent - p));
+    if (percent[1] == '%') {
+      BufAppend(b, "%", 1);
+      p = percent + 2;
+      continue;
+    }
+    p = FormatSpec(b, percent, args, nargs, &next);
+  }
+}
+
+static void FormatPrefix(struct LineBuf *b, const struct LogRecord *rec,
+                         int ring_id) {
+  unsigned flags = g_log.opts.flags;
+  if (flags & LOG_FLAG_TIME) {
+    time_t sec = (time_t)(rec->time_ns / 1000000000ull);
+    struct tm tm;
+    localtime_r(&sec, &tm);
+    BufPrintf(b, "%02d:%02d:%02d.%06u ", tm.tm_hour, tm.tm_min, tm.tm_sec,
+              (unsigned)(rec->time_ns % 1000000000ull / 1000));
+  }
+  if (flags & LOG_FLAG_LEVEL) BufPrintf(b, "%-5s ", kLevelNames[rec->level]);
+  if (flags & LOG_FLAG_THREAD) BufPrintf(b, "[T%d] ", ring_id);
+}
+
+// Запись в кольцо
+
+static void ReleaseRing(void *ring) {
+  atomic_store_explicit(&((struct LogRing *)ring)->in_use, 0,
+                        memory_order_release);
+}
+
+static void InitRings(void) { pthread_key_create(&g_ring_key, ReleaseRing); }
+
+static struct LogRing *AcquireRing(void) {
+  pthread_once(&g_ring_once, InitRings);
+  struct LogRing *ring;
+  for (ring = atomic_load_explicit(&g_rings, memory_order_acquire);
+       ring != NULL; ring = ring->next) {
+    int expected = 0;
+    if (atomic_compare_exchange_strong_explicit(&ring->in_use, &expected, 1,
+                                                memory_order_acquire,
+                                                memory_order_relaxed))
+      break;
+  }
+  if (ring == NULL) {
+    size_t size = LOG_MIN_RING;
+    while (size < g_log.opts.ring_bytes) size <<= 1;
+    ring = aligned_alloc(LOG_CACHE_LINE, sizeof(*ring));
+    char *buf = aligned_alloc(LOG_CACHE_LINE, size);
+    if (ring == NULL || buf == NULL) {
+      free(ring);
+      free(buf);
+      return NULL;
+    }
+    memset(ring, 0, sizeof(*ring));
+    memset(buf, 0, size);  // страницы кольца - сразу, а не на горячем пути
+    ring->buf = buf;
+    ring->size = size;
+    ring->id = atomic_fetch_add(&g_ring_count, 1);
+    atomic_init(&ring->in_use, 1);
+    ring->next = atomic_load_explicit(&g_rings, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(
+        &g_rings, &ring->next, ring, memory_order_release,
+        memory_order_relaxed)) {
+    }
+  }
+  pthread_setspecific(g_ring_key, ring);
+  // Новый владелец мог прийти на смену завершившемуся потоку.
+  ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  return ring;
+}
+
+static size_t AlignUp(size_t n) { return (n + LOG_ALIGN - 1) & ~(size_t)(LOG_ALIGN - 1); }
+
+// Возвращает место под запись size байт (непрерывное) или NULL.
+static char *Reserve(struct LogRing *ring, size_t size, uint64_t *new_head) {
+  uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  size_t offset = head & (ring->size - 1);
+  size_t pad = offset + size > ring->size ? ring->size - offset : 0;
+  size_t need = pad + size;
+  for (;;) {
+    if (head + need - ring->cached_tail <= ring->size) break;
+    ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head + need - ring->cached_tail <= ring->size) break;
+    if (!(g_log.opts.flags & LOG_FLAG_BLOCK) ||
+        !atomic_load_explicit(&g_log.running, memory_order_relaxed))
+      return NULL;
+    sched_yield();
+  }
+  if (pad != 0) {
+    struct LogRecord *filler = (struct LogRecord *)(ring->buf + offset);
+    filler->size = (uint32_t)pad;
+    filler->level = LOG_PAD_LEVEL;
+    offset = 0;
+  }
+  *new_head = head + need;
+  return ring->buf + offset;
+}
+
+static void WriteSync(const char *fmt, int nargs, const struct LogArg *args) {
+  struct LineBuf line;
+  BufInit(&line);
+  FormatLine(&line, fmt, args, nargs);
+  fwrite(line.data, 1, line.len, stdout);
+  BufFree(&line);
+}
+
+void AsyncLogWrite(int level, const char *fmt, int nargs,
+                   const struct LogArg *args) {
+  if (!atomic_load_explicit(&g_log.running, memory_order_acquire)) {
+    WriteSync(fmt, nargs, args);
+    return;
+  }
+  struct LogRing *ring = t_ring;
+  if (ring == NULL) {
+    ring = t_ring = AcquireRing();
+    if (ring == NULL) {
+      WriteSync(fmt, nargs, args);
+      return;
+    }
+  }
+
+  // строки копируются в запись: указатели вызывающего после возврата
+  // могут быть уже недействительны
+  uint32_t lens[LOG_MAX_ARGS];
+  if (nargs > LOG_MAX_ARGS) nargs = LOG_MAX_ARGS;
+  size_t size = sizeof(struct LogRecord) + (size_t)nargs * sizeof(struct LogArg);
+  for (int i = 0; i < nargs; i++) {
+    lens[i] = 0;
+    if (args[i].type != LOG_ARG_STR || args[i].v.s == NULL) continue;
+    lens[i] = args[i].len != UINT32_MAX
+                  ? args[i].len
+                  : (uint32_t)strnlen(args[i].v.s, LOG_MAX_STRING);
+    size += lens[i];
+  }
+  size = AlignUp(size);
+  if (size > ring->size / 2) {
+    atomic_store_explicit(&ring->dropped,
+                          atomic_load_explicit(&ring->dropped, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    return;
+  }
+
+  uint64_t new_head;
+  char *dst = Reserve(ring, size, &new_head);
+  if (dst == NULL) {
+    atomic_store_explicit(&ring->dropped,
+                          atomic_load_explicit(&ring->dropped, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    return;
+  }
+  struct LogRecord *rec = (struct LogRecord *)dst;
+  rec->size = (uint32_t)size;
+  rec->level = (uint8_t)level;
+  rec->nargs = (uint8_t)nargs;
+  // Точное время - только если его печатают: грубые часы в несколько раз
+  // дешевле, а для слияния колец по времени их хватает.
+  rec->time_ns = NowNs(g_log.opts.flags & LOG_FLAG_TIME ? CLOCK_REALTIME
+                                                        : CLOCK_REALTIME_COARSE);
+  rec->fmt = fmt;
+  struct LogArg *out_args = (struct LogArg *)(rec + 1);
+  memcpy(out_args, args, (size_t)nargs * sizeof(struct LogArg));
+  char *strings = (char *)(out_args + nargs);
+  for (int i = 0; i < nargs; i++) {
+    if (args[i].type != LOG_ARG_STR) continue;
+    memcpy(strings, args[i].v.s, lens[i]);
+    out_args[i].len = lens[i];
+    strings += lens[i];
+  }
+  atomic_store_explicit(&ring->head, new_head, memory_order_release);
+}
+
+// Поток записи
+
+struct RingCursor {
+  struct LogRing *ring;
+  uint64_t pos;
+  uint64_t end;
+};
+
+// Пропускает заглушку; возвращает запись под курсором или NULL.
+static struct LogRecord *CursorRecord(struct RingCursor *c) {
+  while (c->pos < c->end) {
+    struct LogRecord *rec =
+        (struct LogRecord *)(c->ring->buf + (c->pos & (c->ring->size - 1)));
+    if (rec->level != LOG_PAD_LEVEL) return rec;
+    c->pos += rec->size;
+    atomic_store_explicit(&c->ring->tail, c->pos, memory_order_release);
+  }
+  return NULL;
+}
+
+static void EmitRecord(struct LineBuf *line, struct LogRecord *rec,
+                       int ring_id) {
+  struct LogArg *args = (struct LogArg *)(rec + 1);
+  char *strings = (char *)(args + rec->nargs);
+  for (int i = 0; i < rec->nargs; i++) {
+    if (args[i].type != LOG_ARG_STR) continue;
+    args[i].v.s = args[i].v.s != NULL ? strings : NULL;
+    strings += args[i].len;
+  }
+  line->len = 0;
+  if (g_log.opts.flags & (LOG_FLAG_TIME | LOG_FLAG_LEVEL | LOG_FLAG_THREAD))
+    FormatPrefix(line, rec, ring_id);
+  FormatLine(line, rec->fmt, args, rec->nargs);
+  // блокировка stdio здесь без соперников: рабочие потоки в файл не пишут
+  fwrite(line->data, 1, line->len, g_log.opts.out);
+}
+
+// Один проход: забирает всё, что есть сейчас, сливая кольца по времени.
+static int DrainOnce(struct LineBuf *line, struct RingCursor **cursors,
+                     int *capacity) {
+  int count = 0;
+  for (struct LogRing *ring = atomic_load_explicit(&g_rings, memory_order_acquire);
+       ring != NULL; ring = ring->next) {
+    if (count == *capacity) {
+      int grown = *capacity ? *capacity * 2 : 16;
+      struct RingCursor *tmp = realloc(*cursors, sizeof(**cursors) * (size_t)grown);
+      if (tmp == NULL) break;
+      *cursors = tmp;
+      *capacity = grown;
+    }
+    struct RingCursor *c = &(*cursors)[count];
+    c->ring = ring;
+    c->pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    c->end = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (c->pos != c->end) count++;
+  }
+
+  int emitted = 0;
+  for (;;) {
+    struct RingCursor *best = NULL;
+    struct LogRecord *best_rec = NULL;
+    for (int i = 0; i < count; i++) {
+      struct LogRecord *rec = CursorRecord(&(*cursors)[i]);
+      if (rec != NULL && (best_rec == NULL || rec->time_ns < best_rec->time_ns)) {
+        best = &(*cursors)[i];
+        best_rec = rec;
+      }
+    }
+    if (best == NULL) break;
+    EmitRecord(line, best_rec, best->ring->id);
+    best->pos += best_rec->size;
+    atomic_store_explicit(&best->ring->tail, best->pos, memory_order_release);
+    emitted++;
+  }
+  return emitted;
+}
+
+// Не чаще раза в секунду, чтобы сообщения о потерях сами не забили stderr.
+static void ReportDropped(int force) {
+  uint64_t dropped = AsyncLogDropped();
+  if (dropped == g_log.dropped_reported) return;
+  uint64_t now = NowNs(CLOCK_MONOTONIC);
+  if (!force && now - g_log.dropped_report_ns < 1000000000ull) return;
+  g_log.dropped_report_ns = now;
+  fprintf(stderr, "async_log: %llu records dropped (ring full)\n",
+          (unsigned long long)(dropped - g_log.dropped_reported));
+  g_log.dropped_reported = dropped;
+}
+
+static void *WriterMain(void *arg) {
+  (void)arg;
+  struct RingCursor *cursors = NULL;
+  int capacity = 0;
+  struct LineBuf line;
+  BufInit(&line);
+  struct timespec idle = {0, LOG_IDLE_NS};
+  while (atomic_load_explicit(&g_log.running, memory_order_acquire)) {
+    int emitted = DrainOnce(&line, &cursors, &capacity);
+    unsigned requested = atomic_load(&g_log.flush_requested);
+    if (requested != atomic_load(&g_log.flush_done)) {
+      fflush(g_log.opts.out);
+      atomic_store(&g_log.flush_done, requested);
+    }
+    if (emitted == 0) {
+      fflush(g_log.opts.out);
+      ReportDropped(0);
+      nanosleep(&idle, NULL);
+    }
+  }
+  while (DrainOnce(&line, &cursors, &capacity) != 0) {
+  }
+  fflush(g_log.opts.out);
+  ReportDropped(1);
+  free(cursors);
+  BufFree(&line);
+  return NULL;
+}
+
+int AsyncLogStart(const struct AsyncLogOptions *opts) {
+  if (atomic_load(&g_log.running)) return -1;
+  g_log.opts = *opts;
+  if (g_log.opts.out == NULL) g_log.opts.out = stdout;
+  AsyncLogSetLevel(opts->level);
+  g_log.dropped_reported = AsyncLogDropped();
+  atomic_store(&g_log.running, 1);
+  if (pthread_create(&g_log.writer, NULL, WriterMain, NULL) != 0) {
+    atomic_store(&g_log.running, 0);
+    return -1;
+  }
+  return 0;
+}
+
+void AsyncLogStop(void) {
+  if (!atomic_load(&g_log.running)) return;
+  atomic_store_explicit(&g_log.running, 0, memory_order_release);
+  pthread_join(g_log.writer, NULL);
+}
+
+void AsyncLogFlush(void) {
+  if (!atomic_load(&g_log.running)) return;
+  struct timespec pause = {0, LOG_IDLE_NS / 4};
+  for (struct LogRing *ring = atomic_load_explicit(&g_rings, memory_order_acquire);
+       ring != NULL; ring = ring->next) {
+    uint64_t target = atomic_load_explicit(&ring->head, memory_order_acquire);
+    while (atomic_load_explicit(&ring->tail, memory_order_acquire) < target &&
+           atomic_load(&g_log.running))
+      nanosleep(&pause, NULL);
+  }
+  // записи выведены в буфер stdio потока записи - просим сбросить его
+  unsigned ticket = atomic_fetch_add(&g_log.flush_requested, 1) + 1;
+  while ((int)(atomic_load(&g_log.flush_done) - ticket) < 0 &&
+         atomic_load(&g_log.running))
+    nanosleep(&pause, NULL);
+}
+
+uint64_t AsyncLogDropped(void) {
+  uint64_t total = 0;
+  for (struct LogRing *ring = atomic_load_explicit(&g_rings, memory_order_acquire);
+       ring != NULL; ring = ring->next)
+    total += atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+  return total;
+}
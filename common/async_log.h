@@ -0,0 +1,219 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Асинхронный лог. Вызов LOG_INFO(...) не форматирует строку: он кладёт
+// в кольцо своего потока (один писатель, один читатель, без блокировок)
+// двоичную запись - время, указатель на формат и аргументы. Отдельный
+// поток забирает записи из всех колец в порядке времени и только тогда
+// делает printf. Рабочие потоки не встречаются ни на блокировке stdio,
+// ни друг с другом.
+//
+// Ограничения:
+//  - формат должен быть строковым литералом (хранится указатель на него);
+//  - не больше LOG_MAX_ARGS аргументов;
+//  - char * всегда считается строкой %s и копируется в запись, для %p
+//    указатель приводится к void *; строку без '\0' передают как
+//    LOG_STR(ptr, len);
+//  - кольцо полно - запись отбрасывается (или ждёт, см. LOG_FLAG_BLOCK),
+//    отброшенные считает AsyncLogDropped().
+// До AsyncLogStart и после AsyncLogStop строки печатаются сразу.
+
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARN 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF 5
+
+// Вызовы ниже LOG_MIN_LEVEL не попадают в код вовсе
+// (например, -DLOG_MIN_LEVEL=LOG_LEVEL_INFO для замеров).
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_MAX_ARGS 8
+#define LOG_MAX_STRING 1024  // длиннее - обрезается при копировании
+
+enum LogFlags {
+  LOG_FLAG_TIME = 1,    // префикс "ЧЧ:ММ:СС.мкс"
+  LOG_FLAG_LEVEL = 2,   // префикс "INFO "
+  LOG_FLAG_THREAD = 4,  // префикс "[T<номер кольца>]"
+  LOG_FLAG_BLOCK = 8,   // при полном кольце ждать, а не отбрасывать
+};
+
+struct AsyncLogOptions {
+  FILE *out;
+  size_t ring_bytes;  // кольцо каждого потока, округляется до степени 2
+  int level;          // уровень на старте, меняется AsyncLogSetLevel
+  unsigned flags;
+};
+
+// out = stdout, кольцо 64 КиБ, без префиксов; уровень - из переменной
+// окружения ASYNC_LOG_LEVEL (trace|debug|info|warn|error|off), иначе info.
+void AsyncLogDefaultOptions(struct AsyncLogOptions *opts);
+
+int AsyncLogStart(const struct AsyncLogOptions *opts);
+
+// Дописывает всё, что в кольцах, и останавливает поток записи.
+// Вызывать после остановки потоков, которые пишут в лог.
+void AsyncLogStop(void);
+
+// Ждёт, пока поток записи выведет всё, что поставлено до вызова.
+void AsyncLogFlush(void);
+
+void AsyncLogSetLevel(int level);
+int ParseLogLevel(const char *name, int *level);
+uint64_t AsyncLogDropped(void);
+
+// Дальше - внутренности макросов.
+
+enum LogArgType {
+  LOG_ARG_INT,
+  LOG_ARG_UINT,
+  LOG_ARG_DOUBLE,
+  LOG_ARG_PTR,
+  LOG_ARG_STR,
+};
+
+struct LogArg {
+  uint32_t type;
+  uint32_t len;  // для строк
+  union {
+    int64_t i;
+    uint64_t u;
+    double d;
+    const void *p;
+    const char *s;
+  } v;
+};
+
+struct LogStrN {
+  const char *s;
+  size_t len;
+};
+
+#define LOG_STR(ptr, len) ((struct LogStrN){(ptr), (len)})
+
+extern atomic_int async_log_level;
+
+void AsyncLogWrite(int level, const char *fmt, int nargs,
+                   const struct LogArg *args);
+
+static inline struct LogArg LogArgInt(int64_t v) {
+  struct LogArg a = {LOG_ARG_INT, 0, {.i = v}};
+  return a;
+}
+static inline struct LogArg LogArgUint(uint64_t v) {
+  struct LogArg a = {LOG_ARG_UINT, 0, {.u = v}};
+  return a;
+}
+static inline struct LogArg LogArgDouble(double v) {
+  struct LogArg a = {LOG_ARG_DOUBLE, 0, {.d = v}};
+  return a;
+}
+static inline struct LogArg LogArgPtr(const void *v) {
+  struct LogArg a = {LOG_ARG_PTR, 0, {.p = v}};
+  return a;
+}
+// Длина считается позже, при копировании в кольцо.
+static inline struct LogArg LogArgStr(const char *v) {
+  struct LogArg a = {LOG_ARG_STR, UINT32_MAX, {.s = v}};
+  return a;
+}
+static inline struct LogArg LogArgStrN(struct LogStrN v) {
+  struct LogArg a = {LOG_ARG_STR,
+                     (uint32_t)(v.len < LOG_MAX_STRING ? v.len : LOG_MAX_STRING),
+                     {.s = v.s}};
+  return a;
+}
+
+#define LOG_ARG(x)                                                          \
+  _Generic((x),                                                             \
+      char *: LogArgStr, const char *: LogArgStr,                           \
+      void *: LogArgPtr, const void *: LogArgPtr,                           \
+      struct LogStrN: LogArgStrN,                                           \
+      float: LogArgDouble, double: LogArgDouble, long double: LogArgDouble, \
+      _Bool: LogArgUint, unsigned char: LogArgUint,                         \
+      unsigned short: LogArgUint, unsigned int: LogArgUint,                 \
+      unsigned long: LogArgUint, unsigned long long: LogArgUint,            \
+      default: LogArgInt)(x)
+
+// Для проверки формата компилятором LOG_STR выглядит как строка.
+#define LOG_CHECK(x) _Generic((x), struct LogStrN: "", default: (x))
+
+static inline void LogCheckFormat(const char *fmt, ...)
+    __attribute__((format(printf, 1, 2)));
+static inline void LogCheckFormat(const char *fmt, ...) { (void)fmt; }
+
+#define LOG_FIRST(...) LOG_FIRST_(__VA_ARGS__, _)
+#define LOG_FIRST_(fmt, ...) fmt
+#define LOG_NARGS(...) LOG_NARGS_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, _)
+#define LOG_NARGS_(fmt, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define LOG_CAT(a, b) LOG_CAT_(a, b)
+#define LOG_CAT_(a, b) a##b
+
+// LOG_MAP(f, fmt, a, b) -> f(a) f(b)
+#define LOG_MAP(f, ...) LOG_CAT(LOG_MAP_, LOG_NARGS(__VA_ARGS__))(f, __VA_ARGS__)
+#define LOG_MAP_0(f, fmt)
+#define LOG_MAP_1(f, fmt, a) f(a)
+#define LOG_MAP_2(f, fmt, a, ...) f(a) LOG_MAP_1(f, fmt, __VA_ARGS__)
+#define LOG_MAP_3(f, fmt, a, ...) f(a) LOG_MAP_2(f, fmt, __VA_ARGS__)
+#define LOG_MAP_4(f, fmt, a, ...) f(a) LOG_MAP_3(f, fmt, __VA_ARGS__)
+#define LOG_MAP_5(f, fmt, a, ...) f(a) LOG_MAP_4(f, fmt, __VA_ARGS__)
+#define LOG_MAP_6(f, fmt, a, ...) f(a) LOG_MAP_5(f, fmt, __VA_ARGS__)
+#define LOG_MAP_7(f, fmt, a, ...) f(a) LOG_MAP_6(f, fmt, __VA_ARGS__)
+#define LOG_MAP_8(f, fmt, a, ...) f(a) LOG_MAP_7(f, fmt, __VA_ARGS__)
+
+#define LOG_ARG_ITEM(x) LOG_ARG(x),
+#define LOG_CHECK_ITEM(x) , LOG_CHECK(x)
+
+// Аргументы не вычисляются, формат проверяется.
+#define LOG_DISCARD(...)                                                \
+  do {                                                                  \
+    if (0)                                                              \
+      LogCheckFormat(LOG_FIRST(__VA_ARGS__)                             \
+                         LOG_MAP(LOG_CHECK_ITEM, __VA_ARGS__));         \
+  } while (0)
+
+#define LOG_AT(level, ...)                                                   \
+  do {                                                                       \
+    LOG_DISCARD(__VA_ARGS__);                                                \
+    if ((level) >= atomic_load_explicit(&async_log_level,                    \
+                                        memory_order_relaxed))               \
+      AsyncLogWrite((level), LOG_FIRST(__VA_ARGS__), LOG_NARGS(__VA_ARGS__), \
+                    (const struct LogArg[]){                                 \
+                        LOG_MAP(LOG_ARG_ITEM, __VA_ARGS__){0}});             \
+  } while (0)
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) LOG_AT(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+#if LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#endif
@@ -0,0 +1,276 @@
+#define _GNU_SOURCE
+#include "coro.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_EVENTS 256
+
+static uint64_t MonotonicNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Куча сроков: минимум в heap[0], каждая сопрограмма знает свой индекс,
+// чтобы снять срок, когда ввод-вывод завершился раньше.
+static void HeapSwap(struct CoroLoop *loop, size_t a, size_t b) {
+  struct Coro *tmp = loop->heap[a];
+  loop->heap[a] = loop->heap[b];
+  loop->heap[b] = tmp;
+  loop->heap[a]->heap_index = a;
+  loop->heap[b]->heap_index = b;
+}
+
+static void HeapUp(struct CoroLoop *loop, size_t i) {
+  while (i > 0) {
+    size_t parent = (i - 1) / 2;
+    if (loop->heap[parent]->deadline_ns <= loop->heap[i]->deadline_ns) break;
+    HeapSwap(loop, i, parent);
+    i = parent;
+  }
+}
+
+static void HeapDown(struct CoroLoop *loop, size_t i) {
+  for (;;) {
+    size_t least = i;
+    size_t left = 2 * i + 1;
+    size_t right = left + 1;
+    if (left < loop->heap_len &&
+        loop->heap[left]->deadline_ns < loop->heap[least]->deadline_ns)
+      least = left;
+    if (right < loop->heap_len &&
+        loop->heap[right]->deadline_ns < loop->heap[least]->deadline_ns)
+      least = right;
+    if (least == i) return;
+    HeapSwap(loop, i, least);
+    i = least;
+  }
+}
+
+static int HeapPush(struct CoroLoop *loop, struct Coro *co) {
+  if (loop->heap_len == loop->heap_cap) {
+    size_t cap = loop->heap_cap ? loop->heap_cap * 2 : 64;
+    struct Coro **heap = realloc(loop->heap, cap * sizeof(*heap));
+    if (heap == NULL) return -1;
+    loop->heap = heap;
+    loop->heap_cap = cap;
+  }
+  co->heap_index = loop->heap_len;
+  loop->heap[loop->heap_len++] = co;
+  HeapUp(loop, co->heap_index);
+  return 0;
+}
+
+static void HeapRemove(struct CoroLoop *loop, struct Coro *co) {
+  size_t i = co->heap_index;
+  if (i == SIZE_MAX) return;
+  co->heap_index = SIZE_MAX;
+  loop->heap_len--;
+  if (i == loop->heap_len) return;
+  loop->heap[i] = loop->heap[loop->heap_len];
+  loop->heap[i]->heap_index = i;
+  HeapUp(loop, i);
+  HeapDown(loop, loop->heap[i]->heap_index);
+}
+
+int CoroLoopInit(struct CoroLoop *loop) {
+  loop->heap = NULL;
+  loop->heap_len = 0;
+  loop->heap_cap = 0;
+  loop->live = 0;
+  loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  return loop->epoll_fd < 0 ? -1 : 0;
+}
+
+void CoroLoopDestroy(struct CoroLoop *loop) {
+  if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+  loop->epoll_fd = -1;
+  free(loop->heap);
+  loop->heap = NULL;
+  loop->heap_len = loop->heap_cap = 0;
+}
+
+static void Resume(struct Coro *co) {
+  if (co->fn(co) == CORO_DONE) {
+    HeapRemove(co->loop, co);
+    co->loop->live--;
+  }
+}
+
+void CoroSpawn(struct CoroLoop *loop, struct Coro *co, CoroFn fn) {
+  co->fn = fn;
+  co->loop = loop;
+  co->line = 0;
+  co->fresh = 0;
+  co->wait_fd = -1;
+  co->armed_fd = -1;
+  co->timed_out = 0;
+  co->heap_index = SIZE_MAX;
+  co->deadline_ns = 0;
+  co->timeout_ns = 0;
+  co->done = 0;
+  co->result = 0;
+  co->err = 0;
+  loop->live++;
+  Resume(co);
+}
+
+void CoroSetTimeout(struct Coro *co, uint64_t timeout_ms) {
+  co->timeout_ns = timeout_ms * 1000000ull;
+}
+
+// Начало операции: срок отсчитывается один раз на всю операцию, а не на
+// каждое ожидание, иначе собеседник, присылающий по байту чуть чаще срока,
+// держал бы recv/send бесконечно.
+static void StartOp(struct Coro *co) {
+  co->fresh = 0;
+  co->done = 0;
+  co->deadline_ns = co->timeout_ns != 0 ? MonotonicNs() + co->timeout_ns : 0;
+}
+
+static int Finish(struct Coro *co, long result, int err) {
+  co->result = result;
+  co->err = err;
+  return 1;
+}
+
+// Ждёт события на fd (и срока, если задан). EPOLLONESHOT: после
+// срабатывания fd выключен, пока сопрограмма снова не начнёт ждать,
+// так что событие никогда не придёт сопрограмме, которая его не ждёт.
+static int WaitFd(struct Coro *co, int fd, uint32_t events) {
+  struct CoroLoop *loop = co->loop;
+  struct epoll_event ev = {.events = events | EPOLLONESHOT, .data.ptr = co};
+  int op = co->armed_fd == fd ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  int rc = epoll_ctl(loop->epoll_fd, op, fd, &ev);
+  // fd закрыли и номер выдали снова - регистрация уже не та, что помним
+  if (rc != 0 && op == EPOLL_CTL_MOD && errno == ENOENT)
+    rc = epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+  if (rc != 0 && op == EPOLL_CTL_ADD && errno == EEXIST)
+    rc = epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+  if (rc != 0) return Finish(co, -1, errno);
+  co->armed_fd = fd;
+  co->timed_out = 0;
+  if (co->timeout_ns != 0) {
+    // deadline_ns выставил StartOp; уже истёкший сработает на ближайшем круге
+    if (HeapPush(loop, co) != 0) {
+      epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+      co->armed_fd = -1;
+      return Finish(co, -1, ENOMEM);
+    }
+  }
+  co->wait_fd = fd;
+  return 0;
+}
+
+int CoroConnect(struct Coro *co, int fd, const struct sockaddr *addr,
+                socklen_t addr_len) {
+  if (co->fresh) {
+    StartOp(co);
+    if (connect(fd, addr, addr_len) == 0) return Finish(co, 0, 0);
+    if (errno != EINPROGRESS) return Finish(co, -1, errno);
+    return WaitFd(co, fd, EPOLLOUT);
+  }
+  if (co->timed_out) return Finish(co, -1, ETIMEDOUT);
+  int err = 0;
+  socklen_t len = sizeof(err);
+  if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0) err = errno;
+  return Finish(co, err != 0 ? -1 : 0, err);
+}
+
+int CoroSend(struct Coro *co, int fd, const void *buf, size_t len) {
+  if (co->fresh) {
+    StartOp(co);
+  } else if (co->timed_out) {
+    return Finish(co, -1, ETIMEDOUT);
+  }
+  while (co->done < len) {
+    ssize_t n = send(fd, (const char *)buf + co->done, len - co->done,
+                     MSG_NOSIGNAL);
+    if (n >= 0) {
+      co->done += (size_t)n;
+      continue;
+    }
+    if (errno == EINTR) continue;
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      return WaitFd(co, fd, EPOLLOUT);
+    return Finish(co, -1, errno);
+  }
+  return Finish(co, (long)len, 0);
+}
+
+int CoroRecv(struct Coro *co, int fd, void *buf, size_t len) {
+  if (co->fresh) {
+    StartOp(co);
+  } else if (co->timed_out) {
+    return Finish(co, -1, ETIMEDOUT);
+  }
+  while (co->done < len) {
+    ssize_t n = recv(fd, (char *)buf + co->done, len - co->done, 0);
+    if (n > 0) {
+      co->done += (size_t)n;
+      continue;
+    }
+    if (n == 0) break;
+    if (errno == EINTR) continue;
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      return WaitFd(co, fd, EPOLLIN);
+    return Finish(co, -1, errno);
+  }
+  return Finish(co, (long)co->done, 0);
+}
+
+int CoroSleep(struct Coro *co, uint64_t ms) {
+  if (!co->fresh) return Finish(co, 0, 0);
+  co->fresh = 0;
+  co->timed_out = 0;
+  co->deadline_ns = MonotonicNs() + ms * 1000000ull;
+  if (HeapPush(co->loop, co) != 0) return Finish(co, -1, ENOMEM);
+  return 0;
+}
+
+int CoroLoopRun(struct CoroLoop *loop) {
+  struct epoll_event events[MAX_EVENTS];
+  while (loop->live > 0) {
+    int timeout = -1;
+    if (loop->heap_len > 0) {
+      uint64_t now = MonotonicNs();
+      uint64_t deadline = loop->heap[0]->deadline_ns;
+      uint64_t wait_ms =
+          deadline > now ? (deadline - now + 999999) / 1000000 : 0;
+      timeout = wait_ms > INT_MAX ? INT_MAX : (int)wait_ms;
+    }
+    int n = epoll_wait(loop->epoll_fd, events, MAX_EVENTS, timeout);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    for (int i = 0; i < n; i++) {
+      struct Coro *co = events[i].data.ptr;
+      if (co->wait_fd < 0) continue;
+      co->wait_fd = -1;
+      HeapRemove(loop, co);
+      Resume(co);
+    }
+    // Истёкшие сроки: сон закончился или ввод-вывод ждал слишком долго.
+    uint64_t now = MonotonicNs();
+    while (loop->heap_len > 0 && loop->heap[0]->deadline_ns <= now) {
+      struct Coro *co = loop->heap[0];
+      HeapRemove(loop, co);
+      if (co->wait_fd >= 0) {
+        // fd ещё взведён: снимаем, чтобы запоздавшее событие не разбудило
+        // сопрограмму посреди следующей операции
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, co->wait_fd, NULL);
+        co->armed_fd = -1;
+        co->wait_fd = -1;
+      }
+      co->timed_out = 1;
+      Resume(co);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,122 @@
+#ifndef CORO_H
+#define CORO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+// Однопоточные сопрограммы поверх epoll для клиентов, которые держат
+// тысячи соединений сразу. Сопрограмма - обычная функция, которая пишет
+// connect/send/recv/sleep подряд, как блокирующий код, а на месте
+// ожидания возвращает управление циклу:
+//
+//   static int Shard(struct Coro *co) {
+//     struct ShardTask *t = CORO_OWNER(co, struct ShardTask, co);
+//     CORO_BEGIN(co);
+//     CORO_AWAIT(co, CoroConnect(co, t->fd, addr, addr_len));
+//     if (co->result < 0) CORO_EXIT(co);
+//     CORO_AWAIT(co, CoroSend(co, t->fd, t->request, sizeof(t->request)));
+//     ...
+//     CORO_END(co);
+//   }
+//
+// Сопрограммы бесстековые (switch по номеру строки): всё состояние -
+// struct Coro и структура вызывающего, в которую она встроена, так что
+// соединение стоит ~сотню байт, а не стек потока. Отсюда ограничения:
+// локальные переменные не переживают CORO_AWAIT (храните их в своей
+// структуре), внутри тела нельзя свой switch вокруг CORO_AWAIT и не
+// больше одного CORO_AWAIT на строке.
+//
+// Цикл не использует глобальных переменных: на каждом ядре можно
+// запустить свой CoroLoop в своём потоке.
+
+#define CORO_PENDING 0
+#define CORO_DONE 1
+
+struct Coro;
+struct CoroLoop;
+typedef int (*CoroFn)(struct Coro *co);
+
+struct Coro {
+  CoroFn fn;
+  struct CoroLoop *loop;
+  int line;  // точка продолжения (0 - начало тела)
+  int fresh;  // операция CORO_AWAIT только начинается
+  // ожидание: fd в epoll (-1 - нет) и/или срок в heap
+  int wait_fd;
+  int armed_fd;  // fd, зарегистрированный в epoll этой сопрограммой
+  int timed_out;
+  size_t heap_index;  // SIZE_MAX - не в куче сроков
+  uint64_t deadline_ns;
+  uint64_t timeout_ns;  // срок на операцию ввода-вывода, 0 - без срока
+  size_t done;  // уже передано байт текущей операцией
+  // результат последней операции: >= 0 - успех, -1 - ошибка в err
+  long result;
+  int err;
+};
+
+// Структура, в которую встроена сопрограмма.
+#define CORO_OWNER(co, type, member) \
+  ((type *)((char *)(co) - offsetof(type, member)))
+
+#define CORO_BEGIN(co) \
+  switch ((co)->line) { \
+    case 0:
+
+#define CORO_END(co) \
+  } \
+  (co)->line = -1; \
+  return CORO_DONE
+
+// Досрочное завершение тела.
+#define CORO_EXIT(co) \
+  do { \
+    (co)->line = -1; \
+    return CORO_DONE; \
+  } while (0)
+
+// op - вызов CoroConnect/CoroSend/...: 1 - готово (итог в co->result),
+// 0 - ждём, и при пробуждении тот же op вызывается снова.
+#define CORO_AWAIT(co, op) \
+  do { \
+    (co)->fresh = 1; \
+    (co)->line = __LINE__; \
+    __attribute__((fallthrough)); \
+    case __LINE__: \
+      if (!(op)) return CORO_PENDING; \
+  } while (0)
+
+struct CoroLoop {
+  int epoll_fd;
+  struct Coro **heap;  // сроки, минимум в корне
+  size_t heap_len;
+  size_t heap_cap;
+  size_t live;  // запущенные и ещё не завершённые сопрограммы
+};
+
+int CoroLoopInit(struct CoroLoop *loop);
+void CoroLoopDestroy(struct CoroLoop *loop);
+
+// Запускает fn до первого ожидания. Память co - у вызывающего и должна
+// жить до завершения сопрограммы.
+void CoroSpawn(struct CoroLoop *loop, struct Coro *co, CoroFn fn);
+
+// Крутит цикл, пока не завершатся все сопрограммы. -1 - ошибка epoll.
+int CoroLoopRun(struct CoroLoop *loop);
+
+// Срок на каждую следующую операцию connect/send/recv целиком, сколько бы
+// ожиданий она ни заняла (0 - без срока); вызывается из тела: CoroSpawn
+// сбрасывает его. По истечении операция завершается с result -1 и err
+// ETIMEDOUT.
+void CoroSetTimeout(struct Coro *co, uint64_t timeout_ms);
+
+// fd должен быть неблокирующим. Успех - result 0.
+int CoroConnect(struct Coro *co, int fd, const struct sockaddr *addr,
+                socklen_t addr_len);
+// Отправляет все len байт. Успех - result len.
+int CoroSend(struct Coro *co, int fd, const void *buf, size_t len);
+// Читает ровно len байт; result меньше len - соединение закрыто раньше.
+int CoroRecv(struct Coro *co, int fd, void *buf, size_t len);
+int CoroSleep(struct Coro *co, uint64_t ms);
+
+#endif
@@ -0,0 +1,394 @@
+#define _GNU_SOURCE
+#include "event_loop_internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+#define MAX_EVENTS 256
+#define RECV_CHUNK 65536
+#define DGRAM_SIZE 65536
+
+struct LoopStats loop_stats;
+volatile sig_atomic_t loop_stop = 0;
+
+static ConnHandler conn_handler;
+static void *conn_user;
+
+int ParseLoopBackend(const char *name, enum LoopBackend *backend) {
+  if (strcmp(name, "epoll") == 0) {
+    *backend = LOOP_BACKEND_EPOLL;
+    return 0;
+  }
+  if (strcmp(name, "uring") == 0 || strcmp(name, "io_uring") == 0) {
+    *backend = LOOP_BACKEND_URING;
+    return 0;
+  }
+  return -1;
+}
+
+const char *LoopBackendName(enum LoopBackend backend) {
+  return backend == LOOP_BACKEND_URING ? "io_uring" : "epoll";
+}
+
+void LoopStop(void) { loop_stop = 1; }
+
+void LoopSetConnHandler(ConnHandler handler, void *user) {
+  conn_handler = handler;
+  conn_user = user;
+}
+
+int LoopConnFd(const struct LoopConn *conn) { return conn->fd; }
+
+const struct LoopStats *LoopGetStats(void) { return &loop_stats; }
+
+void LoopPrintStats(const char *backend_name) {
+  fprintf(stderr,
+          "[%s] syscalls: %llu, accepted: %llu, messages: %llu, "
+          "bytes in/out: %llu/%llu, syscalls per message: %.3f\n",
+          backend_name, (unsigned long long)loop_stats.syscalls,
+          (unsigned long long)loop_stats.accepted,
+          (unsigned long long)loop_stats.messages,
+          (unsigned long long)loop_stats.bytes_in,
+          (unsigned long long)loop_stats.bytes_out,
+          loop_stats.messages
+              ? (double)loop_stats.syscalls / (double)loop_stats.messages
+              : 0.0);
+}
+
+static int Reserve(char **buf, size_t *cap, size_t need) {
+  if (need <= *cap) return 0;
+  size_t new_cap = *cap ? *cap : 256;
+  while (new_cap < need) new_cap *= 2;
+  char *p = realloc(*buf, new_cap);
+  if (p == NULL) return -1;
+  *buf = p;
+  *cap = new_cap;
+  return 0;
+}
+
+int LoopConnFeed(struct LoopConn *conn, const char *data, size_t len,
+                 StreamHandler handler, void *user) {
+  loop_stats.bytes_in += len;
+  loop_stats.messages++;
+
+  if (conn->closing) return -1;
+  // Частый случай: хвоста нет, обрабатываем данные прямо из буфера приёма.
+  if (conn->in_len == 0) {
+    size_t used = handler(conn, data, len, user);
+    if (conn->closing) return -1;
+    if (used < len) {
+      if (Reserve(&conn->in, &conn->in_cap, len - used) != 0) return -1;
+      memcpy(conn->in, data + used, len - used);
+      conn->in_len = len - used;
+    }
+    return 0;
+  }
+
+  if (Reserve(&conn->in, &conn->in_cap, conn->in_len + len) != 0) return -1;
+  memcpy(conn->in + conn->in_len, data, len);
+  conn->in_len += len;
+  size_t used = handler(conn, conn->in, conn->in_len, user);
+  if (conn->closing) return -1;
+  memmove(conn->in, conn->in + used, conn->in_len - used);
+  conn->in_len -= used;
+  return 0;
+}
+
+void LoopConnOpened(struct LoopConn *conn) {
+  conn->opened = 1;
+  if (conn_handler != NULL) conn_handler(conn, 1, conn_user);
+}
+
+void LoopConnFree(struct LoopConn *conn) {
+  if (conn->opened && conn_handler != NULL) conn_handler(conn, 0, conn_user);
+  free(conn->in);
+  free(conn->out);
+  free(conn);
+}
+
+static int SetNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  if (flags < 0) return -1;
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// --- epoll ---
+
+static int epoll_fd = -1;
+
+static void EpollWatch(struct LoopConn *conn, int want_write) {
+  if (conn->want_write == want_write) return;
+  struct epoll_event ev = {0};
+  ev.events = EPOLLIN | (want_write ? EPOLLOUT : 0);
+  ev.data.ptr = conn;
+  loop_stats.syscalls++;
+  epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+  conn->want_write = want_write;
+}
+
+static int EpollFlush(struct LoopConn *conn) {
+  while (conn->out_off < conn->out_len) {
+    loop_stats.syscalls++;
+    TraceBegin("send");
+    ssize_t n = send(conn->fd, conn->out + conn->out_off,
+                     conn->out_len - conn->out_off, MSG_NOSIGNAL);
+    TraceEnd("send");
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        EpollWatch(conn, 1);
+        return 0;
+      }
+      return -1;
+    }
+    conn->out_off += (size_t)n;
+    loop_stats.bytes_out += (size_t)n;
+  }
+  conn->out_off = conn->out_len = 0;
+  EpollWatch(conn, 0);
+  return 0;
+}
+
+void LoopSend(struct LoopConn *conn, const void *data, size_t len) {
+  if (conn->backend == LOOP_BACKEND_URING) {
+    UringSend(conn, data, len);
+    return;
+  }
+  // Ответы копятся в out и уходят одним send после обработки порции.
+  if (Reserve(&conn->out, &conn->out_cap, conn->out_len + len) != 0) {
+    fprintf(stderr, "LoopSend: out of memory, response dropped\n");
+    return;
+  }
+  memcpy(conn->out + conn->out_len, data, len);
+  conn->out_len += len;
+}
+
+void LoopClose(struct LoopConn *conn) { conn->closing = 1; }
+
+static void EpollClose(struct LoopConn *conn) {
+  loop_stats.syscalls++;
+  close(conn->fd);  // close сам убирает fd из epoll
+  LoopConnFree(conn);
+}
+
+static void EpollAcceptAll(int listen_fd) {
+  while (1) {
+    loop_stats.syscalls++;
+    TraceBegin("accept");
+    int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK);
+    TraceEnd("accept");
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        perror("accept4");
+      return;
+    }
+    struct LoopConn *conn = calloc(1, sizeof(*conn));
+    if (conn == NULL) {
+      close(fd);
+      continue;
+    }
+    conn->fd = fd;
+    conn->backend = LOOP_BACKEND_EPOLL;
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN;
+    ev.data.ptr = conn;
+    loop_stats.syscalls++;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+      perror("epoll_ctl");
+      close(fd);
+      LoopConnFree(conn);
+      continue;
+    }
+    loop_stats.accepted++;
+    LoopConnOpened(conn);
+  }
+}
+
+// Возвращает -1, если соединение нужно закрыть.
+static int EpollRead(struct LoopConn *conn, char *buf, StreamHandler handler,
+                     void *user) {
+  while (1) {
+    loop_stats.syscalls++;
+    TraceBegin("recv");
+    ssize_t n = recv(conn->fd, buf, RECV_CHUNK, 0);
+    TraceEnd("recv");
+    if (n == 0) return -1;
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      return -1;
+    }
+    if (LoopConnFeed(conn, buf, (size_t)n, handler, user) != 0) {
+      // ответы на запросы до LoopClose - лучшим усилием, не дожидаясь EPOLLOUT
+      if (conn->closing) EpollFlush(conn);
+      return -1;
+    }
+    if (n < RECV_CHUNK) break;  // сокет вычитан, лишний recv не нужен
+  }
+  return EpollFlush(conn);
+}
+
+int RunStreamServerEpoll(int listen_fd, StreamHandler handler, void *user) {
+  if (SetNonBlocking(listen_fd) < 0) {
+    perror("fcntl");
+    return -1;
+  }
+  epoll_fd = epoll_create1(0);
+  if (epoll_fd < 0) {
+    perror("epoll_create1");
+    return -1;
+  }
+  struct epoll_event ev = {0};
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;  // NULL - слушающий сокет
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev) < 0) {
+    perror("epoll_ctl");
+    close(epoll_fd);
+    return -1;
+  }
+
+  char *buf = malloc(RECV_CHUNK);
+  struct epoll_event *events = malloc(sizeof(*events) * MAX_EVENTS);
+  if (buf == NULL || events == NULL) {
+    free(buf);
+    free(events);
+    close(epoll_fd);
+    return -1;
+  }
+
+  int rc = 0;
+  while (!loop_stop) {
+    loop_stats.syscalls++;
+    int n = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      perror("epoll_wait");
+      rc = -1;
+      break;
+    }
+    for (int i = 0; i < n; i++) {
+      struct LoopConn *conn = events[i].data.ptr;
+      if (conn == NULL) {
+        EpollAcceptAll(listen_fd);
+        continue;
+      }
+      int close_conn = 0;
+      if (events[i].events & (EPOLLERR | EPOLLHUP)) close_conn = 1;
+      if (!close_conn && (events[i].events & EPOLLOUT))
+        close_conn = EpollFlush(conn) != 0;
+      if (!close_conn && (events[i].events & EPOLLIN))
+        close_conn = EpollRead(conn, buf, handler, user) != 0;
+      if (close_conn) EpollClose(conn);
+    }
+  }
+
+  free(events);
+  free(buf);
+  close(epoll_fd);
+  epoll_fd = -1;
+  return rc;
+}
+
+int RunDatagramServerEpoll(int fd, DatagramHandler handler, void *user) {
+  if (SetNonBlocking(fd) < 0) {
+    perror("fcntl");
+    return -1;
+  }
+  epoll_fd = epoll_create1(0);
+  if (epoll_fd < 0) {
+    perror("epoll_create1");
+    return -1;
+  }
+  struct epoll_event ev = {0};
+  ev.events = EPOLLIN;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    perror("epoll_ctl");
+    close(epoll_fd);
+    return -1;
+  }
+
+  char *buf = malloc(DGRAM_SIZE);
+  char *reply = malloc(DGRAM_SIZE);
+  if (buf == NULL || reply == NULL) {
+    free(buf);
+    free(reply);
+    close(epoll_fd);
+    return -1;
+  }
+
+  int rc = 0;
+  while (!loop_stop) {
+    struct epoll_event out;
+    loop_stats.syscalls++;
+    int n = epoll_wait(epoll_fd, &out, 1, -1);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      perror("epoll_wait");
+      rc = -1;
+      break;
+    }
+    while (1) {
+      struct sockaddr_in from;
+      socklen_t from_len = sizeof(from);
+      loop_stats.syscalls++;
+      ssize_t len = recvfrom(fd, buf, DGRAM_SIZE, 0,
+                             (struct sockaddr *)&from, &from_len);
+      if (len < 0) {
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) perror("recvfrom");
+        break;
+      }
+      loop_stats.messages++;
+      loop_stats.bytes_in += (size_t)len;
+      size_t reply_len =
+          handler(buf, (size_t)len, &from, reply, DGRAM_SIZE, user);
+      if (reply_len > 0) {
+        loop_stats.syscalls++;
+        if (sendto(fd, reply, reply_len, 0, (struct sockaddr *)&from,
+                   from_len) < 0)
+          perror("sendto");
+        else
+          loop_stats.bytes_out += reply_len;
+      }
+    }
+  }
+
+  free(buf);
+  free(reply);
+  close(epoll_fd);
+  epoll_fd = -1;
+  return rc;
+}
+
+// --- выбор бэкенда ---
+
+int RunStreamServer(int listen_fd, enum LoopBackend backend,
+                    StreamHandler handler, void *user) {
+  if (backend == LOOP_BACKEND_URING) {
+    int fallback = 0;
+    int rc = RunStreamServerUring(listen_fd, handler, user, &fallback);
+    if (!fallback) return rc;
+    fprintf(stderr, "io_uring is unavailable, falling back to epoll\n");
+  }
+  return RunStreamServerEpoll(listen_fd, handler, user);
+}
+
+int RunDatagramServer(int fd, enum LoopBackend backend,
+                      DatagramHandler handler, void *user) {
+  if (backend == LOOP_BACKEND_URING) {
+    int fallback = 0;
+    int rc = RunDatagramServerUring(fd, handler, user, &fallback);
+    if (!fallback) return rc;
+    fprintf(stderr, "io_uring is unavailable, falling back to epoll\n");
+  }
+  return RunDatagramServerEpoll(fd, handler, user);
+}
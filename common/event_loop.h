@@ -0,0 +1,71 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Цикл обработки событий для серверов lab6/lab7.
+// Бэкенд выбирается во время запуска: epoll (по умолчанию) или io_uring.
+// Если io_uring недоступен (старое ядро, запрет в sysctl/seccomp),
+// сервер автоматически переходит на epoll.
+
+enum LoopBackend { LOOP_BACKEND_EPOLL, LOOP_BACKEND_URING };
+
+struct LoopConn;
+
+// Вызывается, когда у соединения появились новые данные.
+// data/len - все накопленные и ещё не потреблённые байты.
+// Возвращает число потреблённых байт, остаток придёт в следующем вызове.
+typedef size_t (*StreamHandler)(struct LoopConn *conn, const char *data,
+                                size_t len, void *user);
+
+// Обработчик датаграммы. Возвращает длину ответа в reply (0 - без ответа).
+typedef size_t (*DatagramHandler)(const char *data, size_t len,
+                                  const struct sockaddr_in *from, char *reply,
+                                  size_t reply_cap, void *user);
+
+// Вызывается при появлении (opened = 1) и закрытии (opened = 0)
+// соединения потокового сервера - например, для лога соединений.
+typedef void (*ConnHandler)(struct LoopConn *conn, int opened, void *user);
+
+struct LoopStats {
+  uint64_t syscalls;  // системные вызовы, сделанные самим циклом
+  uint64_t accepted;
+  uint64_t messages;  // вызовы обработчика с непустыми данными
+  uint64_t bytes_in;
+  uint64_t bytes_out;
+};
+
+int ParseLoopBackend(const char *name, enum LoopBackend *backend);
+const char *LoopBackendName(enum LoopBackend backend);
+
+// Ставит ответ в очередь на отправку. Порядок ответов внутри соединения
+// сохраняется.
+void LoopSend(struct LoopConn *conn, const void *data, size_t len);
+
+// Закрывает соединение после уже поставленных ответов: оставшиеся данные
+// не разбираются, обработчик для него больше не вызывается. Для запросов,
+// на которые нет осмысленного ответа, - иначе клиент ждал бы вечно.
+void LoopClose(struct LoopConn *conn);
+
+// Необязательный обработчик открытия/закрытия соединений; задаётся
+// до RunStreamServer. Вызывается из потока цикла событий.
+void LoopSetConnHandler(ConnHandler handler, void *user);
+
+// Сокет соединения (например, для getpeername в ConnHandler).
+int LoopConnFd(const struct LoopConn *conn);
+
+// Оба вызова блокируются до LoopStop() или фатальной ошибки (-1).
+int RunStreamServer(int listen_fd, enum LoopBackend backend,
+                    StreamHandler handler, void *user);
+int RunDatagramServer(int fd, enum LoopBackend backend,
+                      DatagramHandler handler, void *user);
+
+// Безопасно вызывать из обработчика сигнала.
+void LoopStop(void);
+
+const struct LoopStats *LoopGetStats(void);
+void LoopPrintStats(const char *backend_name);
+
+#endif
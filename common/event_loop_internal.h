@@ -0,0 +1,59 @@
+#ifndef EVENT_LOOP_INTERNAL_H
+#define EVENT_LOOP_INTERNAL_H
+
+#include <signal.h>
+
+#include "event_loop.h"
+
+struct UringLoop;
+struct SendReq;
+
+struct LoopConn {
+  int fd;
+  enum LoopBackend backend;
+  int closing;  // LoopClose: дописать ответы и закрыть
+  int opened;   // ConnHandler уже знает о соединении
+
+  // входной буфер: необработанный хвост предыдущих порций
+  char *in;
+  size_t in_len;
+  size_t in_cap;
+
+  // epoll: неотправленные ответы
+  char *out;
+  size_t out_len;
+  size_t out_off;
+  size_t out_cap;
+  int want_write;
+
+  // io_uring: число операций в полёте; send в полёте не больше одного,
+  // остальные ответы ждут в очереди send_head..send_tail
+  struct UringLoop *uring;
+  int refs;
+  int recv_done;
+  int sending;
+  struct SendReq *send_head;
+  struct SendReq *send_tail;
+};
+
+extern struct LoopStats loop_stats;
+extern volatile sig_atomic_t loop_stop;
+
+// Складывает новые байты во входной буфер и вызывает обработчик.
+int LoopConnFeed(struct LoopConn *conn, const char *data, size_t len,
+                 StreamHandler handler, void *user);
+// Соединение принято и зарегистрировано в бэкенде: сообщает ConnHandler.
+void LoopConnOpened(struct LoopConn *conn);
+void LoopConnFree(struct LoopConn *conn);
+
+int RunStreamServerEpoll(int listen_fd, StreamHandler handler, void *user);
+int RunDatagramServerEpoll(int fd, DatagramHandler handler, void *user);
+
+// Если io_uring недоступен, выставляют *fallback = 1 и сразу возвращаются.
+int RunStreamServerUring(int listen_fd, StreamHandler handler, void *user,
+                         int *fallback);
+int RunDatagramServerUring(int fd, DatagramHandler handler, void *user,
+                           int *fallback);
+void UringSend(struct LoopConn *conn, const void *data, size_t len);
+
+#endif
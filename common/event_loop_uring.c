@@ -0,0 +1,576 @@
+#define _GNU_SOURCE
+#include "event_loop_internal.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// io_uring без liburing: кольца отображаются вручную через mmap.
+// Потоковый сервер использует multishot accept, multishot recv с кольцом
+// предоставленных буферов (provided buffer ring). У соединения в полёте
+// не больше одного send, следующий ответ уходит из завершения
+// предыдущего - так ответы не перемешиваются, даже если клиент читает
+// медленно и send висит дольше одной пачки.
+
+#define RING_ENTRIES 1024
+#define BUF_GROUP 1
+#define BUF_COUNT 1024  // степень двойки
+#define BUF_SIZE 4096
+#define DGRAM_SLOTS 64
+#define DGRAM_SIZE 65536
+
+// В младших битах user_data хранится тип операции.
+enum {
+  TAG_ACCEPT = 1,
+  TAG_RECV = 2,
+  TAG_SEND = 3,
+  TAG_DGRAM_RECV = 4,
+  TAG_DGRAM_SEND = 5,
+};
+#define TAG_MASK 7ULL
+
+struct UringLoop {
+  int fd;
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned sq_mask;
+  unsigned *sq_array;
+  unsigned sq_entries;
+  struct io_uring_sqe *sqes;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned cq_mask;
+  struct io_uring_cqe *cqes;
+
+  void *sq_ring;
+  size_t sq_ring_size;
+  void *cq_ring;
+  size_t cq_ring_size;
+  size_t sqes_size;
+
+  unsigned local_tail;  // ещё не опубликованный хвост SQ
+  unsigned pending;     // подготовленные, но не отправленные SQE
+  int single_recv;      // ядро без multishot recv (до 6.0): recv по одному
+
+  struct io_uring_buf_ring *buf_ring;
+  size_t buf_ring_size;
+  char *bufs;
+  unsigned buf_tail;
+};
+
+struct SendReq {
+  struct LoopConn *conn;
+  struct SendReq *next;
+  size_t len;
+  size_t off;  // уже отправлено
+  char data[];
+};
+
+static int SysSetup(unsigned entries, struct io_uring_params *p) {
+  return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int SysEnter(int fd, unsigned to_submit, unsigned min_complete,
+                    unsigned flags) {
+  return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                      NULL, 0);
+}
+
+static int SysRegister(int fd, unsigned opcode, void *arg, unsigned nr) {
+  return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr);
+}
+
+static void UringDestroy(struct UringLoop *ring) {
+  if (ring->bufs) free(ring->bufs);
+  if (ring->buf_ring) munmap(ring->buf_ring, ring->buf_ring_size);
+  if (ring->sqes) munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ring && ring->cq_ring != ring->sq_ring)
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  if (ring->sq_ring) munmap(ring->sq_ring, ring->sq_ring_size);
+  if (ring->fd >= 0) close(ring->fd);
+}
+
+static int UringInit(struct UringLoop *ring) {
+  memset(ring, 0, sizeof(*ring));
+  ring->fd = -1;
+
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  p.flags = IORING_SETUP_SINGLE_ISSUER;
+  int fd = SysSetup(RING_ENTRIES, &p);
+  if (fd < 0 && errno == EINVAL) {
+    // ядро старше 6.0 не знает SINGLE_ISSUER
+    memset(&p, 0, sizeof(p));
+    fd = SysSetup(RING_ENTRIES, &p);
+  }
+  if (fd < 0) return -1;
+  ring->fd = fd;
+
+  ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size =
+      p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (ring->cq_ring_size > ring->sq_ring_size)
+      ring->sq_ring_size = ring->cq_ring_size;
+    ring->cq_ring_size = ring->sq_ring_size;
+  }
+
+  ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ring == MAP_FAILED) {
+    ring->sq_ring = NULL;
+    goto fail;
+  }
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->cq_ring = ring->sq_ring;
+  } else {
+    ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ring == MAP_FAILED) {
+      ring->cq_ring = NULL;
+      goto fail;
+    }
+  }
+  ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    ring->sqes = NULL;
+    goto fail;
+  }
+
+  char *sq = ring->sq_ring;
+  char *cq = ring->cq_ring;
+  ring->sq_head = (unsigned *)(sq + p.sq_off.head);
+  ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+  ring->sq_mask = *(unsigned *)(sq + p.sq_off.ring_mask);
+  ring->sq_entries = *(unsigned *)(sq + p.sq_off.ring_entries);
+  ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+  ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+  ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+  ring->cq_mask = *(unsigned *)(cq + p.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+  ring->local_tail = *ring->sq_tail;
+  return 0;
+
+fail:
+  UringDestroy(ring);
+  return -1;
+}
+
+// Регистрирует кольцо буферов для multishot recv (ядро 5.19+).
+static int UringSetupBufRing(struct UringLoop *ring) {
+  ring->buf_ring_size = BUF_COUNT * sizeof(struct io_uring_buf);
+  ring->buf_ring = mmap(NULL, ring->buf_ring_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ring->buf_ring == MAP_FAILED) {
+    ring->buf_ring = NULL;
+    return -1;
+  }
+  if (posix_memalign((void **)&ring->bufs, 4096, (size_t)BUF_COUNT * BUF_SIZE))
+    return -1;
+
+  struct io_uring_buf_reg reg;
+  memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = (unsigned long)ring->buf_ring;
+  reg.ring_entries = BUF_COUNT;
+  reg.bgid = BUF_GROUP;
+  if (SysRegister(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) return -1;
+
+  for (unsigned i = 0; i < BUF_COUNT; i++) {
+    struct io_uring_buf *b = &ring->buf_ring->bufs[i];
+    b->addr = (unsigned long)(ring->bufs + (size_t)i * BUF_SIZE);
+    b->len = BUF_SIZE;
+    b->bid = (unsigned short)i;
+  }
+  ring->buf_tail = BUF_COUNT;
+  __atomic_store_n(&ring->buf_ring->tail, (unsigned short)ring->buf_tail,
+                   __ATOMIC_RELEASE);
+  return 0;
+}
+
+static void UringRecycleBuf(struct UringLoop *ring, unsigned bid) {
+  struct io_uring_buf *b =
+      &ring->buf_ring->bufs[ring->buf_tail & (BUF_COUNT - 1)];
+  b->addr = (unsigned long)(ring->bufs + (size_t)bid * BUF_SIZE);
+  b->len = BUF_SIZE;
+  b->bid = (unsigned short)bid;
+  ring->buf_tail++;
+  __atomic_store_n(&ring->buf_ring->tail, (unsigned short)ring->buf_tail,
+                   __ATOMIC_RELEASE);
+}
+
+static int UringSubmit(struct UringLoop *ring, unsigned wait_nr) {
+  __atomic_store_n(ring->sq_tail, ring->local_tail, __ATOMIC_RELEASE);
+  unsigned flags = wait_nr ? IORING_ENTER_GETEVENTS : 0;
+  unsigned to_submit = ring->pending;
+  ring->pending = 0;
+  if (to_submit == 0 && wait_nr == 0) return 0;
+  loop_stats.syscalls++;
+  int rc = SysEnter(ring->fd, to_submit, wait_nr, flags);
+  if (rc < 0 && errno != EINTR && errno != EBUSY) return -1;
+  return 0;
+}
+
+static struct io_uring_sqe *UringGetSqe(struct UringLoop *ring) {
+  unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+  if (ring->local_tail - head >= ring->sq_entries) {
+    UringSubmit(ring, 0);
+    head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (ring->local_tail - head >= ring->sq_entries) return NULL;
+  }
+  unsigned idx = ring->local_tail & ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[idx];
+  memset(sqe, 0, sizeof(*sqe));
+  ring->sq_array[idx] = idx;
+  ring->local_tail++;
+  ring->pending++;
+  return sqe;
+}
+
+static void PrepAccept(struct UringLoop *ring, int listen_fd) {
+  struct io_uring_sqe *sqe = UringGetSqe(ring);
+  if (sqe == NULL) return;
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = listen_fd;
+  sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  sqe->user_data = TAG_ACCEPT;
+}
+
+static void PrepRecv(struct UringLoop *ring, struct LoopConn *conn) {
+  struct io_uring_sqe *sqe = UringGetSqe(ring);
+  if (sqe == NULL) return;
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = conn->fd;
+  if (!ring->single_recv) sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = BUF_GROUP;
+  sqe->user_data = (unsigned long)conn | TAG_RECV;
+  conn->refs++;
+}
+
+// Отправляет остаток головы очереди. 0 - send поставлен.
+static int PrepSend(struct UringLoop *ring, struct LoopConn *conn) {
+  struct SendReq *req = conn->send_head;
+  struct io_uring_sqe *sqe = UringGetSqe(ring);
+  if (sqe == NULL) return -1;
+  sqe->opcode = IORING_OP_SEND;
+  sqe->fd = conn->fd;
+  sqe->addr = (unsigned long)(req->data + req->off);
+  sqe->len = (unsigned)(req->len - req->off);
+  sqe->msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+  sqe->user_data = (unsigned long)req | TAG_SEND;
+  conn->refs++;
+  conn->sending = 1;
+  return 0;
+}
+
+static void DropSends(struct LoopConn *conn) {
+  while (conn->send_head != NULL) {
+    struct SendReq *req = conn->send_head;
+    conn->send_head = req->next;
+    free(req);
+  }
+  conn->send_tail = NULL;
+}
+
+void UringSend(struct LoopConn *conn, const void *data, size_t len) {
+  struct SendReq *req = malloc(sizeof(*req) + len);
+  if (req == NULL) {
+    fprintf(stderr, "LoopSend: out of memory, response dropped\n");
+    return;
+  }
+  req->conn = conn;
+  req->next = NULL;
+  req->len = len;
+  req->off = 0;
+  memcpy(req->data, data, len);
+
+  if (conn->send_tail != NULL)
+    conn->send_tail->next = req;
+  else
+    conn->send_head = req;
+  conn->send_tail = req;
+  if (!conn->sending && PrepSend(conn->uring, conn) != 0) {
+    fprintf(stderr, "LoopSend: submission queue is full, closing\n");
+    DropSends(conn);
+    shutdown(conn->fd, SHUT_RDWR);
+  }
+}
+
+static void ConnRelease(struct LoopConn *conn) {
+  if (--conn->refs > 0 || !conn->recv_done) return;
+  loop_stats.syscalls++;
+  close(conn->fd);
+  LoopConnFree(conn);
+}
+
+static void HandleStreamCqe(struct UringLoop *ring, int listen_fd,
+                            struct io_uring_cqe *cqe, StreamHandler handler,
+                            void *user, int *unsupported) {
+  unsigned long tag = cqe->user_data & TAG_MASK;
+  void *ptr = (void *)(unsigned long)(cqe->user_data & ~TAG_MASK);
+  int more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+
+  switch (tag) {
+    case TAG_ACCEPT:
+      if (cqe->res >= 0) {
+        struct LoopConn *conn = calloc(1, sizeof(*conn));
+        if (conn == NULL) {
+          close(cqe->res);
+        } else {
+          conn->fd = cqe->res;
+          conn->backend = LOOP_BACKEND_URING;
+          conn->uring = ring;
+          loop_stats.accepted++;
+          LoopConnOpened(conn);
+          PrepRecv(ring, conn);
+        }
+      } else if (cqe->res == -EINVAL) {
+        // старое ядро (до 5.19): io_uring есть, а multishot accept нет - работаем
+        // через epoll; соединений через кольцо ещё не принято
+        fprintf(stderr, "io_uring: multishot accept is not supported\n");
+        *unsupported = 1;
+        return;
+      }
+      if (!more) PrepAccept(ring, listen_fd);
+      break;
+
+    case TAG_RECV: {
+      struct LoopConn *conn = ptr;
+      if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+        unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        if (!conn->recv_done &&
+            LoopConnFeed(conn, ring->bufs + (size_t)bid * BUF_SIZE,
+                         (size_t)cqe->res, handler, user) != 0)
+          // LoopClose: только чтение, поставленные send ещё уйдут
+          shutdown(conn->fd, conn->closing ? SHUT_RD : SHUT_RDWR);
+        UringRecycleBuf(ring, bid);
+      }
+      if (more) break;
+      int retry = cqe->res == -ENOBUFS || cqe->res > 0;
+      if (cqe->res == -EINVAL && !ring->single_recv) {
+        // 5.19: multishot accept есть, multishot recv ещё нет (6.0) -
+        // дальше recv с выбором буфера по одному
+        fprintf(stderr, "io_uring: multishot recv is not supported\n");
+        ring->single_recv = 1;
+        retry = 1;
+      }
+      // recv завершился: EOF/ошибка, кончились буферы или это был
+      // одиночный recv, и пора ставить следующий
+      if (retry) {
+        conn->refs--;
+        PrepRecv(ring, conn);
+        break;
+      }
+      conn->recv_done = 1;
+      ConnRelease(conn);
+      break;
+    }
+
+    case TAG_SEND: {
+      struct SendReq *req = ptr;
+      struct LoopConn *conn = req->conn;
+      conn->sending = 0;
+      if (cqe->res > 0) {
+        loop_stats.bytes_out += (size_t)cqe->res;
+        req->off += (size_t)cqe->res;
+        if (req->off == req->len) {
+          conn->send_head = req->next;
+          if (conn->send_head == NULL) conn->send_tail = NULL;
+          free(req);
+        }
+        // остаток короткой отправки или следующий ответ
+        if (conn->send_head != NULL && PrepSend(ring, conn) != 0) {
+          DropSends(conn);
+          shutdown(conn->fd, SHUT_RDWR);
+        }
+      } else {
+        // клиент ушёл: остальные ответы некому отдавать, multishot recv
+        // после shutdown вернёт 0
+        DropSends(conn);
+        shutdown(conn->fd, SHUT_RDWR);
+      }
+      ConnRelease(conn);
+      break;
+    }
+  }
+}
+
+static void DrainCq(struct UringLoop *ring,
+                    void (*fn)(struct UringLoop *, struct io_uring_cqe *,
+                               void *),
+                    void *ctx) {
+  unsigned head = *ring->cq_head;
+  unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+  while (head != tail) {
+    fn(ring, &ring->cqes[head & ring->cq_mask], ctx);
+    head++;
+  }
+  __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+struct StreamCtx {
+  int listen_fd;
+  StreamHandler handler;
+  void *user;
+  int unsupported;
+};
+
+static void StreamCqeThunk(struct UringLoop *ring, struct io_uring_cqe *cqe,
+                           void *arg) {
+  struct StreamCtx *ctx = arg;
+  HandleStreamCqe(ring, ctx->listen_fd, cqe, ctx->handler, ctx->user,
+                  &ctx->unsupported);
+}
+
+int RunStreamServerUring(int listen_fd, StreamHandler handler, void *user,
+                         int *fallback) {
+  struct UringLoop ring;
+  if (UringInit(&ring) != 0) {
+    *fallback = 1;
+    return -1;
+  }
+  if (UringSetupBufRing(&ring) != 0) {
+    UringDestroy(&ring);
+    *fallback = 1;
+    return -1;
+  }
+
+  struct StreamCtx ctx = {listen_fd, handler, user, 0};
+  PrepAccept(&ring, listen_fd);
+  int rc = 0;
+  while (!loop_stop && !ctx.unsupported) {
+    // одна io_uring_enter и отправляет накопленные SQE, и ждёт событий
+    if (UringSubmit(&ring, 1) != 0) {
+      perror("io_uring_enter");
+      rc = -1;
+      break;
+    }
+    DrainCq(&ring, StreamCqeThunk, &ctx);
+  }
+  if (ctx.unsupported) *fallback = 1;
+  // Открытые соединения закроются вместе с процессом.
+  UringDestroy(&ring);
+  return rc;
+}
+
+// --- датаграммы ---
+
+// Для UDP держим DGRAM_SLOTS одновременных recvmsg. Ответ и повторный
+// recvmsg того же слота отправляются одной связанной цепочкой.
+struct DgramSlot {
+  char buf[DGRAM_SIZE];
+  char reply[DGRAM_SIZE];
+  struct sockaddr_in from;
+  struct sockaddr_in to;
+  struct iovec in_iov;
+  struct iovec out_iov;
+  struct msghdr in_msg;
+  struct msghdr out_msg;
+};
+
+struct DgramCtx {
+  int fd;
+  DatagramHandler handler;
+  void *user;
+};
+
+static void PrepDgramRecv(struct UringLoop *ring, int fd,
+                          struct DgramSlot *slot) {
+  struct io_uring_sqe *sqe = UringGetSqe(ring);
+  if (sqe == NULL) return;
+  slot->in_iov.iov_base = slot->buf;
+  slot->in_iov.iov_len = DGRAM_SIZE;
+  memset(&slot->in_msg, 0, sizeof(slot->in_msg));
+  slot->in_msg.msg_name = &slot->from;
+  slot->in_msg.msg_namelen = sizeof(slot->from);
+  slot->in_msg.msg_iov = &slot->in_iov;
+  slot->in_msg.msg_iovlen = 1;
+  sqe->opcode = IORING_OP_RECVMSG;
+  sqe->fd = fd;
+  sqe->addr = (unsigned long)&slot->in_msg;
+  sqe->len = 1;
+  sqe->user_data = (unsigned long)slot | TAG_DGRAM_RECV;
+}
+
+static void DgramCqeThunk(struct UringLoop *ring, struct io_uring_cqe *cqe,
+                          void *arg) {
+  struct DgramCtx *ctx = arg;
+  unsigned long tag = cqe->user_data & TAG_MASK;
+  struct DgramSlot *slot =
+      (struct DgramSlot *)(unsigned long)(cqe->user_data & ~TAG_MASK);
+
+  if (tag == TAG_DGRAM_SEND) {
+    if (cqe->res >= 0) loop_stats.bytes_out += (size_t)cqe->res;
+    return;
+  }
+  if (cqe->res < 0) {
+    if (cqe->res != -ECANCELED) fprintf(stderr, "recvmsg: %s\n",
+                                        strerror(-cqe->res));
+    PrepDgramRecv(ring, ctx->fd, slot);
+    return;
+  }
+
+  loop_stats.messages++;
+  loop_stats.bytes_in += (size_t)cqe->res;
+  size_t reply_len = ctx->handler(slot->buf, (size_t)cqe->res, &slot->from,
+                                  slot->reply, DGRAM_SIZE, ctx->user);
+  if (reply_len > 0) {
+    struct io_uring_sqe *sqe = UringGetSqe(ring);
+    if (sqe != NULL) {
+      slot->to = slot->from;
+      slot->out_iov.iov_base = slot->reply;
+      slot->out_iov.iov_len = reply_len;
+      memset(&slot->out_msg, 0, sizeof(slot->out_msg));
+      slot->out_msg.msg_name = &slot->to;
+      slot->out_msg.msg_namelen = sizeof(slot->to);
+      slot->out_msg.msg_iov = &slot->out_iov;
+      slot->out_msg.msg_iovlen = 1;
+      sqe->opcode = IORING_OP_SENDMSG;
+      sqe->fd = ctx->fd;
+      sqe->addr = (unsigned long)&slot->out_msg;
+      sqe->len = 1;
+      sqe->flags = IOSQE_IO_LINK;
+      sqe->user_data = (unsigned long)slot | TAG_DGRAM_SEND;
+    }
+  }
+  PrepDgramRecv(ring, ctx->fd, slot);
+}
+
+int RunDatagramServerUring(int fd, DatagramHandler handler, void *user,
+                           int *fallback) {
+  struct UringLoop ring;
+  if (UringInit(&ring) != 0) {
+    *fallback = 1;
+    return -1;
+  }
+  struct DgramSlot *slots = calloc(DGRAM_SLOTS, sizeof(*slots));
+  if (slots == NULL) {
+    UringDestroy(&ring);
+    return -1;
+  }
+
+  struct DgramCtx ctx = {fd, handler, user};
+  for (int i = 0; i < DGRAM_SLOTS; i++) PrepDgramRecv(&ring, fd, &slots[i]);
+
+  int rc = 0;
+  while (!loop_stop) {
+    if (UringSubmit(&ring, 1) != 0) {
+      perror("io_uring_enter");
+      rc = -1;
+      break;
+    }
+    DrainCq(&ring, DgramCqeThunk, &ctx);
+  }
+
+  UringDestroy(&ring);
+  free(slots);
+  return rc;
+}
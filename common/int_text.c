@@ -0,0 +1,153 @@
+#include "int_text.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static int IsSpace(unsigned char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+void IntTextSplit(const char *text, size_t len, int parts, size_t *bounds) {
+  bounds[0] = 0;
+  for (int k = 1; k < parts; k++) {
+    size_t p = len / (size_t)parts * (size_t)k;
+    if (p < bounds[k - 1]) p = bounds[k - 1];
+    while (p < len && !IsSpace((unsigned char)text[p])) p++;
+    bounds[k] = p;
+  }
+  bounds[parts] = len;
+}
+
+size_t IntTextCount(const char *p, size_t len) {
+  size_t count = 0;
+  int prev_space = 1;
+  size_t i = 0;
+#if defined(__SSE2__)
+  // маска непробельных байтов; число начинается там, где перед
+  // непробельным байтом стоит пробельный
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i nl = _mm_set1_epi8('\n');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i cr = _mm_set1_epi8('\r');
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+    __m128i ws = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, nl)),
+        _mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_cmpeq_epi8(v, cr)));
+    unsigned int word = ~(unsigned int)_mm_movemask_epi8(ws) & 0xFFFF;
+    unsigned int starts = word & ~((word << 1) | (unsigned int)!prev_space);
+    count += (size_t)__builtin_popcount(starts);
+    prev_space = !(word & 0x8000);
+  }
+#endif
+  for (; i < len; i++) {
+    int is_space = IsSpace((unsigned char)p[i]);
+    if (!is_space && prev_space) count++;
+    prev_space = is_space;
+  }
+  return count;
+}
+
+// 1, если все 8 байт - цифры '0'..'9'
+static int AllDigits8(uint64_t x) {
+  return ((x & 0xF0F0F0F0F0F0F0F0ULL) == 0x3030303030303030ULL) &&
+         (((x + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) ==
+          0x3030303030303030ULL);
+}
+
+// Восемь ASCII-цифр (первая - в младшем байте) в число 0..99999999.
+static uint32_t Parse8(uint64_t x) {
+  x &= 0x0F0F0F0F0F0F0F0FULL;
+  x = (x * 10 + (x >> 8)) & 0x00FF00FF00FF00FFULL;
+  x = (x * 100 + (x >> 16)) & 0x0000FFFF0000FFFFULL;
+  x = (x * 10000 + (x >> 32)) & 0x00000000FFFFFFFFULL;
+  return (uint32_t)x;
+}
+
+enum IntTextStatus IntTextNext(const char **pos, const char *end,
+                               int64_t *value) {
+  const char *p = *pos;
+  while (p < end && IsSpace((unsigned char)*p)) p++;
+  if (p == end) {
+    *pos = p;
+    return INT_TEXT_END;
+  }
+
+  const char *token = p;  // при ошибке *pos указывает сюда
+  int negative = 0;
+  if (*p == '-' || *p == '+') {
+    negative = *p == '-';
+    p++;
+  }
+  const char *digits = p;
+  // модуль копим в uint64_t: |INT64_MIN| = INT64_MAX + 1
+  uint64_t acc = 0;
+  const uint64_t limit = (uint64_t)INT64_MAX + (uint64_t)negative;
+  while (end - p >= 8) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    if (!AllDigits8(word)) break;
+    uint32_t chunk = Parse8(word);
+    if (acc > (limit - chunk) / 100000000ULL) {
+      *pos = token;
+      return INT_TEXT_OVERFLOW;
+    }
+    acc = acc * 100000000ULL + chunk;
+    p += 8;
+  }
+  for (; p < end && (unsigned char)(*p - '0') < 10; p++) {
+    unsigned int d = (unsigned int)(*p - '0');
+    if (acc > (limit - d) / 10) {
+      *pos = token;
+      return INT_TEXT_OVERFLOW;
+    }
+    acc = acc * 10 + d;
+  }
+  if (p == digits || (p < end && !IsSpace((unsigned char)*p))) {
+    *pos = token;
+    return INT_TEXT_BAD;
+  }
+  *value = negative ? (int64_t)(0 - acc) : (int64_t)acc;
+  *pos = p;
+  return INT_TEXT_OK;
+}
+
+size_t IntTextLength(int64_t value) {
+  uint64_t v = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+  size_t len = value < 0 ? 2 : 1;
+  while (v >= 10) {
+    v /= 10;
+    len++;
+  }
+  return len;
+}
+
+char *IntTextFormat(int64_t value, char *out) {
+  static const char kPairs[] =
+      "00010203040506070809101112131415161718192021222324252627282930313233"
+      "34353637383940414243444546474849505152535455565758596061626364656667"
+      "6869707172737475767778798081828384858687888990919293949596979899";
+  uint64_t v = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+  if (value < 0) *out++ = '-';
+  char tmp[20];
+  char *t = tmp + sizeof(tmp);
+  // по две цифры за деление
+  while (v >= 100) {
+    unsigned int pair = (unsigned int)(v % 100) * 2;
+    v /= 100;
+    *--t = kPairs[pair + 1];
+    *--t = kPairs[pair];
+  }
+  if (v >= 10) {
+    *--t = kPairs[v * 2 + 1];
+    *--t = kPairs[v * 2];
+  } else {
+    *--t = (char)('0' + v);
+  }
+  size_t n = (size_t)(tmp + sizeof(tmp) - t);
+  memcpy(out, t, n);
+  return out + n;
+}
@@ -0,0 +1,37 @@
+#ifndef INT_TEXT_H
+#define INT_TEXT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Разбор и печать целых в тексте: числа разделены пробельными символами
+// (пробел, \t, \n, \r), допускается знак '-' или '+'.
+//
+// Границы чисел ищутся SSE2 по 16 байт, цифры переводятся по 8 за раз
+// (SWAR: одно 64-битное слово - восемь ASCII-цифр). Текст можно делить
+// на куски по пробельным символам и разбирать кусками параллельно.
+
+enum IntTextStatus {
+  INT_TEXT_END = 0,       // чисел больше нет
+  INT_TEXT_OK = 1,
+  INT_TEXT_OVERFLOW = -1, // не помещается в int64_t
+  INT_TEXT_BAD = -2,      // посторонний символ
+};
+
+// Делит [0, len) на parts кусков; bounds[0..parts] - границы, каждая
+// внутренняя сдвинута вперёд до пробельного символа, чтобы не резать число.
+void IntTextSplit(const char *text, size_t len, int parts, size_t *bounds);
+
+// Число чисел (серий непробельных символов) в [p, p + len).
+size_t IntTextCount(const char *p, size_t len);
+
+// Разбирает следующее число начиная с *pos (не дальше end) в *value.
+// *pos сдвигается за число; при ошибке - на начало ошибочного числа.
+enum IntTextStatus IntTextNext(const char **pos, const char *end,
+                               int64_t *value);
+
+// Длина десятичной записи и сама запись (без завершающего нуля).
+size_t IntTextLength(int64_t value);
+char *IntTextFormat(int64_t value, char *out);
+
+#endif
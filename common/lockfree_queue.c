@@ -0,0 +1,151 @@
+#include "lockfree_queue.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+static size_t RoundUpPow2(size_t x) {
+  size_t p = 2;
+  while (p < x) p <<= 1;
+  return p;
+}
+
+int MpmcInit(struct MpmcQueue *q, size_t capacity) {
+  capacity = RoundUpPow2(capacity);
+  q->cells = malloc(sizeof(struct MpmcCell) * capacity);
+  if (q->cells == NULL) return -1;
+  for (size_t i = 0; i < capacity; i++)
+    atomic_store_explicit(&q->cells[i].seq, i, memory_order_relaxed);
+  q->mask = capacity - 1;
+  atomic_store(&q->enqueue_pos, 0);
+  atomic_store(&q->dequeue_pos, 0);
+  return 0;
+}
+
+void MpmcDestroy(struct MpmcQueue *q) {
+  free(q->cells);
+  q->cells = NULL;
+}
+
+// Ячейка pos свободна для записи на этом круге, если seq == pos, и
+// заполнена для чтения, если seq == pos + 1. Сколько подряд ячеек с
+// нужным состоянием, начиная с pos (не больше count)?
+static size_t ReadyRun(const struct MpmcQueue *q, size_t pos, size_t count,
+                       size_t lag) {
+  size_t n = 0;
+  while (n < count && n <= q->mask) {
+    const struct MpmcCell *cell = &q->cells[(pos + n) & q->mask];
+    if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + n + lag)
+      break;
+    n++;
+  }
+  return n;
+}
+
+size_t MpmcPushBatch(struct MpmcQueue *q, void *const *items, size_t count) {
+  size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+  size_t n;
+  for (;;) {
+    n = ReadyRun(q, pos, count, 0);
+    if (n == 0) {
+      // ячейка занята: либо очередь полна, либо pos устарел
+      size_t seq = atomic_load_explicit(&q->cells[pos & q->mask].seq,
+                                        memory_order_acquire);
+      if ((intptr_t)(seq - pos) < 0) return 0;
+      pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+      continue;
+    }
+    // Пока enqueue_pos не сдвинут, готовые ячейки никто другой не займёт.
+    if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + n,
+                                              memory_order_relaxed,
+                                              memory_order_relaxed))
+      break;
+  }
+  for (size_t i = 0; i < n; i++) {
+    struct MpmcCell *cell = &q->cells[(pos + i) & q->mask];
+    cell->data = items[i];
+    atomic_store_explicit(&cell->seq, pos + i + 1, memory_order_release);
+  }
+  return n;
+}
+
+size_t MpmcPopBatch(struct MpmcQueue *q, void **items, size_t count) {
+  size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+  size_t n;
+  for (;;) {
+    n = ReadyRun(q, pos, count, 1);
+    if (n == 0) {
+      size_t seq = atomic_load_explicit(&q->cells[pos & q->mask].seq,
+                                        memory_order_acquire);
+      if ((intptr_t)(seq - (pos + 1)) < 0) return 0;
+      pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+      continue;
+    }
+    if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + n,
+                                              memory_order_relaxed,
+                                              memory_order_relaxed))
+      break;
+  }
+  for (size_t i = 0; i < n; i++) {
+    struct MpmcCell *cell = &q->cells[(pos + i) & q->mask];
+    items[i] = cell->data;
+    // ячейка освобождается для следующего круга
+    atomic_store_explicit(&cell->seq, pos + i + q->mask + 1,
+                          memory_order_release);
+  }
+  return n;
+}
+
+int MpmcPush(struct MpmcQueue *q, void *item) {
+  return MpmcPushBatch(q, &item, 1) == 1 ? 0 : -1;
+}
+
+int MpmcPop(struct MpmcQueue *q, void **item) {
+  return MpmcPopBatch(q, item, 1) == 1 ? 0 : -1;
+}
+
+int SpscInit(struct SpscQueue *q, size_t capacity) {
+  capacity = RoundUpPow2(capacity);
+  q->slots = malloc(sizeof(void *) * capacity);
+  if (q->slots == NULL) return -1;
+  q->mask = capacity - 1;
+  atomic_store(&q->head, 0);
+  atomic_store(&q->tail, 0);
+  q->cached_head = q->cached_tail = 0;
+  return 0;
+}
+
+void SpscDestroy(struct SpscQueue *q) {
+  free(q->slots);
+  q->slots = NULL;
+}
+
+size_t SpscPushBatch(struct SpscQueue *q, void *const *items, size_t count) {
+  size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  size_t capacity = q->mask + 1;
+  if (tail - q->cached_head + count > capacity)
+    q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+  size_t free_slots = capacity - (tail - q->cached_head);
+  size_t n = count < free_slots ? count : free_slots;
+  for (size_t i = 0; i < n; i++) q->slots[(tail + i) & q->mask] = items[i];
+  atomic_store_explicit(&q->tail, tail + n, memory_order_release);
+  return n;
+}
+
+size_t SpscPopBatch(struct SpscQueue *q, void **items, size_t count) {
+  size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+  if (q->cached_tail - head < count)
+    q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+  size_t available = q->cached_tail - head;
+  size_t n = count < available ? count : available;
+  for (size_t i = 0; i < n; i++) items[i] = q->slots[(head + i) & q->mask];
+  atomic_store_explicit(&q->head, head + n, memory_order_release);
+  return n;
+}
+
+int SpscPush(struct SpscQueue *q, void *item) {
+  return SpscPushBatch(q, &item, 1) == 1 ? 0 : -1;
+}
+
+int SpscPop(struct SpscQueue *q, void **item) {
+  return SpscPopBatch(q, item, 1) == 1 ? 0 : -1;
+}
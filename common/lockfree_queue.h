@@ -0,0 +1,64 @@
+#ifndef LOCKFREE_QUEUE_H
+#define LOCKFREE_QUEUE_H
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Ограниченные очереди указателей без блокировок.
+//
+// MpmcQueue - кольцо Вьюкова для многих производителей и потребителей:
+// у каждой ячейки свой счётчик seq, по которому видно, свободна она на
+// этом круге или уже заполнена. Производители и потребители соревнуются
+// только за свой индекс (одна CAS на операцию или на пакет).
+//
+// SpscQueue - кольцо для одного производителя и одного потребителя:
+// только load/store, каждая сторона кэширует индекс другой стороны и
+// перечитывает его, лишь когда кольцо кажется полным (пустым).
+//
+// Индексы лежат в разных кэш-линиях, чтобы стороны не мешали друг другу.
+// Ёмкость округляется вверх до степени двойки.
+
+#define QUEUE_CACHE_LINE 64
+
+struct MpmcCell {
+  atomic_size_t seq;
+  void *data;
+};
+
+struct MpmcQueue {
+  alignas(QUEUE_CACHE_LINE) atomic_size_t enqueue_pos;
+  alignas(QUEUE_CACHE_LINE) atomic_size_t dequeue_pos;
+  alignas(QUEUE_CACHE_LINE) struct MpmcCell *cells;
+  size_t mask;
+};
+
+int MpmcInit(struct MpmcQueue *q, size_t capacity);
+void MpmcDestroy(struct MpmcQueue *q);
+
+// 0 - успех, -1 - очередь полна (пуста).
+int MpmcPush(struct MpmcQueue *q, void *item);
+int MpmcPop(struct MpmcQueue *q, void **item);
+
+// Пакетные версии занимают сразу несколько подряд идущих ячеек одной CAS.
+// Возвращают число помещённых (извлечённых) элементов, от 0 до count.
+size_t MpmcPushBatch(struct MpmcQueue *q, void *const *items, size_t count);
+size_t MpmcPopBatch(struct MpmcQueue *q, void **items, size_t count);
+
+struct SpscQueue {
+  alignas(QUEUE_CACHE_LINE) atomic_size_t head;  // пишет потребитель
+  size_t cached_tail;
+  alignas(QUEUE_CACHE_LINE) atomic_size_t tail;  // пишет производитель
+  size_t cached_head;
+  alignas(QUEUE_CACHE_LINE) void **slots;
+  size_t mask;
+};
+
+int SpscInit(struct SpscQueue *q, size_t capacity);
+void SpscDestroy(struct SpscQueue *q);
+int SpscPush(struct SpscQueue *q, void *item);
+int SpscPop(struct SpscQueue *q, void **item);
+size_t SpscPushBatch(struct SpscQueue *q, void *const *items, size_t count);
+size_t SpscPopBatch(struct SpscQueue *q, void **items, size_t count);
+
+#endif
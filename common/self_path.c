@@ -0,0 +1,30 @@
+#define _GNU_SOURCE
+#include "self_path.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+int SiblingPath(const char *argv0, const char *name, char *path,
+                size_t size) {
+  char self[4096];
+  ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+  const char *exe = argv0;
+  if (len > 0) {
+    self[len] = '\0';
+    exe = self;
+  }
+  const char *slash = exe != NULL ? strrchr(exe, '/') : NULL;
+  if (slash == NULL) {
+    // запущены через PATH без /proc: каталог неизвестен, "./" не угадываем
+    errno = ENOENT;
+    return -1;
+  }
+  int n = snprintf(path, size, "%.*s/%s", (int)(slash - exe), exe, name);
+  if (n < 0 || (size_t)n >= size) {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+  return 0;
+}
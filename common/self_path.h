@@ -0,0 +1,13 @@
+#ifndef SELF_PATH_H
+#define SELF_PATH_H
+
+#include <stddef.h>
+
+// Путь к программе name, лежащей в одном каталоге с нашим исполняемым
+// файлом, - чтобы exec рабочего не зависел от текущего каталога.
+// Каталог берётся из /proc/self/exe, без него - из argv0 (если в нём
+// есть '/'; argv0 == NULL - только /proc/self/exe).
+// 0 - успех, -1 - каталог не определить или путь не влез в size.
+int SiblingPath(const char *argv0, const char *name, char *path, size_t size);
+
+#endif
@@ -0,0 +1,131 @@
+#define _GNU_SOURCE
+#include "shm_array.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SHM_MAGIC "MINMAXSH"
+
+static size_t HeaderSize(uint32_t workers) {
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t bytes = SHM_SLOT_SIZE + (size_t)workers * SHM_SLOT_SIZE;
+  return (bytes + page - 1) / page * page;
+}
+
+static int MapSegment(struct ShmArray *shm, int data_prot) {
+  shm->header = mmap(NULL, shm->header_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED, shm->fd, 0);
+  if (shm->header == MAP_FAILED) {
+    shm->header = NULL;
+    return -1;
+  }
+  if (shm->data_size == 0) return 0;
+  shm->data = mmap(NULL, shm->data_size, data_prot, MAP_SHARED, shm->fd,
+                   (off_t)shm->header_size);
+  if (shm->data == MAP_FAILED) {
+    shm->data = NULL;
+    munmap(shm->header, shm->header_size);
+    shm->header = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+int ShmArrayCreate(struct ShmArray *shm, const char *name, size_t count,
+                   int workers) {
+  memset(shm, 0, sizeof(*shm));
+  shm->owner = 1;
+  if (name == NULL) {
+    // без MFD_CLOEXEC: дескриптор должен пережить exec рабочего
+    shm->fd = memfd_create("minmax_array", 0);
+  } else {
+    shm->fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    // имя запоминаем только своё, чтобы не удалить чужой объект
+    if (shm->fd >= 0) snprintf(shm->name, sizeof(shm->name), "%s", name);
+  }
+  if (shm->fd < 0) return -1;
+
+  shm->header_size = HeaderSize((uint32_t)workers);
+  shm->data_size = count * sizeof(int);
+  if (ftruncate(shm->fd, (off_t)(shm->header_size + shm->data_size)) < 0 ||
+      MapSegment(shm, PROT_READ | PROT_WRITE) < 0) {
+    int err = errno;
+    ShmArrayClose(shm);
+    errno = err;
+    return -1;
+  }
+  memcpy(shm->header->magic, SHM_MAGIC, 8);
+  shm->header->count = count;
+  shm->header->workers = (uint32_t)workers;
+  shm->header->data_offset = shm->header_size;
+  return 0;
+}
+
+int ShmArrayAttach(struct ShmArray *shm, const char *spec) {
+  memset(shm, 0, sizeof(*shm));
+  if (strncmp(spec, "fd:", 3) == 0) {
+    shm->fd = dup(atoi(spec + 3));
+  } else {
+    snprintf(shm->name, sizeof(shm->name), "%s", spec);
+    shm->fd = shm_open(spec, O_RDWR, 0);
+  }
+  if (shm->fd < 0) return -1;
+
+  struct ShmHeader header;
+  struct stat st;
+  if (pread(shm->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+      memcmp(header.magic, SHM_MAGIC, 8) != 0 || fstat(shm->fd, &st) < 0 ||
+      header.data_offset != HeaderSize(header.workers) ||
+      (uint64_t)st.st_size < header.data_offset + header.count * sizeof(int)) {
+    close(shm->fd);
+    shm->fd = -1;
+    errno = EINVAL;
+    return -1;
+  }
+  shm->header_size = header.data_offset;
+  shm->data_size = header.count * sizeof(int);
+  if (MapSegment(shm, PROT_READ) < 0) {
+    int err = errno;
+    close(shm->fd);
+    shm->fd = -1;
+    errno = err;
+    return -1;
+  }
+  return 0;
+}
+
+void ShmArraySpec(const struct ShmArray *shm, char *buf, size_t len) {
+  if (shm->name[0] != '\0')
+    snprintf(buf, len, "%s", shm->name);
+  else
+    snprintf(buf, len, "fd:%d", shm->fd);
+}
+
+struct ShmResult *ShmArrayResult(const struct ShmArray *shm, int worker) {
+  return (struct ShmResult *)((char *)shm->header + SHM_SLOT_SIZE +
+                              (size_t)worker * SHM_SLOT_SIZE);
+}
+
+void ShmArrayChunk(const struct ShmArray *shm, int worker, size_t *begin,
+                   size_t *end) {
+  size_t count = shm->header->count;
+  size_t workers = shm->header->workers;
+  size_t chunk = count / workers;
+  *begin = (size_t)worker * chunk;
+  *end = (size_t)worker == workers - 1 ? count : *begin + chunk;
+}
+
+void ShmArrayClose(struct ShmArray *shm) {
+  if (shm->data != NULL) munmap(shm->data, shm->data_size);
+  if (shm->header != NULL) munmap(shm->header, shm->header_size);
+  if (shm->fd >= 0) close(shm->fd);
+  if (shm->owner && shm->name[0] != '\0') shm_unlink(shm->name);
+  memset(shm, 0, sizeof(*shm));
+  shm->fd = -1;
+}
@@ -0,0 +1,70 @@
+#ifndef SHM_ARRAY_H
+#define SHM_ARRAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Массив int в разделяемом сегменте (memfd или shm_open) для процессов,
+// запущенных через fork/exec. Родитель создаёт сегмент и заполняет
+// массив один раз; рабочие процессы отображают данные только на чтение
+// и пишут результаты в слоты того же сегмента. Падение рабочего не
+// портит ни массив, ни чужие результаты.
+//
+//   [заголовок] [слот результата 0] ... [слот workers-1] [массив]
+//
+// Слоты - по кэш-линии на рабочего, массив начинается с границы страницы,
+// чтобы его можно было отобразить отдельно с PROT_READ.
+//
+// Сегмент передаётся рабочему строкой spec:
+//   fd:<N>  - унаследованный дескриптор memfd (без O_CLOEXEC);
+//   /<имя>  - объект shm_open.
+
+#define SHM_SLOT_SIZE 64
+
+struct ShmHeader {
+  char magic[8];
+  uint64_t count;
+  uint32_t workers;
+  uint32_t reserved;
+  uint64_t data_offset;
+};
+
+struct ShmResult {
+  int32_t min;
+  int32_t max;
+  int64_t sum;
+  int32_t done;  // 1 - рабочий записал результат
+  int32_t pid;
+};
+
+struct ShmArray {
+  int fd;
+  int owner;           // создатель удаляет имя при закрытии
+  char name[64];       // пусто - memfd
+  struct ShmHeader *header;  // заголовок и слоты, на запись
+  size_t header_size;
+  int *data;           // у рабочих - только чтение
+  size_t data_size;
+};
+
+// name == NULL - анонимный memfd, иначе имя для shm_open ("/...").
+// 0 - успех, -1 - ошибка (errno сохранён).
+int ShmArrayCreate(struct ShmArray *shm, const char *name, size_t count,
+                   int workers);
+
+// Подключается к сегменту по spec, массив - только на чтение.
+int ShmArrayAttach(struct ShmArray *shm, const char *spec);
+
+// Строка для передачи рабочему через argv.
+void ShmArraySpec(const struct ShmArray *shm, char *buf, size_t len);
+
+struct ShmResult *ShmArrayResult(const struct ShmArray *shm, int worker);
+
+// Кусок [begin, end) рабочего worker; последний забирает остаток.
+void ShmArrayChunk(const struct ShmArray *shm, int worker, size_t *begin,
+                   size_t *end);
+
+// Снимает отображения; у создателя ещё и удаляет имя shm_open.
+void ShmArrayClose(struct ShmArray *shm);
+
+#endif
@@ -0,0 +1,37 @@
+#include "shm_worker.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "find_min_max.h"
+#include "shm_array.h"
+#include "trace.h"
+
+int RunShmWorker(const char *spec, const char *worker_arg) {
+  TraceInitFromEnv("sequential_min_max");
+  struct ShmArray shm;
+  if (ShmArrayAttach(&shm, spec) != 0) {
+    perror("shm attach");
+    return 1;
+  }
+  int worker = atoi(worker_arg);
+  if (worker < 0 || (unsigned int)worker >= shm.header->workers) {
+    printf("worker index out of range\n");
+    ShmArrayClose(&shm);
+    return 1;
+  }
+
+  size_t begin, end;
+  ShmArrayChunk(&shm, worker, &begin, &end);
+  TraceBeginArg("chunk", "worker", worker);
+  struct MinMax min_max = GetMinMax(shm.data, begin, end);
+  TraceEnd("chunk");
+  struct ShmResult *result = ShmArrayResult(&shm, worker);
+  result->min = min_max.min;
+  result->max = min_max.max;
+  result->pid = getpid();
+  __atomic_store_n(&result->done, 1, __ATOMIC_RELEASE);
+  ShmArrayClose(&shm);
+  return 0;
+}
@@ -0,0 +1,14 @@
+#ifndef SHM_WORKER_H
+#define SHM_WORKER_H
+
+// Тело рабочего sequential_min_max --shm <spec> <worker> (lab3, lab4):
+// подключается к сегменту из shm_array.h, считает min/max своего куска
+// и пишет результат в свой слот. Генерировать или копировать массив не
+// нужно - его уже заполнил родитель.
+//
+// GetMinMax берётся из find_min_max.h лабораторной, которая собирает
+// этот файл. TRACE_FILE включает трассировку куска ("chunk").
+// Возвращает код выхода процесса: 0 - результат записан.
+int RunShmWorker(const char *spec, const char *worker_arg);
+
+#endif
@@ -0,0 +1,165 @@
+#define _GNU_SOURCE
+#include "sync_locks.h"
+
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static void CpuRelax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+// Ожидание внутри спин-блокировок: pause, а после лимита - sched_yield.
+static void SpinWait(int *spins) {
+  if (++*spins < SYNC_SPIN_LIMIT) {
+    CpuRelax();
+  } else {
+    sched_yield();
+  }
+}
+
+static void FutexWait(atomic_int *addr, int expected) {
+  syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void FutexWake(atomic_int *addr, int count) {
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+// --- AdaptiveMutex (схема Дреппера "Futexes are tricky", mutex3) ---
+
+int AdaptiveMutexTryLock(struct AdaptiveMutex *m) {
+  int expected = 0;
+  return atomic_compare_exchange_strong_explicit(
+             &m->state, &expected, 1, memory_order_acquire,
+             memory_order_relaxed)
+             ? 0
+             : -1;
+}
+
+void AdaptiveMutexLock(struct AdaptiveMutex *m) {
+  for (int i = 0; i < SYNC_SPIN_LIMIT; i++) {
+    if (atomic_load_explicit(&m->state, memory_order_relaxed) == 0 &&
+        AdaptiveMutexTryLock(m) == 0)
+      return;
+    CpuRelax();
+  }
+  // Помечаем мьютекс как «есть ожидающие» и спим, пока он занят.
+  while (atomic_exchange_explicit(&m->state, 2, memory_order_acquire) != 0)
+    FutexWait(&m->state, 2);
+}
+
+void AdaptiveMutexUnlock(struct AdaptiveMutex *m) {
+  if (atomic_fetch_sub_explicit(&m->state, 1, memory_order_release) != 1) {
+    atomic_store_explicit(&m->state, 0, memory_order_release);
+    FutexWake(&m->state, 1);
+  }
+}
+
+// --- TicketLock ---
+
+void TicketLockInit(struct TicketLock *l) {
+  atomic_init(&l->next, 0);
+  atomic_init(&l->serving, 0);
+}
+
+void TicketLockLock(struct TicketLock *l) {
+  unsigned my = atomic_fetch_add_explicit(&l->next, 1, memory_order_relaxed);
+  int spins = 0;
+  while (atomic_load_explicit(&l->serving, memory_order_acquire) != my)
+    SpinWait(&spins);
+}
+
+void TicketLockUnlock(struct TicketLock *l) {
+  unsigned cur = atomic_load_explicit(&l->serving, memory_order_relaxed);
+  atomic_store_explicit(&l->serving, cur + 1, memory_order_release);
+}
+
+// --- McsLock ---
+
+void McsLockInit(struct McsLock *l) { atomic_init(&l->tail, NULL); }
+
+void McsLockLock(struct McsLock *l, struct McsNode *node) {
+  atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+  atomic_store_explicit(&node->locked, 1, memory_order_relaxed);
+  struct McsNode *prev =
+      atomic_exchange_explicit(&l->tail, node, memory_order_acq_rel);
+  if (prev == NULL) return;
+  atomic_store_explicit(&prev->next, node, memory_order_release);
+  int spins = 0;
+  while (atomic_load_explicit(&node->locked, memory_order_acquire))
+    SpinWait(&spins);
+}
+
+void McsLockUnlock(struct McsLock *l, struct McsNode *node) {
+  struct McsNode *next = atomic_load_explicit(&node->next, memory_order_acquire);
+  if (next == NULL) {
+    struct McsNode *expected = node;
+    if (atomic_compare_exchange_strong_explicit(&l->tail, &expected, NULL,
+                                                memory_order_release,
+                                                memory_order_relaxed))
+      return;
+    // преемник уже встал в очередь, но ещё не записал себя в next
+    int spins = 0;
+    while ((next = atomic_load_explicit(&node->next, memory_order_acquire)) ==
+           NULL)
+      SpinWait(&spins);
+  }
+  atomic_store_explicit(&next->locked, 0, memory_order_release);
+}
+
+// --- RwLock ---
+
+void RwLockInit(struct RwLock *l) {
+  for (int i = 0; i < RW_SLOTS; i++) atomic_init(&l->slots[i].readers, 0);
+  atomic_init(&l->writer, 0);
+  atomic_init(&l->writers.state, 0);
+}
+
+int RwReadLock(struct RwLock *l) {
+  int cpu = sched_getcpu();
+  int slot = (cpu < 0 ? 0 : cpu) % RW_SLOTS;
+  int spins = 0;
+  for (;;) {
+    while (atomic_load_explicit(&l->writer, memory_order_acquire))
+      SpinWait(&spins);
+    atomic_fetch_add_explicit(&l->slots[slot].readers, 1, memory_order_seq_cst);
+    // писатель мог выставить флаг между проверкой и увеличением
+    if (!atomic_load_explicit(&l->writer, memory_order_seq_cst)) return slot;
+    atomic_fetch_sub_explicit(&l->slots[slot].readers, 1, memory_order_release);
+  }
+}
+
+void RwReadUnlock(struct RwLock *l, int slot) {
+  atomic_fetch_sub_explicit(&l->slots[slot].readers, 1, memory_order_release);
+}
+
+static int NoReaders(struct RwLock *l) {
+  for (int i = 0; i < RW_SLOTS; i++)
+    if (atomic_load_explicit(&l->slots[i].readers, memory_order_seq_cst))
+      return 0;
+  return 1;
+}
+
+// Приоритет у читателей: флаг выставляется, только когда читателей нет,
+// а если кто-то успел войти, писатель снимает флаг и ждёт дальше.
+void RwWriteLock(struct RwLock *l) {
+  AdaptiveMutexLock(&l->writers);
+  int spins = 0;
+  for (;;) {
+    while (!NoReaders(l)) SpinWait(&spins);
+    atomic_store_explicit(&l->writer, 1, memory_order_seq_cst);
+    if (NoReaders(l)) return;
+    atomic_store_explicit(&l->writer, 0, memory_order_seq_cst);
+  }
+}
+
+void RwWriteUnlock(struct RwLock *l) {
+  atomic_store_explicit(&l->writer, 0, memory_order_release);
+  AdaptiveMutexUnlock(&l->writers);
+}
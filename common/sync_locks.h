@@ -0,0 +1,77 @@
+#ifndef SYNC_LOCKS_H
+#define SYNC_LOCKS_H
+
+#include <stdalign.h>
+#include <stdatomic.h>
+
+// Примитивы синхронизации поверх атомиков и futex (только Linux).
+//
+// AdaptiveMutex - futex-мьютекс из трёх состояний (свободен / занят /
+//   занят и есть спящие): сначала ограниченно крутится, потом засыпает в
+//   ядре. Освобождение без ожидающих обходится без системного вызова.
+// TicketLock - честная очередь по номерам (FIFO), все ждут на одной линии.
+// McsLock - очередь MCS: каждый ждёт на своём узле, передача блокировки
+//   трогает только кэш-линию следующего.
+// RwLock - «big reader» блокировка с приоритетом читателей: читатель
+//   увеличивает счётчик своего ядра (своя кэш-линия), писатель дожидается
+//   нуля во всех счётчиках и лишь тогда закрывает вход флагом. Чтение
+//   дешёвое, запись дорогая и при постоянном потоке читателей может ждать.
+//
+// Спин-блокировки после SYNC_SPIN_LIMIT попыток уступают процессор
+// (sched_yield), чтобы не крутиться, пока владелец вытеснен.
+
+#define SYNC_CACHE_LINE 64
+#define SYNC_SPIN_LIMIT 128
+#define RW_SLOTS 64
+
+struct AdaptiveMutex {
+  atomic_int state;  // 0 - свободен, 1 - занят, 2 - занят и есть ожидающие
+};
+
+#define ADAPTIVE_MUTEX_INITIALIZER {0}
+
+void AdaptiveMutexLock(struct AdaptiveMutex *m);
+int AdaptiveMutexTryLock(struct AdaptiveMutex *m);  // 0 - захвачен
+void AdaptiveMutexUnlock(struct AdaptiveMutex *m);
+
+struct TicketLock {
+  alignas(SYNC_CACHE_LINE) atomic_uint next;
+  alignas(SYNC_CACHE_LINE) atomic_uint serving;
+};
+
+void TicketLockInit(struct TicketLock *l);
+void TicketLockLock(struct TicketLock *l);
+void TicketLockUnlock(struct TicketLock *l);
+
+struct McsNode {
+  alignas(SYNC_CACHE_LINE) struct McsNode *_Atomic next;
+  atomic_int locked;
+};
+
+struct McsLock {
+  struct McsNode *_Atomic tail;
+};
+
+// node живёт у вызывающего (обычно на стеке) от Lock до Unlock.
+void McsLockInit(struct McsLock *l);
+void McsLockLock(struct McsLock *l, struct McsNode *node);
+void McsLockUnlock(struct McsLock *l, struct McsNode *node);
+
+struct RwSlot {
+  alignas(SYNC_CACHE_LINE) atomic_int readers;
+};
+
+struct RwLock {
+  struct RwSlot slots[RW_SLOTS];
+  alignas(SYNC_CACHE_LINE) atomic_int writer;
+  struct AdaptiveMutex writers;  // писатели между собой
+};
+
+void RwLockInit(struct RwLock *l);
+// Возвращает номер счётчика, который нужно передать в RwReadUnlock.
+int RwReadLock(struct RwLock *l);
+void RwReadUnlock(struct RwLock *l, int slot);
+void RwWriteLock(struct RwLock *l);
+void RwWriteUnlock(struct RwLock *l);
+
+#endif
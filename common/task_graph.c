@@ -0,0 +1,60 @@
+#include "task_graph.h"
+
+void TaskGraphInit(struct TaskGraph *graph, struct ThreadPool *pool) {
+  graph->pool = pool;
+  TaskGroupInit(&graph->group);
+  graph->tasks = NULL;
+  graph->tail = &graph->tasks;
+}
+
+void TaskGraphAdd(struct TaskGraph *graph, struct GraphTask *task,
+                  GraphTaskFn fn) {
+  task->fn = fn;
+  task->graph = graph;
+  task->successor_count = 0;
+  task->deps = 0;
+  atomic_init(&task->deps_left, 0);
+  task->next = NULL;
+  *graph->tail = task;
+  graph->tail = &task->next;
+}
+
+int TaskGraphDepend(struct GraphTask *task, struct GraphTask *before) {
+  if (before->successor_count == GRAPH_MAX_SUCCESSORS) return -1;
+  before->successors[before->successor_count++] = task;
+  task->deps++;
+  return 0;
+}
+
+static void Schedule(struct GraphTask *task);
+
+static void RunGraphTask(struct PoolTask *pool_task) {
+  struct GraphTask *task = (struct GraphTask *)pool_task;
+  task->fn(task);
+  // acq_rel: результаты всех предшественников видны задаче, которая
+  // снимает последнюю зависимость
+  for (int i = 0; i < task->successor_count; i++) {
+    struct GraphTask *next = task->successors[i];
+    if (atomic_fetch_sub_explicit(&next->deps_left, 1, memory_order_acq_rel) == 1)
+      Schedule(next);
+  }
+}
+
+static void Schedule(struct GraphTask *task) {
+  struct TaskGraph *graph = task->graph;
+  if (graph->pool == NULL) {
+    RunGraphTask(&task->pool_task);
+    return;
+  }
+  ThreadPoolSubmit(graph->pool, &graph->group, &task->pool_task, RunGraphTask);
+}
+
+void TaskGraphRun(struct TaskGraph *graph) {
+  for (struct GraphTask *task = graph->tasks; task != NULL; task = task->next)
+    atomic_store_explicit(&task->deps_left, task->deps, memory_order_relaxed);
+  // deps не меняется во время работы, поэтому корни можно искать, пока
+  // уже запущенные задачи снимают deps_left у остальных.
+  for (struct GraphTask *task = graph->tasks; task != NULL; task = task->next)
+    if (task->deps == 0) Schedule(task);
+  if (graph->pool != NULL) ThreadPoolWait(graph->pool, &graph->group);
+}
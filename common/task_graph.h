@@ -0,0 +1,59 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "thread_pool.h"
+
+// Граф задач поверх ThreadPool: задача уходит в пул, как только
+// выполнены все задачи, от которых она зависит. Так стадии конвейера
+// идут внахлёст по кускам: кусок i уже сворачивается, пока кусок i + 1
+// ещё читается или генерируется.
+//
+// Задачи, как и PoolTask, встраиваются в структуры вызывающего, у каждой
+// не больше GRAPH_MAX_SUCCESSORS зависимых. Готовые задачи ставятся
+// в очередь в том порядке, в каком вызывался TaskGraphDepend, поэтому
+// зависимость "следующий кусок ввода" стоит объявлять первой: чтение
+// не ждёт за свёртками.
+
+#define GRAPH_MAX_SUCCESSORS 4
+
+struct GraphTask;
+typedef void (*GraphTaskFn)(struct GraphTask *task);
+
+struct GraphTask {
+  struct PoolTask pool_task;  // первым полем: пул передаёт указатель на него
+  GraphTaskFn fn;
+  struct TaskGraph *graph;
+  struct GraphTask *next;  // список задач графа
+  struct GraphTask *successors[GRAPH_MAX_SUCCESSORS];
+  int successor_count;
+  int deps;               // число входящих рёбер
+  atomic_int deps_left;   // осталось невыполненных до запуска
+};
+
+// Структура, в которую встроена задача (их может быть несколько в одной).
+#define GRAPH_TASK_OWNER(task, type, member) \
+  ((type *)((char *)(task) - offsetof(type, member)))
+
+struct TaskGraph {
+  struct ThreadPool *pool;  // NULL - всё выполняется в вызывающем потоке
+  struct TaskGroup group;
+  struct GraphTask *tasks;  // в порядке добавления
+  struct GraphTask **tail;
+};
+
+void TaskGraphInit(struct TaskGraph *graph, struct ThreadPool *pool);
+void TaskGraphAdd(struct TaskGraph *graph, struct GraphTask *task,
+                  GraphTaskFn fn);
+
+// task выполнится после before. -1 - у before уже GRAPH_MAX_SUCCESSORS.
+int TaskGraphDepend(struct GraphTask *task, struct GraphTask *before);
+
+// Запускает задачи без зависимостей и возвращается, когда выполнен весь
+// граф. Вызывающий поток тоже выполняет задачи. Граф можно запускать
+// повторно.
+void TaskGraphRun(struct TaskGraph *graph);
+
+#endif
@@ -0,0 +1,110 @@
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdlib.h>
+
+#include "lockfree_queue.h"
+
+struct ThreadPool {
+  struct MpmcQueue queue;
+  sem_t ready;  // число задач в очереди; на нём спят свободные потоки
+  atomic_int stop;
+  int threads;
+  pthread_t *tids;
+  PoolStartFn on_start;
+  void *start_arg;
+  atomic_int started;  // раздаёт index для on_start
+};
+
+static void RunTask(struct PoolTask *task) {
+  struct TaskGroup *group = task->group;
+  task->fn(task);
+  // после уменьшения счётчика задача может быть уже освобождена владельцем
+  atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release);
+}
+
+static void *Worker(void *arg) {
+  struct ThreadPool *pool = arg;
+  if (pool->on_start != NULL)
+    pool->on_start(atomic_fetch_add(&pool->started, 1), pool->start_arg);
+  for (;;) {
+    sem_wait(&pool->ready);
+    void *task;
+    if (MpmcPop(&pool->queue, &task) == 0) {
+      RunTask(task);
+    } else if (atomic_load(&pool->stop)) {
+      return NULL;
+    }
+    // иначе задачу уже забрал ожидающий поток в ThreadPoolWait
+  }
+}
+
+struct ThreadPool *ThreadPoolCreate(int threads, size_t queue_capacity) {
+  return ThreadPoolCreateWithStart(threads, queue_capacity, NULL, NULL);
+}
+
+struct ThreadPool *ThreadPoolCreateWithStart(int threads, size_t queue_capacity,
+                                             PoolStartFn on_start, void *arg) {
+  struct ThreadPool *pool = calloc(1, sizeof(*pool));
+  if (pool == NULL) return NULL;
+  pool->on_start = on_start;
+  pool->start_arg = arg;
+  if (MpmcInit(&pool->queue, queue_capacity) != 0) {
+    free(pool);
+    return NULL;
+  }
+  sem_init(&pool->ready, 0, 0);
+  pool->tids = malloc(sizeof(pthread_t) * threads);
+  if (pool->tids == NULL) {
+    ThreadPoolDestroy(pool);
+    return NULL;
+  }
+  for (int i = 0; i < threads; i++) {
+    if (pthread_create(&pool->tids[i], NULL, Worker, pool) != 0) break;
+    pool->threads++;
+  }
+  if (pool->threads == 0) {
+    ThreadPoolDestroy(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+void ThreadPoolDestroy(struct ThreadPool *pool) {
+  if (pool == NULL) return;
+  atomic_store(&pool->stop, 1);
+  for (int i = 0; i < pool->threads; i++) sem_post(&pool->ready);
+  for (int i = 0; i < pool->threads; i++) pthread_join(pool->tids[i], NULL);
+  sem_destroy(&pool->ready);
+  MpmcDestroy(&pool->queue);
+  free(pool->tids);
+  free(pool);
+}
+
+void TaskGroupInit(struct TaskGroup *group) {
+  atomic_init(&group->pending, 0);
+}
+
+void ThreadPoolSubmit(struct ThreadPool *pool, struct TaskGroup *group,
+                      struct PoolTask *task, PoolTaskFn fn) {
+  task->fn = fn;
+  task->group = group;
+  atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+  if (MpmcPush(&pool->queue, task) != 0) {
+    RunTask(task);
+    return;
+  }
+  sem_post(&pool->ready);
+}
+
+void ThreadPoolWait(struct ThreadPool *pool, struct TaskGroup *group) {
+  while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0) {
+    void *task;
+    if (MpmcPop(&pool->queue, &task) == 0)
+      RunTask(task);
+    else
+      sched_yield();
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Пул постоянных потоков поверх MpmcQueue. Задачи встраиваются в
+// структуры вызывающего (без malloc на задачу) и объединяются в группы,
+// которые можно дождаться. Ожидающий поток не спит, а сам выполняет
+// задачи из очереди, пока его группа не завершится.
+
+struct ThreadPool;
+struct PoolTask;
+
+typedef void (*PoolTaskFn)(struct PoolTask *task);
+
+struct TaskGroup {
+  atomic_size_t pending;
+};
+
+struct PoolTask {
+  PoolTaskFn fn;
+  struct TaskGroup *group;
+};
+
+typedef void (*PoolStartFn)(int index, void *arg);
+
+// threads рабочих потоков, очередь на queue_capacity задач.
+struct ThreadPool *ThreadPoolCreate(int threads, size_t queue_capacity);
+
+// То же, но каждый рабочий поток до первой задачи вызывает
+// on_start(index, arg), index - 0..threads-1 (например, привязка к ядру).
+struct ThreadPool *ThreadPoolCreateWithStart(int threads, size_t queue_capacity,
+                                             PoolStartFn on_start, void *arg);
+void ThreadPoolDestroy(struct ThreadPool *pool);
+
+void TaskGroupInit(struct TaskGroup *group);
+
+// Ставит задачу в очередь; если очередь полна, выполняет её сразу.
+void ThreadPoolSubmit(struct ThreadPool *pool, struct TaskGroup *group,
+                      struct PoolTask *task, PoolTaskFn fn);
+
+// Возвращается, когда все задачи группы выполнены.
+void ThreadPoolWait(struct ThreadPool *pool, struct TaskGroup *group);
+
+#endif
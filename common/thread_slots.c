@@ -0,0 +1,26 @@
+#include "thread_slots.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int ThreadSlotsInit(struct ThreadSlots *slots, int count, size_t elem_size,
+                    int padded) {
+  size_t stride = elem_size;
+  if (padded)
+    stride = (elem_size + SLOT_CACHE_LINE - 1) / SLOT_CACHE_LINE * SLOT_CACHE_LINE;
+  // aligned_alloc требует размер, кратный выравниванию
+  size_t bytes = (size_t)(count > 0 ? count : 1) * stride;
+  bytes = (bytes + SLOT_CACHE_LINE - 1) / SLOT_CACHE_LINE * SLOT_CACHE_LINE;
+  slots->base = aligned_alloc(SLOT_CACHE_LINE, bytes);
+  if (slots->base == NULL) return -1;
+  memset(slots->base, 0, bytes);
+  slots->stride = stride;
+  slots->count = count;
+  return 0;
+}
+
+void ThreadSlotsFree(struct ThreadSlots *slots) {
+  free(slots->base);
+  slots->base = NULL;
+  slots->count = 0;
+}
@@ -0,0 +1,33 @@
+#ifndef THREAD_SLOTS_H
+#define THREAD_SLOTS_H
+
+#include <stddef.h>
+
+// Массив per-thread записей (аргументы и результат потока), в котором
+// каждая запись занимает целое число кэш-линий и начинается с границы
+// линии. Поток пишет результат только в свою линию, поэтому соседние
+// потоки не отбирают её друг у друга (false sharing), даже если пишут
+// после каждого мелкого куска.
+//
+// Режим packed оставляет записи вплотную, как в обычном malloc-массиве
+// структур, - для сравнения в бенчмарках.
+
+#define SLOT_CACHE_LINE 64
+
+struct ThreadSlots {
+  char *base;
+  size_t stride;  // расстояние между записями
+  int count;
+};
+
+// Выделяет count записей по elem_size байт, обнулённых.
+// 0 - успех, -1 - нет памяти.
+int ThreadSlotsInit(struct ThreadSlots *slots, int count, size_t elem_size,
+                    int padded);
+void ThreadSlotsFree(struct ThreadSlots *slots);
+
+static inline void *ThreadSlotAt(const struct ThreadSlots *slots, int i) {
+  return slots->base + (size_t)i * slots->stride;
+}
+
+#endif
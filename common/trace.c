@@ -0,0 +1,326 @@
+#define _GNU_SOURCE
+#include "trace.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TRACE_DEFAULT_EVENTS 65536
+#define TRACE_NAME_MAX 48
+
+struct TraceEvent {
+  uint64_t ticks;
+  const char *name;
+  const char *arg_name;  // NULL - без аргумента
+  int64_t arg;
+  char phase;
+};
+
+// Буфер одного потока. Пишет только владелец, count публикуется
+// с release, чтобы TraceFlush из другого потока видел готовые события.
+struct TraceBuffer {
+  struct TraceEvent *events;
+  size_t capacity;
+  atomic_size_t count;
+  size_t written;  // уже выведено предыдущим TraceFlush
+  size_t dropped;  // копится и при повторном использовании буфера
+  int tid;
+  char name[TRACE_NAME_MAX];
+  struct TraceBuffer *next;
+  struct TraceBuffer *next_free;  // в g_free, пока буфер без владельца
+};
+
+int trace_enabled;
+
+static struct {
+  char path[4096];
+  char process_name[TRACE_NAME_MAX];
+  size_t capacity;
+  int root;   // процесс, создавший файл: он и закрывает массив
+  int named;  // process_name уже в файле
+  uint64_t ticks0;
+  uint64_t ns0;
+  pthread_mutex_t flush_lock;
+} g_trace = {.flush_lock = PTHREAD_MUTEX_INITIALIZER};
+
+static _Atomic(struct TraceBuffer *) g_buffers;
+static _Thread_local struct TraceBuffer *t_buffer;
+
+// Буферы завершившихся потоков: деструктор ключа выводит их события
+// и кладёт буфер сюда, новый поток берёт его вместо malloc. Из g_buffers
+// буферы не удаляются, поэтому памяти - по числу одновременно живых
+// потоков, а не по числу потоков за всё время (lab6 --dispatch threads).
+// Под flush_lock.
+static struct TraceBuffer *g_free;
+static pthread_key_t g_buffer_key;
+
+static uint64_t MonotonicNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// TSC на x86 (несколько тактов), иначе - те же наносекунды CLOCK_MONOTONIC.
+static inline uint64_t Ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __builtin_ia32_rdtsc();
+#else
+  return MonotonicNs();
+#endif
+}
+
+static struct TraceBuffer *ReuseBuffer(void) {
+  pthread_mutex_lock(&g_trace.flush_lock);
+  struct TraceBuffer *buf = g_free;
+  if (buf != NULL) {
+    g_free = buf->next_free;
+    buf->next_free = NULL;
+    buf->name[0] = '\0';
+    buf->written = 0;
+    atomic_store_explicit(&buf->count, 0, memory_order_relaxed);
+    buf->tid = (int)syscall(SYS_gettid);
+  }
+  pthread_mutex_unlock(&g_trace.flush_lock);
+  return buf;
+}
+
+static struct TraceBuffer *AcquireBuffer(void) {
+  struct TraceBuffer *buf = ReuseBuffer();
+  if (buf != NULL) return buf;
+  buf = calloc(1, sizeof(*buf));
+  if (buf == NULL) return NULL;
+  buf->events = malloc(g_trace.capacity * sizeof(*buf->events));
+  if (buf->events == NULL) {
+    free(buf);
+    return NULL;
+  }
+  buf->capacity = g_trace.capacity;
+  buf->tid = (int)syscall(SYS_gettid);
+  buf->next = atomic_load_explicit(&g_buffers, memory_order_relaxed);
+  while (!atomic_compare_exchange_weak_explicit(&g_buffers, &buf->next, buf,
+                                                memory_order_release,
+                                                memory_order_relaxed)) {
+  }
+  return buf;
+}
+
+static struct TraceBuffer *Buffer(void) {
+  if (t_buffer == NULL) {
+    t_buffer = AcquireBuffer();
+    if (t_buffer != NULL) pthread_setspecific(g_buffer_key, t_buffer);
+  }
+  return t_buffer;
+}
+
+void TraceRecord(char phase, const char *name, const char *arg_name,
+                 int64_t arg) {
+  uint64_t ticks = Ticks();
+  struct TraceBuffer *buf = Buffer();
+  if (buf == NULL) return;
+  size_t n = atomic_load_explicit(&buf->count, memory_order_relaxed);
+  if (n == buf->capacity) {
+    buf->dropped++;
+    return;
+  }
+  struct TraceEvent *e = &buf->events[n];
+  e->ticks = ticks;
+  e->name = name;
+  e->arg_name = arg_name;
+  e->arg = arg;
+  e->phase = phase;
+  atomic_store_explicit(&buf->count, n + 1, memory_order_release);
+}
+
+void TraceThreadName(const char *name, int index) {
+  if (!trace_enabled) return;
+  struct TraceBuffer *buf = Buffer();
+  if (buf == NULL) return;
+  if (index < 0)
+    snprintf(buf->name, sizeof(buf->name), "%s", name);
+  else
+    snprintf(buf->name, sizeof(buf->name), "%s %d", name, index);
+}
+
+// Имена - литералы программы, но кавычка в них сломала бы JSON.
+static void WriteJsonString(FILE *out, const char *s) {
+  fputc('"', out);
+  for (; *s != '\0'; s++) {
+    if (*s == '"' || *s == '\\') fputc('\\', out);
+    if ((unsigned char)*s >= 0x20) fputc(*s, out);
+  }
+  fputc('"', out);
+}
+
+// Одна запись write в O_APPEND: события разных процессов не перемешаются.
+static int AppendToFile(const char *data, size_t len) {
+  int fd = open(g_trace.path, O_WRONLY | O_APPEND | O_CLOEXEC);
+  if (fd < 0) return -1;
+  while (len > 0) {
+    ssize_t n = write(fd, data, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      close(fd);
+      return -1;
+    }
+    data += n;
+    len -= (size_t)n;
+  }
+  close(fd);
+  return 0;
+}
+
+static void WriteMetadata(FILE *out, int pid, int tid, const char *kind,
+                          const char *name) {
+  fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+               "\"args\":{\"name\":",
+          kind, pid, tid);
+  WriteJsonString(out, name);
+  fputs("}}", out);
+}
+
+void TraceFlush(void) {
+  if (!trace_enabled) return;
+  pthread_mutex_lock(&g_trace.flush_lock);
+  // Частота TSC - по двум точкам: старт и текущий момент.
+  uint64_t ticks1 = Ticks();
+  uint64_t ns1 = MonotonicNs();
+  double ns_per_tick =
+      ticks1 > g_trace.ticks0
+          ? (double)(ns1 - g_trace.ns0) / (double)(ticks1 - g_trace.ticks0)
+          : 1.0;
+
+  char *text = NULL;
+  size_t text_len = 0;
+  FILE *out = open_memstream(&text, &text_len);
+  if (out == NULL) {
+    pthread_mutex_unlock(&g_trace.flush_lock);
+    return;
+  }
+  int pid = (int)getpid();
+  if (!g_trace.named) {
+    WriteMetadata(out, pid, 0, "process_name", g_trace.process_name);
+    g_trace.named = 1;
+  }
+  size_t dropped = 0;
+  for (struct TraceBuffer *buf = atomic_load_explicit(&g_buffers, memory_order_acquire);
+       buf != NULL; buf = buf->next) {
+    size_t count = atomic_load_explicit(&buf->count, memory_order_acquire);
+    if (buf->written == 0 && buf->name[0] != '\0' && count > 0)
+      WriteMetadata(out, pid, buf->tid, "thread_name", buf->name);
+    for (size_t i = buf->written; i < count; i++) {
+      const struct TraceEvent *e = &buf->events[i];
+      double ns = (double)g_trace.ns0 +
+                  (double)(int64_t)(e->ticks - g_trace.ticks0) * ns_per_tick;
+      fputs(",\n{\"name\":", out);
+      WriteJsonString(out, e->name);
+      fprintf(out, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d", e->phase,
+              ns / 1000.0, pid, buf->tid);
+      if (e->phase == 'i') fputs(",\"s\":\"t\"", out);
+      if (e->arg_name != NULL) {
+        fputs(",\"args\":{", out);
+        WriteJsonString(out, e->arg_name);
+        fprintf(out, ":%lld}", (long long)e->arg);
+      }
+      fputc('}', out);
+    }
+    buf->written = count;
+    dropped += buf->dropped;
+  }
+  fclose(out);
+  if (text_len > 0 && AppendToFile(text, text_len) != 0)
+    perror(g_trace.path);
+  free(text);
+  if (dropped > 0)
+    fprintf(stderr, "trace: %zu events dropped (raise TRACE_EVENTS)\n", dropped);
+  pthread_mutex_unlock(&g_trace.flush_lock);
+}
+
+// Выход потока: его события - в файл, буфер - в g_free.
+static void ReleaseBuffer(void *arg) {
+  struct TraceBuffer *buf = arg;
+  t_buffer = NULL;  // события из более поздних деструкторов - в новый буфер
+  TraceFlush();
+  pthread_mutex_lock(&g_trace.flush_lock);
+  buf->next_free = g_free;
+  g_free = buf;
+  pthread_mutex_unlock(&g_trace.flush_lock);
+}
+
+static void TraceAtExit(void) {
+  TraceFlush();
+  if (g_trace.root) {
+    static const char kClose[] = "\n]\n";
+    AppendToFile(kClose, sizeof(kClose) - 1);
+  }
+}
+
+// В потомке после fork события родителя уже не его: начинаем с нуля,
+// оставшийся поток получает свой tid, процесс - подпись "<имя> (fork)".
+// Буферы остальных потоков родителя в потомке ничьи - все в g_free.
+static void TraceAtFork(void) {
+  g_free = NULL;
+  for (struct TraceBuffer *buf = atomic_load_explicit(&g_buffers, memory_order_relaxed);
+       buf != NULL; buf = buf->next) {
+    atomic_store_explicit(&buf->count, 0, memory_order_relaxed);
+    buf->written = 0;
+    buf->dropped = 0;
+    if (buf != t_buffer) {
+      buf->next_free = g_free;
+      g_free = buf;
+    }
+  }
+  if (t_buffer != NULL) t_buffer->tid = (int)syscall(SYS_gettid);
+  g_trace.root = 0;
+  g_trace.named = 0;
+  size_t len = strlen(g_trace.process_name);
+  snprintf(g_trace.process_name + len, sizeof(g_trace.process_name) - len,
+           "%s", strstr(g_trace.process_name, " (fork)") ? "" : " (fork)");
+  pthread_mutex_init(&g_trace.flush_lock, NULL);
+}
+
+void TraceInitFromEnv(const char *process_name) {
+  const char *path = getenv("TRACE_FILE");
+  if (path == NULL || *path == '\0' || trace_enabled) return;
+  snprintf(g_trace.path, sizeof(g_trace.path), "%s", path);
+  snprintf(g_trace.process_name, sizeof(g_trace.process_name), "%s",
+           process_name);
+  g_trace.capacity = TRACE_DEFAULT_EVENTS;
+  const char *events = getenv("TRACE_EVENTS");
+  if (events != NULL && atol(events) > 0) g_trace.capacity = (size_t)atol(events);
+  g_trace.ticks0 = Ticks();
+  g_trace.ns0 = MonotonicNs();
+
+  // Первый процесс создаёт файл; запущенные через exec видят
+  // TRACE_APPEND и только дописывают.
+  const char *append = getenv("TRACE_APPEND");
+  g_trace.root = append == NULL;
+  if (g_trace.root) {
+    FILE *f = fopen(g_trace.path, "w");
+    if (f == NULL) {
+      perror(g_trace.path);
+      return;
+    }
+    // Каждая следующая запись начинается с ",": первой идёт подпись процесса.
+    fprintf(f, "[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+               "\"tid\":0,\"args\":{\"name\":",
+            (int)getpid());
+    WriteJsonString(f, g_trace.process_name);
+    fputs("}}", f);
+    fclose(f);
+    g_trace.named = 1;
+    setenv("TRACE_APPEND", "1", 1);
+  }
+
+  pthread_key_create(&g_buffer_key, ReleaseBuffer);
+  pthread_atfork(NULL, NULL, TraceAtFork);
+  atexit(TraceAtExit);
+  trace_enabled = 1;
+  TraceThreadName("main", -1);
+}
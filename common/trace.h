@@ -0,0 +1,52 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Трассировка фаз программы для Perfetto / chrome://tracing.
+// Запуск с TRACE_FILE=trace.json включает запись: каждое событие
+// (начало/конец участка) - это такты TSC и указатель на имя в буфере
+// своего потока, без блокировок и форматирования. При выходе события
+// переводятся в микросекунды CLOCK_MONOTONIC и дописываются в файл
+// в формате Chrome trace-event (массив событий). Процессы, порождённые
+// fork или exec, пишут в тот же файл, так что воркеры видны рядом
+// с родителем. Без TRACE_FILE вызов стоит одну проверку флага.
+//
+// Имена - строковые литералы (хранится только указатель). Буфер потока -
+// TRACE_EVENTS событий (по умолчанию 65536), лишние отбрасываются.
+// При выходе потока его события сразу дописываются в файл, а буфер
+// достаётся следующему новому потоку.
+
+extern int trace_enabled;
+
+// Читает TRACE_FILE; process_name - подпись процесса на временной шкале.
+void TraceInitFromEnv(const char *process_name);
+
+// Подпись текущего потока, например "worker 3" (index < 0 - без номера).
+void TraceThreadName(const char *name, int index);
+
+// Дописывает накопленные события процесса в файл (вызывается и при exit).
+void TraceFlush(void);
+
+void TraceRecord(char phase, const char *name, const char *arg_name,
+                 int64_t arg);
+
+static inline void TraceBegin(const char *name) {
+  if (trace_enabled) TraceRecord('B', name, 0, 0);
+}
+
+static inline void TraceEnd(const char *name) {
+  if (trace_enabled) TraceRecord('E', name, 0, 0);
+}
+
+// Начало участка с числовым аргументом (виден в панели события).
+static inline void TraceBeginArg(const char *name, const char *arg_name,
+                                 int64_t arg) {
+  if (trace_enabled) TraceRecord('B', name, arg_name, arg);
+}
+
+static inline void TraceInstant(const char *name) {
+  if (trace_enabled) TraceRecord('i', name, 0, 0);
+}
+
+#endif
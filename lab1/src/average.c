@@ -0,0 +1,278 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "int_text.h"
+
+// Замена average.sh для больших наборов чисел.
+//
+//   average 1 2 3                - как average.sh, числа в аргументах
+//   average -f numbers.txt       - файл через mmap, делится по строкам
+//   average -f - < numbers.txt   - стандартный ввод
+//   [-t потоки] [--all]
+//
+// Вывод по умолчанию совпадает с average.sh: число аргументов и среднее
+// с отбрасыванием дробной части, как $((sum/count)). Сумма копится в
+// 128 битах, поэтому не переполняется; числа вне int64 - ошибка, а не
+// молчаливое усечение, как в bash. --all добавляет сумму, точное среднее,
+// минимум и максимум.
+
+struct Aggregate {
+  uint64_t count;
+  __int128 sum;
+  int64_t min;
+  int64_t max;
+};
+
+struct Part {
+  const char *text;
+  size_t begin;
+  size_t end;
+  struct Aggregate agg;
+  enum IntTextStatus status;
+  size_t error_at;
+};
+
+static void AggInit(struct Aggregate *agg) {
+  agg->count = 0;
+  agg->sum = 0;
+  agg->min = INT64_MAX;
+  agg->max = INT64_MIN;
+}
+
+static void AggMerge(struct Aggregate *into, const struct Aggregate *from) {
+  into->count += from->count;
+  into->sum += from->sum;
+  if (from->min < into->min) into->min = from->min;
+  if (from->max > into->max) into->max = from->max;
+}
+
+// Разбирает кусок текста за один проход.
+static void *ScanPart(void *arg) {
+  struct Part *part = arg;
+  const char *pos = part->text + part->begin;
+  const char *end = part->text + part->end;
+  struct Aggregate agg;
+  AggInit(&agg);
+  part->status = INT_TEXT_OK;
+  for (;;) {
+    int64_t value;
+    enum IntTextStatus st = IntTextNext(&pos, end, &value);
+    if (st != INT_TEXT_OK) {
+      if (st != INT_TEXT_END) {
+        part->status = st;
+        part->error_at = (size_t)(pos - part->text);
+      }
+      break;
+    }
+    agg.count++;
+    agg.sum += value;
+    if (value < agg.min) agg.min = value;
+    if (value > agg.max) agg.max = value;
+  }
+  part->agg = agg;
+  return NULL;
+}
+
+static void ReportError(const char *name, const char *text, size_t at,
+                        enum IntTextStatus status) {
+  size_t line = 1;
+  for (size_t i = 0; i < at; i++) line += text[i] == '\n';
+  fprintf(stderr, "%s:%zu: %s\n", name, line,
+          status == INT_TEXT_OVERFLOW ? "число не помещается в 64 бита"
+                                      : "не число");
+}
+
+// Текст делится на куски по пробельным символам, куски - по потокам.
+static int ScanText(const char *name, const char *text, size_t size,
+                    int threads, struct Aggregate *total) {
+  if (size < (size_t)threads * 4096) threads = 1;
+  size_t bounds[threads + 1];
+  IntTextSplit(text, size, threads, bounds);
+  struct Part parts[threads];
+  pthread_t tids[threads];
+  int created[threads];
+  for (int t = 0; t < threads; t++) {
+    parts[t].text = text;
+    parts[t].begin = bounds[t];
+    parts[t].end = bounds[t + 1];
+    created[t] = t > 0 && pthread_create(&tids[t], NULL, ScanPart, &parts[t]) == 0;
+    if (t > 0 && !created[t]) ScanPart(&parts[t]);
+  }
+  ScanPart(&parts[0]);
+  for (int t = 1; t < threads; t++)
+    if (created[t]) pthread_join(tids[t], NULL);
+
+  for (int t = 0; t < threads; t++) {
+    if (parts[t].status != INT_TEXT_OK) {
+      ReportError(name, text, parts[t].error_at, parts[t].status);
+      return -1;
+    }
+    AggMerge(total, &parts[t].agg);
+  }
+  return 0;
+}
+
+static char *ReadStdin(size_t *size) {
+  size_t cap = 1 << 20;
+  size_t len = 0;
+  char *buf = malloc(cap);
+  while (buf != NULL) {
+    ssize_t n = read(STDIN_FILENO, buf + len, cap - len);
+    if (n < 0) {
+      free(buf);
+      return NULL;
+    }
+    if (n == 0) break;
+    len += (size_t)n;
+    if (len == cap) {
+      char *grown = realloc(buf, cap * 2);
+      if (grown == NULL) free(buf);
+      buf = grown;
+      cap *= 2;
+    }
+  }
+  *size = len;
+  return buf;
+}
+
+static int ScanFile(const char *path, int threads, struct Aggregate *total) {
+  if (strcmp(path, "-") == 0) {
+    size_t size = 0;
+    char *text = ReadStdin(&size);
+    if (text == NULL) {
+      perror("stdin");
+      return -1;
+    }
+    int rc = ScanText("stdin", text, size, threads, total);
+    free(text);
+    return rc;
+  }
+
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    perror(path);
+    if (fd >= 0) close(fd);
+    return -1;
+  }
+  size_t size = (size_t)st.st_size;
+  if (size == 0) {
+    close(fd);
+    return 0;
+  }
+  char *text = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (text == MAP_FAILED) {
+    perror("mmap");
+    return -1;
+  }
+  madvise(text, size, MADV_SEQUENTIAL);
+  int rc = ScanText(path, text, size, threads, total);
+  munmap(text, size);
+  return rc;
+}
+
+static void PrintInt128(__int128 v) {
+  char buf[48];
+  char *p = buf + sizeof(buf);
+  unsigned __int128 u = v < 0 ? -(unsigned __int128)v : (unsigned __int128)v;
+  *--p = '\0';
+  do {
+    *--p = (char)('0' + (int)(u % 10));
+    u /= 10;
+  } while (u != 0);
+  if (v < 0) *--p = '-';
+  fputs(p, stdout);
+}
+
+// sum / count с 6 знаками после точки, дробь отбрасывается
+static void PrintExactAverage(__int128 sum, uint64_t count) {
+  unsigned __int128 u = sum < 0 ? -(unsigned __int128)sum : (unsigned __int128)sum;
+  unsigned __int128 whole = u / count;
+  unsigned __int128 rest = u % count;
+  char frac[7];
+  for (int k = 0; k < 6; k++) {
+    rest *= 10;
+    frac[k] = (char)('0' + (int)(rest / count));
+    rest %= count;
+  }
+  frac[6] = '\0';
+  if (sum < 0 && (whole != 0 || strcmp(frac, "000000") != 0)) putchar('-');
+  PrintInt128((__int128)whole);
+  printf(".%s\n", frac);
+}
+
+int main(int argc, char **argv) {
+  int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads < 1) threads = 1;
+  int all = 0;
+  struct Aggregate total;
+  AggInit(&total);
+
+  // числа могут быть отрицательными, поэтому без getopt: опции - только
+  // точные -f/-t/--all, "--" завершает опции
+  int options_done = 0;
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (!options_done && strcmp(arg, "--") == 0) {
+      options_done = 1;
+    } else if (!options_done && strcmp(arg, "--all") == 0) {
+      all = 1;
+    } else if (!options_done && strcmp(arg, "-t") == 0 && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+      if (threads <= 0) {
+        fprintf(stderr, "-t: нужно положительное число потоков\n");
+        return 1;
+      }
+    } else if (!options_done && strcmp(arg, "-f") == 0 && i + 1 < argc) {
+      if (ScanFile(argv[++i], threads, &total) != 0) return 1;
+    } else {
+      const char *pos = arg;
+      const char *end = arg + strlen(arg);
+      int64_t value;
+      enum IntTextStatus st = IntTextNext(&pos, end, &value);
+      const char *after = pos;
+      int64_t extra;
+      if (st == INT_TEXT_OK && IntTextNext(&after, end, &extra) != INT_TEXT_END)
+        st = INT_TEXT_BAD;  // в одном аргументе одно число
+      if (st != INT_TEXT_OK) {
+        fprintf(stderr, "%s: %s\n", arg,
+                st == INT_TEXT_OVERFLOW ? "число не помещается в 64 бита"
+                                        : "не число");
+        return 1;
+      }
+      total.count++;
+      total.sum += value;
+      if (value < total.min) total.min = value;
+      if (value > total.max) total.max = value;
+    }
+  }
+
+  printf("Число аргументов: %llu\n", (unsigned long long)total.count);
+  if (total.count == 0) {
+    fprintf(stderr, "Нет чисел: среднее не определено\n");
+    return 1;
+  }
+  // деление с отбрасыванием к нулю, как $((sum/count))
+  printf("Среднее значение: ");
+  PrintInt128(total.sum / (__int128)total.count);
+  printf("\n");
+
+  if (all) {
+    printf("Сумма: ");
+    PrintInt128(total.sum);
+    printf("\nТочное среднее: ");
+    PrintExactAverage(total.sum, total.count);
+    printf("Минимум: %lld\n", (long long)total.min);
+    printf("Максимум: %lld\n", (long long)total.max);
+  }
+  return 0;
+}
@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "revert_string.h"
+
+/*
+ * Замер переворота 64 MiB: побайтовый обмен против RevertString (SIMD)
+ * и RevertBuffer на потоках. Проверки - в tests/tests.c.
+ */
+
+static double Seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(void)
+{
+	size_t length = 64u << 20;
+	char *buffer = malloc(length + 1);
+	if (buffer == NULL) {
+		perror("malloc");
+		return 1;
+	}
+	memset(buffer, 'a', length);
+	buffer[length] = '\0';
+
+	double start = Seconds();
+	for (size_t i = 0; i < length / 2; i++) {
+		char temp = buffer[i];
+		buffer[i] = buffer[length - 1 - i];
+		buffer[length - 1 - i] = temp;
+	}
+	double scalar = Seconds() - start;
+
+	start = Seconds();
+	RevertString(buffer);
+	double simd = Seconds() - start;
+
+	start = Seconds();
+	RevertBuffer(buffer, length, 4);
+	double threaded = Seconds() - start;
+
+	printf("64 MiB: byte swap %.1f ms, RevertString %.1f ms, "
+	       "RevertBuffer(4 threads) %.1f ms\n",
+	       scalar * 1e3, simd * 1e3, threaded * 1e3);
+	free(buffer);
+	return 0;
+}
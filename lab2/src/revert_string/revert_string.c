@@ -1,14 +1,250 @@
 #include "revert_string.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
 #include <string.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define REVERT_X86 1
+#endif
+
+/* буфер меньше этого размера потоками не делится */
+#define PARALLEL_MIN_BYTES (1 << 20)
+/* строки раздаются потокам пачками */
+#define STRINGS_BATCH 64
+
+/*
+ * Ядро переворота: меняет lo[k] и hi[-1 - k] для k < count. Полный
+ * переворот строки - SwapReversed(str, str + length, length / 2); потоки
+ * получают непересекающиеся пары отрезков с двух концов.
+ */
+static void SwapReversedScalar(char *lo, char *hi, size_t count)
+{
+	for (size_t k = 0; k < count; k++) {
+		char temp = lo[k];
+		lo[k] = hi[-1 - (ptrdiff_t)k];
+		hi[-1 - (ptrdiff_t)k] = temp;
+	}
+}
+
+#ifdef REVERT_X86
+__attribute__((target("ssse3")))
+static void SwapReversedSsse3(char *lo, char *hi, size_t count)
+{
+	const __m128i mask = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+					   7, 6, 5, 4, 3, 2, 1, 0);
+	while (count >= 16) {
+		hi -= 16;
+		__m128i a = _mm_loadu_si128((const __m128i *)lo);
+		__m128i b = _mm_loadu_si128((const __m128i *)hi);
+		_mm_storeu_si128((__m128i *)lo, _mm_shuffle_epi8(b, mask));
+		_mm_storeu_si128((__m128i *)hi, _mm_shuffle_epi8(a, mask));
+		lo += 16;
+		count -= 16;
+	}
+	SwapReversedScalar(lo, hi, count);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i Reverse32(__m256i v)
+{
+	const __m256i mask = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+					      7, 6, 5, 4, 3, 2, 1, 0,
+					      15, 14, 13, 12, 11, 10, 9, 8,
+					      7, 6, 5, 4, 3, 2, 1, 0);
+	/* pshufb переворачивает байты внутри 128-битных половин, */
+	/* permute меняет половины местами */
+	return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, mask), 0x4E);
+}
+
+__attribute__((target("avx2")))
+static void SwapReversedAvx2(char *lo, char *hi, size_t count)
+{
+	/* по 64 байта с каждого конца за шаг */
+	while (count >= 64) {
+		hi -= 64;
+		__m256i a0 = _mm256_loadu_si256((const __m256i *)lo);
+		__m256i a1 = _mm256_loadu_si256((const __m256i *)(lo + 32));
+		__m256i b0 = _mm256_loadu_si256((const __m256i *)hi);
+		__m256i b1 = _mm256_loadu_si256((const __m256i *)(hi + 32));
+		_mm256_storeu_si256((__m256i *)lo, Reverse32(b1));
+		_mm256_storeu_si256((__m256i *)(lo + 32), Reverse32(b0));
+		_mm256_storeu_si256((__m256i *)hi, Reverse32(a1));
+		_mm256_storeu_si256((__m256i *)(hi + 32), Reverse32(a0));
+		lo += 64;
+		count -= 64;
+	}
+	if (count >= 32) {
+		hi -= 32;
+		__m256i a = _mm256_loadu_si256((const __m256i *)lo);
+		__m256i b = _mm256_loadu_si256((const __m256i *)hi);
+		_mm256_storeu_si256((__m256i *)lo, Reverse32(b));
+		_mm256_storeu_si256((__m256i *)hi, Reverse32(a));
+		lo += 32;
+		count -= 32;
+	}
+	SwapReversedSsse3(lo, hi, count);
+}
+#endif
+
+typedef void (*SwapReversedFn)(char *lo, char *hi, size_t count);
+
+static SwapReversedFn PickKernel(void)
+{
+#ifdef REVERT_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return SwapReversedAvx2;
+	if (__builtin_cpu_supports("ssse3"))
+		return SwapReversedSsse3;
+#endif
+	return SwapReversedScalar;
+}
+
+static void SwapReversed(char *lo, char *hi, size_t count)
+{
+	/* выбор один раз; гонка безобидна - все потоки запишут одно и то же */
+	static _Atomic(SwapReversedFn) kernel;
+	SwapReversedFn fn = atomic_load_explicit(&kernel, memory_order_relaxed);
+	if (fn == NULL) {
+		fn = PickKernel();
+		atomic_store_explicit(&kernel, fn, memory_order_relaxed);
+	}
+	fn(lo, hi, count);
+}
+
 void RevertString(char *str)
 {
-	// your code here
-	int length = strlen(str);
-    for (int i = 0; i < length / 2; i++) {
-        char temp = str[i];
-        str[i] = str[length - 1 - i];
-        str[length - 1 - i] = temp;
-    }
+	RevertStringN(str, strlen(str));
 }
 
+void RevertStringN(char *str, size_t length)
+{
+	SwapReversed(str, str + length, length / 2);
+}
+
+void RevertStringUtf8(char *str, size_t length)
+{
+	/*
+	 * Переворачиваем байты, затем возвращаем порядок внутри каждого
+	 * символа: после переворота продолжения (10xxxxxx) стоят перед
+	 * ведущим байтом. Битые последовательности остаются как есть.
+	 */
+	unsigned char *s = (unsigned char *)str;
+	RevertStringN(str, length);
+	size_t i = 0;
+	while (i < length) {
+		if ((s[i] & 0xC0) != 0x80) {
+			i++;
+			continue;
+		}
+		size_t j = i;
+		while (j < length && j - i < 3 && (s[j] & 0xC0) == 0x80)
+			j++;
+		if (j < length && (s[j] & 0xC0) == 0xC0) {
+			SwapReversedScalar(str + i, str + j + 1, (j - i + 1) / 2);
+			i = j + 1;
+		} else {
+			i = j;
+		}
+	}
+}
+
+struct BufferPart {
+	char *buffer;
+	size_t length;
+	size_t begin;   /* отрезок [begin, end) левой половины */
+	size_t end;
+};
+
+static void *RevertBufferPart(void *arg)
+{
+	struct BufferPart *part = arg;
+	SwapReversed(part->buffer + part->begin,
+		     part->buffer + part->length - part->begin,
+		     part->end - part->begin);
+	return NULL;
+}
+
+void RevertBuffer(char *buffer, size_t length, int threads)
+{
+	if (threads <= 1 || length < PARALLEL_MIN_BYTES) {
+		RevertStringN(buffer, length);
+		return;
+	}
+
+	pthread_t tids[threads];
+	struct BufferPart parts[threads];
+	size_t half = length / 2;
+	/* границы кратны 64, чтобы потоки не делили кэш-линии левой половины */
+	size_t chunk = (half / (size_t)threads + 63) & ~(size_t)63;
+	int started = 0;
+	for (int t = 0; t < threads; t++) {
+		size_t begin = (size_t)t * chunk;
+		if (begin >= half)
+			break;
+		parts[t].buffer = buffer;
+		parts[t].length = length;
+		parts[t].begin = begin;
+		parts[t].end = begin + chunk < half ? begin + chunk : half;
+		if (pthread_create(&tids[t], NULL, RevertBufferPart, &parts[t]) != 0) {
+			/* поток не создался - остаток делаем сами */
+			parts[t].end = half;
+			RevertBufferPart(&parts[t]);
+			break;
+		}
+		started++;
+	}
+	for (int t = 0; t < started; t++)
+		pthread_join(tids[t], NULL);
+}
+
+struct StringsJob {
+	char **strings;
+	const size_t *lengths;
+	size_t count;
+	atomic_size_t next;
+};
+
+static void *RevertStringsWorker(void *arg)
+{
+	struct StringsJob *job = arg;
+	for (;;) {
+		size_t first = atomic_fetch_add(&job->next, STRINGS_BATCH);
+		if (first >= job->count)
+			break;
+		size_t last = first + STRINGS_BATCH < job->count ?
+			      first + STRINGS_BATCH : job->count;
+		for (size_t i = first; i < last; i++) {
+			if (job->lengths != NULL)
+				RevertStringN(job->strings[i], job->lengths[i]);
+			else
+				RevertString(job->strings[i]);
+		}
+	}
+	return NULL;
+}
+
+void RevertStrings(char **strings, const size_t *lengths, size_t count,
+		   int threads)
+{
+	struct StringsJob job = {strings, lengths, count, 0};
+	if (threads < 1)
+		threads = 1;
+	if ((size_t)threads > count / STRINGS_BATCH)
+		threads = (int)(count / STRINGS_BATCH) + 1;
+
+	/* текущий поток - один из рабочих */
+	pthread_t tids[threads];
+	int started = 0;
+	for (int t = 1; t < threads; t++) {
+		if (pthread_create(&tids[started], NULL, RevertStringsWorker,
+				   &job) != 0)
+			break;
+		started++;
+	}
+	RevertStringsWorker(&job);
+	for (int t = 0; t < started; t++)
+		pthread_join(tids[t], NULL);
+}
@@ -1,4 +1,17 @@
+#include <stddef.h>
 
 /* function to revert string */
 void RevertString(char *str);
 
+/* то же для строки известной длины - без прохода strlen */
+void RevertStringN(char *str, size_t length);
+
+/* переворот по кодовым точкам UTF-8: многобайтовые символы не разрываются */
+void RevertStringUtf8(char *str, size_t length);
+
+/* большой буфер, перевёрнутый threads потоками (<= 1 - в текущем потоке) */
+void RevertBuffer(char *buffer, size_t length, int threads);
+
+/* много строк за раз; lengths == NULL - длины считаются через strlen */
+void RevertStrings(char **strings, const size_t *lengths, size_t count,
+		   int threads);
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "swap.h"
+
+/*
+ * Замер SwapBlocks и RotateLeft против memcpy через временный буфер.
+ * Перед замером результаты сверяются с наивной реализацией.
+ */
+
+static double Seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void SwapViaMemcpy(void *left, void *right, void *temp, size_t bytes)
+{
+	memcpy(temp, left, bytes);
+	memcpy(left, right, bytes);
+	memcpy(right, temp, bytes);
+}
+
+static void RotateViaMemcpy(unsigned char *base, size_t bytes, size_t shift,
+			    unsigned char *temp)
+{
+	memcpy(temp, base, shift);
+	memmove(base, base + shift, bytes - shift);
+	memcpy(base + bytes - shift, temp, shift);
+}
+
+static int Check(void)
+{
+	unsigned char a[700], b[700], expected[700];
+	for (size_t bytes = 1; bytes < sizeof(a); bytes++) {
+		for (size_t shift = 0; shift <= bytes; shift++) {
+			for (size_t i = 0; i < bytes; i++)
+				a[i] = (unsigned char)i;
+			for (size_t i = 0; i < bytes; i++)
+				expected[i] = a[(i + shift) % bytes];
+			RotateLeft(a, bytes, shift);
+			if (memcmp(a, expected, bytes) != 0) {
+				printf("RotateLeft(%zu, %zu) is wrong\n", bytes, shift);
+				return 1;
+			}
+		}
+		for (size_t i = 0; i < bytes; i++) {
+			a[i] = (unsigned char)i;
+			b[i] = (unsigned char)~i;
+		}
+		SwapBlocks(a, b, bytes);
+		for (size_t i = 0; i < bytes; i++) {
+			if (a[i] != (unsigned char)~i || b[i] != (unsigned char)i) {
+				printf("SwapBlocks(%zu) is wrong\n", bytes);
+				return 1;
+			}
+		}
+	}
+
+	short s1 = 1, s2 = 2;
+	int i1 = 3, i2 = 4;
+	double d1 = 5, d2 = 6;
+	float f1 = 9, f2 = 10;
+	long l1 = 11, l2 = 12;
+	long long ll1 = 13, ll2 = 14;
+	__int128 q1 = 7, q2 = 8;
+	struct { char name[20]; } n1 = {"left"}, n2 = {"right"};
+	SWAP(&s1, &s2);
+	SWAP(&i1, &i2);
+	SWAP(&d1, &d2);
+	SWAP(&f1, &f2);
+	SWAP(&l1, &l2);
+	SWAP(&ll1, &ll2);
+	SWAP(&q1, &q2);
+	SWAP(&n1, &n2);
+	if (s1 != 2 || i1 != 4 || d1 != 6 || f1 != 10 || l1 != 12 || ll1 != 14 ||
+	    q1 != 8 || strcmp(n1.name, "right") != 0) {
+		printf("SWAP is wrong\n");
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t bytes = argc > 1 ? strtoull(argv[1], NULL, 10) : (size_t)(64 << 20);
+	int repeat = argc > 2 ? atoi(argv[2]) : 5;
+	if (bytes < 2 || repeat <= 0) {
+		printf("Usage: %s [bytes] [repeat]\n", argv[0]);
+		return 1;
+	}
+	if (Check() != 0)
+		return 1;
+
+	unsigned char *left = malloc(bytes);
+	unsigned char *right = malloc(bytes);
+	unsigned char *temp = malloc(bytes);
+	if (left == NULL || right == NULL || temp == NULL) {
+		printf("malloc failed\n");
+		return 1;
+	}
+	memset(left, 1, bytes);
+	memset(right, 2, bytes);
+	memset(temp, 0, bytes);
+
+	double start = Seconds();
+	for (int r = 0; r < repeat; r++)
+		SwapBlocks(left, right, bytes);
+	double swap_blocks = (Seconds() - start) / repeat;
+
+	start = Seconds();
+	for (int r = 0; r < repeat; r++)
+		SwapViaMemcpy(left, right, temp, bytes);
+	double swap_memcpy = (Seconds() - start) / repeat;
+
+	printf("swap %zu bytes: SwapBlocks %.2f ms, memcpy via buffer %.2f ms\n",
+	       bytes, swap_blocks * 1e3, swap_memcpy * 1e3);
+
+	/* сдвиги: маленький, примерно треть и почти половина */
+	size_t shifts[] = {64, bytes / 3 + 1, bytes / 2 - 1};
+	for (size_t k = 0; k < sizeof(shifts) / sizeof(shifts[0]); k++) {
+		size_t shift = shifts[k] % bytes;
+		start = Seconds();
+		for (int r = 0; r < repeat; r++)
+			RotateLeft(left, bytes, shift);
+		double rotate = (Seconds() - start) / repeat;
+
+		start = Seconds();
+		for (int r = 0; r < repeat; r++)
+			RotateViaMemcpy(left, bytes, shift, temp);
+		double rotate_memcpy = (Seconds() - start) / repeat;
+
+		printf("rotate %zu by %zu: RotateLeft %.2f ms (256 byte buffer), "
+		       "memcpy+memmove %.2f ms (%zu byte buffer)\n",
+		       bytes, shift, rotate * 1e3, rotate_memcpy * 1e3, shift);
+	}
+
+	free(left);
+	free(right);
+	free(temp);
+	return 0;
+}
@@ -1,5 +1,13 @@
 #include "swap.h"
 
+#include <stdatomic.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SWAP_X86 1
+#endif
+
 void Swap(char *left, char *right)
 {
 	// ваш код здесь
@@ -7,3 +15,181 @@ void Swap(char *left, char *right)
     *left = *right;      
     *right = temp; 
 }
+
+/* хвост блока: по 8 байт, затем по одному */
+static void SwapTail(unsigned char *left, unsigned char *right, size_t bytes)
+{
+	while (bytes >= 8) {
+		uint64_t a, b;
+		memcpy(&a, left, 8);
+		memcpy(&b, right, 8);
+		memcpy(left, &b, 8);
+		memcpy(right, &a, 8);
+		left += 8;
+		right += 8;
+		bytes -= 8;
+	}
+	while (bytes-- > 0)
+		Swap8(left++, right++);
+}
+
+#ifdef SWAP_X86
+#ifdef __SSE2__
+static void SwapBlocksSse2(unsigned char *left, unsigned char *right,
+			   size_t bytes)
+{
+	while (bytes >= 64) {
+		__m128i a0 = _mm_loadu_si128((const __m128i *)left);
+		__m128i a1 = _mm_loadu_si128((const __m128i *)(left + 16));
+		__m128i a2 = _mm_loadu_si128((const __m128i *)(left + 32));
+		__m128i a3 = _mm_loadu_si128((const __m128i *)(left + 48));
+		__m128i b0 = _mm_loadu_si128((const __m128i *)right);
+		__m128i b1 = _mm_loadu_si128((const __m128i *)(right + 16));
+		__m128i b2 = _mm_loadu_si128((const __m128i *)(right + 32));
+		__m128i b3 = _mm_loadu_si128((const __m128i *)(right + 48));
+		_mm_storeu_si128((__m128i *)left, b0);
+		_mm_storeu_si128((__m128i *)(left + 16), b1);
+		_mm_storeu_si128((__m128i *)(left + 32), b2);
+		_mm_storeu_si128((__m128i *)(left + 48), b3);
+		_mm_storeu_si128((__m128i *)right, a0);
+		_mm_storeu_si128((__m128i *)(right + 16), a1);
+		_mm_storeu_si128((__m128i *)(right + 32), a2);
+		_mm_storeu_si128((__m128i *)(right + 48), a3);
+		left += 64;
+		right += 64;
+		bytes -= 64;
+	}
+	SwapTail(left, right, bytes);
+}
+#endif
+
+__attribute__((target("avx2")))
+static void SwapBlocksAvx2(unsigned char *left, unsigned char *right,
+			   size_t bytes)
+{
+	/* 128 байт за шаг: 4 + 4 регистра ymm */
+	while (bytes >= 128) {
+		__m256i a0 = _mm256_loadu_si256((const __m256i *)left);
+		__m256i a1 = _mm256_loadu_si256((const __m256i *)(left + 32));
+		__m256i a2 = _mm256_loadu_si256((const __m256i *)(left + 64));
+		__m256i a3 = _mm256_loadu_si256((const __m256i *)(left + 96));
+		__m256i b0 = _mm256_loadu_si256((const __m256i *)right);
+		__m256i b1 = _mm256_loadu_si256((const __m256i *)(right + 32));
+		__m256i b2 = _mm256_loadu_si256((const __m256i *)(right + 64));
+		__m256i b3 = _mm256_loadu_si256((const __m256i *)(right + 96));
+		_mm256_storeu_si256((__m256i *)left, b0);
+		_mm256_storeu_si256((__m256i *)(left + 32), b1);
+		_mm256_storeu_si256((__m256i *)(left + 64), b2);
+		_mm256_storeu_si256((__m256i *)(left + 96), b3);
+		_mm256_storeu_si256((__m256i *)right, a0);
+		_mm256_storeu_si256((__m256i *)(right + 32), a1);
+		_mm256_storeu_si256((__m256i *)(right + 64), a2);
+		_mm256_storeu_si256((__m256i *)(right + 96), a3);
+		left += 128;
+		right += 128;
+		bytes -= 128;
+	}
+	while (bytes >= 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)left);
+		__m256i b = _mm256_loadu_si256((const __m256i *)right);
+		_mm256_storeu_si256((__m256i *)left, b);
+		_mm256_storeu_si256((__m256i *)right, a);
+		left += 32;
+		right += 32;
+		bytes -= 32;
+	}
+	SwapTail(left, right, bytes);
+}
+#endif
+
+typedef void (*SwapBlocksFn)(unsigned char *left, unsigned char *right,
+			     size_t bytes);
+
+static SwapBlocksFn PickKernel(void)
+{
+#ifdef SWAP_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return SwapBlocksAvx2;
+#ifdef __SSE2__
+	return SwapBlocksSse2;
+#endif
+#endif
+	return SwapTail;
+}
+
+void SwapBlocks(void *left, void *right, size_t bytes)
+{
+	/* мелкие блоки не стоят выбора ядра */
+	if (bytes < 32) {
+		SwapTail(left, right, bytes);
+		return;
+	}
+	/* выбор один раз; гонка безобидна - все потоки запишут одно и то же */
+	static _Atomic(SwapBlocksFn) kernel;
+	SwapBlocksFn fn = atomic_load_explicit(&kernel, memory_order_relaxed);
+	if (fn == NULL) {
+		fn = PickKernel();
+		atomic_store_explicit(&kernel, fn, memory_order_relaxed);
+	}
+	fn(left, right, bytes);
+}
+
+/* сдвиг, когда одна из частей помещается в буфер на стеке */
+#define ROTATE_BUFFER 256
+
+static void RotateSmall(unsigned char *p, size_t left, size_t right)
+{
+	unsigned char temp[ROTATE_BUFFER];
+	if (left <= right) {
+		memcpy(temp, p, left);
+		memmove(p, p + left, right);
+		memcpy(p + right, temp, left);
+	} else {
+		memcpy(temp, p + left, right);
+		memmove(p + right, p, left);
+		memcpy(p, temp, right);
+	}
+}
+
+void RotateLeft(void *base, size_t bytes, size_t shift)
+{
+	unsigned char *p = base;
+	if (bytes == 0)
+		return;
+	shift %= bytes;
+	if (shift == 0)
+		return;
+
+	/*
+	 * Слева от точки split лежит ещё не поставленная часть длины left,
+	 * справа - длины right. Меньшая часть обменивается с равным куском
+	 * большей и встаёт на место; остаётся та же задача меньшего размера.
+	 * Когда меньшая часть помещается в буфер, мелкие обмены заменяются
+	 * одним memmove - иначе при left ~ right шагов становится очень много.
+	 */
+	size_t split = shift;
+	size_t left = shift;
+	size_t right = bytes - shift;
+	while (left != right) {
+		if (left <= ROTATE_BUFFER || right <= ROTATE_BUFFER) {
+			RotateSmall(p + split - left, left, right);
+			return;
+		}
+		if (left > right) {
+			SwapBlocks(p + split - left, p + split, right);
+			left -= right;
+		} else {
+			SwapBlocks(p + split - left, p + split + right - left, left);
+			right -= left;
+		}
+	}
+	SwapBlocks(p + split - left, p + split, left);
+}
+
+void RotateElements(void *base, size_t count, size_t size, size_t shift)
+{
+	if (count == 0)
+		return;
+	RotateLeft(base, count * size, (shift % count) * size);
+}
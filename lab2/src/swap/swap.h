@@ -1,2 +1,115 @@
+#ifndef SWAP_H
+#define SWAP_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 void Swap(char *left, char *right);
+
+/* обмен элементов фиксированной ширины - через регистр, без memcpy */
+static inline void Swap8(uint8_t *left, uint8_t *right)
+{
+	uint8_t temp = *left;
+	*left = *right;
+	*right = temp;
+}
+
+static inline void Swap16(uint16_t *left, uint16_t *right)
+{
+	uint16_t temp = *left;
+	*left = *right;
+	*right = temp;
+}
+
+static inline void Swap32(uint32_t *left, uint32_t *right)
+{
+	uint32_t temp = *left;
+	*left = *right;
+	*right = temp;
+}
+
+static inline void Swap64(uint64_t *left, uint64_t *right)
+{
+	uint64_t temp = *left;
+	*left = *right;
+	*right = temp;
+}
+
+static inline void Swap128(__uint128_t *left, __uint128_t *right)
+{
+	__uint128_t temp = *left;
+	*left = *right;
+	*right = temp;
+}
+
+/*
+ * Типы, несовместимые с uintN_t (float, double, long long на LP64), нельзя
+ * читать через uintN_t * - это нарушение strict aliasing. memcpy фиксированной
+ * длины компилятор сводит к тем же загрузкам в регистр.
+ */
+static inline void SwapBytes4(void *left, void *right)
+{
+	uint32_t a, b;
+	memcpy(&a, left, 4);
+	memcpy(&b, right, 4);
+	memcpy(left, &b, 4);
+	memcpy(right, &a, 4);
+}
+
+static inline void SwapBytes8(void *left, void *right)
+{
+	uint64_t a, b;
+	memcpy(&a, left, 8);
+	memcpy(&b, right, 8);
+	memcpy(left, &b, 8);
+	memcpy(right, &a, 8);
+}
+
+/* обмен блоков произвольного размера; большие - векторными регистрами */
+void SwapBlocks(void *left, void *right, size_t bytes);
+
+/*
+ * SWAP(a, b) выбирает обмен по типу указателя на этапе компиляции.
+ * Типы без своей ветки идут через SwapBlocks по sizeof(*a).
+ */
+#define SWAP_AS(bits, a, b) \
+	Swap##bits((uint##bits##_t *)(void *)(a), (uint##bits##_t *)(void *)(b))
+
+/* long совместим с uint64_t только там, где uint64_t - это unsigned long */
+#if ULONG_MAX == UINT64_MAX
+#define SWAP_LONG(a, b) SWAP_AS(64, a, b)
+#else
+#define SWAP_LONG(a, b) SwapBytes4((a), (b))
+#endif
+
+#define SWAP(a, b) _Generic((a), \
+	char *: Swap((char *)(a), (char *)(b)), \
+	signed char *: SWAP_AS(8, a, b), \
+	unsigned char *: SWAP_AS(8, a, b), \
+	short *: SWAP_AS(16, a, b), \
+	unsigned short *: SWAP_AS(16, a, b), \
+	int *: SWAP_AS(32, a, b), \
+	unsigned int *: SWAP_AS(32, a, b), \
+	float *: SwapBytes4((a), (b)), \
+	long *: SWAP_LONG(a, b), \
+	unsigned long *: SWAP_LONG(a, b), \
+	long long *: SwapBytes8((a), (b)), \
+	unsigned long long *: SwapBytes8((a), (b)), \
+	double *: SwapBytes8((a), (b)), \
+	__int128 *: Swap128((__uint128_t *)(void *)(a), (__uint128_t *)(void *)(b)), \
+	unsigned __int128 *: Swap128((__uint128_t *)(void *)(a), (__uint128_t *)(void *)(b)), \
+	default: SwapBlocks((a), (b), sizeof(*(a))))
+
+/*
+ * Циклический сдвиг влево на shift байт на месте: [0, shift) уезжает
+ * в конец. Алгоритм Гриса-Миллса: обмены блоков, без буфера на весь
+ * массив (хвост до 256 байт - через буфер на стеке).
+ */
+void RotateLeft(void *base, size_t bytes, size_t shift);
+
+/* то же для массива count элементов по size байт, сдвиг в элементах */
+void RotateElements(void *base, size_t count, size_t size, size_t shift);
+
+#endif
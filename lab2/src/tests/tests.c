@@ -1,5 +1,6 @@
 #include <CUnit/Basic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "revert_string.h"
@@ -23,6 +24,123 @@ void testRevertString(void) {
   CU_ASSERT_STRING_EQUAL_FATAL(str_with_even_chars_num, "dcba");
 }
 
+/* эталон: побайтовый переворот в новый буфер */
+static void ReferenceRevert(const char *src, char *dst, size_t length) {
+  for (size_t i = 0; i < length; i++) dst[i] = src[length - 1 - i];
+}
+
+static void FillRandom(char *buffer, size_t length, unsigned int *seed) {
+  for (size_t i = 0; i < length; i++)
+    buffer[i] = (char)(1 + rand_r(seed) % 255); /* без нулевых байтов */
+}
+
+void testRevertStringN(void) {
+  char with_zero[] = {'a', 'b', '\0', 'c', 'd'};
+  RevertStringN(with_zero, sizeof(with_zero));
+  CU_ASSERT_EQUAL(memcmp(with_zero, "dc\0ba", 5), 0);
+
+  char empty[] = "";
+  RevertStringN(empty, 0);
+  CU_ASSERT_STRING_EQUAL(empty, "");
+
+  char one[] = "x";
+  RevertStringN(one, 1);
+  CU_ASSERT_STRING_EQUAL(one, "x");
+}
+
+void testRevertStringUtf8(void) {
+  char cyrillic[] = "Привет, мир";
+  RevertStringUtf8(cyrillic, strlen(cyrillic));
+  CU_ASSERT_STRING_EQUAL(cyrillic, "рим ,тевирП");
+
+  /* 2, 3 и 4 байта на символ вперемешку с ASCII */
+  char mixed[] = "a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80z";
+  RevertStringUtf8(mixed, strlen(mixed));
+  CU_ASSERT_STRING_EQUAL(mixed, "z\xf0\x9f\x98\x80\xe2\x82\xac\xc3\xa9" "a");
+
+  /* дважды перевёрнутая строка совпадает с исходной */
+  char twice[] = "Ёжик 🦔 в тумане";
+  char original[sizeof(twice)];
+  memcpy(original, twice, sizeof(twice));
+  RevertStringUtf8(twice, strlen(twice));
+  RevertStringUtf8(twice, strlen(twice));
+  CU_ASSERT_STRING_EQUAL(twice, original);
+}
+
+/* случайные длины около границ 16/32/64-байтовых шагов SIMD-ядер */
+void testRevertStringFuzz(void) {
+  unsigned int seed = 12345;
+  char buffer[1024 + 1];
+  char expected[1024 + 1];
+  for (int iter = 0; iter < 5000; iter++) {
+    size_t length = iter < 300 ? (size_t)iter : (size_t)(rand_r(&seed) % 1024);
+    FillRandom(buffer, length, &seed);
+    buffer[length] = '\0';
+    ReferenceRevert(buffer, expected, length);
+    expected[length] = '\0';
+    if (iter % 2)
+      RevertString(buffer);
+    else
+      RevertStringN(buffer, length);
+    CU_ASSERT_EQUAL_FATAL(memcmp(buffer, expected, length + 1), 0);
+  }
+}
+
+void testRevertLarge(void) {
+  unsigned int seed = 7;
+  /* нечётная длина, больше порога деления между потоками */
+  size_t length = (8u << 20) + 77;
+  char *buffer = malloc(length + 1);
+  char *expected = malloc(length + 1);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(expected);
+  FillRandom(buffer, length, &seed);
+  buffer[length] = '\0';
+  ReferenceRevert(buffer, expected, length);
+  expected[length] = '\0';
+
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    RevertBuffer(buffer, length, threads);
+    CU_ASSERT_EQUAL_FATAL(memcmp(buffer, expected, length + 1), 0);
+    RevertBuffer(buffer, length, threads); /* обратно к исходной */
+  }
+  RevertString(buffer);
+  CU_ASSERT_EQUAL(memcmp(buffer, expected, length + 1), 0);
+  free(buffer);
+  free(expected);
+}
+
+void testRevertStrings(void) {
+  enum { kCount = 1000 };
+  unsigned int seed = 99;
+  char *strings[kCount];
+  char *expected[kCount];
+  size_t lengths[kCount];
+  for (int i = 0; i < kCount; i++) {
+    lengths[i] = (size_t)(rand_r(&seed) % 200);
+    strings[i] = malloc(lengths[i] + 1);
+    expected[i] = malloc(lengths[i] + 1);
+    FillRandom(strings[i], lengths[i], &seed);
+    strings[i][lengths[i]] = '\0';
+    ReferenceRevert(strings[i], expected[i], lengths[i]);
+    expected[i][lengths[i]] = '\0';
+  }
+
+  RevertStrings(strings, lengths, kCount, 4);
+  for (int i = 0; i < kCount; i++)
+    CU_ASSERT_STRING_EQUAL_FATAL(strings[i], expected[i]);
+  /* без длин - через strlen, обратно к исходным */
+  RevertStrings(strings, NULL, kCount, 3);
+  for (int i = 0; i < kCount; i++) {
+    RevertStringN(expected[i], lengths[i]);
+    CU_ASSERT_STRING_EQUAL_FATAL(strings[i], expected[i]);
+  }
+  for (int i = 0; i < kCount; i++) {
+    free(strings[i]);
+    free(expected[i]);
+  }
+}
+
 int main() {
   CU_pSuite pSuite = NULL;
 
@@ -39,7 +157,17 @@ int main() {
   /* add the tests to the suite */
   /* NOTE - ORDER IS IMPORTANT - MUST TEST fread() AFTER fprintf() */
   if ((NULL == CU_add_test(pSuite, "test of RevertString function",
-                           testRevertString))) {
+                           testRevertString)) ||
+      (NULL == CU_add_test(pSuite, "test of RevertStringN function",
+                           testRevertStringN)) ||
+      (NULL == CU_add_test(pSuite, "test of RevertStringUtf8 function",
+                           testRevertStringUtf8)) ||
+      (NULL == CU_add_test(pSuite, "fuzz of RevertString against reference",
+                           testRevertStringFuzz)) ||
+      (NULL == CU_add_test(pSuite, "test of RevertBuffer on 8 MiB",
+                           testRevertLarge)) ||
+      (NULL == CU_add_test(pSuite, "test of RevertStrings function",
+                           testRevertStrings))) {
     CU_cleanup_registry();
     return CU_get_error();
   }
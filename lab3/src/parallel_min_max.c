@@ -1,18 +1,111 @@
-#define _POSIX_C_SOURCE 199309L
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <time.h>
+#include "arena.h"
+#include "self_path.h"
+#include "shm_array.h"
 #include "utils.h"
 #include "find_min_max.h"
+#include "trace.h"
 
 #define MAX_PROCESSES 100
+#define WORKER_NAME "sequential_min_max"
+
+// Режим shm: массив генерируется один раз в разделяемом сегменте (memfd
+// или shm_open), рабочие - отдельные программы sequential_min_max,
+// запущенные через exec, - отображают его только на чтение и пишут
+// результаты в слоты сегмента. Кусок упавшего рабочего досчитывает родитель.
+static int run_shm_mode(const char *argv0, unsigned int array_size,
+                        unsigned int seed, int num_processes,
+                        const char *shm_name) {
+    char worker_exe[4096];
+    // рабочий - рядом с нашим исполняемым файлом, а не в текущем каталоге
+    if (SiblingPath(argv0, WORKER_NAME, worker_exe, sizeof(worker_exe)) != 0) {
+        perror("cannot locate " WORKER_NAME);
+        return 1;
+    }
+
+    struct ShmArray shm;
+    if (ShmArrayCreate(&shm, shm_name, array_size, num_processes) != 0) {
+        perror("shm create");
+        return 1;
+    }
+    TraceBegin("generate");
+    GenerateArray(shm.data, array_size, seed);
+    TraceEnd("generate");
+
+    char spec[80];
+    ShmArraySpec(&shm, spec, sizeof(spec));
+
+    struct timespec start_time, end_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    pid_t pids[MAX_PROCESSES];
+    TraceBegin("spawn");
+    for (int i = 0; i < num_processes; i++) {
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            char worker[16];
+            snprintf(worker, sizeof(worker), "%d", i);
+            char *args[] = {worker_exe, "--shm", spec, worker, NULL};
+            execv(args[0], args);
+            perror(worker_exe);
+            _exit(127);
+        } else if (pids[i] < 0) {
+            perror("fork");
+            num_processes = i;
+            break;
+        }
+    }
+    TraceEnd("spawn");
+
+    struct MinMax final_result = {__INT_MAX__, -__INT_MAX__ - 1};
+    for (int i = 0; i < num_processes; i++) {
+        int status = 0;
+        TraceBeginArg("wait", "worker", i);
+        waitpid(pids[i], &status, 0);
+        TraceEnd("wait");
+
+        struct ShmResult *result = ShmArrayResult(&shm, i);
+        struct MinMax local;
+        if (__atomic_load_n(&result->done, __ATOMIC_ACQUIRE)) {
+            local.min = result->min;
+            local.max = result->max;
+        } else {
+            // рабочий упал или не запустился - массив цел, считаем сами
+            if (WIFSIGNALED(status))
+                printf("Worker %d killed by signal %d, recomputing\n", i, WTERMSIG(status));
+            else
+                printf("Worker %d exited with %d, recomputing\n", i, WEXITSTATUS(status));
+            size_t begin, end;
+            ShmArrayChunk(&shm, i, &begin, &end);
+            TraceBeginArg("recompute chunk", "worker", i);
+            local = GetMinMax(shm.data, begin, end);
+            TraceEnd("recompute chunk");
+        }
+        if (local.min < final_result.min) final_result.min = local.min;
+        if (local.max > final_result.max) final_result.max = local.max;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    double execution_time = (end_time.tv_sec - start_time.tv_sec) +
+                           (end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+
+    printf("Min: %d\n", final_result.min);
+    printf("Max: %d\n", final_result.max);
+    printf("Execution time: %.6f seconds\n", execution_time);
+
+    ShmArrayClose(&shm);
+    return 0;
+}
 
 int main(int argc, char *argv[]) {
     if (argc != 5) {
-        printf("Usage: %s <array_size> <seed> <num_processes> <pipe|files>\n", argv[0]);
+        printf("Usage: %s <array_size> <seed> <num_processes> <pipe|files|shm[:/name]>\n", argv[0]);
         return 1;
     }
     
@@ -26,16 +119,27 @@ int main(int argc, char *argv[]) {
         printf("Number of processes must be between 1 and %d\n", MAX_PROCESSES);
         return 1;
     }
+
+    TraceInitFromEnv("parallel_min_max");
+    if (strcmp(argv[4], "shm") == 0)
+        return run_shm_mode(argv[0], array_size, seed, num_processes, NULL);
+    if (strncmp(argv[4], "shm:", 4) == 0)
+        return run_shm_mode(argv[0], array_size, seed, num_processes, argv[4] + 4);
     
-    // Выделение памяти для массива
-    int *array = (int*)malloc(sizeof(int) * array_size);
-    if (array == NULL) {
+    // Выделение памяти для массива (арена на огромных страницах)
+    struct ArenaOptions arena_opts;
+    struct Arena arena;
+    ArenaOptionsFromEnv(&arena_opts);
+    if (ArenaInit(&arena, sizeof(int) * array_size, &arena_opts) != 0) {
         printf("Memory allocation failed\n");
         return 1;
     }
+    int *array = ArenaAlloc(&arena, sizeof(int) * array_size);
     
     // Генерация массива
+    TraceBegin("generate");
     GenerateArray(array, array_size, seed);
+    TraceEnd("generate");
     
     // Создание pipe'ов если используется pipe
     int pipe_fds[MAX_PROCESSES][2];
@@ -43,7 +147,7 @@ int main(int argc, char *argv[]) {
         for (int i = 0; i < num_processes; i++) {
             if (pipe(pipe_fds[i]) == -1) {
                 perror("pipe");
-                free(array);
+                ArenaDestroy(&arena);
                 return 1;
             }
         }
@@ -54,11 +158,12 @@ int main(int argc, char *argv[]) {
     clock_gettime(CLOCK_MONOTONIC, &start_time);
     
     // Создание дочерних процессов
+    TraceBegin("spawn");
     for (int i = 0; i < num_processes; i++) {
         pid_t pid = fork();
         
         if (pid == 0) {
-            // Дочерний процесс
+            // Дочерний процесс (его события дописываются в трассу при exit)
             if (use_pipe) {
                 close(pipe_fds[i][0]); // Закрываем чтение в дочернем процессе
             }
@@ -69,8 +174,11 @@ int main(int argc, char *argv[]) {
             int end = (i == num_processes - 1) ? array_size : (i + 1) * chunk_size;
             
             // Находим min и max в своем диапазоне
+            TraceBeginArg("chunk", "elements", end - begin);
             struct MinMax local_min_max = GetMinMax(array, begin, end);
+            TraceEnd("chunk");
             
+            TraceBegin(use_pipe ? "pipe write" : "file write");
             if (use_pipe) {
                 // Передача через pipe
                 write(pipe_fds[i][1], &local_min_max, sizeof(struct MinMax));
@@ -86,15 +194,16 @@ int main(int argc, char *argv[]) {
                     fclose(file);
                 }
             }
+            TraceEnd(use_pipe ? "pipe write" : "file write");
             
-            free(array);
             exit(0);
         } else if (pid < 0) {
             printf("Fork failed\n");
-            free(array);
+            ArenaDestroy(&arena);
             return 1;
         }
     }
+    TraceEnd("spawn");
     
     // Родительский процесс
     if (use_pipe) {
@@ -104,13 +213,16 @@ int main(int argc, char *argv[]) {
     }
     
     // Ожидание завершения всех дочерних процессов
+    TraceBegin("wait");
     for (int i = 0; i < num_processes; i++) {
         wait(NULL);
     }
+    TraceEnd("wait");
     
     // Сбор результатов
     struct MinMax partial_results[MAX_PROCESSES];
     
+    TraceBegin("collect");
     if (use_pipe) {
         // Чтение из pipe
         for (int i = 0; i < num_processes; i++) {
@@ -131,8 +243,10 @@ int main(int argc, char *argv[]) {
             }
         }
     }
+    TraceEnd("collect");
     
     // Объединение результатов
+    TraceBegin("combine");
     struct MinMax final_result;
     final_result.min = partial_results[0].min;
     final_result.max = partial_results[0].max;
@@ -145,6 +259,7 @@ int main(int argc, char *argv[]) {
             final_result.max = partial_results[i].max;
         }
     }
+    TraceEnd("combine");
     
     // Замер времени окончания
     clock_gettime(CLOCK_MONOTONIC, &end_time);
@@ -157,9 +272,10 @@ int main(int argc, char *argv[]) {
     printf("Min: %d\n", final_result.min);
     printf("Max: %d\n", final_result.max);
     printf("Execution time: %.6f seconds\n", execution_time);
+    ArenaReportTimes(&arena, execution_time);
     
     // Очистка
-    free(array);
+    ArenaDestroy(&arena);
     
     return 0;
 }
\ No newline at end of file
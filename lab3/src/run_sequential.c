@@ -5,6 +5,8 @@
 #include <sys/wait.h>
 #include <string.h>
 
+#include "self_path.h"
+
 int main(int argc, char **argv) {
     if (argc != 3) {
         printf("Usage: %s seed arraysize\n", argv[0]);
@@ -16,7 +18,13 @@ int main(int argc, char **argv) {
     // argv[0] - имя программы-обертки
     // argv[1] - seed
     // argv[2] - arraysize
-    const char *prog_name = "./sequential_min_max"; // Имя исполняемого файла
+    // sequential_min_max ищем в каталоге обёртки, а не в текущем
+    char prog_name[4096];
+    if (SiblingPath(argv[0], "sequential_min_max", prog_name, sizeof(prog_name)) != 0 ||
+        access(prog_name, X_OK) != 0) {
+        perror("cannot locate sequential_min_max next to the wrapper");
+        return 1;
+    }
 
     pid_t pid = fork();
 
@@ -28,14 +36,14 @@ int main(int argc, char **argv) {
         // Дочерний процесс
         printf("Child process (PID: %d) is launching %s...\n", getpid(), prog_name);
 
-        // execlp заменяет текущий образ процесса на sequential_min_max.
-        // Первый аргумент - имя программы (с поиском в PATH).
+        // execl заменяет текущий образ процесса на sequential_min_max.
+        // Первый аргумент - полный путь к программе.
         // Далее идут аргументы для запускаемой программы (включая ее имя), 
         // завершаясь NULL.
-        execlp(prog_name, prog_name, argv[1], argv[2], (char *)NULL);
+        execl(prog_name, prog_name, argv[1], argv[2], (char *)NULL);
 
-        // Если execlp вернула управление, значит произошла ошибка (программа не найдена/не запущена)
-        perror("execlp failed to launch sequential_min_max");
+        // Если execl вернула управление, значит произошла ошибка (программа не найдена/не запущена)
+        perror("execl failed to launch sequential_min_max");
         exit(1); 
     } else {
         // Родительский процесс
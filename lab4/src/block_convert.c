@@ -0,0 +1,118 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "block_format.h"
+
+// Конвертер между «сырым» бинарным файлом int и блочным форматом,
+// плюс запросы агрегатов прямо по индексу блочного файла.
+
+static void PrintUsage(const char *prog) {
+  printf("Usage:\n");
+  printf("  %s pack <raw_in> <block_out>\n", prog);
+  printf("  %s unpack <block_in> <raw_out>\n", prog);
+  printf("  %s stat <block_in> [begin end]\n", prog);
+}
+
+static int Pack(const char *in, const char *out) {
+  int fd = open(in, O_RDONLY);
+  if (fd < 0) {
+    perror("open");
+    return 1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    perror("fstat");
+    close(fd);
+    return 1;
+  }
+  size_t count = (size_t)st.st_size / sizeof(int);
+  const int *array = NULL;
+  if (count > 0) {
+    array = mmap(NULL, count * sizeof(int), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (array == MAP_FAILED) {
+      perror("mmap");
+      close(fd);
+      return 1;
+    }
+  }
+  close(fd);
+
+  int rc = BlockFileWrite(out, array, count);
+  if (array != NULL) munmap((void *)array, count * sizeof(int));
+  if (rc == 0) {
+    struct stat out_st;
+    stat(out, &out_st);
+    printf("packed %zu elements: %lld -> %lld bytes\n", count,
+           (long long)st.st_size, (long long)out_st.st_size);
+  }
+  return rc == 0 ? 0 : 1;
+}
+
+static int Unpack(const char *in, const char *out) {
+  struct BlockFile bf;
+  if (BlockFileOpen(in, &bf) != 0) return 1;
+  FILE *f = fopen(out, "wb");
+  int *buf = malloc(sizeof(int) * BLOCK_ELEMS);
+  if (f == NULL || buf == NULL) {
+    perror("unpack");
+    if (f) fclose(f);
+    free(buf);
+    BlockFileClose(&bf);
+    return 1;
+  }
+  int rc = 0;
+  for (uint64_t b = 0; b < bf.blocks; b++) {
+    BlockDecodeRange(&bf, b, 0, bf.index[b].count, buf);
+    if (fwrite(buf, sizeof(int), bf.index[b].count, f) != bf.index[b].count) {
+      perror("fwrite");
+      rc = 1;
+      break;
+    }
+  }
+  if (fclose(f) != 0) rc = 1;
+  free(buf);
+  BlockFileClose(&bf);
+  return rc;
+}
+
+static int Stat(const char *in, int argc, char **argv) {
+  struct BlockFile bf;
+  if (BlockFileOpen(in, &bf) != 0) return 1;
+  size_t begin = 0;
+  size_t end = bf.count;
+  if (argc == 2) {
+    begin = strtoull(argv[0], NULL, 10);
+    end = strtoull(argv[1], NULL, 10);
+  }
+  if (begin > end || end > bf.count) {
+    fprintf(stderr, "range must satisfy begin <= end <= %llu\n",
+            (unsigned long long)bf.count);
+    BlockFileClose(&bf);
+    return 1;
+  }
+  printf("count: %llu, blocks: %llu\n", (unsigned long long)bf.count,
+         (unsigned long long)bf.blocks);
+  if (begin < end) {
+    struct MinMax mm = BlockQueryMinMax(&bf, begin, end);
+    printf("range [%zu, %zu): min: %d, max: %d, sum: %lld\n", begin, end,
+           mm.min, mm.max, BlockQuerySum(&bf, begin, end));
+  }
+  BlockFileClose(&bf);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc == 4 && strcmp(argv[1], "pack") == 0)
+    return Pack(argv[2], argv[3]);
+  if (argc == 4 && strcmp(argv[1], "unpack") == 0)
+    return Unpack(argv[2], argv[3]);
+  if ((argc == 3 || argc == 5) && strcmp(argv[1], "stat") == 0)
+    return Stat(argv[2], argc - 3, argv + 3);
+  PrintUsage(argv[0]);
+  return 1;
+}
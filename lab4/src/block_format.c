@@ -0,0 +1,309 @@
+#define _GNU_SOURCE
+#include "block_format.h"
+
+#include <endian.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define HEADER_MAGIC "MINMAXB1"
+#define TRAILER_MAGIC "MINMAXIX"
+#define HEADER_SIZE 32
+#define ENTRY_SIZE 32
+#define TRAILER_SIZE 24
+#define BLOCK_PAD 8  // запас, чтобы декодер мог читать по 8 байт
+
+static void Put32(unsigned char *p, uint32_t v) {
+  v = htole32(v);
+  memcpy(p, &v, 4);
+}
+
+static void Put64(unsigned char *p, uint64_t v) {
+  v = htole64(v);
+  memcpy(p, &v, 8);
+}
+
+static uint32_t Get32(const unsigned char *p) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return le32toh(v);
+}
+
+static uint64_t Get64(const unsigned char *p) {
+  uint64_t v;
+  memcpy(&v, p, 8);
+  return le64toh(v);
+}
+
+static uint32_t BitsFor(uint32_t range) {
+  return range == 0 ? 0 : 32 - (uint32_t)__builtin_clz(range);
+}
+
+static size_t PackedBytes(uint32_t count, uint32_t bits) {
+  size_t words = ((size_t)count * bits + 63) / 64;
+  return words * 8 + BLOCK_PAD;
+}
+
+int IsBlockFile(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) return -1;
+  char magic[8];
+  size_t n = fread(magic, 1, sizeof(magic), f);
+  fclose(f);
+  return n == sizeof(magic) && memcmp(magic, HEADER_MAGIC, 8) == 0;
+}
+
+int BlockFileWrite(const char *path, const int *array, size_t count) {
+  FILE *f = fopen(path, "wb");
+  if (f == NULL) {
+    perror("fopen");
+    return -1;
+  }
+
+  uint64_t blocks = (count + BLOCK_ELEMS - 1) / BLOCK_ELEMS;
+  struct BlockIndexEntry *index = calloc(blocks ? blocks : 1, sizeof(*index));
+  uint64_t *packed = malloc(PackedBytes(BLOCK_ELEMS, 32));
+  if (index == NULL || packed == NULL) {
+    free(index);
+    free(packed);
+    fclose(f);
+    return -1;
+  }
+
+  unsigned char header[HEADER_SIZE] = {0};
+  memcpy(header, HEADER_MAGIC, 8);
+  Put32(header + 8, 1);
+  Put32(header + 12, BLOCK_ELEMS);
+  Put64(header + 16, count);
+  fwrite(header, 1, sizeof(header), f);
+  uint64_t offset = HEADER_SIZE;
+
+  for (uint64_t b = 0; b < blocks; b++) {
+    const int *v = array + b * BLOCK_ELEMS;
+    uint32_t n = (uint32_t)(count - b * BLOCK_ELEMS < BLOCK_ELEMS
+                                ? count - b * BLOCK_ELEMS
+                                : BLOCK_ELEMS);
+    int32_t mn = v[0], mx = v[0];
+    int64_t sum = 0;
+    for (uint32_t i = 0; i < n; i++) {
+      if (v[i] < mn) mn = v[i];
+      if (v[i] > mx) mx = v[i];
+      sum += v[i];
+    }
+    uint32_t bits = BitsFor((uint32_t)mx - (uint32_t)mn);
+    size_t bytes = PackedBytes(n, bits);
+    memset(packed, 0, bytes);
+
+    // упаковка разностей v - min по bits бит подряд
+    uint64_t bitpos = 0;
+    for (uint32_t i = 0; i < n && bits > 0; i++, bitpos += bits) {
+      uint64_t delta = (uint32_t)v[i] - (uint32_t)mn;
+      uint64_t word = bitpos / 64;
+      uint32_t shift = bitpos % 64;
+      packed[word] |= htole64(delta << shift);
+      if (shift + bits > 64) packed[word + 1] |= htole64(delta >> (64 - shift));
+    }
+
+    index[b].offset = offset;
+    index[b].count = n;
+    index[b].bits = bits;
+    index[b].min = mn;
+    index[b].max = mx;
+    index[b].sum = sum;
+    if (fwrite(packed, 1, bytes, f) != bytes) {
+      perror("fwrite");
+      free(index);
+      free(packed);
+      fclose(f);
+      return -1;
+    }
+    offset += bytes;
+  }
+
+  uint64_t index_offset = offset;
+  for (uint64_t b = 0; b < blocks; b++) {
+    unsigned char e[ENTRY_SIZE];
+    Put64(e, index[b].offset);
+    Put32(e + 8, index[b].count);
+    Put32(e + 12, index[b].bits);
+    Put32(e + 16, (uint32_t)index[b].min);
+    Put32(e + 20, (uint32_t)index[b].max);
+    Put64(e + 24, (uint64_t)index[b].sum);
+    fwrite(e, 1, sizeof(e), f);
+  }
+  unsigned char trailer[TRAILER_SIZE];
+  Put64(trailer, index_offset);
+  Put64(trailer + 8, blocks);
+  memcpy(trailer + 16, TRAILER_MAGIC, 8);
+  fwrite(trailer, 1, sizeof(trailer), f);
+
+  free(index);
+  free(packed);
+  if (fclose(f) != 0) {
+    perror("fclose");
+    return -1;
+  }
+  return 0;
+}
+
+int BlockFileOpen(const char *path, struct BlockFile *bf) {
+  memset(bf, 0, sizeof(*bf));
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    perror("open");
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0 || st.st_size < HEADER_SIZE + TRAILER_SIZE) {
+    fprintf(stderr, "%s: not a block file\n", path);
+    close(fd);
+    return -1;
+  }
+  bf->map_size = (size_t)st.st_size;
+  void *map = mmap(NULL, bf->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    perror("mmap");
+    return -1;
+  }
+  bf->map = map;
+
+  const unsigned char *trailer = bf->map + bf->map_size - TRAILER_SIZE;
+  if (memcmp(bf->map, HEADER_MAGIC, 8) != 0 ||
+      memcmp(trailer + 16, TRAILER_MAGIC, 8) != 0 ||
+      Get32(bf->map + 12) != BLOCK_ELEMS) {
+    fprintf(stderr, "%s: bad block file header\n", path);
+    BlockFileClose(bf);
+    return -1;
+  }
+  bf->count = Get64(bf->map + 16);
+  uint64_t index_offset = Get64(trailer);
+  bf->blocks = Get64(trailer + 8);
+  // все проверки без переполнений: поля файла могут быть любыми
+  if (bf->blocks > (bf->map_size - TRAILER_SIZE) / ENTRY_SIZE ||
+      index_offset < HEADER_SIZE ||
+      index_offset != bf->map_size - TRAILER_SIZE - bf->blocks * ENTRY_SIZE ||
+      bf->count > bf->blocks * BLOCK_ELEMS ||
+      bf->blocks != (bf->count + BLOCK_ELEMS - 1) / BLOCK_ELEMS) {
+    fprintf(stderr, "%s: corrupted block index\n", path);
+    BlockFileClose(bf);
+    return -1;
+  }
+
+  bf->index = calloc(bf->blocks ? bf->blocks : 1, sizeof(*bf->index));
+  if (bf->index == NULL) {
+    BlockFileClose(bf);
+    return -1;
+  }
+  for (uint64_t b = 0; b < bf->blocks; b++) {
+    const unsigned char *e = bf->map + index_offset + b * ENTRY_SIZE;
+    struct BlockIndexEntry *ie = &bf->index[b];
+    ie->offset = Get64(e);
+    ie->count = Get32(e + 8);
+    ie->bits = Get32(e + 12);
+    ie->min = (int32_t)Get32(e + 16);
+    ie->max = (int32_t)Get32(e + 20);
+    ie->sum = (int64_t)Get64(e + 24);
+    // Запросы считают позицию как b * BLOCK_ELEMS + i, поэтому все блоки,
+    // кроме последнего, обязаны быть полными, а последний - добирать
+    // count точно. Данные блока целиком лежат между заголовком и индексом.
+    uint64_t expected = b + 1 < bf->blocks
+                            ? BLOCK_ELEMS
+                            : bf->count - (bf->blocks - 1) * BLOCK_ELEMS;
+    if (ie->bits > 32 || ie->count != expected || ie->offset < HEADER_SIZE ||
+        ie->offset > index_offset ||
+        PackedBytes(ie->count, ie->bits) > index_offset - ie->offset) {
+      fprintf(stderr, "%s: corrupted block %llu\n", path,
+              (unsigned long long)b);
+      BlockFileClose(bf);
+      return -1;
+    }
+  }
+  // данные читаются последовательно по блокам
+  madvise((void *)bf->map, bf->map_size, MADV_SEQUENTIAL);
+  return 0;
+}
+
+void BlockFileClose(struct BlockFile *bf) {
+  if (bf->map != NULL) munmap((void *)bf->map, bf->map_size);
+  free(bf->index);
+  memset(bf, 0, sizeof(*bf));
+}
+
+void BlockDecodeRange(const struct BlockFile *bf, uint64_t block, uint32_t from,
+                      uint32_t to, int *out) {
+  const struct BlockIndexEntry *e = &bf->index[block];
+  uint32_t base = (uint32_t)e->min;
+  if (e->bits == 0) {
+    for (uint32_t i = from; i < to; i++) *out++ = e->min;
+    return;
+  }
+  const unsigned char *data = bf->map + e->offset;
+  uint64_t mask = (e->bits == 32) ? 0xffffffffULL : ((1ULL << e->bits) - 1);
+  uint64_t bitpos = (uint64_t)from * e->bits;
+  for (uint32_t i = from; i < to; i++, bitpos += e->bits) {
+    // 8 байт, начиная с нужного, всегда содержат значение целиком
+    uint64_t word = Get64(data + bitpos / 8);
+    uint32_t delta = (uint32_t)((word >> (bitpos % 8)) & mask);
+    *out++ = (int)(base + delta);
+  }
+}
+
+struct MinMax BlockQueryMinMax(const struct BlockFile *bf, size_t begin,
+                               size_t end) {
+  struct MinMax r = {INT_MAX, INT_MIN};
+  if (end > bf->count) end = bf->count;
+  int *tmp = NULL;
+  for (size_t pos = begin; pos < end;) {
+    uint64_t b = pos / BLOCK_ELEMS;
+    uint32_t from = (uint32_t)(pos % BLOCK_ELEMS);
+    uint32_t to = bf->index[b].count;
+    if (b * BLOCK_ELEMS + to > end) to = (uint32_t)(end - b * BLOCK_ELEMS);
+
+    if (from == 0 && to == bf->index[b].count) {
+      if (bf->index[b].min < r.min) r.min = bf->index[b].min;
+      if (bf->index[b].max > r.max) r.max = bf->index[b].max;
+    } else if (bf->index[b].min < r.min || bf->index[b].max > r.max) {
+      // неполный блок распаковываем, только если он может что-то изменить
+      if (tmp == NULL) tmp = malloc(sizeof(int) * BLOCK_ELEMS);
+      if (tmp == NULL) break;
+      BlockDecodeRange(bf, b, from, to, tmp);
+      for (uint32_t i = 0; i < to - from; i++) {
+        if (tmp[i] < r.min) r.min = tmp[i];
+        if (tmp[i] > r.max) r.max = tmp[i];
+      }
+    }
+    pos = b * BLOCK_ELEMS + to;
+  }
+  free(tmp);
+  return r;
+}
+
+long long BlockQuerySum(const struct BlockFile *bf, size_t begin, size_t end) {
+  long long sum = 0;
+  if (end > bf->count) end = bf->count;
+  int *tmp = NULL;
+  for (size_t pos = begin; pos < end;) {
+    uint64_t b = pos / BLOCK_ELEMS;
+    uint32_t from = (uint32_t)(pos % BLOCK_ELEMS);
+    uint32_t to = bf->index[b].count;
+    if (b * BLOCK_ELEMS + to > end) to = (uint32_t)(end - b * BLOCK_ELEMS);
+
+    if (from == 0 && to == bf->index[b].count) {
+      sum += bf->index[b].sum;
+    } else {
+      if (tmp == NULL) tmp = malloc(sizeof(int) * BLOCK_ELEMS);
+      if (tmp == NULL) break;
+      BlockDecodeRange(bf, b, from, to, tmp);
+      for (uint32_t i = 0; i < to - from; i++) sum += tmp[i];
+    }
+    pos = b * BLOCK_ELEMS + to;
+  }
+  free(tmp);
+  return sum;
+}
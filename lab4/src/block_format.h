@@ -0,0 +1,56 @@
+#ifndef BLOCK_FORMAT_H
+#define BLOCK_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utils.h"
+
+// Блочный формат входных файлов для parallel_min_max / parallel_sum.
+//
+//   [заголовок 32 байта] [блок 0] [блок 1] ... [индекс] [хвост 24 байта]
+//
+// Блок - до BLOCK_ELEMS чисел, сжатых frame-of-reference: хранится
+// минимум блока и разности (v - min), упакованные по bits бит.
+// Индекс в конце файла содержит для каждого блока смещение, число
+// элементов, min, max и сумму, поэтому агрегаты по целым блокам
+// считаются без чтения данных. Все поля - little-endian.
+
+#define BLOCK_ELEMS 65536
+
+struct BlockIndexEntry {
+  uint64_t offset;  // смещение данных блока от начала файла
+  uint32_t count;
+  uint32_t bits;
+  int32_t min;
+  int32_t max;
+  int64_t sum;
+};
+
+struct BlockFile {
+  const unsigned char *map;
+  size_t map_size;
+  uint64_t count;
+  uint64_t blocks;
+  struct BlockIndexEntry *index;
+};
+
+// 1 - файл начинается с магии блочного формата, 0 - нет, -1 - ошибка.
+int IsBlockFile(const char *path);
+
+int BlockFileWrite(const char *path, const int *array, size_t count);
+
+int BlockFileOpen(const char *path, struct BlockFile *bf);
+void BlockFileClose(struct BlockFile *bf);
+
+// Распаковывает элементы [from, to) блока block в out.
+void BlockDecodeRange(const struct BlockFile *bf, uint64_t block, uint32_t from,
+                      uint32_t to, int *out);
+
+// Агрегаты по элементам [begin, end): целые блоки берутся из индекса,
+// распаковываются только крайние неполные блоки.
+struct MinMax BlockQueryMinMax(const struct BlockFile *bf, size_t begin,
+                               size_t end);
+long long BlockQuerySum(const struct BlockFile *bf, size_t begin, size_t end);
+
+#endif
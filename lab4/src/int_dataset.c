@@ -0,0 +1,545 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "int_text.h"
+
+// Наборы данных для parallel_min_max files / parallel_sort files:
+// сырой файл int32 в порядке байтов машины (как читает fread).
+//
+//   int_dataset gen <out> --count N [--dist D] [--seed S] [--min a --max b]
+//   int_dataset to_text <in.raw> <out.txt>
+//   int_dataset from_text <in.txt> <out.raw>
+//
+// Генерация: значение i зависит только от seed и i (splitmix64), поэтому
+// файл не зависит от числа потоков; каждый поток пишет свой кусок через
+// pwrite по своему смещению. dist rand повторяет GenerateArray
+// (srand/rand) и потому идёт в один поток.
+// Текст - одно число в строке; при чтении годится любой пробельный
+// разделитель.
+
+#define GEN_BUFFER_ELEMS (1 << 20)  // 4 МиБ на pwrite
+#define TEXT_BUFFER_BYTES (4 << 20)
+
+enum Dist { DIST_UNIFORM, DIST_NORMAL, DIST_SKEW, DIST_SORTED, DIST_REVERSE,
+            DIST_CONSTANT, DIST_RAND };
+
+static const char *kDistNames[] = {"uniform", "normal", "skew", "sorted",
+                                   "reverse", "constant", "rand"};
+
+struct Options {
+  uint64_t count;
+  enum Dist dist;
+  uint64_t seed;
+  int64_t min;
+  int64_t max;
+  int threads;
+};
+
+static double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t Mix(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+static int32_t Value(const struct Options *opt, uint64_t key, uint64_t i) {
+  uint64_t range = (uint64_t)(opt->max - opt->min) + 1;  // до 2^32
+  uint64_t r = Mix(key + i);
+  double u = ((r >> 11) + 0.5) / 9007199254740992.0;  // (0, 1)
+  switch (opt->dist) {
+    case DIST_UNIFORM:
+      return (int32_t)(opt->min + (int64_t)(((r >> 32) * range) >> 32));
+    case DIST_NORMAL: {
+      // Бокс-Мюллер; центр - середина диапазона, 4 сигмы до краёв
+      double u2 = (double)(r & 0xFFFFFFFFULL) / 4294967296.0;
+      double z = sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * u2);
+      double v = (opt->min + (double)opt->max) / 2.0 + z * (double)range / 8.0;
+      if (v < (double)opt->min) v = (double)opt->min;
+      if (v > (double)opt->max) v = (double)opt->max;
+      return (int32_t)v;
+    }
+    case DIST_SKEW:
+      // большая часть значений у минимума, длинный хвост к максимуму
+      return (int32_t)(opt->min + (int64_t)(u * u * u * u * (double)(range - 1)));
+    case DIST_SORTED:
+      return (int32_t)(opt->min + (int64_t)((__uint128_t)i * range / opt->count));
+    case DIST_REVERSE:
+      return (int32_t)(opt->max -
+                       (int64_t)((__uint128_t)i * range / opt->count));
+    case DIST_CONSTANT:
+    default:
+      return (int32_t)opt->min;
+  }
+}
+
+static int WriteAll(int fd, const void *buf, size_t bytes, off_t offset) {
+  const char *p = buf;
+  while (bytes > 0) {
+    ssize_t n = pwrite(fd, p, bytes, offset);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += n;
+    bytes -= (size_t)n;
+    offset += n;
+  }
+  return 0;
+}
+
+// Запускает fn на каждой из threads частей; часть, для которой поток не
+// создался, выполняется в текущем потоке.
+static void RunParallel(int threads, void *(*fn)(void *), void *parts,
+                        size_t part_size) {
+  pthread_t tids[threads];
+  int created[threads];
+  for (int t = 0; t < threads; t++) {
+    void *part = (char *)parts + (size_t)t * part_size;
+    created[t] = pthread_create(&tids[t], NULL, fn, part) == 0;
+    if (!created[t]) fn(part);
+  }
+  for (int t = 0; t < threads; t++)
+    if (created[t]) pthread_join(tids[t], NULL);
+}
+
+static uint64_t PartBegin(uint64_t count, int threads, int t) {
+  return count / (uint64_t)threads * (uint64_t)t;
+}
+
+static uint64_t PartEnd(uint64_t count, int threads, int t) {
+  return t == threads - 1 ? count : PartBegin(count, threads, t + 1);
+}
+
+struct GenPart {
+  const struct Options *opt;
+  int fd;
+  uint64_t begin;
+  uint64_t end;
+  int status;
+};
+
+static void *GenWorker(void *arg) {
+  struct GenPart *part = arg;
+  const struct Options *opt = part->opt;
+  int32_t *buffer = malloc(GEN_BUFFER_ELEMS * sizeof(int32_t));
+  if (buffer == NULL) {
+    part->status = -1;
+    return NULL;
+  }
+  uint64_t key = Mix(opt->seed);
+  for (uint64_t pos = part->begin; pos < part->end; pos += GEN_BUFFER_ELEMS) {
+    uint64_t n = part->end - pos < GEN_BUFFER_ELEMS ? part->end - pos
+                                                    : GEN_BUFFER_ELEMS;
+    for (uint64_t k = 0; k < n; k++) buffer[k] = Value(opt, key, pos + k);
+    if (WriteAll(part->fd, buffer, n * sizeof(int32_t),
+                 (off_t)(pos * sizeof(int32_t))) != 0) {
+      part->status = -1;
+      break;
+    }
+  }
+  free(buffer);
+  return NULL;
+}
+
+// rand() - одна последовательность, поэтому один поток
+static int GenRand(const struct Options *opt, int fd) {
+  int32_t *buffer = malloc(GEN_BUFFER_ELEMS * sizeof(int32_t));
+  if (buffer == NULL) return -1;
+  srand((unsigned int)opt->seed);
+  int rc = 0;
+  for (uint64_t pos = 0; pos < opt->count && rc == 0; pos += GEN_BUFFER_ELEMS) {
+    uint64_t n = opt->count - pos < GEN_BUFFER_ELEMS ? opt->count - pos
+                                                     : GEN_BUFFER_ELEMS;
+    for (uint64_t k = 0; k < n; k++) buffer[k] = rand();
+    rc = WriteAll(fd, buffer, n * sizeof(int32_t), (off_t)(pos * sizeof(int32_t)));
+  }
+  free(buffer);
+  return rc;
+}
+
+static int Generate(const char *path, const struct Options *opt) {
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    perror(path);
+    return 1;
+  }
+  // размер сразу: потоки пишут в разные места файла
+  if (ftruncate(fd, (off_t)(opt->count * sizeof(int32_t))) != 0) {
+    perror("ftruncate");
+    close(fd);
+    return 1;
+  }
+
+  double start = Now();
+  int failed = 0;
+  if (opt->dist == DIST_RAND) {
+    failed = GenRand(opt, fd) != 0;
+  } else {
+    struct GenPart parts[opt->threads];
+    for (int t = 0; t < opt->threads; t++) {
+      parts[t].opt = opt;
+      parts[t].fd = fd;
+      parts[t].begin = PartBegin(opt->count, opt->threads, t);
+      parts[t].end = PartEnd(opt->count, opt->threads, t);
+      parts[t].status = 0;
+    }
+    RunParallel(opt->threads, GenWorker, parts, sizeof(parts[0]));
+    for (int t = 0; t < opt->threads; t++) failed |= parts[t].status != 0;
+  }
+  if (fsync(fd) != 0 || close(fd) != 0) failed = 1;
+  if (failed) {
+    perror("write");
+    return 1;
+  }
+  double seconds = Now() - start;
+  double mib = (double)opt->count * sizeof(int32_t) / (1 << 20);
+  printf("%s: %llu ints (%s), %.1f MiB in %.3f s, %.0f MiB/s\n", path,
+         (unsigned long long)opt->count, kDistNames[opt->dist], mib, seconds,
+         mib / seconds);
+  return 0;
+}
+
+// Входной файл целиком через mmap (только чтение).
+static const char *MapInput(const char *path, size_t *size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    perror(path);
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    perror("fstat");
+    close(fd);
+    return NULL;
+  }
+  *size = (size_t)st.st_size;
+  if (*size == 0) {
+    close(fd);
+    return "";
+  }
+  void *map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    perror("mmap");
+    return NULL;
+  }
+  madvise(map, *size, MADV_SEQUENTIAL);
+  return map;
+}
+
+static void UnmapInput(const char *map, size_t size) {
+  if (size > 0) munmap((void *)map, size);
+}
+
+static int CreateOutput(const char *path, uint64_t bytes) {
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    perror(path);
+    return -1;
+  }
+  if (ftruncate(fd, (off_t)bytes) != 0) {
+    perror("ftruncate");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+struct ToTextPart {
+  const int32_t *values;
+  uint64_t begin;
+  uint64_t end;
+  uint64_t bytes;   // проход 1: длина текста куска
+  uint64_t offset;  // проход 2: где кусок начинается в файле
+  int fd;
+  int status;
+};
+
+static void *ToTextMeasure(void *arg) {
+  struct ToTextPart *part = arg;
+  uint64_t bytes = 0;
+  for (uint64_t i = part->begin; i < part->end; i++)
+    bytes += IntTextLength(part->values[i]) + 1;
+  part->bytes = bytes;
+  return NULL;
+}
+
+static void *ToTextWrite(void *arg) {
+  struct ToTextPart *part = arg;
+  char *buffer = malloc(TEXT_BUFFER_BYTES);
+  if (buffer == NULL) {
+    part->status = -1;
+    return NULL;
+  }
+  char *out = buffer;
+  off_t offset = (off_t)part->offset;
+  for (uint64_t i = part->begin; i < part->end; i++) {
+    if (out - buffer > TEXT_BUFFER_BYTES - 24) {
+      if (WriteAll(part->fd, buffer, (size_t)(out - buffer), offset) != 0) {
+        part->status = -1;
+        break;
+      }
+      offset += out - buffer;
+      out = buffer;
+    }
+    out = IntTextFormat(part->values[i], out);
+    *out++ = '\n';
+  }
+  if (part->status == 0 && out > buffer &&
+      WriteAll(part->fd, buffer, (size_t)(out - buffer), offset) != 0)
+    part->status = -1;
+  free(buffer);
+  return NULL;
+}
+
+// Два параллельных прохода: длины кусков текста -> смещения -> запись.
+static int ToText(const char *in, const char *out, int threads) {
+  size_t size;
+  const char *map = MapInput(in, &size);
+  if (map == NULL) return 1;
+  if (size % sizeof(int32_t) != 0)
+    fprintf(stderr, "%s: %zu trailing bytes ignored\n", in, size % sizeof(int32_t));
+  uint64_t count = size / sizeof(int32_t);
+
+  double start = Now();
+  struct ToTextPart parts[threads];
+  for (int t = 0; t < threads; t++) {
+    parts[t].values = (const int32_t *)(const void *)map;
+    parts[t].begin = PartBegin(count, threads, t);
+    parts[t].end = PartEnd(count, threads, t);
+    parts[t].status = 0;
+  }
+  RunParallel(threads, ToTextMeasure, parts, sizeof(parts[0]));
+  uint64_t total = 0;
+  for (int t = 0; t < threads; t++) {
+    parts[t].offset = total;
+    total += parts[t].bytes;
+  }
+
+  int fd = CreateOutput(out, total);
+  int failed = fd < 0;
+  if (!failed) {
+    for (int t = 0; t < threads; t++) parts[t].fd = fd;
+    RunParallel(threads, ToTextWrite, parts, sizeof(parts[0]));
+    for (int t = 0; t < threads; t++) failed |= parts[t].status != 0;
+    if (close(fd) != 0) failed = 1;
+  }
+  UnmapInput(map, size);
+  if (failed) {
+    perror("write");
+    return 1;
+  }
+  double seconds = Now() - start;
+  printf("%s: %llu ints -> %llu bytes of text in %.3f s, %.0f MiB/s\n", out,
+         (unsigned long long)count, (unsigned long long)total, seconds,
+         (double)total / (1 << 20) / seconds);
+  return 0;
+}
+
+struct FromTextPart {
+  const char *text;
+  size_t begin;
+  size_t end;
+  uint64_t count;   // проход 1: чисел в куске
+  uint64_t first;   // проход 2: индекс первого числа куска
+  int fd;
+  enum IntTextStatus status;
+  size_t error_at;
+};
+
+static void *FromTextCount(void *arg) {
+  struct FromTextPart *part = arg;
+  part->count = IntTextCount(part->text + part->begin, part->end - part->begin);
+  return NULL;
+}
+
+static void *FromTextParse(void *arg) {
+  struct FromTextPart *part = arg;
+  int32_t *buffer = malloc(GEN_BUFFER_ELEMS * sizeof(int32_t));
+  if (buffer == NULL) {
+    part->status = INT_TEXT_BAD;
+    part->error_at = part->begin;
+    return NULL;
+  }
+  const char *pos = part->text + part->begin;
+  const char *end = part->text + part->end;
+  uint64_t index = part->first;
+  size_t n = 0;
+  part->status = INT_TEXT_OK;
+  for (;;) {
+    int64_t value;
+    const char *token = pos;
+    enum IntTextStatus st = IntTextNext(&pos, end, &value);
+    if (st == INT_TEXT_OK && (value < INT32_MIN || value > INT32_MAX)) {
+      // ошибка указывает на начало числа, а не за него
+      while (*token == ' ' || *token == '\t' || *token == '\n' || *token == '\r')
+        token++;
+      pos = token;
+      st = INT_TEXT_OVERFLOW;
+    }
+    if (st != INT_TEXT_OK) {
+      if (st != INT_TEXT_END) {
+        part->status = st;
+        part->error_at = (size_t)(pos - part->text);
+      }
+      break;
+    }
+    buffer[n++] = (int32_t)value;
+    if (n == GEN_BUFFER_ELEMS || pos == end) {
+      if (WriteAll(part->fd, buffer, n * sizeof(int32_t),
+                   (off_t)(index * sizeof(int32_t))) != 0) {
+        part->status = INT_TEXT_BAD;
+        part->error_at = (size_t)(pos - part->text);
+        break;
+      }
+      index += n;
+      n = 0;
+    }
+  }
+  if (part->status == INT_TEXT_OK && n > 0 &&
+      WriteAll(part->fd, buffer, n * sizeof(int32_t),
+               (off_t)(index * sizeof(int32_t))) != 0) {
+    part->status = INT_TEXT_BAD;
+    part->error_at = part->end;
+  }
+  free(buffer);
+  return NULL;
+}
+
+// Текст делится по пробельным символам; проход 1 считает числа в кусках
+// (SIMD), проход 2 разбирает и пишет каждый кусок по своему смещению.
+static int FromText(const char *in, const char *out, int threads) {
+  size_t size;
+  const char *map = MapInput(in, &size);
+  if (map == NULL) return 1;
+
+  double start = Now();
+  size_t bounds[threads + 1];
+  IntTextSplit(map, size, threads, bounds);
+  struct FromTextPart parts[threads];
+  for (int t = 0; t < threads; t++) {
+    parts[t].text = map;
+    parts[t].begin = bounds[t];
+    parts[t].end = bounds[t + 1];
+  }
+  RunParallel(threads, FromTextCount, parts, sizeof(parts[0]));
+  uint64_t total = 0;
+  for (int t = 0; t < threads; t++) {
+    parts[t].first = total;
+    total += parts[t].count;
+  }
+
+  int fd = CreateOutput(out, total * sizeof(int32_t));
+  int failed = fd < 0;
+  if (!failed) {
+    for (int t = 0; t < threads; t++) parts[t].fd = fd;
+    RunParallel(threads, FromTextParse, parts, sizeof(parts[0]));
+    for (int t = 0; t < threads && !failed; t++) {
+      if (parts[t].status == INT_TEXT_OK) continue;
+      fprintf(stderr, "%s: %s at byte %zu\n", in,
+              parts[t].status == INT_TEXT_OVERFLOW ? "number out of int32 range"
+                                                   : "not a number",
+              parts[t].error_at);
+      failed = 1;
+    }
+    if (close(fd) != 0) failed = 1;
+  }
+  UnmapInput(map, size);
+  if (failed) {
+    unlink(out);
+    return 1;
+  }
+  double seconds = Now() - start;
+  printf("%s: %zu bytes of text -> %llu ints in %.3f s, %.0f MiB/s\n", out,
+         size, (unsigned long long)total, seconds,
+         (double)size / (1 << 20) / seconds);
+  return 0;
+}
+
+static void Usage(const char *prog) {
+  printf("Usage: %s gen <out> --count N [--dist uniform|normal|skew|sorted|"
+         "reverse|constant|rand]\n"
+         "          [--seed S] [--min a] [--max b] [--threads T]\n"
+         "       %s to_text <in.raw> <out.txt> [--threads T]\n"
+         "       %s from_text <in.txt> <out.raw> [--threads T]\n",
+         prog, prog, prog);
+}
+
+int main(int argc, char **argv) {
+  struct Options opt = {0, DIST_UNIFORM, 1, 0, INT32_MAX,
+                        (int)sysconf(_SC_NPROCESSORS_ONLN)};
+  if (opt.threads < 1) opt.threads = 1;
+
+  static struct option options[] = {{"count", required_argument, 0, 0},
+                                    {"dist", required_argument, 0, 0},
+                                    {"seed", required_argument, 0, 0},
+                                    {"min", required_argument, 0, 0},
+                                    {"max", required_argument, 0, 0},
+                                    {"threads", required_argument, 0, 0},
+                                    {0, 0, 0, 0}};
+  int option_index = 0;
+  int c;
+  while ((c = getopt_long(argc, argv, "", options, &option_index)) != -1) {
+    if (c != 0) {
+      Usage(argv[0]);
+      return 1;
+    }
+    switch (option_index) {
+      case 0: opt.count = strtoull(optarg, NULL, 10); break;
+      case 1: {
+        size_t k = 0;
+        for (; k < sizeof(kDistNames) / sizeof(kDistNames[0]); k++)
+          if (strcmp(optarg, kDistNames[k]) == 0) break;
+        if (k == sizeof(kDistNames) / sizeof(kDistNames[0])) {
+          printf("Unknown distribution %s\n", optarg);
+          return 1;
+        }
+        opt.dist = (enum Dist)k;
+        break;
+      }
+      case 2: opt.seed = strtoull(optarg, NULL, 10); break;
+      case 3: opt.min = strtoll(optarg, NULL, 10); break;
+      case 4: opt.max = strtoll(optarg, NULL, 10); break;
+      case 5: opt.threads = atoi(optarg); break;
+    }
+  }
+
+  int rest = argc - optind;
+  if (rest < 2 || opt.threads <= 0) {
+    Usage(argv[0]);
+    return 1;
+  }
+  const char *cmd = argv[optind];
+  if (strcmp(cmd, "gen") == 0 && rest == 2) {
+    if (opt.count == 0 || opt.min > opt.max || opt.min < INT32_MIN ||
+        opt.max > INT32_MAX) {
+      printf("--count must be positive, INT32_MIN <= min <= max <= INT32_MAX\n");
+      return 1;
+    }
+    return Generate(argv[optind + 1], &opt);
+  }
+  if (strcmp(cmd, "to_text") == 0 && rest == 3)
+    return ToText(argv[optind + 1], argv[optind + 2], opt.threads);
+  if (strcmp(cmd, "from_text") == 0 && rest == 3)
+    return FromText(argv[optind + 1], argv[optind + 2], opt.threads);
+  Usage(argv[0]);
+  return 1;
+}
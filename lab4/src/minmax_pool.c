@@ -0,0 +1,268 @@
+#define _GNU_SOURCE
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "find_min_max.h"
+#include "process_pool.h"
+#include "self_path.h"
+#include "utils.h"
+
+// Супервизор с пулом pre-fork рабочих против fork+exec на каждую задачу
+// (как run_sequential). Задача i - массив с seed + i / ranges, отрезок
+// i % ranges из ranges равных частей. --crash_every k роняет рабочего на
+// первой попытке каждой k-й задачи: пул должен её переотправить.
+// Все ответы сверяются с подсчётом в самом супервизоре.
+
+struct Options {
+  int workers;
+  int jobs;
+  int array_size;
+  int seed;
+  int ranges;
+  int crash_every;
+  const char *mode;
+};
+
+struct Outcome {
+  int32_t *min;
+  int32_t *max;
+  char *ok;
+};
+
+static double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void MakeJobs(const struct Options *opt, struct PoolJob *jobs) {
+  uint32_t part = (uint32_t)opt->array_size / (uint32_t)opt->ranges;
+  for (int i = 0; i < opt->jobs; i++) {
+    int r = i % opt->ranges;
+    jobs[i].id = (uint64_t)i;
+    jobs[i].seed = (uint32_t)(opt->seed + i / opt->ranges);
+    jobs[i].size = (uint32_t)opt->array_size;
+    jobs[i].begin = part * (uint32_t)r;
+    jobs[i].end = r == opt->ranges - 1 ? (uint32_t)opt->array_size
+                                       : part * (uint32_t)(r + 1);
+    jobs[i].crash = opt->crash_every > 0 && (i + 1) % opt->crash_every == 0;
+    jobs[i].attempts = 0;
+  }
+}
+
+static void OnResult(const struct PoolJob *job, const struct PoolReply *reply,
+                     void *user) {
+  struct Outcome *out = user;
+  out->min[job->id] = reply->min;
+  out->max[job->id] = reply->max;
+  out->ok[job->id] = (char)reply->ok;
+}
+
+static int RunPool(const struct Options *opt, const struct PoolJob *jobs,
+                   struct Outcome *out, double *seconds) {
+  double start = Now();
+  struct ProcessPool *pool = ProcessPoolCreate(opt->workers);
+  if (pool == NULL) {
+    fprintf(stderr, "cannot start the worker pool\n");
+    return -1;
+  }
+  int rc = ProcessPoolRun(pool, jobs, (size_t)opt->jobs, OnResult, out);
+  const struct ProcessPoolStats *st = ProcessPoolGetStats(pool);
+  printf("pool: completed %zu, failed %zu, crashes %zu, respawns %zu, retries %zu\n",
+         st->completed, st->failed, st->crashes, st->respawns, st->retries);
+  ProcessPoolDestroy(pool);
+  *seconds = Now() - start;
+  return rc;
+}
+
+// fork + execv sequential_min_max на каждую задачу, до workers
+// одновременно; ответ разбирается из stdout ребёнка. Программа берётся
+// из каталога minmax_pool, а не из текущего.
+static int RunForkPerJob(const struct Options *opt, const struct PoolJob *jobs,
+                         struct Outcome *out, double *seconds) {
+  char exe[4096];
+  if (SiblingPath(NULL, "sequential_min_max", exe, sizeof(exe)) != 0 ||
+      access(exe, X_OK) != 0) {
+    perror("cannot locate sequential_min_max next to minmax_pool");
+    return -1;
+  }
+  pid_t *pids = calloc((size_t)opt->workers, sizeof(pid_t));
+  int *pipes = calloc((size_t)opt->workers, sizeof(int));
+  int *job_of = calloc((size_t)opt->workers, sizeof(int));
+  if (pids == NULL || pipes == NULL || job_of == NULL) {
+    free(pids);
+    free(pipes);
+    free(job_of);
+    return -1;
+  }
+
+  double start = Now();
+  int next = 0;
+  int running = 0;
+  while (next < opt->jobs || running > 0) {
+    for (int s = 0; s < opt->workers && next < opt->jobs; s++) {
+      if (pids[s] != 0) continue;
+      int fd[2];
+      if (pipe(fd) < 0) {
+        perror("pipe");
+        next = opt->jobs;
+        break;
+      }
+      char seed[16], size[16];
+      snprintf(seed, sizeof(seed), "%u", jobs[next].seed);
+      snprintf(size, sizeof(size), "%u", jobs[next].size);
+      pid_t pid = fork();
+      if (pid == 0) {
+        dup2(fd[1], STDOUT_FILENO);
+        close(fd[0]);
+        close(fd[1]);
+        // строка арены в stderr не нужна
+        if (freopen("/dev/null", "w", stderr) == NULL) _exit(1);
+        char *args[] = {exe, seed, size, NULL};
+        execv(exe, args);
+        _exit(127);
+      }
+      close(fd[1]);
+      if (pid < 0) {
+        perror("fork");
+        close(fd[0]);
+        next = opt->jobs;
+        break;
+      }
+      pids[s] = pid;
+      pipes[s] = fd[0];
+      job_of[s] = next++;
+      running++;
+    }
+    if (running == 0) break;
+
+    int status;
+    pid_t done = waitpid(-1, &status, 0);
+    if (done < 0) break;
+    for (int s = 0; s < opt->workers; s++) {
+      if (pids[s] != done) continue;
+      char buf[256] = {0};
+      ssize_t n = read(pipes[s], buf, sizeof(buf) - 1);
+      close(pipes[s]);
+      int id = job_of[s];
+      const char *min_line = n > 0 ? strstr(buf, "min: ") : NULL;
+      const char *max_line = n > 0 ? strstr(buf, "max: ") : NULL;
+      out->ok[id] = WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                    min_line != NULL && max_line != NULL;
+      if (out->ok[id]) {
+        out->min[id] = atoi(min_line + 5);
+        out->max[id] = atoi(max_line + 5);
+      }
+      pids[s] = 0;
+      running--;
+    }
+  }
+  *seconds = Now() - start;
+  free(pids);
+  free(pipes);
+  free(job_of);
+  return 0;
+}
+
+static int Verify(const struct Options *opt, const struct PoolJob *jobs,
+                  const struct Outcome *out, const char *name) {
+  int *array = malloc((size_t)opt->array_size * sizeof(int));
+  if (array == NULL) return -1;
+  int bad = 0;
+  uint32_t seed = 0;
+  for (int i = 0; i < opt->jobs; i++) {
+    if (i == 0 || jobs[i].seed != seed) {
+      seed = jobs[i].seed;
+      GenerateArray(array, jobs[i].size, seed);
+    }
+    struct MinMax expected = GetMinMax(array, jobs[i].begin, jobs[i].end);
+    if (!out->ok[i] || out->min[i] != expected.min || out->max[i] != expected.max)
+      bad++;
+  }
+  free(array);
+  if (bad) printf("%s: %d of %d jobs wrong or failed\n", name, bad, opt->jobs);
+  return bad;
+}
+
+int main(int argc, char **argv) {
+  struct Options opt = {4, 200, 10000, 1, 1, 0, "both"};
+
+  static struct option options[] = {{"workers", required_argument, 0, 0},
+                                    {"jobs", required_argument, 0, 0},
+                                    {"array_size", required_argument, 0, 0},
+                                    {"seed", required_argument, 0, 0},
+                                    {"ranges", required_argument, 0, 0},
+                                    {"crash_every", required_argument, 0, 0},
+                                    {"mode", required_argument, 0, 0},
+                                    {0, 0, 0, 0}};
+  int option_index = 0;
+  int c;
+  while ((c = getopt_long(argc, argv, "", options, &option_index)) != -1) {
+    if (c != 0) {
+      printf("Usage: %s [--workers 4] [--jobs 200] [--array_size 10000] "
+             "[--seed 1] [--ranges 1] [--crash_every 0] [--mode pool|fork|both]\n",
+             argv[0]);
+      return 1;
+    }
+    switch (option_index) {
+      case 0: opt.workers = atoi(optarg); break;
+      case 1: opt.jobs = atoi(optarg); break;
+      case 2: opt.array_size = atoi(optarg); break;
+      case 3: opt.seed = atoi(optarg); break;
+      case 4: opt.ranges = atoi(optarg); break;
+      case 5: opt.crash_every = atoi(optarg); break;
+      case 6: opt.mode = optarg; break;
+    }
+  }
+  int want_pool = strcmp(opt.mode, "pool") == 0 || strcmp(opt.mode, "both") == 0;
+  int want_fork = strcmp(opt.mode, "fork") == 0 || strcmp(opt.mode, "both") == 0;
+  if (opt.workers <= 0 || opt.jobs <= 0 || opt.array_size <= 0 ||
+      opt.seed <= 0 || opt.ranges <= 0 || opt.ranges > opt.array_size ||
+      opt.crash_every < 0 || (!want_pool && !want_fork)) {
+    printf("workers, jobs, array_size, seed > 0; 0 < ranges <= array_size; "
+           "mode pool, fork or both\n");
+    return 1;
+  }
+  if (want_fork && opt.ranges != 1) {
+    // sequential_min_max считает только весь массив
+    printf("fork mode runs whole arrays, use --ranges 1\n");
+    return 1;
+  }
+
+  struct PoolJob *jobs = calloc((size_t)opt.jobs, sizeof(*jobs));
+  struct Outcome out = {calloc((size_t)opt.jobs, sizeof(int32_t)),
+                        calloc((size_t)opt.jobs, sizeof(int32_t)),
+                        calloc((size_t)opt.jobs, 1)};
+  if (jobs == NULL || out.min == NULL || out.max == NULL || out.ok == NULL) {
+    perror("calloc");
+    return 1;
+  }
+  MakeJobs(&opt, jobs);
+  printf("%d jobs, array_size %d, %d ranges per array, %d workers\n", opt.jobs,
+         opt.array_size, opt.ranges, opt.workers);
+
+  int bad = 0;
+  double seconds;
+  if (want_pool) {
+    if (RunPool(&opt, jobs, &out, &seconds) != 0) return 1;
+    bad += Verify(&opt, jobs, &out, "pool");
+    printf("pre-fork pool: %.3f s, %.0f jobs/s\n", seconds, opt.jobs / seconds);
+  }
+  if (want_fork) {
+    memset(out.ok, 0, (size_t)opt.jobs);
+    if (RunForkPerJob(&opt, jobs, &out, &seconds) != 0) return 1;
+    bad += Verify(&opt, jobs, &out, "fork");
+    printf("fork per job:  %.3f s, %.0f jobs/s\n", seconds, opt.jobs / seconds);
+  }
+
+  free(jobs);
+  free(out.min);
+  free(out.max);
+  free(out.ok);
+  return bad ? 1 : 0;
+}
@@ -0,0 +1,268 @@
+#define _GNU_SOURCE
+#include "numa_place.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define MAX_NODES 64
+#define MPOL_PREFERRED_MODE 1  // MPOL_PREFERRED из linux/mempolicy.h
+
+// Узлы плотно: индекс 0..nodes-1, номер узла в ядре - ids[i]
+// (номера бывают с дырами, например "0,2").
+struct Topology {
+  int nodes;
+  int ids[MAX_NODES];
+  int *cpus[MAX_NODES];
+  int counts[MAX_NODES];
+};
+
+static struct Topology topo;
+static int topo_ready = 0;
+
+// Разбирает список вида "0-3,8,10-11". Возвращает число ядер или -1.
+static int ParseCpuList(const char *text, int **out) {
+  int cap = 16;
+  int count = 0;
+  int *cpus = malloc(sizeof(int) * cap);
+  if (cpus == NULL) return -1;
+
+  const char *p = text;
+  while (*p != '\0' && *p != '\n') {
+    char *end;
+    long lo = strtol(p, &end, 10);
+    if (end == p || lo < 0) goto bad;
+    long hi = lo;
+    p = end;
+    if (*p == '-') {
+      hi = strtol(p + 1, &end, 10);
+      if (end == p + 1 || hi < lo) goto bad;
+      p = end;
+    }
+    for (long c = lo; c <= hi; c++) {
+      if (count == cap) {
+        cap *= 2;
+        int *grown = realloc(cpus, sizeof(int) * cap);
+        if (grown == NULL) goto bad;
+        cpus = grown;
+      }
+      cpus[count++] = (int)c;
+    }
+    if (*p == ',') p++;
+    else if (*p != '\0' && *p != '\n') goto bad;
+  }
+  *out = cpus;
+  return count;
+
+bad:
+  free(cpus);
+  return -1;
+}
+
+static void LoadTopology(void) {
+  if (topo_ready) return;
+  topo_ready = 1;
+
+  // online - список вида "0,2-3": узлы не обязаны идти подряд
+  char line[4096] = {0};
+  int *online = NULL;
+  int online_count = -1;
+  FILE *f = fopen("/sys/devices/system/node/online", "r");
+  if (f != NULL) {
+    if (fgets(line, sizeof(line), f) == NULL) line[0] = '\0';
+    fclose(f);
+    online_count = ParseCpuList(line, &online);
+  }
+
+  for (int i = 0; i < online_count && topo.nodes < MAX_NODES; i++) {
+    int node = online[i];
+    if (node >= MAX_NODES) continue;  // не влезет в маску mbind
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+             node);
+    f = fopen(path, "r");
+    if (f == NULL) continue;
+    line[0] = '\0';
+    if (fgets(line, sizeof(line), f) == NULL) line[0] = '\0';
+    fclose(f);
+    int *cpus = NULL;
+    int count = ParseCpuList(line, &cpus);
+    if (count < 0) continue;
+    topo.ids[topo.nodes] = node;
+    topo.cpus[topo.nodes] = cpus;
+    topo.counts[topo.nodes] = count;
+    topo.nodes++;
+  }
+  free(online);
+
+  if (topo.nodes == 0) {
+    // sysfs недоступен: один узел со всеми доступными ядрами
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    sched_getaffinity(0, sizeof(set), &set);
+    int count = CPU_COUNT(&set);
+    topo.cpus[0] = malloc(sizeof(int) * (count > 0 ? count : 1));
+    int k = 0;
+    for (int c = 0; c < CPU_SETSIZE && k < count; c++)
+      if (CPU_ISSET(c, &set)) topo.cpus[0][k++] = c;
+    topo.counts[0] = k;
+    topo.ids[0] = 0;
+    topo.nodes = 1;
+  }
+}
+
+int NumaNodeCount(void) {
+  LoadTopology();
+  return topo.nodes;
+}
+
+static int NodeOfCpu(int cpu) {
+  for (int n = 0; n < topo.nodes; n++)
+    for (int i = 0; i < topo.counts[n]; i++)
+      if (topo.cpus[n][i] == cpu) return topo.ids[n];
+  return topo.ids[0];
+}
+
+int ParsePinPolicy(const char *spec, struct PinConfig *cfg) {
+  memset(cfg, 0, sizeof(*cfg));
+  if (strcmp(spec, "none") == 0) {
+    cfg->policy = PIN_NONE;
+  } else if (strcmp(spec, "compact") == 0) {
+    cfg->policy = PIN_COMPACT;
+  } else if (strcmp(spec, "scatter") == 0) {
+    cfg->policy = PIN_SCATTER;
+  } else {
+    int count = ParseCpuList(spec, &cfg->cpus);
+    if (count <= 0) {
+      free(cfg->cpus);
+      cfg->cpus = NULL;
+      return -1;
+    }
+    cfg->policy = PIN_LIST;
+    cfg->cpus_count = count;
+  }
+  return 0;
+}
+
+void FreePinConfig(struct PinConfig *cfg) {
+  free(cfg->cpus);
+  cfg->cpus = NULL;
+  cfg->cpus_count = 0;
+}
+
+int PlanPlacement(const struct PinConfig *cfg, int threads, int *cpu_of_thread,
+                  int *node_of_thread) {
+  LoadTopology();
+  int total = 0;
+  for (int n = 0; n < topo.nodes; n++) total += topo.counts[n];
+
+  for (int t = 0; t < threads; t++) {
+    int cpu = -1;
+    switch (cfg->policy) {
+      case PIN_NONE:
+        break;
+      case PIN_LIST:
+        cpu = cfg->cpus[t % cfg->cpus_count];
+        break;
+      case PIN_COMPACT: {
+        int k = total > 0 ? t % total : 0;
+        for (int n = 0; n < topo.nodes; n++) {
+          if (k < topo.counts[n]) {
+            cpu = topo.cpus[n][k];
+            break;
+          }
+          k -= topo.counts[n];
+        }
+        break;
+      }
+      case PIN_SCATTER: {
+        // поток t идёт на узел t % nodes, внутри узла - по очереди;
+        // узлы без ядер пропускаем, а если ядер нет нигде - не привязываем
+        if (total == 0) break;
+        int n = t % topo.nodes;
+        int k = t / topo.nodes;
+        while (topo.counts[n] == 0) n = (n + 1) % topo.nodes;
+        cpu = topo.cpus[n][k % topo.counts[n]];
+        break;
+      }
+    }
+    cpu_of_thread[t] = cpu;
+    // без привязки считаем, что поток крутится на узле по кругу
+    node_of_thread[t] = cpu >= 0 ? NodeOfCpu(cpu) : topo.ids[t % topo.nodes];
+  }
+  return 0;
+}
+
+void PinPoolWorker(int index, void *cpus) {
+  PinSelf(((const int *)cpus)[index + 1]);
+}
+
+int PinSelf(int cpu) {
+  if (cpu < 0) return 0;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (err != 0) {
+    fprintf(stderr, "pthread_setaffinity_np(cpu %d): %s\n", cpu,
+            strerror(err));
+    return -1;
+  }
+  return 0;
+}
+
+void *PinSelfSaved(int cpu) {
+  if (cpu < 0) return NULL;
+  cpu_set_t *saved = malloc(sizeof(*saved));
+  if (saved == NULL ||
+      pthread_getaffinity_np(pthread_self(), sizeof(*saved), saved) != 0 ||
+      PinSelf(cpu) != 0) {
+    free(saved);
+    return NULL;
+  }
+  return saved;
+}
+
+void PinRestore(void *saved) {
+  if (saved == NULL) return;
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), saved);
+  free(saved);
+}
+
+void *NumaAllocArray(size_t bytes) {
+  if (bytes == 0) bytes = 1;
+  void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return p == MAP_FAILED ? NULL : p;
+}
+
+void NumaFreeArray(void *addr, size_t bytes) {
+  if (addr != NULL) munmap(addr, bytes ? bytes : 1);
+}
+
+int BindRangeToNode(void *addr, size_t len, int node) {
+  LoadTopology();
+  if (topo.nodes <= 1 || node < 0 || node >= MAX_NODES) return 0;
+
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  uintptr_t begin = ((uintptr_t)addr + page - 1) & ~(uintptr_t)(page - 1);
+  uintptr_t end = ((uintptr_t)addr + len) & ~(uintptr_t)(page - 1);
+  if (end <= begin) return 0;
+
+  unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long)) + 1] = {0};
+  mask[node / (8 * sizeof(unsigned long))] |=
+      1UL << (node % (8 * sizeof(unsigned long)));
+  if (syscall(SYS_mbind, (void *)begin, end - begin, MPOL_PREFERRED_MODE, mask,
+              (unsigned long)MAX_NODES + 1, 0) != 0) {
+    if (errno == ENOSYS || errno == EPERM) return 0;  // ядро без NUMA
+    perror("mbind");
+    return -1;
+  }
+  return 0;
+}
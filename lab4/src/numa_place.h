@@ -0,0 +1,55 @@
+#ifndef NUMA_PLACE_H
+#define NUMA_PLACE_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+// Размещение массива по NUMA-узлам и привязка потоков к ядрам.
+// Топология читается из /sys/devices/system/node; на машинах с одним
+// узлом (или без sysfs) все функции корректно вырождаются в no-op.
+
+enum PinPolicy {
+  PIN_NONE,     // потоки не привязываются
+  PIN_COMPACT,  // заполняем ядра узла 0, затем узла 1, ...
+  PIN_SCATTER,  // по кругу между узлами
+  PIN_LIST,     // явный список ядер
+};
+
+struct PinConfig {
+  enum PinPolicy policy;
+  int *cpus;  // для PIN_LIST
+  int cpus_count;
+};
+
+// Разбирает "none", "compact", "scatter" или список "0,2,4-7".
+int ParsePinPolicy(const char *spec, struct PinConfig *cfg);
+void FreePinConfig(struct PinConfig *cfg);
+
+// Для каждого потока выбирает ядро (-1 - без привязки) и его NUMA-узел.
+int PlanPlacement(const struct PinConfig *cfg, int threads, int *cpu_of_thread,
+                  int *node_of_thread);
+
+int NumaNodeCount(void);
+
+// Привязывает вызывающий поток к ядру; cpu < 0 - ничего не делает.
+int PinSelf(int cpu);
+
+// То же на время: возвращает прежнюю маску ядер, которую PinRestore
+// возвращает потоку (NULL - привязки не было, PinRestore ничего не делает).
+void *PinSelfSaved(int cpu);
+void PinRestore(void *saved);
+
+// Старт рабочего потока пула (PoolStartFn): arg - план ядер из
+// PlanPlacement, место 0 занимает вызывающий поток, рабочий index
+// берёт cpus[index + 1].
+void PinPoolWorker(int index, void *cpus);
+
+// Выделяет память через mmap без первого касания страниц.
+void *NumaAllocArray(size_t bytes);
+void NumaFreeArray(void *addr, size_t bytes);
+
+// Просит ядро размещать страницы [addr, addr + len) на узле node (mbind).
+// Страницы, попадающие на границу соседних диапазонов, не трогаются.
+int BindRangeToNode(void *addr, size_t len, int node);
+
+#endif
@@ -4,48 +4,264 @@
 #include <stdlib.h> 
 #include <string.h> 
 #include <stddef.h> 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "arena.h"
+#include "block_format.h"
 #include "find_min_max.h"
+#include "numa_place.h"
+#include "stats_reduce.h"
+#include "task_graph.h"
+#include "thread_slots.h"
+#include "trace.h"
 
 // --- Прототипы функций для I/O ---
-int read_array_from_file(const char *filename, int **array, size_t *array_size_out);
+int read_min_max_pipeline(const char *filename, int num_threads, const int *cpus,
+                          int **array, size_t *array_size_out, struct MinMax *result);
+int read_array_from_file_numa(const char *filename, int **array, size_t *array_size_out,
+                              int num_threads, const int *cpus);
 int write_result_to_file(const char *filename, struct MinMax result);
 
 // --- Структура для передачи данных в поток ---
+// Лежит в ThreadSlots: у каждого потока своя кэш-линия под result.
 struct ThreadData {
   pthread_t thread;
   int thread_id;
   int *array;
+  const struct BlockFile *blocks;  // не NULL - вход в блочном формате
   size_t begin;
   size_t end;
+  int cpu;
   struct MinMax result;
 };
 
 // --- Функция-обработчик потока ---
 void *find_min_max_thread(void *arg) {
   struct ThreadData *data = (struct ThreadData *)arg;
-  data->result = GetMinMax(data->array, data->begin, data->end);
+  PinSelf(data->cpu);
+  TraceThreadName("min/max", data->thread_id);
+  TraceBeginArg("min/max chunk", "elements", (int64_t)(data->end - data->begin));
+  if (data->blocks != NULL)
+    data->result = BlockQueryMinMax(data->blocks, data->begin, data->end);
+  else
+    data->result = GetMinMax(data->array, data->begin, data->end);
+  TraceEnd("min/max chunk");
   return NULL;
 }
 
+// Без --numa массив живёт в арене на огромных страницах.
+static struct Arena array_arena;
+
+static int *alloc_array(size_t array_size) {
+  struct ArenaOptions opts;
+  ArenaOptionsFromEnv(&opts);
+  if (ArenaInit(&array_arena, array_size * sizeof(int), &opts) != 0) return NULL;
+  return (int *)ArenaAlloc(&array_arena, array_size * sizeof(int));
+}
+
+// Входной файл в блочном формате: массив не загружается, потоки
+// отвечают на запросы по индексу и распаковывают только крайние блоки.
+static struct BlockFile block_input;
+
+static void free_array(int *array, size_t array_size, int numa) {
+  if (block_input.map != NULL) BlockFileClose(&block_input);
+  else if (numa) NumaFreeArray(array, array_size * sizeof(int));
+  else ArenaDestroy(&array_arena);
+}
+
+// Дополнительные свёртки поверх min/max (--topk, --percentile, --hist).
+#define MAX_PERCENTILES 16
+
+struct StatRequest {
+  size_t topk;
+  double percentiles[MAX_PERCENTILES];
+  int percentiles_count;
+  size_t hist_bins;
+};
+
+static int parse_percentiles(const char *spec, struct StatRequest *req) {
+  char *copy = strdup(spec);
+  if (copy == NULL) return -1;
+  int status = 0;
+  for (char *tok = strtok(copy, ","); tok != NULL; tok = strtok(NULL, ",")) {
+    char *end;
+    double p = strtod(tok, &end);
+    if (*end != '\0' || p < 0 || p > 100 || req->percentiles_count == MAX_PERCENTILES) {
+      status = -1;
+      break;
+    }
+    req->percentiles[req->percentiles_count++] = p;
+  }
+  free(copy);
+  return (status == 0 && req->percentiles_count > 0) ? 0 : -1;
+}
+
+static int has_stats(const struct StatRequest *req) {
+  return req->topk > 0 || req->percentiles_count > 0 || req->hist_bins > 0;
+}
+
+// Считает запрошенные свёртки в num_threads потоков и печатает их в f.
+static int report_stats(FILE *f, const int *array, size_t array_size, int num_threads,
+                        const struct StatRequest *req) {
+  if (req->topk > 0) {
+    int *top = malloc(req->topk * sizeof(int));
+    if (top == NULL) return -1;
+    size_t n = ParallelTopK(array, array_size, req->topk, num_threads, top);
+    fprintf(f, "Top-%zu:", req->topk);
+    for (size_t i = 0; i < n; i++) fprintf(f, " %d", top[i]);
+    fprintf(f, "\n");
+    free(top);
+  }
+  for (int i = 0; i < req->percentiles_count; i++) {
+    fprintf(f, "p%g: %d\n", req->percentiles[i],
+            ParallelPercentile(array, array_size, req->percentiles[i], num_threads));
+  }
+  if (req->hist_bins > 0) {
+    size_t *counts = malloc(req->hist_bins * sizeof(size_t));
+    struct MinMax range;
+    if (counts == NULL ||
+        ParallelHistogram(array, array_size, req->hist_bins, num_threads, &range, counts) != 0) {
+      free(counts);
+      return -1;
+    }
+    double width = ((double)range.max - range.min + 1) / req->hist_bins;
+    fprintf(f, "Histogram (%zu bins):\n", req->hist_bins);
+    for (size_t b = 0; b < req->hist_bins; b++) {
+      fprintf(f, "  [%.0f, %.0f): %zu\n", range.min + b * width,
+              range.min + (b + 1) * width, counts[b]);
+    }
+    free(counts);
+  }
+  return 0;
+}
+
+// Границы куска i: последний поток получает остаток.
+static void chunk_bounds(size_t array_size, int num_threads, int i, size_t *begin, size_t *end) {
+  size_t chunk_size = array_size / num_threads;
+  *begin = i * chunk_size;
+  *end = (i == num_threads - 1) ? array_size : (i + 1) * chunk_size;
+}
+
+// Потоки по одному на кусок [begin, end), результаты сворачиваются
+// после join. -1 - не хватило памяти или не создался поток.
+static int threaded_min_max(int *array, size_t array_size, int num_threads,
+                            const struct PinConfig *pin, struct MinMax *result) {
+  struct ThreadSlots slots = {0};
+  int slots_ok = ThreadSlotsInit(&slots, num_threads, sizeof(struct ThreadData), 1) == 0;
+  int *cpus = malloc(num_threads * sizeof(int));
+  int *nodes = malloc(num_threads * sizeof(int));
+  if (!slots_ok || cpus == NULL || nodes == NULL) {
+    fprintf(stderr, "Ошибка: не удалось выделить память для данных потоков.\n");
+    ThreadSlotsFree(&slots);
+    free(cpus);
+    free(nodes);
+    return -1;
+  }
+  PlanPlacement(pin, num_threads, cpus, nodes);
+
+  result->min = INT_MAX;
+  result->max = INT_MIN;
+
+  int started = 0;
+  TraceBegin("spawn");
+  for (int i = 0; i < num_threads; i++) {
+    struct ThreadData *data = ThreadSlotAt(&slots, i);
+    data->thread_id = i;
+    data->array = array;
+    data->blocks = block_input.map != NULL ? &block_input : NULL;
+    data->cpu = cpus[i];
+    // Обеспечиваем, что последний поток обработает все оставшиеся элементы
+    chunk_bounds(array_size, num_threads, i, &data->begin, &data->end);
+
+    if (pthread_create(&data->thread, NULL, find_min_max_thread, data) != 0) {
+      perror("pthread_create");
+      break;
+    }
+    started++;
+  }
+  TraceEnd("spawn");
+
+  TraceBegin("join+combine");
+  for (int i = 0; i < started; i++) {
+    struct ThreadData *data = ThreadSlotAt(&slots, i);
+    pthread_join(data->thread, NULL);
+    // потоков больше, чем элементов: у пустого куска нет min/max
+    if (data->begin == data->end) continue;
+
+    if (data->result.min < result->min) result->min = data->result.min;
+    if (data->result.max > result->max) result->max = data->result.max;
+  }
+  TraceEnd("join+combine");
+
+  ThreadSlotsFree(&slots);
+  free(cpus);
+  free(nodes);
+  return started == num_threads ? 0 : -1;
+}
+
 // --- ОСНОВНАЯ ФУНКЦИЯ main ---
 int main(int argc, char *argv[]) {
   if (argc < 4) {
     fprintf(stderr, "Использование:\n");
-    fprintf(stderr, "  Генерация/Pipe: %s pipe <seed> <размер_массива> <число_потоков>\n", argv[0]);
-    fprintf(stderr, "  Файловый ввод/вывод: %s files <входной_файл> <выходной_файл> <число_потоков>\n", argv[0]);
+    fprintf(stderr, "  Генерация/Pipe: %s pipe <seed> <размер_массива> <число_потоков> [опции]\n", argv[0]);
+    fprintf(stderr, "  Файловый ввод/вывод: %s files <входной_файл> <выходной_файл> <число_потоков> [опции]\n", argv[0]);
+    fprintf(stderr, "  Опции: --pin compact|scatter|<список ядер>  --numa\n");
+    fprintf(stderr, "  Свёртки: --topk <k>  --percentile <p>[,<p>...]  --hist <корзин>\n");
     return 1;
   }
 
+  // Необязательные опции после позиционных аргументов
+  struct PinConfig pin = {PIN_NONE, NULL, 0};
+  int numa = 0;
+  struct StatRequest stats = {0};
+  for (int i = 5; i < argc; i++) {
+    if (strcmp(argv[i], "--numa") == 0) {
+      numa = 1;
+    } else if (strcmp(argv[i], "--topk") == 0 && i + 1 < argc) {
+      long long k = atoll(argv[++i]);
+      if (k <= 0) {
+        fprintf(stderr, "Ошибка: --topk должен быть > 0.\n");
+        return 1;
+      }
+      stats.topk = (size_t)k;
+    } else if (strcmp(argv[i], "--percentile") == 0 && i + 1 < argc) {
+      if (parse_percentiles(argv[++i], &stats) != 0) {
+        fprintf(stderr, "Ошибка: --percentile ожидает числа 0..100 через запятую.\n");
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--hist") == 0 && i + 1 < argc) {
+      long long bins = atoll(argv[++i]);
+      if (bins <= 0 || bins > 1000000) {
+        fprintf(stderr, "Ошибка: --hist ожидает число корзин 1..1000000.\n");
+        return 1;
+      }
+      stats.hist_bins = (size_t)bins;
+    } else if (strcmp(argv[i], "--pin") == 0 && i + 1 < argc) {
+      if (ParsePinPolicy(argv[++i], &pin) != 0) {
+        fprintf(stderr, "Ошибка: неизвестная политика привязки '%s'.\n", argv[i]);
+        return 1;
+      }
+    } else {
+      fprintf(stderr, "Ошибка: неизвестная опция '%s'.\n", argv[i]);
+      return 1;
+    }
+  }
+
+  TraceInitFromEnv("parallel_min_max");
   char *mode = argv[1];
   size_t array_size = 0;
   int *array = NULL;
   int num_threads = 0;
   struct MinMax final_result;
   int result_output_ok = 0; // Флаг успешного вывода результата
+  int pipelined = 0;        // результат посчитан конвейером при чтении
+  struct timespec reduce_start = {0}, reduce_finish = {0};
 
   // --- ЛОГИКА РЕЖИМА PIPE (Генерация данных) ---
   if (strcmp(mode, "pipe") == 0) {
-    if (argc != 5) {
+    if (argc < 5) {
       fprintf(stderr, "Ошибка: Для режима 'pipe' требуются <seed> <размер> <потоки>.\n");
       return 1;
     }
@@ -62,24 +278,44 @@ int main(int argc, char *argv[]) {
 
     // Выделение памяти (Heap Allocation - ФИКС КРУПНЫХ МАССИВОВ)
     printf("[PIPE MODE] Выделение памяти для %zu элементов...\n", array_size);
-    array = (int *)malloc(array_size * sizeof(int)); 
+    array = numa ? (int *)NumaAllocArray(array_size * sizeof(int))
+                 : alloc_array(array_size);
     if (array == NULL) {
       fprintf(stderr, "Ошибка: не удалось выделить %zu байт памяти (не хватает RAM?).\n", array_size * sizeof(int));
       return 1;
     }
 
+    // Страницы каждого куска закрепляем за узлом потока, который его обработает,
+    // до первого касания при заполнении.
+    if (numa) {
+      int *cpus = malloc(num_threads * sizeof(int));
+      int *nodes = malloc(num_threads * sizeof(int));
+      if (cpus != NULL && nodes != NULL) {
+        PlanPlacement(&pin, num_threads, cpus, nodes);
+        for (int i = 0; i < num_threads; i++) {
+          size_t begin, end;
+          chunk_bounds(array_size, num_threads, i, &begin, &end);
+          BindRangeToNode(array + begin, (end - begin) * sizeof(int), nodes[i]);
+        }
+      }
+      free(cpus);
+      free(nodes);
+    }
+
     // Заполнение массива (Генерация)
     printf("[PIPE MODE] Заполнение массива...\n");
+    TraceBegin("generate");
     srand(seed);
     for (size_t i = 0; i < array_size; i++) {
       array[i] = rand(); 
     }
+    TraceEnd("generate");
 
   } 
   
   // --- ЛОГИКА РЕЖИМА FILES (Чтение из файла) ---
   else if (strcmp(mode, "files") == 0) {
-    if (argc != 5) {
+    if (argc < 5) {
       fprintf(stderr, "Ошибка: Для режима 'files' требуются <входной_файл> <выходной_файл> <потоки>.\n");
       return 1;
     }
@@ -93,8 +329,53 @@ int main(int argc, char *argv[]) {
     }
     
     printf("[FILES MODE] Чтение данных из файла '%s'...\n", input_filename);
-    
-    if (read_array_from_file(input_filename, &array, &array_size) != 0) {
+
+    int read_status;
+    TraceBegin("read input");
+    if (IsBlockFile(input_filename) == 1) {
+      if (has_stats(&stats)) {
+        fprintf(stderr, "Ошибка: --topk/--percentile/--hist требуют сырой файл (block_convert unpack).\n");
+        return 1;
+      }
+      read_status = BlockFileOpen(input_filename, &block_input);
+      array_size = block_input.count;
+      printf("[FILES MODE] Блочный формат: %llu блоков\n",
+             (unsigned long long)block_input.blocks);
+    } else if (numa) {
+      // Параллельное первое касание: каждый поток читает свой кусок сам.
+      int *cpus = malloc(num_threads * sizeof(int));
+      int *nodes = malloc(num_threads * sizeof(int));
+      if (cpus == NULL || nodes == NULL) {
+        free(cpus);
+        free(nodes);
+        return 1;
+      }
+      PlanPlacement(&pin, num_threads, cpus, nodes);
+      read_status = read_array_from_file_numa(input_filename, &array, &array_size, num_threads, cpus);
+      free(cpus);
+      free(nodes);
+    } else {
+      // чтение и свёртка идут конвейером по кускам; --pin действует
+      // на вызывающий поток (место 0) и рабочие потоки пула
+      int *cpus = malloc(num_threads * sizeof(int));
+      int *nodes = malloc(num_threads * sizeof(int));
+      if (cpus == NULL || nodes == NULL) {
+        free(cpus);
+        free(nodes);
+        return 1;
+      }
+      PlanPlacement(&pin, num_threads, cpus, nodes);
+      clock_gettime(CLOCK_MONOTONIC, &reduce_start);
+      read_status = read_min_max_pipeline(input_filename, num_threads, cpus, &array,
+                                          &array_size, &final_result);
+      clock_gettime(CLOCK_MONOTONIC, &reduce_finish);
+      free(cpus);
+      free(nodes);
+      pipelined = 1;
+    }
+    TraceEnd("read input");
+
+    if (read_status != 0) {
         fprintf(stderr, "Ошибка: Не удалось прочитать массив из файла.\n");
         return 1;
     }
@@ -103,7 +384,7 @@ int main(int argc, char *argv[]) {
     if (array_size > 800000000) {
       fprintf(stderr, "Ошибка: Превышено максимальное количество элементов (800,000,000).\n");
       fprintf(stderr, "Прочитано из файла: %zu элементов.\n", array_size);
-      free(array);
+      free_array(array, array_size, numa);
       return 1;
     }
   } 
@@ -116,66 +397,57 @@ int main(int argc, char *argv[]) {
   
   // --- ОБЩАЯ МНОГОПОТОЧНАЯ ЛОГИКА ---
   
-  if (array == NULL || array_size == 0) {
+  if ((array == NULL && block_input.map == NULL) || array_size == 0) {
       fprintf(stderr, "Ошибка: Массив пуст.\n");
       return 1;
   }
   
-  // 4. ЗАПУСК ПОТОКОВ
-  struct ThreadData *thread_data = malloc(num_threads * sizeof(struct ThreadData));
-  if (thread_data == NULL) {
-    fprintf(stderr, "Ошибка: не удалось выделить память для данных потоков.\n");
-    free(array);
-    return 1;
-  }
-  
-  size_t chunk_size = array_size / num_threads;
-  final_result.min = INT_MAX;
-  final_result.max = INT_MIN;
-
-  printf("Запуск %d потоков (общий размер: %zu)...\n", num_threads, array_size);
-
-  for (int i = 0; i < num_threads; i++) {
-    thread_data[i].thread_id = i;
-    thread_data[i].array = array;
-    thread_data[i].begin = i * chunk_size;
-    // Обеспечиваем, что последний поток обработает все оставшиеся элементы
-    thread_data[i].end = (i == num_threads - 1) ? array_size : (i + 1) * chunk_size;
-
-    if (pthread_create(&thread_data[i].thread, NULL, find_min_max_thread, &thread_data[i]) != 0) {
-      perror("pthread_create");
-      free(array); free(thread_data); return 1;
+  // 4-5. ЗАПУСК ПОТОКОВ И ОБЪЕДИНЕНИЕ (конвейер files всё посчитал при чтении)
+  if (!pipelined) {
+    printf("Запуск %d потоков (общий размер: %zu)...\n", num_threads, array_size);
+    clock_gettime(CLOCK_MONOTONIC, &reduce_start);
+    int status = threaded_min_max(array, array_size, num_threads, &pin, &final_result);
+    clock_gettime(CLOCK_MONOTONIC, &reduce_finish);
+    if (status != 0) {
+      free_array(array, array_size, numa);
+      return 1;
     }
   }
-
-  // 5. ОЖИДАНИЕ И ОБЪЕДИНЕНИЕ РЕЗУЛЬТАТОВ
-  for (int i = 0; i < num_threads; i++) {
-    pthread_join(thread_data[i].thread, NULL);
-    
-    if (thread_data[i].result.min < final_result.min) final_result.min = thread_data[i].result.min;
-    if (thread_data[i].result.max > final_result.max) final_result.max = thread_data[i].result.max;
+  if (!numa && block_input.map == NULL) {
+    double seconds = (reduce_finish.tv_sec - reduce_start.tv_sec) +
+                     (reduce_finish.tv_nsec - reduce_start.tv_nsec) / 1e9;
+    // в конвейере чтение и свёртка перекрываются: отдельной фазы
+    // свёртки нет, печатаем общее время
+    if (pipelined) ArenaReportPhase(&array_arena, "read+reduce pipeline", seconds);
+    else ArenaReportTimes(&array_arena, seconds);
   }
-  
 
   // 6. ВЫВОД РЕЗУЛЬТАТА
+  TraceBegin("write result");
   if (strcmp(mode, "pipe") == 0) {
     // Вывод в stdout для режима pipe
     printf("--- Результат (pipe) --- \n");
     printf("Глобальный минимум: %d\n", final_result.min);
     printf("Глобальный максимум: %d\n", final_result.max);
+    if (has_stats(&stats)) result_output_ok = report_stats(stdout, array, array_size, num_threads, &stats);
     printf("------------------------\n");
-    result_output_ok = 0;
   } else {
     // Вывод в файл для режима files
     const char *output_filename = argv[3];
     printf("[FILES MODE] Запись результата в файл '%s'...\n", output_filename);
     result_output_ok = write_result_to_file(output_filename, final_result);
+    if (result_output_ok == 0 && has_stats(&stats)) {
+      FILE *f = fopen(output_filename, "a");
+      result_output_ok = f != NULL ? report_stats(f, array, array_size, num_threads, &stats) : -1;
+      if (f != NULL) fclose(f);
+    }
   }
+  TraceEnd("write result");
 
 
   // 7. ОЧИСТКА
-  free(array);
-  free(thread_data);
+  free_array(array, array_size, numa);
+  FreePinConfig(&pin);
 
   return (result_output_ok != 0) ? 1 : 0;
 }
@@ -183,56 +455,223 @@ int main(int argc, char *argv[]) {
 
 // --- РЕАЛИЗАЦИЯ ФУНКЦИЙ ФАЙЛОВОГО I/O ---
 
-// Читает массив из файла. Предполагается, что файл содержит только int в бинарном формате.
-int read_array_from_file(const char *filename, int **array, size_t *array_size_out) {
-    FILE *f = fopen(filename, "rb");
+// Записывает результат в файл (текстовый формат).
+int write_result_to_file(const char *filename, struct MinMax result) {
+    FILE *f = fopen(filename, "w");
     if (!f) {
-        perror("Error opening input file for reading");
+        perror("Error opening output file for writing");
         return -1;
     }
     
-    // Определяем размер файла
-    fseek(f, 0, SEEK_END);
-    long file_size = ftell(f);
-    if (file_size < 0) {
+    fprintf(f, "Min: %d\n", result.min);
+    fprintf(f, "Max: %d\n", result.max);
+    
+    fclose(f);
+    return 0;
+}
+
+// Поток чтения: привязывается к ядру и читает свой кусок файла,
+// так что страницы выделяются на его NUMA-узле.
+struct ReadChunk {
+  int fd;
+  int *array;
+  size_t begin;
+  size_t end;
+  int cpu;
+  int status;
+};
+
+// Читает элементы [begin, end) файла в array + begin.
+static int pread_range(int fd, int *array, size_t begin, size_t end) {
+  char *dst = (char *)(array + begin);
+  size_t left = (end - begin) * sizeof(int);
+  off_t offset = (off_t)(begin * sizeof(int));
+  while (left > 0) {
+    ssize_t n = pread(fd, dst, left, offset);
+    if (n <= 0) return -1;
+    dst += n;
+    offset += n;
+    left -= (size_t)n;
+  }
+  return 0;
+}
+
+static void *read_chunk_thread(void *arg) {
+  struct ReadChunk *c = (struct ReadChunk *)arg;
+  PinSelf(c->cpu);
+  c->status = pread_range(c->fd, c->array, c->begin, c->end);
+  return NULL;
+}
+
+// Конвейер режима files: файл читается кусками по PIPELINE_CHUNK
+// элементов, и кусок i сворачивается в пуле, пока читается кусок i + 1.
+// Чтения идут цепочкой по порядку (последовательный pread - то, что
+// любит диск), поэтому на холодном файле время до результата - примерно
+// max(чтение, свёртка), а не их сумма.
+#define PIPELINE_CHUNK ((size_t)1 << 18)
+
+struct PipelineChunk {
+  struct GraphTask read;
+  struct GraphTask reduce;
+  int fd;
+  int *array;
+  size_t begin;
+  size_t end;
+  int status;
+  struct MinMax result;
+};
+
+static void pipeline_read(struct GraphTask *task) {
+  struct PipelineChunk *c = GRAPH_TASK_OWNER(task, struct PipelineChunk, read);
+  TraceBeginArg("read chunk", "begin", (int64_t)c->begin);
+  c->status = pread_range(c->fd, c->array, c->begin, c->end);
+  TraceEnd("read chunk");
+}
+
+static void pipeline_reduce(struct GraphTask *task) {
+  struct PipelineChunk *c = GRAPH_TASK_OWNER(task, struct PipelineChunk, reduce);
+  if (c->status != 0) return;
+  TraceBeginArg("min/max chunk", "begin", (int64_t)c->begin);
+  c->result = GetMinMax(c->array, c->begin, c->end);
+  TraceEnd("min/max chunk");
+}
+
+// Читает сырой файл int в арену и сразу считает min/max. Пул - из
+// num_threads - 1 потоков, вызывающий поток работает вместе с ними;
+// поток i привязывается к cpus[i] (-1 - без привязки).
+int read_min_max_pipeline(const char *filename, int num_threads, const int *cpus,
+                          int **array, size_t *array_size_out, struct MinMax *result) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Error opening input file for reading");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
         perror("Error determining file size");
-        fclose(f);
+        close(fd);
         return -1;
     }
-
-    *array_size_out = file_size / sizeof(int);
-    fseek(f, 0, SEEK_SET);
-    
-    // Выделяем память
-    *array = (int*)malloc(*array_size_out * sizeof(int));
+    size_t size = (size_t)st.st_size / sizeof(int);
+    *array_size_out = size;
+    *array = alloc_array(size);
     if (*array == NULL) {
         fprintf(stderr, "Error: Could not allocate memory for array from file.\n");
-        fclose(f);
+        close(fd);
         return -1;
     }
-    
-    // Читаем весь массив
-    size_t items_read = fread(*array, sizeof(int), *array_size_out, f);
-    if (items_read != *array_size_out) {
-        fprintf(stderr, "Warning: Expected %zu items, read %zu items.\n", *array_size_out, items_read);
+
+    size_t count = (size + PIPELINE_CHUNK - 1) / PIPELINE_CHUNK;
+    struct PipelineChunk *chunks = calloc(count ? count : 1, sizeof(*chunks));
+    if (chunks == NULL) {
+        close(fd);
+        free_array(*array, size, 0);
+        *array = NULL;
+        return -1;
     }
+    // вызывающий поток привязан только на время конвейера
+    void *saved_affinity = PinSelfSaved(cpus[0]);
+    struct ThreadPool *pool = NULL;
+    if (num_threads > 1 && count > 1)
+        pool = ThreadPoolCreateWithStart(num_threads - 1, 2 * count, PinPoolWorker,
+                                         (void *)cpus);
 
-    fclose(f);
-    printf("Прочитано %zu элементов.\n", *array_size_out);
+    struct TaskGraph graph;
+    TaskGraphInit(&graph, pool);
+    for (size_t i = 0; i < count; i++) {
+        struct PipelineChunk *c = &chunks[i];
+        c->fd = fd;
+        c->array = *array;
+        c->begin = i * PIPELINE_CHUNK;
+        c->end = c->begin + PIPELINE_CHUNK < size ? c->begin + PIPELINE_CHUNK : size;
+        TaskGraphAdd(&graph, &c->read, pipeline_read);
+        TaskGraphAdd(&graph, &c->reduce, pipeline_reduce);
+    }
+    for (size_t i = 0; i < count; i++) {
+        // сначала следующее чтение, потом свёртка: чтение не ждёт в очереди
+        if (i + 1 < count) TaskGraphDepend(&chunks[i + 1].read, &chunks[i].read);
+        TaskGraphDepend(&chunks[i].reduce, &chunks[i].read);
+    }
+    TaskGraphRun(&graph);
+    ThreadPoolDestroy(pool);
+    PinRestore(saved_affinity);
+    close(fd);
+
+    int status = 0;
+    result->min = INT_MAX;
+    result->max = INT_MIN;
+    TraceBegin("combine");
+    for (size_t i = 0; i < count; i++) {
+        if (chunks[i].status != 0) status = -1;
+        if (chunks[i].result.min < result->min) result->min = chunks[i].result.min;
+        if (chunks[i].result.max > result->max) result->max = chunks[i].result.max;
+    }
+    TraceEnd("combine");
+    free(chunks);
+    if (status != 0) {
+        fprintf(stderr, "Error: failed to read input file.\n");
+        free_array(*array, size, 0);
+        *array = NULL;
+        return -1;
+    }
+    printf("Прочитано %zu элементов.\n", size);
     return 0;
 }
 
-// Записывает результат в файл (текстовый формат).
-int write_result_to_file(const char *filename, struct MinMax result) {
-    FILE *f = fopen(filename, "w");
-    if (!f) {
-        perror("Error opening output file for writing");
+// Читает сырой файл int для --numa: память выделяется без касания, куски
+// читаются параллельно потоками, привязанными к cpus[i], так что каждая
+// страница попадает на узел читающего её потока.
+int read_array_from_file_numa(const char *filename, int **array, size_t *array_size_out,
+                              int num_threads, const int *cpus) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Error opening input file for reading");
         return -1;
     }
-    
-    fprintf(f, "Min: %d\n", result.min);
-    fprintf(f, "Max: %d\n", result.max);
-    
-    fclose(f);
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("Error determining file size");
+        close(fd);
+        return -1;
+    }
+    *array_size_out = (size_t)st.st_size / sizeof(int);
+    *array = (int *)NumaAllocArray(*array_size_out * sizeof(int));
+    if (*array == NULL) {
+        fprintf(stderr, "Error: Could not allocate memory for array from file.\n");
+        close(fd);
+        return -1;
+    }
+
+    struct ReadChunk *chunks = calloc(num_threads, sizeof(struct ReadChunk));
+    pthread_t *threads = calloc(num_threads, sizeof(pthread_t));
+    int status = (chunks == NULL || threads == NULL) ? -1 : 0;
+    int started = 0;
+    for (int i = 0; status == 0 && i < num_threads; i++) {
+        chunks[i].fd = fd;
+        chunks[i].array = *array;
+        chunks[i].cpu = cpus[i];
+        chunk_bounds(*array_size_out, num_threads, i, &chunks[i].begin, &chunks[i].end);
+        if (pthread_create(&threads[i], NULL, read_chunk_thread, &chunks[i]) != 0) {
+            perror("pthread_create");
+            status = -1;
+            break;
+        }
+        started++;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        if (chunks[i].status != 0) status = -1;
+    }
+    free(chunks);
+    free(threads);
+    close(fd);
+
+    if (status != 0) {
+        fprintf(stderr, "Error: failed to read input file in parallel.\n");
+        NumaFreeArray(*array, *array_size_out * sizeof(int));
+        *array = NULL;
+        return -1;
+    }
+    printf("Прочитано %zu элементов.\n", *array_size_out);
     return 0;
-}
\ No newline at end of file
+}
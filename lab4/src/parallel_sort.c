@@ -0,0 +1,246 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sort_lib.h"
+#include "utils.h"
+
+// Параллельная сортировка массива int: сгенерированного (pipe) или
+// сырого бинарного файла (files), который сортируется на месте через mmap.
+
+static double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int CompareInt(const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+// Копирует входной файл в выходной, если это разные файлы. Одинаковость
+// определяется по устройству и inode: "e.raw", "./e.raw", симлинк или
+// жёсткая ссылка - один файл, и он сортируется на месте. Копия пишется
+// во временный файл рядом с выходным и переименовывается поверх него,
+// так что вход не обрезается, даже если сравнение ошиблось. Права - как
+// у заменяемого выходного файла, а нового - 0666 & ~umask, как у fopen
+// (mkstemp создаёт 0600).
+static int copy_file(const char *from, const char *to) {
+  struct stat from_st, to_st;
+  if (stat(from, &from_st) != 0) {
+    perror("Error opening input file for reading");
+    return -1;
+  }
+  int to_exists = stat(to, &to_st) == 0;
+  if (to_exists && from_st.st_dev == to_st.st_dev &&
+      from_st.st_ino == to_st.st_ino)
+    return 0;
+  mode_t mode;
+  if (to_exists) {
+    mode = to_st.st_mode & 07777;
+  } else {
+    mode_t mask = umask(0);
+    umask(mask);
+    mode = 0666 & ~mask;
+  }
+
+  FILE *in = fopen(from, "rb");
+  if (!in) {
+    perror("Error opening input file for reading");
+    return -1;
+  }
+  size_t tmp_len = strlen(to) + sizeof(".XXXXXX");
+  char *tmp = malloc(tmp_len);
+  if (tmp == NULL) {
+    perror("malloc");
+    fclose(in);
+    return -1;
+  }
+  snprintf(tmp, tmp_len, "%s.XXXXXX", to);
+  int fd = mkstemp(tmp);
+  if (fd >= 0 && fchmod(fd, mode) != 0) {
+    perror("fchmod");
+    close(fd);
+    unlink(tmp);
+    free(tmp);
+    fclose(in);
+    return -1;
+  }
+  FILE *out = fd >= 0 ? fdopen(fd, "wb") : NULL;
+  if (!out) {
+    perror("Error opening output file for writing");
+    if (fd >= 0) {
+      close(fd);
+      unlink(tmp);
+    }
+    free(tmp);
+    fclose(in);
+    return -1;
+  }
+  char buf[1 << 16];
+  size_t n;
+  int status = 0;
+  while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+    if (fwrite(buf, 1, n, out) != n) {
+      perror("fwrite");
+      status = -1;
+      break;
+    }
+  }
+  if (ferror(in)) {
+    perror("fread");
+    status = -1;
+  }
+  fclose(in);
+  if (fclose(out) != 0) status = -1;
+  if (status == 0 && rename(tmp, to) != 0) {
+    perror("rename");
+    status = -1;
+  }
+  if (status != 0) unlink(tmp);
+  free(tmp);
+  return status;
+}
+
+// Отображает файл в память с MAP_SHARED: сортировка пишет прямо в файл.
+static int *map_file(const char *filename, size_t *array_size_out) {
+  int fd = open(filename, O_RDWR);
+  if (fd < 0) {
+    perror("open");
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    perror("fstat");
+    close(fd);
+    return NULL;
+  }
+  *array_size_out = st.st_size / sizeof(int);
+  if (*array_size_out == 0) {
+    close(fd);
+    return NULL;
+  }
+  void *map = mmap(NULL, *array_size_out * sizeof(int), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    perror("mmap");
+    return NULL;
+  }
+  return map;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 5) {
+    fprintf(stderr, "Использование:\n");
+    fprintf(stderr, "  %s pipe <seed> <размер_массива> <число_потоков> [опции]\n", argv[0]);
+    fprintf(stderr, "  %s files <входной_файл> <выходной_файл> <число_потоков> [опции]\n", argv[0]);
+    fprintf(stderr, "  Опции: --algo radix|sample  --bench (сравнение с qsort)\n");
+    fprintf(stderr, "  Если входной и выходной файл совпадают, файл сортируется на месте.\n");
+    return 1;
+  }
+
+  int sample = 0;
+  int bench = 0;
+  for (int i = 5; i < argc; i++) {
+    if (strcmp(argv[i], "--algo") == 0 && i + 1 < argc) {
+      i++;
+      if (strcmp(argv[i], "sample") == 0) sample = 1;
+      else if (strcmp(argv[i], "radix") != 0) {
+        fprintf(stderr, "Ошибка: неизвестный алгоритм '%s'.\n", argv[i]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--bench") == 0) {
+      bench = 1;
+    } else {
+      fprintf(stderr, "Ошибка: неизвестная опция '%s'.\n", argv[i]);
+      return 1;
+    }
+  }
+
+  const char *mode = argv[1];
+  int num_threads = atoi(argv[4]);
+  if (num_threads <= 0) {
+    fprintf(stderr, "Ошибка: Число потоков должно быть > 0.\n");
+    return 1;
+  }
+
+  int *array = NULL;
+  size_t array_size = 0;
+  int mapped = 0;
+  if (strcmp(mode, "pipe") == 0) {
+    unsigned int seed = (unsigned int)strtoull(argv[2], NULL, 10);
+    array_size = strtoull(argv[3], NULL, 10);
+    if (array_size == 0) {
+      fprintf(stderr, "Ошибка: Размер должен быть > 0.\n");
+      return 1;
+    }
+    array = malloc(array_size * sizeof(int));
+    if (array == NULL) {
+      fprintf(stderr, "Ошибка: не удалось выделить %zu байт памяти.\n", array_size * sizeof(int));
+      return 1;
+    }
+    GenerateArray(array, array_size, seed);
+  } else if (strcmp(mode, "files") == 0) {
+    if (copy_file(argv[2], argv[3]) != 0) return 1;
+    array = map_file(argv[3], &array_size);
+    if (array == NULL) {
+      fprintf(stderr, "Ошибка: файл '%s' пуст или недоступен.\n", argv[3]);
+      return 1;
+    }
+    mapped = 1;
+  } else {
+    fprintf(stderr, "Ошибка: Неизвестный режим работы '%s'. Используйте 'pipe' или 'files'.\n", mode);
+    return 1;
+  }
+
+  // Копия для qsort снимается до сортировки.
+  int *reference = NULL;
+  if (bench) {
+    reference = malloc(array_size * sizeof(int));
+    if (reference == NULL) {
+      fprintf(stderr, "Ошибка: не хватает памяти для сравнения с qsort.\n");
+      bench = 0;
+    } else {
+      memcpy(reference, array, array_size * sizeof(int));
+    }
+  }
+
+  printf("Сортировка %zu элементов (%s, %d потоков)...\n", array_size,
+         sample ? "sample sort" : "radix sort", num_threads);
+  double start = Now();
+  int status = sample ? ParallelSampleSort(array, array_size, num_threads)
+                      : ParallelRadixSort(array, array_size, num_threads);
+  double elapsed = Now() - start;
+  if (status != 0) {
+    fprintf(stderr, "Ошибка: не удалось выделить буфер сортировки.\n");
+    return 1;
+  }
+  printf("Время: %f с\n", elapsed);
+
+  int ok = IsSorted(array, array_size);
+  if (bench) {
+    start = Now();
+    qsort(reference, array_size, sizeof(int), CompareInt);
+    double qsort_time = Now() - start;
+    printf("qsort: %f с (ускорение %.1fx)\n", qsort_time, qsort_time / elapsed);
+    if (memcmp(reference, array, array_size * sizeof(int)) != 0) ok = 0;
+    free(reference);
+  }
+  printf("Минимум: %d, максимум: %d\n", array[0], array[array_size - 1]);
+  if (!ok) fprintf(stderr, "Ошибка: результат не отсортирован!\n");
+
+  if (mapped) {
+    msync(array, array_size * sizeof(int), MS_SYNC);
+    munmap(array, array_size * sizeof(int));
+  } else {
+    free(array);
+  }
+  return ok ? 0 : 1;
+}
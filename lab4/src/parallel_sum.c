@@ -3,31 +3,58 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/time.h>
 
+#include "arena.h"
+#include "block_format.h"
+#include "numa_place.h"
 #include "sum_lib.h"
+#include "task_graph.h"
+#include "thread_slots.h"
+#include "trace.h"
 #include "utils.h"
 
 struct SumArgs {
   const int *array;
+  const struct BlockFile *blocks;  // не NULL - сумма по блочному файлу
   size_t begin;
   size_t end;
+  size_t chunk;  // 0 - один кусок [begin, end), иначе куски через step
+  size_t step;
+  int cpu;
+  int index;
+  long long *result;  // запись в ThreadSlots, пишет только свой поток
 };
 
 static void PrintUsage(const char *prog_name) {
-  printf("Usage: %s --threads_num \"num\" --seed \"num\" --array_size \"num\"\n",
+  printf("Usage: %s --threads_num \"num\" --seed \"num\" --array_size \"num\" "
+         "[--pin compact|scatter|<cpu list>] [--numa]\n"
+         "       [--chunk <elements> [--layout padded|packed]] [--pipeline]\n",
+         prog_name);
+  printf("       %s --threads_num \"num\" --input <block file> "
+         "[--pin compact|scatter|<cpu list>]\n",
          prog_name);
 }
 
 static int ParseArguments(int argc, char **argv, uint32_t *threads_num,
-                          uint32_t *seed, uint32_t *array_size) {
+                          uint32_t *seed, uint32_t *array_size,
+                          struct PinConfig *pin, int *numa,
+                          const char **input, size_t *chunk, int *padded,
+                          int *pipeline) {
   int option_index = 0;
   optind = 1;
 
   static struct option options[] = {{"threads_num", required_argument, 0, 0},
                                     {"seed", required_argument, 0, 0},
                                     {"array_size", required_argument, 0, 0},
+                                    {"pin", required_argument, 0, 0},
+                                    {"numa", no_argument, 0, 0},
+                                    {"input", required_argument, 0, 0},
+                                    {"chunk", required_argument, 0, 0},
+                                    {"layout", required_argument, 0, 0},
+                                    {"pipeline", no_argument, 0, 0},
                                     {0, 0, 0, 0}};
 
   while (1) {
@@ -60,6 +87,40 @@ static int ParseArguments(int argc, char **argv, uint32_t *threads_num,
           }
           *array_size = (uint32_t)parsed_size;
           break;
+        case 3:
+          FreePinConfig(pin);
+          if (ParsePinPolicy(optarg, pin) != 0) {
+            printf("pin must be none, compact, scatter or a cpu list\n");
+            return -1;
+          }
+          break;
+        case 4:
+          *numa = 1;
+          break;
+        case 5:
+          *input = optarg;
+          break;
+        case 6:
+          int parsed_chunk = atoi(optarg);
+          if (parsed_chunk <= 0) {
+            printf("chunk must be a positive number\n");
+            return -1;
+          }
+          *chunk = (size_t)parsed_chunk;
+          break;
+        case 7:
+          if (strcmp(optarg, "padded") == 0) {
+            *padded = 1;
+          } else if (strcmp(optarg, "packed") == 0) {
+            *padded = 0;
+          } else {
+            printf("layout must be padded or packed\n");
+            return -1;
+          }
+          break;
+        case 8:
+          *pipeline = 1;
+          break;
         default:
           break;
       }
@@ -71,7 +132,11 @@ static int ParseArguments(int argc, char **argv, uint32_t *threads_num,
     }
   }
 
-  if (*threads_num == 0 || *seed == 0 || *array_size == 0) {
+  if (*threads_num == 0) {
+    return -1;
+  }
+  // с --input данные берутся из файла, seed и размер не нужны
+  if (*input == NULL && (*seed == 0 || *array_size == 0)) {
     return -1;
   }
 
@@ -80,69 +145,277 @@ static int ParseArguments(int argc, char **argv, uint32_t *threads_num,
     return -1;
   }
 
+  if (*pipeline && (*input != NULL || *numa || *chunk != 0)) {
+    printf("--pipeline works only with a generated array (no --input, --numa, --chunk)\n");
+    return -1;
+  }
+
   return 0;
 }
 
+static long long PartSum(const struct SumArgs *sum_args, size_t begin,
+                         size_t end) {
+  if (sum_args->blocks != NULL)
+    return BlockQuerySum(sum_args->blocks, begin, end);
+  return SumRange(sum_args->array, begin, end);
+}
+
+// Результат пишется в запись потока - без malloc на каждый поток.
 static void *ThreadSum(void *args) {
   struct SumArgs *sum_args = (struct SumArgs *)args;
-  long long *result = (long long *)malloc(sizeof(long long));
-  if (result == NULL) {
-    perror("malloc");
-    pthread_exit(NULL);
+  PinSelf(sum_args->cpu);
+  TraceThreadName("sum", sum_args->index);
+  TraceBeginArg("sum chunk", "elements",
+                (int64_t)(sum_args->end - sum_args->begin));
+  if (sum_args->chunk == 0) {
+    *sum_args->result = PartSum(sum_args, sum_args->begin, sum_args->end);
+    TraceEnd("sum chunk");
+    return NULL;
   }
-  *result = SumRange(sum_args->array, sum_args->begin, sum_args->end);
-  return result;
+  // Режим --chunk: много мелких кусков вперемешку с соседями, результат
+  // пишется в память после каждого. Если результаты потоков делят
+  // кэш-линию, каждая такая запись отбирает линию у соседа.
+  volatile long long *result = sum_args->result;
+  for (size_t pos = sum_args->begin; pos < sum_args->end; pos += sum_args->step) {
+    size_t end = pos + sum_args->chunk;
+    if (end > sum_args->end) end = sum_args->end;
+    *result += PartSum(sum_args, pos, end);
+  }
+  TraceEnd("sum chunk");
+  return NULL;
+}
+
+// --pipeline: генерация и сумма по кускам PIPELINE_CHUNK через граф задач.
+// rand() даёт одну последовательность, поэтому куски генерируются строго
+// по порядку (цепочка зависимостей), а сумма куска i идёт в пуле, пока
+// генерируется кусок i + 1. Время до результата - примерно время
+// генерации, а не генерация плюс сумма.
+#define PIPELINE_CHUNK ((size_t)1 << 18)
+
+struct SumStage {
+  struct GraphTask generate;
+  struct GraphTask sum;
+  int *array;
+  size_t begin;
+  size_t end;
+  long long result;
+};
+
+static void StageGenerate(struct GraphTask *task) {
+  struct SumStage *stage = GRAPH_TASK_OWNER(task, struct SumStage, generate);
+  TraceBeginArg("generate chunk", "begin", (int64_t)stage->begin);
+  GenerateArrayChunk(stage->array, stage->begin, stage->end);
+  TraceEnd("generate chunk");
+}
+
+static void StageSum(struct GraphTask *task) {
+  struct SumStage *stage = GRAPH_TASK_OWNER(task, struct SumStage, sum);
+  TraceBeginArg("sum chunk", "begin", (int64_t)stage->begin);
+  stage->result = SumRange(stage->array, stage->begin, stage->end);
+  TraceEnd("sum chunk");
+}
+
+// Пул из threads_num - 1 потоков, главный поток работает вместе с ними.
+// --pin: главный поток - место 0 плана, рабочие - следующие.
+static int PipelineSum(int *array, size_t size, uint32_t seed,
+                       uint32_t threads_num, const struct PinConfig *pin,
+                       long long *total) {
+  size_t count = (size + PIPELINE_CHUNK - 1) / PIPELINE_CHUNK;
+  struct SumStage *stages = calloc(count, sizeof(*stages));
+  int *cpus = malloc(sizeof(int) * threads_num);
+  int *nodes = malloc(sizeof(int) * threads_num);
+  if (stages == NULL || cpus == NULL || nodes == NULL) {
+    free(stages);
+    free(cpus);
+    free(nodes);
+    return -1;
+  }
+  PlanPlacement(pin, (int)threads_num, cpus, nodes);
+  void *saved_affinity = PinSelfSaved(cpus[0]);
+  struct ThreadPool *pool = NULL;
+  if (threads_num > 1 && count > 1)
+    pool = ThreadPoolCreateWithStart((int)threads_num - 1, 2 * count,
+                                     PinPoolWorker, cpus);
+
+  struct TaskGraph graph;
+  TaskGraphInit(&graph, pool);
+  for (size_t i = 0; i < count; i++) {
+    stages[i].array = array;
+    stages[i].begin = i * PIPELINE_CHUNK;
+    stages[i].end = stages[i].begin + PIPELINE_CHUNK < size
+                        ? stages[i].begin + PIPELINE_CHUNK
+                        : size;
+    TaskGraphAdd(&graph, &stages[i].generate, StageGenerate);
+    TaskGraphAdd(&graph, &stages[i].sum, StageSum);
+  }
+  for (size_t i = 0; i < count; i++) {
+    // следующий кусок генерации - первым, чтобы цепочка не ждала сумм
+    if (i + 1 < count)
+      TaskGraphDepend(&stages[i + 1].generate, &stages[i].generate);
+    TaskGraphDepend(&stages[i].sum, &stages[i].generate);
+  }
+
+  srand(seed);
+  TaskGraphRun(&graph);
+  ThreadPoolDestroy(pool);
+  PinRestore(saved_affinity);
+  free(cpus);
+  free(nodes);
+
+  TraceBegin("combine");
+  *total = 0;
+  for (size_t i = 0; i < count; i++) *total += stages[i].result;
+  TraceEnd("combine");
+  free(stages);
+  return 0;
 }
 
 int main(int argc, char **argv) {
   uint32_t threads_num = 0;
   uint32_t array_size = 0;
   uint32_t seed = 0;
+  struct PinConfig pin = {PIN_NONE, NULL, 0};
+  int numa = 0;
+  const char *input = NULL;
+  size_t chunk = 0;
+  int padded = 1;
+  int pipeline = 0;
 
-  if (ParseArguments(argc, argv, &threads_num, &seed, &array_size) != 0) {
+  if (ParseArguments(argc, argv, &threads_num, &seed, &array_size, &pin,
+                     &numa, &input, &chunk, &padded, &pipeline) != 0) {
     PrintUsage(argv[0]);
+    FreePinConfig(&pin);
     return 1;
   }
+  TraceInitFromEnv("parallel_sum");
 
-  int *array = (int *)malloc(sizeof(int) * array_size);
-  if (array == NULL) {
-    perror("malloc");
-    return 1;
+  // Блочный файл не загружается целиком: суммы целых блоков берутся
+  // из индекса, распаковываются только крайние блоки кусков.
+  struct BlockFile blocks = {0};
+  size_t total = array_size;
+  if (input != NULL) {
+    TraceBegin("open input");
+    if (IsBlockFile(input) != 1) {
+      printf("%s is not a block file (convert it with block_convert pack)\n",
+             input);
+      FreePinConfig(&pin);
+      return 1;
+    }
+    if (BlockFileOpen(input, &blocks) != 0) {
+      FreePinConfig(&pin);
+      return 1;
+    }
+    total = blocks.count;
+    numa = 0;
+    TraceEnd("open input");
   }
 
-  GenerateArray(array, array_size, seed);
-
-  pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * threads_num);
-  if (threads == NULL) {
+  // Без --numa массив берётся из арены на огромных страницах.
+  size_t array_bytes = sizeof(int) * array_size;
+  struct Arena arena = {0};
+  int *array = NULL;
+  if (input != NULL) {
+    array_bytes = 0;
+  } else if (numa) {
+    array = (int *)NumaAllocArray(array_bytes);
+  } else {
+    struct ArenaOptions arena_opts;
+    ArenaOptionsFromEnv(&arena_opts);
+    if (ArenaInit(&arena, array_bytes, &arena_opts) == 0)
+      array = (int *)ArenaAlloc(&arena, array_bytes);
+  }
+  if (array == NULL && input == NULL) {
     perror("malloc");
-    free(array);
     return 1;
   }
 
+  if (pipeline) {
+    // время - от начала генерации до готовой суммы
+    struct timeval start_time = {0};
+    struct timeval finish_time = {0};
+    gettimeofday(&start_time, NULL);
+    long long total_sum = 0;
+    int rc = PipelineSum(array, array_size, seed, threads_num, &pin,
+                         &total_sum);
+    gettimeofday(&finish_time, NULL);
+    double elapsed_time = (finish_time.tv_sec - start_time.tv_sec) +
+                          (finish_time.tv_usec - start_time.tv_usec) / 1000000.0;
+    if (rc == 0) {
+      printf("Total: %lld\n", total_sum);
+      printf("Elapsed time: %f seconds (generate + sum, pipelined)\n",
+             elapsed_time);
+    } else {
+      perror("pipeline");
+    }
+    ArenaReportPhase(&arena, "generate+sum pipeline", elapsed_time);
+    FreePinConfig(&pin);
+    ArenaDestroy(&arena);
+    return rc == 0 ? 0 : 1;
+  }
+
+  // Результаты потоков - по кэш-линии на поток (--layout packed - вплотную,
+  // как обычный массив long long).
+  struct ThreadSlots slots = {0};
+  int slots_ok = ThreadSlotsInit(&slots, (int)threads_num, sizeof(long long),
+                                 padded) == 0;
+  pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * threads_num);
   struct SumArgs *args = (struct SumArgs *)malloc(sizeof(struct SumArgs) * threads_num);
-  if (args == NULL) {
+  int *cpus = (int *)malloc(sizeof(int) * threads_num);
+  int *nodes = (int *)malloc(sizeof(int) * threads_num);
+  if (threads == NULL || args == NULL || !slots_ok || cpus == NULL ||
+      nodes == NULL) {
     perror("malloc");
     free(threads);
-    free(array);
+    free(args);
+    ThreadSlotsFree(&slots);
+    free(cpus);
+    free(nodes);
+    if (numa) NumaFreeArray(array, array_bytes);
+    else ArenaDestroy(&arena);
+    BlockFileClose(&blocks);
     return 1;
   }
 
-  size_t base_chunk = array_size / threads_num;
-  size_t remainder = array_size % threads_num;
+  PlanPlacement(&pin, (int)threads_num, cpus, nodes);
+
+  size_t base_chunk = total / threads_num;
+  size_t remainder = total % threads_num;
   size_t offset = 0;
 
   for (uint32_t i = 0; i < threads_num; ++i) {
     size_t chunk_size = base_chunk + (i < remainder ? 1 : 0);
     args[i].array = array;
+    args[i].blocks = input != NULL ? &blocks : NULL;
+    args[i].cpu = cpus[i];
+    args[i].index = (int)i;
+    args[i].result = ThreadSlotAt(&slots, (int)i);
+    if (chunk != 0) {
+      // поток i берёт куски i, i + threads_num, ...
+      args[i].chunk = chunk;
+      args[i].step = chunk * threads_num;
+      args[i].begin = chunk * i;
+      args[i].end = total;
+      continue;
+    }
     args[i].begin = offset;
     args[i].end = offset + chunk_size;
     offset += chunk_size;
+    // страницы куска окажутся на узле потока, который будет его суммировать
+    if (numa)
+      BindRangeToNode(array + args[i].begin, chunk_size * sizeof(int), nodes[i]);
+  }
+
+  if (input == NULL) {
+    TraceBegin("generate");
+    GenerateArray(array, array_size, seed);
+    TraceEnd("generate");
   }
 
   struct timeval start_time = {0};
   struct timeval finish_time = {0};
   gettimeofday(&start_time, NULL);
 
+  TraceBegin("spawn");
   for (uint32_t i = 0; i < threads_num; ++i) {
     if (pthread_create(&threads[i], NULL, ThreadSum, (void *)&args[i]) != 0) {
       perror("pthread_create");
@@ -150,19 +423,18 @@ int main(int argc, char **argv) {
       break;
     }
   }
+  TraceEnd("spawn");
 
+  TraceBegin("join+combine");
   long long total_sum = 0;
   for (uint32_t i = 0; i < threads_num; ++i) {
-    void *result = NULL;
-    if (pthread_join(threads[i], &result) != 0) {
+    if (pthread_join(threads[i], NULL) != 0) {
       perror("pthread_join");
       continue;
     }
-    if (result != NULL) {
-      total_sum += *(long long *)result;
-      free(result);
-    }
+    total_sum += *args[i].result;
   }
+  TraceEnd("join+combine");
 
   gettimeofday(&finish_time, NULL);
 
@@ -171,9 +443,19 @@ int main(int argc, char **argv) {
 
   printf("Total: %lld\n", total_sum);
   printf("Elapsed time: %f seconds\n", elapsed_time);
+  if (chunk != 0)
+    printf("Chunks of %zu elements, %s results (%zu bytes apart)\n",
+           chunk, padded ? "padded" : "packed", slots.stride);
+  if (!numa && input == NULL) ArenaReportTimes(&arena, elapsed_time);
 
   free(args);
+  ThreadSlotsFree(&slots);
   free(threads);
-  free(array);
+  free(cpus);
+  free(nodes);
+  FreePinConfig(&pin);
+  if (numa) NumaFreeArray(array, array_bytes);
+  else ArenaDestroy(&arena);
+  BlockFileClose(&blocks);
   return 0;
 }
@@ -0,0 +1,299 @@
+#define _GNU_SOURCE
+#include "process_pool.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "find_min_max.h"
+#include "utils.h"
+
+struct PoolWorker {
+  pid_t pid;  // 0 - процесса нет
+  int fd;     // -1 - канал закрыт (рабочий умер, но ещё не забран)
+  int busy;
+  struct PoolJob job;
+};
+
+struct ProcessPool {
+  struct PoolWorker *workers;
+  int count;
+  // очередь задач; задача упавшего рабочего возвращается в начало
+  struct PoolJob *queue;
+  size_t head;
+  size_t tail;
+  size_t pending;  // ещё не отвеченные задачи
+  PoolResultFn on_result;
+  void *user;
+  struct ProcessPoolStats stats;
+  struct sigaction old_sigchld;
+};
+
+static int sigchld_pipe[2] = {-1, -1};
+
+static void OnSigchld(int sig) {
+  (void)sig;
+  int saved = errno;
+  char byte = 0;
+  if (write(sigchld_pipe[1], &byte, 1) < 0) {
+    /* канал полон - супервизор и так проснётся */
+  }
+  errno = saved;
+}
+
+static void WorkerMain(int fd) {
+  int *array = NULL;
+  uint32_t seed = 0;
+  uint32_t size = 0;
+  struct PoolJob job;
+  for (;;) {
+    ssize_t n = recv(fd, &job, sizeof(job), 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n != (ssize_t)sizeof(job)) break;  // EOF - супервизор закрыл канал
+
+    if (job.attempts <= job.crash) {
+      // имитация падения без core-файла
+      struct rlimit no_core = {0, 0};
+      setrlimit(RLIMIT_CORE, &no_core);
+      raise(SIGSEGV);
+    }
+    // массив переиспользуется, пока задачи идут по тому же seed/size
+    if (array == NULL || seed != job.seed || size != job.size) {
+      int *grown = realloc(array, (job.size ? job.size : 1) * sizeof(int));
+      if (grown == NULL) break;
+      array = grown;
+      seed = job.seed;
+      size = job.size;
+      GenerateArray(array, size, seed);
+    }
+    uint32_t end = job.end < size ? job.end : size;
+    uint32_t begin = job.begin < end ? job.begin : end;
+    struct MinMax min_max = GetMinMax(array, begin, end);
+    struct PoolReply reply = {job.id, min_max.min, min_max.max, 1};
+    if (send(fd, &reply, sizeof(reply), MSG_NOSIGNAL) != (ssize_t)sizeof(reply))
+      break;
+  }
+  free(array);
+  _exit(0);
+}
+
+static int Spawn(struct ProcessPool *pool, int index) {
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0) {
+    perror("socketpair");
+    return -1;
+  }
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    close(sv[0]);
+    close(sv[1]);
+    return -1;
+  }
+  if (pid == 0) {
+    // у ребёнка не должно остаться чужих каналов, иначе соседи
+    // не увидят EOF при остановке пула
+    close(sv[0]);
+    for (int i = 0; i < pool->count; i++)
+      if (pool->workers[i].fd >= 0) close(pool->workers[i].fd);
+    close(sigchld_pipe[0]);
+    close(sigchld_pipe[1]);
+    signal(SIGCHLD, SIG_DFL);
+    WorkerMain(sv[1]);
+  }
+  close(sv[1]);
+  pool->workers[index].pid = pid;
+  pool->workers[index].fd = sv[0];
+  pool->workers[index].busy = 0;
+  return 0;
+}
+
+static void Finish(struct ProcessPool *pool, const struct PoolJob *job,
+                   const struct PoolReply *reply) {
+  if (reply->ok)
+    pool->stats.completed++;
+  else
+    pool->stats.failed++;
+  pool->pending--;
+  if (pool->on_result != NULL) pool->on_result(job, reply, pool->user);
+}
+
+// Забирает завершившихся рабочих; задачи упавших - обратно в очередь.
+// waitpid только по своим pid: другие дети процесса-хозяина пулу не
+// принадлежат, их статус должен достаться хозяину.
+static void Reap(struct ProcessPool *pool) {
+  for (int index = 0; index < pool->count; index++) {
+    struct PoolWorker *w = &pool->workers[index];
+    if (w->pid <= 0) continue;
+    int status;
+    pid_t pid = waitpid(w->pid, &status, WNOHANG);
+    if (pid <= 0) continue;  // жив (или EINTR - заберём на следующем круге)
+
+    pool->stats.crashes++;
+    if (w->fd >= 0) close(w->fd);
+    w->fd = -1;
+    w->pid = 0;
+    if (w->busy) {
+      w->busy = 0;
+      if (w->job.attempts >= POOL_MAX_ATTEMPTS) {
+        struct PoolReply reply = {w->job.id, 0, 0, 0};
+        Finish(pool, &w->job, &reply);
+      } else {
+        pool->queue[--pool->head] = w->job;
+        pool->stats.retries++;
+      }
+    }
+    if (Spawn(pool, index) == 0) pool->stats.respawns++;
+  }
+}
+
+struct ProcessPool *ProcessPoolCreate(int workers) {
+  if (workers <= 0 || sigchld_pipe[0] >= 0) return NULL;
+  struct ProcessPool *pool = calloc(1, sizeof(*pool));
+  if (pool == NULL) return NULL;
+  pool->workers = calloc((size_t)workers, sizeof(*pool->workers));
+  if (pool->workers == NULL ||
+      pipe2(sigchld_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+    free(pool->workers);
+    free(pool);
+    return NULL;
+  }
+  pool->count = workers;
+  for (int i = 0; i < workers; i++) pool->workers[i].fd = -1;
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = OnSigchld;
+  sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGCHLD, &sa, &pool->old_sigchld);
+
+  int started = 0;
+  for (int i = 0; i < workers; i++)
+    if (Spawn(pool, i) == 0) started++;
+  if (started == 0) {
+    ProcessPoolDestroy(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+int ProcessPoolRun(struct ProcessPool *pool, const struct PoolJob *jobs,
+                   size_t count, PoolResultFn on_result, void *user) {
+  pool->queue = malloc((count ? count : 1) * sizeof(*pool->queue));
+  struct pollfd *fds = malloc((pool->count + 1) * sizeof(*fds));
+  int *owner = malloc((pool->count + 1) * sizeof(*owner));
+  if (pool->queue == NULL || fds == NULL || owner == NULL) {
+    free(pool->queue);
+    free(fds);
+    free(owner);
+    pool->queue = NULL;
+    return -1;
+  }
+  memcpy(pool->queue, jobs, count * sizeof(*jobs));
+  for (size_t i = 0; i < count; i++) pool->queue[i].attempts = 0;
+  pool->head = 0;
+  pool->tail = count;
+  pool->pending = count;
+  pool->on_result = on_result;
+  pool->user = user;
+
+  int rc = 0;
+  while (pool->pending > 0) {
+    // раздаём задачи свободным живым рабочим
+    for (int i = 0; i < pool->count && pool->head < pool->tail; i++) {
+      struct PoolWorker *w = &pool->workers[i];
+      if (w->busy || w->fd < 0) continue;
+      w->job = pool->queue[pool->head++];
+      w->job.attempts++;
+      if (send(w->fd, &w->job, sizeof(w->job), MSG_NOSIGNAL) !=
+          (ssize_t)sizeof(w->job)) {
+        // рабочий уже умер: задача ждёт в очереди, его заберёт Reap
+        w->job.attempts--;
+        pool->queue[--pool->head] = w->job;
+        close(w->fd);
+        w->fd = -1;
+        continue;
+      }
+      w->busy = 1;
+    }
+
+    int nfds = 0;
+    fds[nfds].fd = sigchld_pipe[0];
+    fds[nfds].events = POLLIN;
+    owner[nfds++] = -1;
+    for (int i = 0; i < pool->count; i++) {
+      if (!pool->workers[i].busy || pool->workers[i].fd < 0) continue;
+      fds[nfds].fd = pool->workers[i].fd;
+      fds[nfds].events = POLLIN;
+      owner[nfds++] = i;
+    }
+    if (poll(fds, (nfds_t)nfds, -1) < 0) {
+      if (errno == EINTR) continue;
+      perror("poll");
+      rc = -1;
+      break;
+    }
+
+    for (int k = 1; k < nfds; k++) {
+      if (fds[k].revents == 0) continue;
+      struct PoolWorker *w = &pool->workers[owner[k]];
+      struct PoolReply reply;
+      ssize_t n = recv(w->fd, &reply, sizeof(reply), MSG_DONTWAIT);
+      if (n == (ssize_t)sizeof(reply)) {
+        w->busy = 0;
+        Finish(pool, &w->job, &reply);
+      } else if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        // канал закрыт - процесс умер; задачу вернёт Reap
+        close(w->fd);
+        w->fd = -1;
+      }
+    }
+    if (fds[0].revents != 0) {
+      char drain[64];
+      while (read(sigchld_pipe[0], drain, sizeof(drain)) > 0) {
+      }
+    }
+    // waitpid(WNOHANG) по рабочим дёшев - вызываем каждый круг, чтобы не
+    // зависеть от того, что пришло раньше: EOF на канале или SIGCHLD
+    Reap(pool);
+  }
+
+  free(fds);
+  free(owner);
+  free(pool->queue);
+  pool->queue = NULL;
+  return rc;
+}
+
+const struct ProcessPoolStats *ProcessPoolGetStats(const struct ProcessPool *pool) {
+  return &pool->stats;
+}
+
+void ProcessPoolDestroy(struct ProcessPool *pool) {
+  if (pool == NULL) return;
+  for (int i = 0; i < pool->count; i++) {
+    if (pool->workers[i].fd >= 0) close(pool->workers[i].fd);
+    pool->workers[i].fd = -1;
+  }
+  for (int i = 0; i < pool->count; i++) {
+    if (pool->workers[i].pid <= 0) continue;
+    while (waitpid(pool->workers[i].pid, NULL, 0) < 0 && errno == EINTR) {
+    }
+    pool->workers[i].pid = 0;
+  }
+  sigaction(SIGCHLD, &pool->old_sigchld, NULL);
+  close(sigchld_pipe[0]);
+  close(sigchld_pipe[1]);
+  sigchld_pipe[0] = sigchld_pipe[1] = -1;
+  free(pool->workers);
+  free(pool);
+}
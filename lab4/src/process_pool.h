@@ -0,0 +1,67 @@
+#ifndef PROCESS_POOL_H
+#define PROCESS_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Пул заранее порождённых (pre-fork) рабочих процессов для задач min/max.
+// Супервизор раздаёт задачи (seed, size, [begin, end)) по socketpair
+// SOCK_SEQPACKET - одна задача и один ответ на сообщение. Рабочий живёт
+// долго и хранит последний сгенерированный массив, так что задачи по
+// разным отрезкам одного массива не генерируют его заново.
+//
+// Падения ловятся по SIGCHLD (self-pipe) и waitpid(pid, WNOHANG) по pid
+// рабочих: завершившийся рабочий забирается сразу, зомби не остаются,
+// а чужие дети процесса остаются его хозяину. Задача
+// упавшего рабочего возвращается в начало очереди, на его место
+// порождается новый процесс. После POOL_MAX_ATTEMPTS попыток задача
+// считается проваленной.
+
+#define POOL_MAX_ATTEMPTS 3
+
+struct PoolJob {
+  uint64_t id;
+  uint32_t seed;
+  uint32_t size;
+  uint32_t begin;
+  uint32_t end;
+  int32_t crash;     // проверка восстановления: падать на первых crash попытках
+  int32_t attempts;  // заполняет пул
+};
+
+struct PoolReply {
+  uint64_t id;
+  int32_t min;
+  int32_t max;
+  int32_t ok;  // 0 - задача провалена после POOL_MAX_ATTEMPTS падений
+};
+
+struct ProcessPoolStats {
+  size_t completed;
+  size_t failed;
+  size_t crashes;
+  size_t respawns;
+  size_t retries;
+};
+
+typedef void (*PoolResultFn)(const struct PoolJob *job,
+                             const struct PoolReply *reply, void *user);
+
+struct ProcessPool;
+
+// Порождает workers процессов. NULL - не удалось ни одного.
+// Одновременно может существовать только один пул (общий SIGCHLD).
+struct ProcessPool *ProcessPoolCreate(int workers);
+
+// Выполняет все задачи; on_result вызывается по мере готовности.
+// 0 - все задачи обработаны (в том числе проваленные), -1 - ошибка пула.
+int ProcessPoolRun(struct ProcessPool *pool, const struct PoolJob *jobs,
+                   size_t count, PoolResultFn on_result, void *user);
+
+const struct ProcessPoolStats *ProcessPoolGetStats(const struct ProcessPool *pool);
+
+// Закрывает каналы (рабочие выходят по EOF) и забирает всех детей.
+void ProcessPoolDestroy(struct ProcessPool *pool);
+
+#endif
@@ -0,0 +1,152 @@
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "find_min_max.h"
+#include "range_tree.h"
+#include "sum_lib.h"
+#include "utils.h"
+
+// Смесь запросов min/max/sum по случайным подотрезкам и пакетов точечных
+// обновлений: дерево отрезков против полного прохода на каждый запрос.
+
+struct Op {
+  int is_update;
+  size_t begin;
+  size_t end;
+};
+
+static double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void PrintUsage(const char *prog_name) {
+  printf("Usage: %s --array_size \"num\" --seed \"num\" [--threads_num \"num\"] "
+         "[--ops \"num\"] [--update_percent \"num\"] [--batch \"num\"]\n",
+         prog_name);
+}
+
+int main(int argc, char **argv) {
+  size_t array_size = 0;
+  unsigned int seed = 0;
+  int threads_num = 1;
+  size_t ops_count = 10000;
+  int update_percent = 20;
+  size_t batch = 64;
+
+  static struct option options[] = {{"array_size", required_argument, 0, 0},
+                                    {"seed", required_argument, 0, 0},
+                                    {"threads_num", required_argument, 0, 0},
+                                    {"ops", required_argument, 0, 0},
+                                    {"update_percent", required_argument, 0, 0},
+                                    {"batch", required_argument, 0, 0},
+                                    {0, 0, 0, 0}};
+  int option_index = 0;
+  while (1) {
+    int c = getopt_long(argc, argv, "", options, &option_index);
+    if (c == -1) break;
+    if (c != 0) {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+    switch (option_index) {
+      case 0: array_size = strtoull(optarg, NULL, 10); break;
+      case 1: seed = (unsigned int)atoi(optarg); break;
+      case 2: threads_num = atoi(optarg); break;
+      case 3: ops_count = strtoull(optarg, NULL, 10); break;
+      case 4: update_percent = atoi(optarg); break;
+      case 5: batch = strtoull(optarg, NULL, 10); break;
+    }
+  }
+  if (array_size == 0 || seed == 0 || threads_num <= 0 || batch == 0 ||
+      update_percent < 0 || update_percent > 100 || optind < argc) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  int *array = malloc(sizeof(int) * array_size);
+  int *plain = malloc(sizeof(int) * array_size);
+  struct Op *ops = malloc(sizeof(struct Op) * ops_count);
+  size_t *upd_index = malloc(sizeof(size_t) * batch * ops_count);
+  int *upd_value = malloc(sizeof(int) * batch * ops_count);
+  if (array == NULL || plain == NULL || ops == NULL || upd_index == NULL ||
+      upd_value == NULL) {
+    perror("malloc");
+    return 1;
+  }
+  GenerateArray(array, array_size, seed);
+  memcpy(plain, array, sizeof(int) * array_size);
+
+  // Операции генерируются заранее, чтобы обе стороны делали одно и то же.
+  unsigned int state = seed;
+  for (size_t i = 0; i < ops_count; i++) {
+    ops[i].is_update = (int)(rand_r(&state) % 100) < update_percent;
+    size_t a = (size_t)rand_r(&state) % array_size;
+    size_t b = (size_t)rand_r(&state) % array_size;
+    ops[i].begin = a < b ? a : b;
+    ops[i].end = (a < b ? b : a) + 1;
+    for (size_t k = 0; k < batch; k++) {
+      upd_index[i * batch + k] = (size_t)rand_r(&state) % array_size;
+      upd_value[i * batch + k] = rand_r(&state);
+    }
+  }
+
+  struct RangeTree tree;
+  double start = Now();
+  if (RangeTreeBuild(&tree, array, array_size, threads_num) != 0) {
+    perror("RangeTreeBuild");
+    return 1;
+  }
+  double build_time = Now() - start;
+
+  long long tree_check = 0;
+  start = Now();
+  for (size_t i = 0; i < ops_count; i++) {
+    if (ops[i].is_update) {
+      RangeTreeUpdate(&tree, upd_index + i * batch, upd_value + i * batch,
+                      batch);
+    } else {
+      struct MinMax mm = RangeTreeMinMax(&tree, ops[i].begin, ops[i].end);
+      tree_check += mm.min ^ mm.max;
+      tree_check += RangeTreeSum(&tree, ops[i].begin, ops[i].end);
+    }
+  }
+  double tree_time = Now() - start;
+
+  long long scan_check = 0;
+  start = Now();
+  for (size_t i = 0; i < ops_count; i++) {
+    if (ops[i].is_update) {
+      for (size_t k = 0; k < batch; k++)
+        plain[upd_index[i * batch + k]] = upd_value[i * batch + k];
+    } else {
+      struct MinMax mm = GetMinMax(plain, ops[i].begin, ops[i].end);
+      scan_check += mm.min ^ mm.max;
+      scan_check += SumRange(plain, ops[i].begin, ops[i].end);
+    }
+  }
+  double scan_time = Now() - start;
+
+  printf("Array: %zu, ops: %zu (%d%% updates, batch %zu)\n", array_size,
+         ops_count, update_percent, batch);
+  printf("Tree build (%d threads): %f seconds\n", threads_num, build_time);
+  printf("Tree:   %f seconds\n", tree_time);
+  printf("Rescan: %f seconds\n", scan_time);
+  if (tree_time > 0) printf("Speedup: %.1fx\n", scan_time / tree_time);
+
+  int ok = tree_check == scan_check;
+  if (!ok) printf("MISMATCH: tree %lld, rescan %lld\n", tree_check, scan_check);
+
+  RangeTreeFree(&tree);
+  free(array);
+  free(plain);
+  free(ops);
+  free(upd_index);
+  free(upd_value);
+  return ok ? 0 : 1;
+}
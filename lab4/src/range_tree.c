@@ -0,0 +1,209 @@
+#include "range_tree.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 4 x int32 - SSE2 на x86-64, NEON на ARM; GCC сам выбирает инструкции.
+typedef int v4si __attribute__((vector_size(16)));
+
+static const struct RangeNode kEmpty = {INT_MAX, INT_MIN, 0};
+
+static void Combine(struct RangeNode *acc, const struct RangeNode *node) {
+  if (node->min < acc->min) acc->min = node->min;
+  if (node->max > acc->max) acc->max = node->max;
+  acc->sum += node->sum;
+}
+
+// Сводка по array[begin, end): min/max по 4 элемента за раз, сумма в
+// четырёх независимых 64-битных аккумуляторах.
+static void ScanRange(const int *array, size_t begin, size_t end,
+                      struct RangeNode *acc) {
+  size_t i = begin;
+  if (end - begin >= 4) {
+    v4si vmin, vmax, v;
+    memcpy(&vmin, array + i, sizeof(v));
+    vmax = vmin;
+    long long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (; i + 4 <= end; i += 4) {
+      memcpy(&v, array + i, sizeof(v));
+      v4si lt = v < vmin;
+      v4si gt = v > vmax;
+      vmin = (v & lt) | (vmin & ~lt);
+      vmax = (v & gt) | (vmax & ~gt);
+      s0 += v[0];
+      s1 += v[1];
+      s2 += v[2];
+      s3 += v[3];
+    }
+    for (int k = 0; k < 4; k++) {
+      if (vmin[k] < acc->min) acc->min = vmin[k];
+      if (vmax[k] > acc->max) acc->max = vmax[k];
+    }
+    acc->sum += s0 + s1 + s2 + s3;
+  }
+  for (; i < end; i++) {
+    if (array[i] < acc->min) acc->min = array[i];
+    if (array[i] > acc->max) acc->max = array[i];
+    acc->sum += array[i];
+  }
+}
+
+static void BuildLeaf(struct RangeTree *tree, size_t block) {
+  struct RangeNode *leaf = &tree->nodes[tree->leaves + block];
+  *leaf = kEmpty;
+  size_t begin = block * RANGE_TREE_LEAF;
+  size_t end = begin + RANGE_TREE_LEAF;
+  if (end > tree->size) end = tree->size;
+  ScanRange(tree->array, begin, end, leaf);
+}
+
+static void PullUp(struct RangeTree *tree, size_t node) {
+  tree->nodes[node] = tree->nodes[2 * node];
+  Combine(&tree->nodes[node], &tree->nodes[2 * node + 1]);
+}
+
+struct LeafArgs {
+  struct RangeTree *tree;
+  size_t begin;
+  size_t end;
+};
+
+static void *BuildLeaves(void *arg) {
+  struct LeafArgs *a = arg;
+  for (size_t b = a->begin; b < a->end; b++) BuildLeaf(a->tree, b);
+  return NULL;
+}
+
+int RangeTreeBuild(struct RangeTree *tree, int *array, size_t size,
+                   int threads) {
+  memset(tree, 0, sizeof(*tree));
+  tree->array = array;
+  tree->size = size;
+  tree->blocks = (size + RANGE_TREE_LEAF - 1) / RANGE_TREE_LEAF;
+  tree->leaves = 1;
+  while (tree->leaves < tree->blocks) tree->leaves <<= 1;
+  tree->nodes = malloc(2 * tree->leaves * sizeof(struct RangeNode));
+  if (tree->nodes == NULL) return -1;
+
+  // Листья - это весь проход по данным, их и делим между потоками.
+  // Внутренних узлов в RANGE_TREE_LEAF раз меньше, чем элементов.
+  if (threads < 1) threads = 1;
+  if ((size_t)threads > tree->blocks) threads = tree->blocks ? tree->blocks : 1;
+  pthread_t *tids = malloc(sizeof(pthread_t) * threads);
+  struct LeafArgs *args = malloc(sizeof(struct LeafArgs) * threads);
+  if (tids == NULL || args == NULL) {
+    free(tids);
+    free(args);
+    RangeTreeFree(tree);
+    return -1;
+  }
+  size_t per = tree->blocks / threads;
+  size_t rem = tree->blocks % threads;
+  size_t block = 0;
+  int started = 0;
+  for (int i = 0; i < threads; i++) {
+    args[i].tree = tree;
+    args[i].begin = block;
+    block += per + ((size_t)i < rem ? 1 : 0);
+    args[i].end = block;
+    if (pthread_create(&tids[started], NULL, BuildLeaves, &args[i]) != 0)
+      BuildLeaves(&args[i]);
+    else
+      started++;
+  }
+  for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+  free(tids);
+  free(args);
+
+  for (size_t b = tree->blocks; b < tree->leaves; b++)
+    tree->nodes[tree->leaves + b] = kEmpty;
+  for (size_t node = tree->leaves - 1; node >= 1; node--) PullUp(tree, node);
+  return 0;
+}
+
+void RangeTreeFree(struct RangeTree *tree) {
+  free(tree->nodes);
+  memset(tree, 0, sizeof(*tree));
+}
+
+static struct RangeNode Query(const struct RangeTree *tree, size_t begin,
+                              size_t end) {
+  struct RangeNode acc = kEmpty;
+  if (end > tree->size) end = tree->size;
+  if (begin >= end) return acc;
+
+  size_t first = (begin + RANGE_TREE_LEAF - 1) / RANGE_TREE_LEAF;
+  size_t last = end / RANGE_TREE_LEAF;
+  if (first >= last) {
+    // не больше двух неполных блоков - дешевле пройти напрямую
+    ScanRange(tree->array, begin, end, &acc);
+    return acc;
+  }
+  ScanRange(tree->array, begin, first * RANGE_TREE_LEAF, &acc);
+  ScanRange(tree->array, last * RANGE_TREE_LEAF, end, &acc);
+
+  for (size_t l = first + tree->leaves, r = last + tree->leaves; l < r;
+       l >>= 1, r >>= 1) {
+    if (l & 1) Combine(&acc, &tree->nodes[l++]);
+    if (r & 1) Combine(&acc, &tree->nodes[--r]);
+  }
+  return acc;
+}
+
+struct MinMax RangeTreeMinMax(const struct RangeTree *tree, size_t begin,
+                              size_t end) {
+  struct RangeNode node = Query(tree, begin, end);
+  struct MinMax result = {node.min, node.max};
+  // как GetMinMax: на пустом отрезке 0, 0
+  if (node.min > node.max) result.min = result.max = 0;
+  return result;
+}
+
+long long RangeTreeSum(const struct RangeTree *tree, size_t begin,
+                       size_t end) {
+  return Query(tree, begin, end).sum;
+}
+
+static int CompareSize(const void *a, const void *b) {
+  size_t x = *(const size_t *)a;
+  size_t y = *(const size_t *)b;
+  return (x > y) - (x < y);
+}
+
+int RangeTreeUpdate(struct RangeTree *tree, const size_t *index,
+                    const int *value, size_t count) {
+  for (size_t i = 0; i < count; i++)
+    if (index[i] >= tree->size) return -1;
+  if (count == 0) return 0;
+
+  size_t *dirty = malloc(sizeof(size_t) * count);
+  if (dirty == NULL) return -1;
+  for (size_t i = 0; i < count; i++) {
+    tree->array[index[i]] = value[i];
+    dirty[i] = index[i] / RANGE_TREE_LEAF;
+  }
+
+  // Отсортированный список без повторов: каждый блок пересчитывается
+  // один раз, а родители соседних блоков совпадают и тоже схлопываются.
+  qsort(dirty, count, sizeof(size_t), CompareSize);
+  size_t n = 0;
+  for (size_t i = 0; i < count; i++)
+    if (n == 0 || dirty[n - 1] != dirty[i]) dirty[n++] = dirty[i];
+  for (size_t i = 0; i < n; i++) {
+    BuildLeaf(tree, dirty[i]);
+    dirty[i] += tree->leaves;
+  }
+  while (dirty[0] > 1) {
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+      size_t parent = dirty[i] >> 1;
+      if (m == 0 || dirty[m - 1] != parent) dirty[m++] = parent;
+    }
+    n = m;
+    for (size_t i = 0; i < n; i++) PullUp(tree, dirty[i]);
+  }
+  free(dirty);
+  return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef RANGE_TREE_H
+#define RANGE_TREE_H
+
+#include <stddef.h>
+
+#include "utils.h"
+
+// Дерево отрезков над изменяемым массивом для многих запросов
+// min/max/sum по подотрезкам и точечных обновлений.
+//
+// Массив режется на листовые блоки по RANGE_TREE_LEAF элементов; сами
+// элементы не копируются, дерево хранит только сводки блоков. Узлы лежат
+// в порядке Эйтцингера (корень 1, дети 2i и 2i+1), поэтому верхние
+// уровни компактны и остаются в кэше. Неполные блоки на краях запроса
+// досчитываются векторным проходом по самому массиву.
+
+#define RANGE_TREE_LEAF 64
+
+struct RangeNode {
+  int min;
+  int max;
+  long long sum;
+};
+
+struct RangeTree {
+  int *array;
+  size_t size;
+  size_t blocks;  // число листовых блоков
+  size_t leaves;  // blocks, округлённое вверх до степени двойки
+  struct RangeNode *nodes;  // 2 * leaves узлов, nodes[0] не используется
+};
+
+// Строит дерево; сводки листовых блоков считаются в threads потоков.
+int RangeTreeBuild(struct RangeTree *tree, int *array, size_t size,
+                   int threads);
+void RangeTreeFree(struct RangeTree *tree);
+
+// Аналоги GetMinMax и SumRange для [begin, end) за O(log n).
+struct MinMax RangeTreeMinMax(const struct RangeTree *tree, size_t begin,
+                              size_t end);
+long long RangeTreeSum(const struct RangeTree *tree, size_t begin, size_t end);
+
+// Пакет точечных обновлений array[index[i]] = value[i]. Каждый затронутый
+// блок и каждый узел над ним пересчитывается один раз на весь пакет.
+int RangeTreeUpdate(struct RangeTree *tree, const size_t *index,
+                    const int *value, size_t count);
+
+#endif
@@ -0,0 +1,234 @@
+#include "rmq.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Запускает fn над args[0..threads) в отдельных потоках; если поток
+// создать не удалось, его часть выполняется в вызывающем потоке.
+static void RunParallel(void *(*fn)(void *), void *args, size_t arg_size,
+                        int threads) {
+  pthread_t *tids = malloc(sizeof(pthread_t) * threads);
+  int started = 0;
+  for (int i = 0; i < threads; i++) {
+    void *arg = (char *)args + i * arg_size;
+    if (tids != NULL && pthread_create(&tids[started], NULL, fn, arg) == 0)
+      started++;
+    else
+      fn(arg);
+  }
+  for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+  free(tids);
+}
+
+static void Split(size_t total, int parts, int i, size_t *begin, size_t *end) {
+  size_t per = total / parts;
+  size_t rem = total % parts;
+  *begin = i * per + ((size_t)i < rem ? (size_t)i : rem);
+  *end = *begin + per + ((size_t)i < rem ? 1 : 0);
+}
+
+static int Log2(size_t x) { return 63 - __builtin_clzll((unsigned long long)x); }
+
+struct BuildArgs {
+  struct RmqIndex *rmq;
+  size_t begin;  // диапазон блоков
+  size_t end;
+  int level;
+};
+
+// Маски монотонных стеков и нулевой уровень таблицы для своих блоков.
+static void *BuildBlocks(void *arg) {
+  struct BuildArgs *a = arg;
+  struct RmqIndex *rmq = a->rmq;
+  const int *v = rmq->array;
+  for (size_t b = a->begin; b < a->end; b++) {
+    size_t start = b * RMQ_BLOCK;
+    size_t len = rmq->size - start < RMQ_BLOCK ? rmq->size - start : RMQ_BLOCK;
+    uint32_t min_stack = 0, max_stack = 0;
+    int mn = v[start], mx = v[start];
+    for (size_t i = 0; i < len; i++) {
+      int x = v[start + i];
+      while (min_stack && v[start + 31 - __builtin_clz(min_stack)] > x)
+        min_stack &= ~(1u << (31 - __builtin_clz(min_stack)));
+      while (max_stack && v[start + 31 - __builtin_clz(max_stack)] < x)
+        max_stack &= ~(1u << (31 - __builtin_clz(max_stack)));
+      min_stack |= 1u << i;
+      max_stack |= 1u << i;
+      rmq->min_mask[start + i] = min_stack;
+      rmq->max_mask[start + i] = max_stack;
+      if (x < mn) mn = x;
+      if (x > mx) mx = x;
+    }
+    rmq->min_table[b] = mn;
+    rmq->max_table[b] = mx;
+  }
+  return NULL;
+}
+
+static void *BuildLevel(void *arg) {
+  struct BuildArgs *a = arg;
+  struct RmqIndex *rmq = a->rmq;
+  size_t half = (size_t)1 << (a->level - 1);
+  const int *prev_min = rmq->min_table + (a->level - 1) * rmq->blocks;
+  const int *prev_max = rmq->max_table + (a->level - 1) * rmq->blocks;
+  int *cur_min = rmq->min_table + a->level * rmq->blocks;
+  int *cur_max = rmq->max_table + a->level * rmq->blocks;
+  size_t last = rmq->blocks - 2 * half + 1;  // b + 2^level <= blocks
+  size_t end = a->end < last ? a->end : last;
+  for (size_t b = a->begin; b < end; b++) {
+    int l = prev_min[b], r = prev_min[b + half];
+    cur_min[b] = l < r ? l : r;
+    l = prev_max[b];
+    r = prev_max[b + half];
+    cur_max[b] = l > r ? l : r;
+  }
+  return NULL;
+}
+
+int RmqBuild(struct RmqIndex *rmq, const int *array, size_t size, int threads) {
+  memset(rmq, 0, sizeof(*rmq));
+  rmq->array = array;
+  rmq->size = size;
+  if (size == 0) return 0;
+  rmq->blocks = (size + RMQ_BLOCK - 1) / RMQ_BLOCK;
+  rmq->levels = Log2(rmq->blocks) + 1;
+  rmq->min_mask = malloc(sizeof(uint32_t) * size);
+  rmq->max_mask = malloc(sizeof(uint32_t) * size);
+  rmq->min_table = malloc(sizeof(int) * rmq->blocks * rmq->levels);
+  rmq->max_table = malloc(sizeof(int) * rmq->blocks * rmq->levels);
+  if (threads < 1) threads = 1;
+  if ((size_t)threads > rmq->blocks) threads = (int)rmq->blocks;
+  struct BuildArgs *args = malloc(sizeof(struct BuildArgs) * threads);
+  if (rmq->min_mask == NULL || rmq->max_mask == NULL ||
+      rmq->min_table == NULL || rmq->max_table == NULL || args == NULL) {
+    free(args);
+    RmqFree(rmq);
+    return -1;
+  }
+
+  for (int i = 0; i < threads; i++) {
+    args[i].rmq = rmq;
+    Split(rmq->blocks, threads, i, &args[i].begin, &args[i].end);
+  }
+  RunParallel(BuildBlocks, args, sizeof(*args), threads);
+  // Уровень k зависит только от k - 1: между уровнями - join.
+  for (int level = 1; level < rmq->levels; level++) {
+    for (int i = 0; i < threads; i++) args[i].level = level;
+    RunParallel(BuildLevel, args, sizeof(*args), threads);
+  }
+  free(args);
+  return 0;
+}
+
+void RmqFree(struct RmqIndex *rmq) {
+  free(rmq->min_mask);
+  free(rmq->max_mask);
+  free(rmq->min_table);
+  free(rmq->max_table);
+  memset(rmq, 0, sizeof(*rmq));
+}
+
+// min/max на [start + lo, start + hi] внутри одного блока.
+static void InBlock(const struct RmqIndex *rmq, size_t start, unsigned lo,
+                    unsigned hi, struct MinMax *acc) {
+  uint32_t keep = ~0u << lo;
+  int mn = rmq->array[start + __builtin_ctz(rmq->min_mask[start + hi] & keep)];
+  int mx = rmq->array[start + __builtin_ctz(rmq->max_mask[start + hi] & keep)];
+  if (mn < acc->min) acc->min = mn;
+  if (mx > acc->max) acc->max = mx;
+}
+
+struct MinMax RmqQuery(const struct RmqIndex *rmq, size_t begin, size_t end) {
+  if (end > rmq->size) end = rmq->size;
+  if (begin >= end) return (struct MinMax){0, 0};
+
+  size_t last = end - 1;
+  size_t bl = begin / RMQ_BLOCK;
+  size_t br = last / RMQ_BLOCK;
+  struct MinMax acc = {rmq->array[begin], rmq->array[begin]};
+  if (bl == br) {
+    InBlock(rmq, bl * RMQ_BLOCK, begin % RMQ_BLOCK, last % RMQ_BLOCK, &acc);
+    return acc;
+  }
+  InBlock(rmq, bl * RMQ_BLOCK, begin % RMQ_BLOCK, RMQ_BLOCK - 1, &acc);
+  InBlock(rmq, br * RMQ_BLOCK, 0, last % RMQ_BLOCK, &acc);
+  if (br - bl > 1) {
+    // два перекрывающихся отрезка длины 2^k покрывают блоки (bl, br)
+    int k = Log2(br - bl - 1);
+    const int *mins = rmq->min_table + k * rmq->blocks;
+    const int *maxs = rmq->max_table + k * rmq->blocks;
+    size_t right = br - ((size_t)1 << k);
+    int mn = mins[bl + 1] < mins[right] ? mins[bl + 1] : mins[right];
+    int mx = maxs[bl + 1] > maxs[right] ? maxs[bl + 1] : maxs[right];
+    if (mn < acc.min) acc.min = mn;
+    if (mx > acc.max) acc.max = mx;
+  }
+  return acc;
+}
+
+// Запросы раскладываются по RMQ_BUCKETS областям массива подсчётом
+// (один проход, без сравнений); внутри области порядок исходный.
+#define RMQ_BUCKETS 4096
+
+struct BatchArgs {
+  const struct RmqIndex *rmq;
+  const struct RmqRange *ranges;
+  const size_t *order;  // номера запросов, сгруппированные по началу
+  struct MinMax *out;
+  size_t begin;
+  size_t end;
+};
+
+static void *AnswerBatch(void *arg) {
+  struct BatchArgs *a = arg;
+  for (size_t i = a->begin; i < a->end; i++) {
+    const struct RmqRange *q = &a->ranges[a->order[i]];
+    a->out[a->order[i]] = RmqQuery(a->rmq, q->begin, q->end);
+  }
+  return NULL;
+}
+
+int RmqQueryBatch(const struct RmqIndex *rmq, const struct RmqRange *ranges,
+                  size_t count, struct MinMax *out, int threads) {
+  if (count == 0) return 0;
+  if (threads < 1) threads = 1;
+  if ((size_t)threads > count) threads = (int)count;
+  size_t *order = malloc(sizeof(size_t) * count);
+  size_t *bucket_start = calloc(RMQ_BUCKETS + 1, sizeof(size_t));
+  struct BatchArgs *args = malloc(sizeof(struct BatchArgs) * threads);
+  if (order == NULL || bucket_start == NULL || args == NULL) {
+    free(order);
+    free(bucket_start);
+    free(args);
+    return -1;
+  }
+  size_t span = rmq->size / RMQ_BUCKETS + 1;
+  for (size_t i = 0; i < count; i++) {
+    size_t bucket = ranges[i].begin / span;
+    if (bucket >= RMQ_BUCKETS) bucket = RMQ_BUCKETS - 1;
+    bucket_start[bucket + 1]++;
+  }
+  for (size_t b = 0; b < RMQ_BUCKETS; b++)
+    bucket_start[b + 1] += bucket_start[b];
+  for (size_t i = 0; i < count; i++) {
+    size_t bucket = ranges[i].begin / span;
+    if (bucket >= RMQ_BUCKETS) bucket = RMQ_BUCKETS - 1;
+    order[bucket_start[bucket]++] = i;
+  }
+  free(bucket_start);
+
+  // Каждому потоку - непрерывный кусок сгруппированных запросов,
+  // то есть своя область массива и масок.
+  for (int i = 0; i < threads; i++) {
+    args[i].rmq = rmq;
+    args[i].ranges = ranges;
+    args[i].order = order;
+    args[i].out = out;
+    Split(count, threads, i, &args[i].begin, &args[i].end);
+  }
+  RunParallel(AnswerBatch, args, sizeof(*args), threads);
+  free(order);
+  free(args);
+  return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef RMQ_H
+#define RMQ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utils.h"
+
+// Статический индекс для запросов min/max по подотрезкам за O(1).
+//
+// Массив делится на блоки по RMQ_BLOCK элементов. Над минимумами и
+// максимумами блоков строится разреженная таблица (sparse table), а
+// внутри блока для каждой позиции i хранится 32-битная маска монотонного
+// стека: бит j установлен, если array[j] - минимум (максимум) на [j, i].
+// Тогда минимум на [l, r] внутри блока - это младший установленный бит
+// маски r после отсечения битов левее l. Доп. память - около 2 масок и
+// 2 * log(n / 32) / 32 int'ов на элемент.
+
+#define RMQ_BLOCK 32
+
+struct RmqIndex {
+  const int *array;
+  size_t size;
+  size_t blocks;
+  int levels;
+  uint32_t *min_mask;  // по маске на элемент
+  uint32_t *max_mask;
+  int *min_table;  // levels x blocks: min блоков [b, b + 2^k)
+  int *max_table;
+};
+
+struct RmqRange {
+  size_t begin;
+  size_t end;
+};
+
+// Строит индекс; маски и каждый уровень таблицы считаются в threads потоков.
+int RmqBuild(struct RmqIndex *rmq, const int *array, size_t size, int threads);
+void RmqFree(struct RmqIndex *rmq);
+
+// Как GetMinMax: min/max на [begin, end), на пустом отрезке 0, 0.
+struct MinMax RmqQuery(const struct RmqIndex *rmq, size_t begin, size_t end);
+
+// Отвечает на count запросов в threads потоков. Запросы группируются по
+// началу, чтобы соседние в работе запросы читали соседние данные;
+// out[i] всегда соответствует ranges[i].
+int RmqQueryBatch(const struct RmqIndex *rmq, const struct RmqRange *ranges,
+                  size_t count, struct MinMax *out, int threads);
+
+#endif
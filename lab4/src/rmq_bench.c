@@ -0,0 +1,120 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "find_min_max.h"
+#include "rmq.h"
+#include "utils.h"
+
+// Пропускная способность RMQ-индекса на случайных запросах: одиночные
+// запросы, пакетный режим в threads потоков и (на выборке) линейный
+// GetMinMax для сравнения и проверки.
+
+#define CHECK_QUERIES 2000
+
+static double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void PrintUsage(const char *prog_name) {
+  printf("Usage: %s --array_size \"num\" --seed \"num\" [--threads_num \"num\"] "
+         "[--queries \"num\"] [--max_len \"num\"]\n",
+         prog_name);
+}
+
+int main(int argc, char **argv) {
+  size_t array_size = 0;
+  unsigned int seed = 0;
+  int threads_num = 1;
+  size_t queries = 1000000;
+  size_t max_len = 0;  // 0 - любая длина
+
+  static struct option options[] = {{"array_size", required_argument, 0, 0},
+                                    {"seed", required_argument, 0, 0},
+                                    {"threads_num", required_argument, 0, 0},
+                                    {"queries", required_argument, 0, 0},
+                                    {"max_len", required_argument, 0, 0},
+                                    {0, 0, 0, 0}};
+  int option_index = 0;
+  while (1) {
+    int c = getopt_long(argc, argv, "", options, &option_index);
+    if (c == -1) break;
+    if (c != 0) {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+    switch (option_index) {
+      case 0: array_size = strtoull(optarg, NULL, 10); break;
+      case 1: seed = (unsigned int)atoi(optarg); break;
+      case 2: threads_num = atoi(optarg); break;
+      case 3: queries = strtoull(optarg, NULL, 10); break;
+      case 4: max_len = strtoull(optarg, NULL, 10); break;
+    }
+  }
+  if (array_size == 0 || seed == 0 || threads_num <= 0 || queries == 0 ||
+      optind < argc) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  int *array = malloc(sizeof(int) * array_size);
+  struct RmqRange *ranges = malloc(sizeof(struct RmqRange) * queries);
+  struct MinMax *out = malloc(sizeof(struct MinMax) * queries);
+  if (array == NULL || ranges == NULL || out == NULL) {
+    perror("malloc");
+    return 1;
+  }
+  GenerateArray(array, array_size, seed);
+
+  unsigned int state = seed;
+  for (size_t i = 0; i < queries; i++) {
+    size_t a = (size_t)rand_r(&state) % array_size;
+    size_t len = (size_t)rand_r(&state) % (max_len ? max_len : array_size) + 1;
+    ranges[i].begin = a;
+    ranges[i].end = a + len > array_size ? array_size : a + len;
+  }
+
+  struct RmqIndex rmq;
+  double start = Now();
+  if (RmqBuild(&rmq, array, array_size, threads_num) != 0) {
+    perror("RmqBuild");
+    return 1;
+  }
+  printf("Build (%d threads): %f seconds\n", threads_num, Now() - start);
+
+  long long check = 0;
+  start = Now();
+  for (size_t i = 0; i < queries; i++) {
+    struct MinMax mm = RmqQuery(&rmq, ranges[i].begin, ranges[i].end);
+    check += mm.min ^ mm.max;
+  }
+  double single = Now() - start;
+  printf("Single queries: %.0f q/s\n", queries / single);
+
+  start = Now();
+  RmqQueryBatch(&rmq, ranges, queries, out, threads_num);
+  double batch = Now() - start;
+  printf("Batch (%d threads): %.0f q/s\n", threads_num, queries / batch);
+
+  long long batch_check = 0;
+  for (size_t i = 0; i < queries; i++) batch_check += out[i].min ^ out[i].max;
+
+  size_t sample = queries < CHECK_QUERIES ? queries : CHECK_QUERIES;
+  int ok = check == batch_check;
+  start = Now();
+  for (size_t i = 0; i < sample; i++) {
+    struct MinMax mm = GetMinMax(array, ranges[i].begin, ranges[i].end);
+    if (mm.min != out[i].min || mm.max != out[i].max) ok = 0;
+  }
+  printf("Linear GetMinMax: %.0f q/s\n", sample / (Now() - start));
+  if (!ok) printf("MISMATCH between RMQ and GetMinMax\n");
+
+  RmqFree(&rmq);
+  free(array);
+  free(ranges);
+  free(out);
+  return ok ? 0 : 1;
+}
@@ -1,16 +1,93 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/types.h>
 
+#include "self_path.h"
+#include "shm_array.h"
+#include "utils.h"
+
+// sequential_min_max ищем рядом с собой, а не в текущем каталоге
+static int worker_exe(const char *argv0, char *path, size_t size) {
+    if (SiblingPath(argv0, "sequential_min_max", path, size) != 0 ||
+        access(path, X_OK) != 0) {
+        perror("cannot locate sequential_min_max next to run_sequential");
+        return -1;
+    }
+    return 0;
+}
+
+// Режим shm: родитель один раз генерирует массив в memfd, дочерний
+// sequential_min_max отображает его только на чтение вместо повторной
+// генерации и пишет min/max в слот того же сегмента.
+static int run_shm(const char *argv0, const char *seed_arg,
+                   const char *size_arg) {
+    int seed = atoi(seed_arg);
+    int array_size = atoi(size_arg);
+    if (seed <= 0 || array_size <= 0) {
+        printf("seed and array_size are positive numbers\n");
+        return 1;
+    }
+    char exe[4096];
+    if (worker_exe(argv0, exe, sizeof(exe)) != 0)
+        return 1;
+
+    struct ShmArray shm;
+    if (ShmArrayCreate(&shm, NULL, (size_t)array_size, 1) != 0) {
+        perror("memfd");
+        return 1;
+    }
+    GenerateArray(shm.data, array_size, seed);
+    char spec[32];
+    ShmArraySpec(&shm, spec, sizeof(spec));
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork failed");
+        ShmArrayClose(&shm);
+        return 1;
+    }
+    if (pid == 0) {
+        printf("process (PID: %d) start, array in %s\n", getpid(), spec);
+        fflush(stdout);
+        char *args[] = {exe, "--shm", spec, "0", NULL};
+        execv(exe, args);
+        perror("failed");
+        exit(1);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    struct ShmResult *result = ShmArrayResult(&shm, 0);
+    int done = __atomic_load_n(&result->done, __ATOMIC_ACQUIRE);
+    if (done) {
+        printf("min: %d\n", result->min);
+        printf("max: %d\n", result->max);
+    } else if (WIFSIGNALED(status)) {
+        printf("process terminated: %d\n", WTERMSIG(status));
+    } else {
+        printf("process exit without result, status: %d\n", WEXITSTATUS(status));
+    }
+    ShmArrayClose(&shm);
+    return done ? 0 : 1;
+}
+
 int main(int argc, char *argv[]) {
+    if (argc == 4 && strcmp(argv[3], "shm") == 0)
+        return run_shm(argv[0], argv[1], argv[2]);
+
     if (argc != 3) {
-        printf("usage: %s <seed> <array_size>\n", argv[0]);
+        printf("usage: %s <seed> <array_size> [shm]\n", argv[0]);
         printf("example: %s 42 1000\n", argv[0]);
         return 1;
     }
 
+    char exe[4096];
+    if (worker_exe(argv[0], exe, sizeof(exe)) != 0)
+        return 1;
+
     pid_t pid = fork();
     
     if (pid < 0) {
@@ -23,11 +100,11 @@ int main(int argc, char *argv[]) {
         printf("process (PID: %d) start\n", getpid());
         
         // запускаем sequential_min_max с переданными аргументами
-        char *args[] = {"./sequential_min_max", argv[1], argv[2], NULL};
+        char *args[] = {exe, argv[1], argv[2], NULL};
         
-        execvp(args[0], args);
+        execv(exe, args);
         
-        // если execvp вернул управление, значит произошла ошибка
+        // если execv вернул управление, значит произошла ошибка
         perror("failed");
         exit(1);
     }
@@ -1,12 +1,21 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 
+#include "arena.h"
 #include "find_min_max.h"
+#include "shm_worker.h"
 #include "utils.h"
 
 int main(int argc, char **argv) {
+  if (argc == 4 && strcmp(argv[1], "--shm") == 0)
+    return RunShmWorker(argv[2], argv[3]);
+
   if (argc != 3) {
     printf("Usage: %s seed arraysize\n", argv[0]);
+    printf("       %s --shm <fd:N|/name> <worker>\n", argv[0]);
     return 1;
   }
 
@@ -22,10 +31,23 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  int *array = malloc(array_size * sizeof(int));
+  struct ArenaOptions arena_opts;
+  struct Arena arena;
+  ArenaOptionsFromEnv(&arena_opts);
+  if (ArenaInit(&arena, array_size * sizeof(int), &arena_opts) != 0) {
+    printf("Memory allocation failed\n");
+    return 1;
+  }
+  int *array = ArenaAlloc(&arena, array_size * sizeof(int));
   GenerateArray(array, array_size, seed);
+
+  struct timespec start, finish;
+  clock_gettime(CLOCK_MONOTONIC, &start);
   struct MinMax min_max = GetMinMax(array, 0, array_size);
-  free(array);
+  clock_gettime(CLOCK_MONOTONIC, &finish);
+  ArenaReportTimes(&arena, (finish.tv_sec - start.tv_sec) +
+                               (finish.tv_nsec - start.tv_nsec) / 1e9);
+  ArenaDestroy(&arena);
 
   printf("min: %d\n", min_max.min);
   printf("max: %d\n", min_max.max);
@@ -0,0 +1,336 @@
+#include "sort_lib.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (32 / RADIX_BITS)
+#define WC_ELEMS 16        // 64 байта - одна кэш-линия на корзину
+#define SAMPLES_PER_THREAD 64
+
+static uint32_t Key(int x) { return (uint32_t)x ^ 0x80000000u; }
+
+static unsigned Digit(int x, int pass) {
+  return (Key(x) >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1);
+}
+
+// Запускает fn над args[0..threads); если поток не создался, его часть
+// выполняет вызывающий поток.
+static void RunParallel(void *(*fn)(void *), void *args, size_t arg_size,
+                        int threads) {
+  pthread_t *tids = malloc(sizeof(pthread_t) * threads);
+  int started = 0;
+  for (int i = 0; i < threads; i++) {
+    void *arg = (char *)args + i * arg_size;
+    if (tids != NULL && pthread_create(&tids[started], NULL, fn, arg) == 0)
+      started++;
+    else
+      fn(arg);
+  }
+  for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+  free(tids);
+}
+
+static void ChunkBounds(size_t size, int threads, int i, size_t *begin,
+                        size_t *end) {
+  size_t chunk = size / threads;
+  *begin = i * chunk;
+  *end = (i == threads - 1) ? size : (i + 1) * chunk;
+}
+
+// Буфер нужен только на время сортировки; mmap не касается страниц заранее.
+static int *AllocTemp(size_t size) {
+  void *p = mmap(NULL, size * sizeof(int), PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return p == MAP_FAILED ? NULL : p;
+}
+
+static void FreeTemp(int *p, size_t size) { munmap(p, size * sizeof(int)); }
+
+struct WcBuffers {
+  int data[RADIX_BUCKETS][WC_ELEMS];
+  unsigned fill[RADIX_BUCKETS];
+};
+
+// Разброс src[begin, end) по корзинам dst; pos[d] - куда писать корзину d.
+static void Scatter(const int *src, size_t begin, size_t end, int *dst,
+                    size_t *pos, int pass, struct WcBuffers *wc) {
+  memset(wc->fill, 0, sizeof(wc->fill));
+  for (size_t i = begin; i < end; i++) {
+    unsigned d = Digit(src[i], pass);
+    wc->data[d][wc->fill[d]++] = src[i];
+    if (wc->fill[d] == WC_ELEMS) {
+      memcpy(dst + pos[d], wc->data[d], sizeof(wc->data[d]));
+      pos[d] += WC_ELEMS;
+      wc->fill[d] = 0;
+    }
+  }
+  for (unsigned d = 0; d < RADIX_BUCKETS; d++) {
+    memcpy(dst + pos[d], wc->data[d], wc->fill[d] * sizeof(int));
+    pos[d] += wc->fill[d];
+  }
+}
+
+// Последовательный radix sort; tmp - буфер того же размера.
+static void RadixSortSeq(int *array, int *tmp, size_t size,
+                         struct WcBuffers *wc) {
+  int *src = array, *dst = tmp;
+  for (int pass = 0; pass < RADIX_PASSES; pass++) {
+    size_t count[RADIX_BUCKETS] = {0};
+    for (size_t i = 0; i < size; i++) count[Digit(src[i], pass)]++;
+    if (size > 0 && count[Digit(src[0], pass)] == size) continue;
+    size_t pos[RADIX_BUCKETS];
+    size_t sum = 0;
+    for (unsigned d = 0; d < RADIX_BUCKETS; d++) {
+      pos[d] = sum;
+      sum += count[d];
+    }
+    Scatter(src, 0, size, dst, pos, pass, wc);
+    int *t = src;
+    src = dst;
+    dst = t;
+  }
+  if (src != array) memcpy(array, src, size * sizeof(int));
+}
+
+// --- параллельный radix sort ---
+
+struct RadixArgs {
+  const int *src;
+  int *dst;
+  size_t begin;
+  size_t end;
+  int pass;
+  size_t count[RADIX_BUCKETS];
+  size_t pos[RADIX_BUCKETS];
+  struct WcBuffers *wc;
+};
+
+static void *CountThread(void *arg) {
+  struct RadixArgs *a = arg;
+  memset(a->count, 0, sizeof(a->count));
+  for (size_t i = a->begin; i < a->end; i++) a->count[Digit(a->src[i], a->pass)]++;
+  return NULL;
+}
+
+static void *ScatterThread(void *arg) {
+  struct RadixArgs *a = arg;
+  Scatter(a->src, a->begin, a->end, a->dst, a->pos, a->pass, a->wc);
+  return NULL;
+}
+
+int ParallelRadixSort(int *array, size_t size, int threads) {
+  if (size < 2) return 0;
+  if (threads < 1) threads = 1;
+  if ((size_t)threads > size / WC_ELEMS) threads = 1;
+  int *tmp = AllocTemp(size);
+  struct RadixArgs *args = malloc(sizeof(struct RadixArgs) * threads);
+  struct WcBuffers *wc = malloc(sizeof(struct WcBuffers) * threads);
+  if (tmp == NULL || args == NULL || wc == NULL) {
+    if (tmp != NULL) FreeTemp(tmp, size);
+    free(args);
+    free(wc);
+    return -1;
+  }
+
+  int *src = array, *dst = tmp;
+  for (int pass = 0; pass < RADIX_PASSES; pass++) {
+    for (int t = 0; t < threads; t++) {
+      args[t].src = src;
+      args[t].dst = dst;
+      args[t].pass = pass;
+      args[t].wc = &wc[t];
+      ChunkBounds(size, threads, t, &args[t].begin, &args[t].end);
+    }
+    RunParallel(CountThread, args, sizeof(*args), threads);
+
+    // Порядок корзина-поток: внутри корзины потоки идут по порядку
+    // своих кусков, так что сортировка остаётся устойчивой.
+    size_t sum = 0;
+    int single = 0;
+    for (unsigned d = 0; d < RADIX_BUCKETS; d++) {
+      size_t bucket = 0;
+      for (int t = 0; t < threads; t++) {
+        args[t].pos[d] = sum;
+        sum += args[t].count[d];
+        bucket += args[t].count[d];
+      }
+      if (bucket == size) single = 1;
+    }
+    if (single) continue;
+    RunParallel(ScatterThread, args, sizeof(*args), threads);
+    int *t = src;
+    src = dst;
+    dst = t;
+  }
+  if (src != array) memcpy(array, src, size * sizeof(int));
+  FreeTemp(tmp, size);
+  free(args);
+  free(wc);
+  return 0;
+}
+
+// --- sample sort ---
+
+static int CompareInt(const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+// Корзины при n различных разделителях s[0] < ... < s[n-1]: 2j - ключи
+// строго между s[j-1] и s[j], 2j + 1 - ключи, равные s[j]. Корзины равных
+// не сортируются, а заполняются значением разделителя, так что частые
+// значения (и постоянный массив) не сваливаются в одну корзину одного
+// потока.
+static int Bucket(const int *splitters, int n, int x) {
+  int lo = 0, hi = n;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (splitters[mid] < x) lo = mid + 1;
+    else hi = mid;
+  }
+  return (lo < n && splitters[lo] == x) ? 2 * lo + 1 : 2 * lo;
+}
+
+struct SampleArgs {
+  int *array;
+  int *tmp;
+  int threads;
+  int index;
+  const int *splitters;
+  int splitters_count;  // различных разделителей
+  int buckets;          // 2 * splitters_count + 1
+  size_t begin;  // кусок исходного массива
+  size_t end;
+  size_t *count;  // buckets корзин
+  size_t *pos;
+  const size_t *bounds;  // buckets + 1 границ корзин после раскладки
+  struct WcBuffers *wc;
+};
+
+static void *SampleCountThread(void *arg) {
+  struct SampleArgs *a = arg;
+  memset(a->count, 0, sizeof(size_t) * a->buckets);
+  for (size_t i = a->begin; i < a->end; i++)
+    a->count[Bucket(a->splitters, a->splitters_count, a->array[i])]++;
+  return NULL;
+}
+
+static void *SampleScatterThread(void *arg) {
+  struct SampleArgs *a = arg;
+  for (size_t i = a->begin; i < a->end; i++) {
+    int b = Bucket(a->splitters, a->splitters_count, a->array[i]);
+    if (b & 1) continue;  // равные разделителю - только считаются
+    a->tmp[a->pos[b]++] = a->array[i];
+  }
+  return NULL;
+}
+
+// Поток index сортирует корзину 2 * index (если она есть): в tmp, а её же
+// участок array служит буфером; затем результат копируется на место.
+// Каждую корзину равных потоки заполняют поровну.
+static void *SampleSortThread(void *arg) {
+  struct SampleArgs *a = arg;
+  if (a->index <= a->splitters_count) {
+    size_t begin = a->bounds[2 * a->index];
+    size_t n = a->bounds[2 * a->index + 1] - begin;
+    int *bucket = a->tmp + begin;
+    RadixSortSeq(bucket, a->array + begin, n, a->wc);
+    memcpy(a->array + begin, bucket, n * sizeof(int));
+  }
+  for (int j = 0; j < a->splitters_count; j++) {
+    size_t begin = a->bounds[2 * j + 1];
+    size_t part_begin, part_end;
+    ChunkBounds(a->bounds[2 * j + 2] - begin, a->threads, a->index,
+                &part_begin, &part_end);
+    for (size_t i = begin + part_begin; i < begin + part_end; i++)
+      a->array[i] = a->splitters[j];
+  }
+  return NULL;
+}
+
+int ParallelSampleSort(int *array, size_t size, int threads) {
+  if (threads < 2 || size < (size_t)threads * SAMPLES_PER_THREAD * 4)
+    return ParallelRadixSort(array, size, threads);
+
+  int samples_count = threads * SAMPLES_PER_THREAD;
+  int max_buckets = 2 * threads - 1;
+  int *samples = malloc(sizeof(int) * samples_count);
+  int *splitters = malloc(sizeof(int) * (threads - 1));
+  struct SampleArgs *args = malloc(sizeof(struct SampleArgs) * threads);
+  size_t *counts = malloc(sizeof(size_t) * 2 * threads * max_buckets);
+  size_t *bounds = malloc(sizeof(size_t) * (max_buckets + 1));
+  struct WcBuffers *wc = malloc(sizeof(struct WcBuffers) * threads);
+  int *tmp = AllocTemp(size);
+  if (samples == NULL || splitters == NULL || args == NULL || counts == NULL ||
+      bounds == NULL || wc == NULL || tmp == NULL) {
+    free(samples);
+    free(splitters);
+    free(args);
+    free(counts);
+    free(bounds);
+    free(wc);
+    if (tmp != NULL) FreeTemp(tmp, size);
+    return -1;
+  }
+
+  unsigned int state = (unsigned int)size;
+  for (int i = 0; i < samples_count; i++)
+    samples[i] = array[((size_t)rand_r(&state) * RAND_MAX + rand_r(&state)) % size];
+  qsort(samples, samples_count, sizeof(int), CompareInt);
+  // повторы среди разделителей дали бы пустые корзины
+  int splitters_count = 0;
+  for (int i = 0; i < threads - 1; i++) {
+    int s = samples[(i + 1) * SAMPLES_PER_THREAD];
+    if (splitters_count == 0 || splitters[splitters_count - 1] != s)
+      splitters[splitters_count++] = s;
+  }
+  int buckets = 2 * splitters_count + 1;
+
+  for (int t = 0; t < threads; t++) {
+    args[t].array = array;
+    args[t].tmp = tmp;
+    args[t].threads = threads;
+    args[t].index = t;
+    args[t].splitters = splitters;
+    args[t].splitters_count = splitters_count;
+    args[t].buckets = buckets;
+    args[t].count = counts + 2 * t * max_buckets;
+    args[t].pos = args[t].count + max_buckets;
+    args[t].bounds = bounds;
+    args[t].wc = &wc[t];
+    ChunkBounds(size, threads, t, &args[t].begin, &args[t].end);
+  }
+  RunParallel(SampleCountThread, args, sizeof(*args), threads);
+
+  size_t sum = 0;
+  for (int b = 0; b < buckets; b++) {
+    bounds[b] = sum;
+    for (int t = 0; t < threads; t++) {
+      args[t].pos[b] = sum;
+      sum += args[t].count[b];
+    }
+  }
+  bounds[buckets] = sum;
+  RunParallel(SampleScatterThread, args, sizeof(*args), threads);
+  RunParallel(SampleSortThread, args, sizeof(*args), threads);
+
+  free(samples);
+  free(splitters);
+  free(args);
+  free(counts);
+  free(bounds);
+  free(wc);
+  FreeTemp(tmp, size);
+  return 0;
+}
+
+int IsSorted(const int *array, size_t size) {
+  for (size_t i = 1; i < size; i++)
+    if (array[i - 1] > array[i]) return 0;
+  return 1;
+}
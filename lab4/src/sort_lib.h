@@ -0,0 +1,27 @@
+#ifndef SORT_LIB_H
+#define SORT_LIB_H
+
+#include <stddef.h>
+
+// Параллельная сортировка int по возрастанию на месте (результат в array).
+// Обеим нужен вспомогательный буфер размером с массив.
+
+// LSD radix sort: 4 прохода по 8 бит. В каждом проходе потоки строят
+// гистограммы своих кусков, общие префиксные суммы дают каждому потоку
+// его место в каждой корзине, и разброс идёт через буферы по 64 байта на
+// корзину, которые сбрасываются в память целой кэш-линией. Проходы, где
+// все элементы в одной корзине, пропускаются.
+int ParallelRadixSort(int *array, size_t size, int threads);
+
+// Sample sort: по выборке выбираются до threads - 1 различных
+// разделителей, элементы раскладываются по корзинам, и каждый поток
+// сортирует свою корзину последовательным radix sort. Ключи, равные
+// разделителю, идут в отдельные корзины, которые потоки заполняют поровну
+// без сортировки. Подходит для очень больших массивов: после раскладки
+// потоки работают с непересекающимися областями.
+int ParallelSampleSort(int *array, size_t size, int threads);
+
+// 1, если array[0..size) не убывает.
+int IsSorted(const int *array, size_t size);
+
+#endif // SORT_LIB_H
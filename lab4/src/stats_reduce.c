@@ -0,0 +1,311 @@
+#include "stats_reduce.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "find_min_max.h"
+
+// 4 x uint64 - векторные расширения GCC, без привязки к набору инструкций.
+typedef uint64_t v4du __attribute__((vector_size(32)));
+
+#define RADIX_BINS 2048
+#define HIST_COPIES 4  // независимые копии корзин против зависимостей store->load
+
+// Общая часть Parallel*: режет [0, size) на куски и запускает fn над
+// args[i] (размер элемента arg_size); ошибка pthread_create - считаем сами.
+static int RunChunks(void *(*fn)(void *), void *args, size_t arg_size,
+                     int threads) {
+  pthread_t *tids = malloc(sizeof(pthread_t) * threads);
+  if (tids == NULL) return -1;
+  int started = 0;
+  for (int i = 0; i < threads; i++) {
+    void *arg = (char *)args + i * arg_size;
+    if (pthread_create(&tids[started], NULL, fn, arg) == 0)
+      started++;
+    else
+      fn(arg);
+  }
+  for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+  free(tids);
+  return 0;
+}
+
+static void ChunkBounds(size_t size, int threads, int i, size_t *begin,
+                        size_t *end) {
+  size_t chunk = size / threads;
+  *begin = i * chunk;
+  *end = (i == threads - 1) ? size : (i + 1) * chunk;
+}
+
+static int ClampThreads(int threads, size_t size) {
+  if (threads < 1) threads = 1;
+  if ((size_t)threads > size) threads = size > 0 ? (int)size : 1;
+  return threads;
+}
+
+// --- top-k ---
+
+static void SiftDown(int *heap, size_t n, size_t i) {
+  for (;;) {
+    size_t smallest = i;
+    size_t l = 2 * i + 1, r = 2 * i + 2;
+    if (l < n && heap[l] < heap[smallest]) smallest = l;
+    if (r < n && heap[r] < heap[smallest]) smallest = r;
+    if (smallest == i) return;
+    int t = heap[i];
+    heap[i] = heap[smallest];
+    heap[smallest] = t;
+    i = smallest;
+  }
+}
+
+static void SiftUp(int *heap, size_t i) {
+  while (i > 0 && heap[(i - 1) / 2] > heap[i]) {
+    int t = heap[i];
+    heap[i] = heap[(i - 1) / 2];
+    heap[(i - 1) / 2] = t;
+    i = (i - 1) / 2;
+  }
+}
+
+// Добавляет x в min-кучу из не более чем k элементов.
+static void HeapPush(int *heap, size_t *n, size_t k, int x) {
+  if (*n < k) {
+    heap[*n] = x;
+    SiftUp(heap, (*n)++);
+  } else if (x > heap[0]) {
+    heap[0] = x;
+    SiftDown(heap, k, 0);
+  }
+}
+
+size_t GetTopK(const int *array, size_t begin, size_t end, size_t k,
+               int *out) {
+  size_t n = 0;
+  if (k == 0) return 0;
+  for (size_t i = begin; i < end; i++) HeapPush(out, &n, k, array[i]);
+  return n;
+}
+
+struct TopKArgs {
+  const int *array;
+  size_t begin;
+  size_t end;
+  size_t k;
+  int *heap;
+  size_t count;
+};
+
+static void *TopKThread(void *arg) {
+  struct TopKArgs *a = arg;
+  a->count = GetTopK(a->array, a->begin, a->end, a->k, a->heap);
+  return NULL;
+}
+
+size_t ParallelTopK(const int *array, size_t size, size_t k, int threads,
+                    int *out) {
+  if (k == 0 || size == 0) return 0;
+  threads = ClampThreads(threads, size);
+  struct TopKArgs *args = malloc(sizeof(struct TopKArgs) * threads);
+  int *heaps = malloc(sizeof(int) * k * threads);
+  if (args == NULL || heaps == NULL) {
+    free(args);
+    free(heaps);
+    return 0;
+  }
+  for (int i = 0; i < threads; i++) {
+    args[i].array = array;
+    ChunkBounds(size, threads, i, &args[i].begin, &args[i].end);
+    args[i].k = k;
+    args[i].heap = heaps + i * k;
+  }
+  if (RunChunks(TopKThread, args, sizeof(*args), threads) != 0) {
+    free(args);
+    free(heaps);
+    return 0;
+  }
+
+  // Слияние: кучи потоков проталкиваются в одну общую.
+  size_t n = 0;
+  for (int i = 0; i < threads; i++)
+    for (size_t j = 0; j < args[i].count; j++)
+      HeapPush(out, &n, k, args[i].heap[j]);
+  // Пирамидальная сортировка min-кучи даёт порядок по убыванию.
+  for (size_t last = n; last > 1; last--) {
+    int t = out[0];
+    out[0] = out[last - 1];
+    out[last - 1] = t;
+    SiftDown(out, last - 1, 0);
+  }
+  free(args);
+  free(heaps);
+  return n;
+}
+
+// --- перцентили ---
+
+// Ключ с тем же порядком, что у int, но беззнаковый.
+static uint32_t Key(int x) { return (uint32_t)x ^ 0x80000000u; }
+
+struct RadixArgs {
+  const int *array;
+  size_t begin;
+  size_t end;
+  uint32_t prefix;  // уже найденные старшие биты ключа
+  uint32_t mask;
+  int shift;
+  uint32_t bin_mask;  // ширина корзины текущего прохода
+  size_t counts[RADIX_BINS];
+};
+
+static void *RadixThread(void *arg) {
+  struct RadixArgs *a = arg;
+  memset(a->counts, 0, sizeof(a->counts));
+  for (size_t i = a->begin; i < a->end; i++) {
+    uint32_t key = Key(a->array[i]);
+    if ((key & a->mask) == a->prefix)
+      a->counts[(key >> a->shift) & a->bin_mask]++;
+  }
+  return NULL;
+}
+
+int ParallelPercentile(const int *array, size_t size, double p, int threads) {
+  if (size == 0) return 0;
+  if (!(p > 0)) p = 0;  // заодно NaN
+  if (p > 100) p = 100;
+  // Ближайший ранг ceil(p/100 * size) в целых: p с точностью до 1e-6
+  // процента, size = q*D + r, чтобы произведение не переполнилось.
+  const uint64_t kScale = 100000000;  // D: 100% в миллионных долях
+  uint64_t p_scaled = (uint64_t)(p * 1e6 + 0.5);
+  uint64_t q = size / kScale, r = size % kScale;
+  uint64_t rank = q * p_scaled + (r * p_scaled + kScale - 1) / kScale;
+  if (rank < 1) rank = 1;
+  if (rank > size) rank = size;
+  rank--;
+
+  threads = ClampThreads(threads, size);
+  struct RadixArgs *args = malloc(sizeof(struct RadixArgs) * threads);
+  if (args == NULL) return 0;
+
+  static const int kShifts[] = {21, 10, 0};
+  static const int kBits[] = {11, 11, 10};
+  uint32_t prefix = 0, mask = 0;
+  for (int pass = 0; pass < 3; pass++) {
+    for (int i = 0; i < threads; i++) {
+      args[i].array = array;
+      ChunkBounds(size, threads, i, &args[i].begin, &args[i].end);
+      args[i].prefix = prefix;
+      args[i].mask = mask;
+      args[i].shift = kShifts[pass];
+      args[i].bin_mask = (1u << kBits[pass]) - 1;
+    }
+    RunChunks(RadixThread, args, sizeof(*args), threads);
+
+    // Корзина, в которую попадает rank, задаёт следующие биты ответа.
+    size_t bins = (size_t)1 << kBits[pass];
+    for (size_t bin = 0; bin < bins; bin++) {
+      size_t count = 0;
+      for (int i = 0; i < threads; i++) count += args[i].counts[bin];
+      if (rank < count) {
+        prefix |= (uint32_t)bin << kShifts[pass];
+        mask |= (uint32_t)(bins - 1) << kShifts[pass];
+        break;
+      }
+      rank -= count;
+    }
+  }
+  free(args);
+  return (int)(prefix ^ 0x80000000u);
+}
+
+// --- гистограммы ---
+
+void GetHistogram(const int *array, size_t begin, size_t end, int min, int max,
+                  size_t bins, size_t *counts) {
+  if (bins == 0 || begin >= end || min > max) return;
+  uint64_t range = (uint64_t)((int64_t)max - min) + 1;
+  // bin = (x - min) * bins / range через умножение и сдвиг вместо деления
+  uint64_t scale = (((uint64_t)bins << 32) - 1) / range;
+  size_t *copies = calloc(bins * HIST_COPIES, sizeof(size_t));
+  if (copies == NULL) return;
+
+  size_t i = begin;
+  v4du vmin = {(uint32_t)min, (uint32_t)min, (uint32_t)min, (uint32_t)min};
+  v4du vscale = {scale, scale, scale, scale};
+  v4du vrange = {range, range, range, range};
+  for (; i + 4 <= end; i += 4) {
+    v4du x = {(uint32_t)array[i], (uint32_t)array[i + 1],
+              (uint32_t)array[i + 2], (uint32_t)array[i + 3]};
+    v4du delta = (x - vmin) & 0xffffffffu;
+    // вне [min, max] - маска 0: такой элемент считается в корзину 0 с весом 0
+    v4du inside = (v4du)(delta < vrange);
+    v4du bin = ((delta * vscale) >> 32) & inside;
+    for (int lane = 0; lane < 4; lane++)
+      copies[lane * bins + bin[lane]] += inside[lane] & 1;
+  }
+  for (; i < end; i++) {
+    if (array[i] < min || array[i] > max) continue;
+    uint64_t delta = (uint32_t)array[i] - (uint32_t)min;
+    copies[(delta * scale) >> 32]++;
+  }
+  for (size_t b = 0; b < bins; b++)
+    for (int c = 0; c < HIST_COPIES; c++) counts[b] += copies[c * bins + b];
+  free(copies);
+}
+
+struct HistArgs {
+  const int *array;
+  size_t begin;
+  size_t end;
+  struct MinMax range;
+  size_t bins;
+  size_t *counts;
+};
+
+static void *MinMaxThread(void *arg) {
+  struct HistArgs *a = arg;
+  a->range = GetMinMax((int *)a->array, a->begin, a->end);
+  return NULL;
+}
+
+static void *HistThread(void *arg) {
+  struct HistArgs *a = arg;
+  GetHistogram(a->array, a->begin, a->end, a->range.min, a->range.max,
+               a->bins, a->counts);
+  return NULL;
+}
+
+int ParallelHistogram(const int *array, size_t size, size_t bins, int threads,
+                      struct MinMax *range, size_t *counts) {
+  memset(counts, 0, sizeof(size_t) * bins);
+  if (size == 0 || bins == 0) return -1;
+  threads = ClampThreads(threads, size);
+  struct HistArgs *args = malloc(sizeof(struct HistArgs) * threads);
+  size_t *local = calloc(bins * threads, sizeof(size_t));
+  if (args == NULL || local == NULL) {
+    free(args);
+    free(local);
+    return -1;
+  }
+  for (int i = 0; i < threads; i++) {
+    args[i].array = array;
+    ChunkBounds(size, threads, i, &args[i].begin, &args[i].end);
+    args[i].bins = bins;
+    args[i].counts = local + i * bins;
+  }
+  RunChunks(MinMaxThread, args, sizeof(*args), threads);
+  *range = args[0].range;
+  for (int i = 1; i < threads; i++) {
+    if (args[i].range.min < range->min) range->min = args[i].range.min;
+    if (args[i].range.max > range->max) range->max = args[i].range.max;
+  }
+  for (int i = 0; i < threads; i++) args[i].range = *range;
+  RunChunks(HistThread, args, sizeof(*args), threads);
+  for (int i = 0; i < threads; i++)
+    for (size_t b = 0; b < bins; b++) counts[b] += args[i].counts[b];
+  free(args);
+  free(local);
+  return 0;
+}
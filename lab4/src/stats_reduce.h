@@ -0,0 +1,36 @@
+#ifndef STATS_REDUCE_H
+#define STATS_REDUCE_H
+
+#include <stddef.h>
+
+#include "utils.h"
+
+// Свёртки, которых не хватает в struct MinMax: top-k, точные перцентили
+// и гистограммы. Функции Get* работают с диапазоном [begin, end), как
+// GetMinMax; Parallel* делят массив между threads потоками, каждый поток
+// копит свой результат отдельно, и они объединяются после join без
+// блокировок.
+
+// Кладёт в out (не меньше k мест) k наибольших элементов диапазона в виде
+// min-кучи; возвращает их число (меньше k, если диапазон короче).
+size_t GetTopK(const int *array, size_t begin, size_t end, size_t k, int *out);
+
+// k наибольших элементов массива, out отсортирован по убыванию.
+size_t ParallelTopK(const int *array, size_t size, size_t k, int threads,
+                    int *out);
+
+// Точный перцентиль p (0..100, nearest rank) через radix select: три
+// прохода по 11/11/10 бит с гистограммами в каждом потоке, без сортировки
+// и копирования массива.
+int ParallelPercentile(const int *array, size_t size, double p, int threads);
+
+// Равные по ширине корзины на [min, max]; counts (bins мест) дополняется.
+void GetHistogram(const int *array, size_t begin, size_t end, int min, int max,
+                  size_t bins, size_t *counts);
+
+// Гистограмма всего массива; границы берутся из min/max массива и
+// возвращаются через range. counts обнуляется.
+int ParallelHistogram(const int *array, size_t size, size_t bins, int threads,
+                      struct MinMax *range, size_t *counts);
+
+#endif
@@ -8,3 +8,9 @@ void GenerateArray(int *array, unsigned int array_size, unsigned int seed) {
     array[i] = rand();
   }
 }
+
+void GenerateArrayChunk(int *array, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    array[i] = rand();
+  }
+}
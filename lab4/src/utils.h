@@ -1,6 +1,8 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <stddef.h>
+
 struct MinMax {
   int min;
   int max;
@@ -8,4 +10,8 @@ struct MinMax {
 
 void GenerateArray(int *array, unsigned int array_size, unsigned int seed);
 
+// Продолжает последовательность rand() после srand(seed): куски,
+// заполненные по порядку, дают тот же массив, что GenerateArray.
+void GenerateArrayChunk(int *array, size_t begin, size_t end);
+
 #endif
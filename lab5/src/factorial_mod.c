@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "trace.h"
+
 struct thread_args {
   unsigned long long start;
   unsigned long long end;
@@ -14,11 +16,21 @@ static pthread_mutex_t result_mutex = PTHREAD_MUTEX_INITIALIZER;
 static unsigned long long global_result = 1;
 // общий результат под защитой мьютекса накапливает произведение остатков
 
+// произведение по модулю в 128 битах: при mod > 2^32 обычное
+// умножение переполнило бы unsigned long long
+static unsigned long long mul_mod(unsigned long long a, unsigned long long b,
+                                  unsigned long long mod) {
+  __extension__ typedef unsigned __int128 wide_t;
+  return (unsigned long long)((wide_t)a * b % mod);
+}
+
 static void *thread_compute(void *arg) {
   struct thread_args *data = (struct thread_args *)arg;
   unsigned long long local = 1;
   // локальный результат позволяет избежать частых блокировок
 
+  TraceThreadName("worker", -1);
+  TraceBeginArg("compute", "from", (int64_t)data->start);
   if (data->mod == 1) {
     local = 0;
   } else {
@@ -26,22 +38,27 @@ static void *thread_compute(void *arg) {
       if (i == 0) {
         continue;
       }
-      local = (local * (i % data->mod)) % data->mod;
+      local = mul_mod(local, i % data->mod, data->mod);
       if (local == 0) {
         break;
       }
     }
   }
 
+  TraceEnd("compute");
+
+  // в трассе видно и ожидание мьютекса, и сам участок под ним
+  TraceBegin("combine");
   pthread_mutex_lock(&result_mutex);
   if (global_result == 0) {
     /* nothing to do */
   } else if (data->mod == 1) {
     global_result = 0;
   } else {
-    global_result = (global_result * (local % data->mod)) % data->mod;
+    global_result = mul_mod(global_result, local, data->mod);
   }
   pthread_mutex_unlock(&result_mutex);
+  TraceEnd("combine");
   // после обновления глобального значения поток завершает работу
 
   return NULL;
@@ -104,6 +121,8 @@ int main(int argc, char **argv) {
     return EXIT_SUCCESS;
   }
 
+  TraceInitFromEnv("factorial_mod");
+
   pthread_t *threads = calloc(pnum, sizeof(pthread_t));
   struct thread_args *args = calloc(pnum, sizeof(struct thread_args));
   if (threads == NULL || args == NULL) {
@@ -118,6 +137,7 @@ int main(int argc, char **argv) {
   unsigned long long current = 1;
   // распределяем диапазоны между потоками так, чтобы первые получали на одну итерацию больше
 
+  TraceBegin("spawn");
   for (int i = 0; i < pnum; ++i) {
     unsigned long long start = current;
     unsigned long long length =
@@ -145,9 +165,12 @@ int main(int argc, char **argv) {
   }
 
 cleanup_join:
+  TraceEnd("spawn");
+  TraceBegin("join");
   for (int i = 0; i < pnum; ++i) {
     pthread_join(threads[i], NULL);
   }
+  TraceEnd("join");
 
   printf("%llu\n", global_result % mod);
 
@@ -0,0 +1,207 @@
+#define _GNU_SOURCE
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sync_locks.h"
+
+// Нагрузка из mutex.c: прочитать общий счётчик, покрутить пустой цикл
+// длины cs, записать счётчик + 1. Каждая блокировка работает duration мс
+// в threads потоков; печатается пропускная способность (захватов в
+// секунду) и честность - индекс Джайна по числу захватов потоков
+// (1 - все поровну, 1/threads - всё досталось одному). Итоговый счётчик
+// сверяется с числом записей: потерянный инкремент - ошибка блокировки.
+
+enum LockKind { LOCK_PTHREAD, LOCK_ADAPTIVE, LOCK_TICKET, LOCK_MCS, LOCK_RW,
+                LOCK_KINDS };
+
+static const char *kLockNames[] = {"pthread", "adaptive", "ticket", "mcs",
+                                   "rwlock"};
+
+struct Shared {
+  enum LockKind kind;
+  unsigned long cs_len;
+  int read_percent;
+  atomic_int start;
+  atomic_int stop;
+  pthread_mutex_t mutex;
+  struct AdaptiveMutex adaptive;
+  struct TicketLock ticket;
+  struct McsLock mcs;
+  struct RwLock rw;
+  volatile long counter;
+};
+
+struct Worker {
+  struct Shared *shared;
+  unsigned int seed;
+  long acquisitions;
+  long writes;
+};
+
+static void CriticalSection(struct Shared *s, int write) {
+  long work = s->counter;
+  for (volatile unsigned long k = 0; k < s->cs_len; k++)
+    ; /* long cycle */
+  if (write) s->counter = work + 1;
+}
+
+static void *Run(void *arg) {
+  struct Worker *w = arg;
+  struct Shared *s = w->shared;
+  while (!atomic_load(&s->start))
+    ;
+  while (!atomic_load_explicit(&s->stop, memory_order_relaxed)) {
+    struct McsNode node;
+    switch (s->kind) {
+      case LOCK_PTHREAD:
+        pthread_mutex_lock(&s->mutex);
+        CriticalSection(s, 1);
+        pthread_mutex_unlock(&s->mutex);
+        break;
+      case LOCK_ADAPTIVE:
+        AdaptiveMutexLock(&s->adaptive);
+        CriticalSection(s, 1);
+        AdaptiveMutexUnlock(&s->adaptive);
+        break;
+      case LOCK_TICKET:
+        TicketLockLock(&s->ticket);
+        CriticalSection(s, 1);
+        TicketLockUnlock(&s->ticket);
+        break;
+      case LOCK_MCS:
+        McsLockLock(&s->mcs, &node);
+        CriticalSection(s, 1);
+        McsLockUnlock(&s->mcs, &node);
+        break;
+      case LOCK_RW:
+        if ((int)(rand_r(&w->seed) % 100) < s->read_percent) {
+          int slot = RwReadLock(&s->rw);
+          CriticalSection(s, 0);
+          RwReadUnlock(&s->rw, slot);
+          w->acquisitions++;
+          continue;
+        }
+        RwWriteLock(&s->rw);
+        CriticalSection(s, 1);
+        RwWriteUnlock(&s->rw);
+        break;
+      default:
+        return NULL;
+    }
+    w->acquisitions++;
+    w->writes++;
+  }
+  return NULL;
+}
+
+// Возвращает 0, если счётчик сошёлся с числом записей.
+static int Measure(enum LockKind kind, int threads, unsigned long cs_len,
+                   int duration_ms, int read_percent) {
+  struct Shared *s = calloc(1, sizeof(*s));
+  struct Worker *workers = calloc(threads, sizeof(*workers));
+  pthread_t *tids = calloc(threads, sizeof(*tids));
+  if (s == NULL || workers == NULL || tids == NULL) {
+    perror("calloc");
+    exit(1);
+  }
+  s->kind = kind;
+  s->cs_len = cs_len;
+  s->read_percent = read_percent;
+  pthread_mutex_init(&s->mutex, NULL);
+  TicketLockInit(&s->ticket);
+  McsLockInit(&s->mcs);
+  RwLockInit(&s->rw);
+
+  for (int i = 0; i < threads; i++) {
+    workers[i].shared = s;
+    workers[i].seed = i + 1;
+    if (pthread_create(&tids[i], NULL, Run, &workers[i]) != 0) {
+      perror("pthread_create");
+      exit(1);
+    }
+  }
+  struct timespec pause = {duration_ms / 1000, (duration_ms % 1000) * 1000000L};
+  atomic_store(&s->start, 1);
+  nanosleep(&pause, NULL);
+  atomic_store(&s->stop, 1);
+  for (int i = 0; i < threads; i++) pthread_join(tids[i], NULL);
+
+  double total = 0, squares = 0;
+  long writes = 0;
+  for (int i = 0; i < threads; i++) {
+    total += workers[i].acquisitions;
+    squares += (double)workers[i].acquisitions * workers[i].acquisitions;
+    writes += workers[i].writes;
+  }
+  double jain = squares > 0 ? total * total / (threads * squares) : 0;
+  int ok = s->counter == writes;
+  printf(" %10.0f/%4.2f%s", total / (duration_ms / 1000.0), jain, ok ? " " : "!");
+
+  pthread_mutex_destroy(&s->mutex);
+  free(s);
+  free(workers);
+  free(tids);
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  int threads = 4;
+  int duration_ms = 200;
+  int read_percent = 90;
+  char cs_list[256] = "0,100,1000,10000";
+
+  static struct option options[] = {{"threads", required_argument, 0, 0},
+                                    {"duration_ms", required_argument, 0, 0},
+                                    {"cs", required_argument, 0, 0},
+                                    {"read_percent", required_argument, 0, 0},
+                                    {0, 0, 0, 0}};
+  int option_index = 0;
+  int c;
+  while ((c = getopt_long(argc, argv, "", options, &option_index)) != -1) {
+    if (c != 0) {
+      fprintf(stderr,
+              "Usage: %s [--threads 4] [--duration_ms 200] "
+              "[--cs 0,100,1000,10000] [--read_percent 90]\n",
+              argv[0]);
+      return 1;
+    }
+    switch (option_index) {
+      case 0: threads = atoi(optarg); break;
+      case 1: duration_ms = atoi(optarg); break;
+      case 2:
+        strncpy(cs_list, optarg, sizeof(cs_list) - 1);
+        break;
+      case 3: read_percent = atoi(optarg); break;
+    }
+  }
+  if (threads <= 0 || duration_ms <= 0 || read_percent < 0 ||
+      read_percent > 100) {
+    fprintf(stderr, "threads > 0, duration_ms > 0, read_percent 0..100\n");
+    return 1;
+  }
+
+  printf("%d threads, %d ms per run, rwlock with %d%% reads\n", threads,
+         duration_ms, read_percent);
+  printf("acquisitions per second / Jain fairness index\n");
+  printf("%8s", "cs");
+  for (int k = 0; k < LOCK_KINDS; k++) printf(" %16s", kLockNames[k]);
+  printf("\n");
+
+  int failed = 0;
+  for (char *tok = strtok(cs_list, ","); tok != NULL; tok = strtok(NULL, ",")) {
+    unsigned long cs_len = strtoul(tok, NULL, 10);
+    printf("%8lu", cs_len);
+    for (int k = 0; k < LOCK_KINDS; k++) {
+      failed |= Measure(k, threads, cs_len, duration_ms, read_percent);
+      fflush(stdout);
+    }
+    printf("\n");
+  }
+  if (failed) printf("! - lost updates: the counter does not match writes\n");
+  return failed;
+}
@@ -0,0 +1,331 @@
+// Профилировщик мьютексов, подгружаемый через LD_PRELOAD:
+//
+//   LD_PRELOAD=./liblockprof.so ./mutex_with_mutex
+//
+// Перехватывает pthread_mutex_lock/trylock/unlock и для каждого мьютекса
+// считает захваты, захваты с ожиданием (lock был занят), суммарное и
+// максимальное время ожидания и удержания. При выходе печатает таблицу,
+// отсортированную по времени ожидания (LOCKPROF_OUT=файл - вместо stderr).
+//
+// Параллельно строится граф порядка захвата: ребро A -> B появляется,
+// когда поток, держа A, запрашивает B. Если новое ребро замыкает цикл,
+// сразу (ещё до блокировки) печатается предупреждение о возможной
+// взаимной блокировке с местами захвата в виде модуль+смещение, которое
+// можно передать addr2line -e <модуль>.
+//
+// Таблицы фиксированного размера и заполняются атомарно, без собственных
+// блокировок; на захват приходится два clock_gettime (vDSO) и поиск в
+// хеш-таблице, так что профилировщик можно держать включённым на стенде.
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LOCK_SLOTS 4096  // степени двойки
+#define EDGE_SLOTS 4096
+#define MAX_HELD 32
+#define MAX_REPORT 32
+
+struct LockStat {
+  _Atomic uintptr_t addr;  // 0 - слот свободен
+  void *first_site;
+  atomic_ulong acquisitions;
+  atomic_ulong contended;
+  atomic_ulong wait_ns;
+  atomic_ulong hold_ns;
+  atomic_ulong max_wait_ns;
+  atomic_ulong max_hold_ns;
+  uint64_t acquired_at;  // пишет только владелец
+};
+
+enum { EDGE_EMPTY, EDGE_CLAIMED, EDGE_READY };
+
+struct Edge {
+  atomic_int state;
+  uintptr_t from;
+  uintptr_t to;
+  void *from_site;  // где был захвачен from
+  void *to_site;    // где запрошен to
+};
+
+static struct LockStat locks[LOCK_SLOTS];
+static struct Edge edges[EDGE_SLOTS];
+static atomic_int tables_full;
+
+static int (*real_lock)(pthread_mutex_t *);
+static int (*real_trylock)(pthread_mutex_t *);
+static int (*real_unlock)(pthread_mutex_t *);
+
+// Мьютексы, которые держит поток, и где они были захвачены.
+static __thread uintptr_t held[MAX_HELD];
+static __thread void *held_site[MAX_HELD];
+static __thread int held_count;
+static __thread int in_profiler;
+// Вершины, пройденные поиском цикла. Свои у каждого потока: рёбра AB и BA
+// два потока добавляют как раз одновременно.
+static __thread uintptr_t cycle_visited[LOCK_SLOTS];
+
+static void Resolve(void) {
+  *(void **)&real_lock = dlsym(RTLD_NEXT, "pthread_mutex_lock");
+  *(void **)&real_trylock = dlsym(RTLD_NEXT, "pthread_mutex_trylock");
+  *(void **)&real_unlock = dlsym(RTLD_NEXT, "pthread_mutex_unlock");
+}
+
+static uint64_t NowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static size_t Hash(uintptr_t a, uintptr_t b) {
+  uint64_t h = (a >> 3) * 0x9e3779b97f4a7c15ull ^ (b >> 3) * 0xc2b2ae3d27d4eb4full;
+  return (size_t)(h >> 32);
+}
+
+static void UpdateMax(atomic_ulong *max, unsigned long value) {
+  unsigned long cur = atomic_load_explicit(max, memory_order_relaxed);
+  while (value > cur &&
+         !atomic_compare_exchange_weak_explicit(max, &cur, value,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+  }
+}
+
+static struct LockStat *FindLock(uintptr_t addr, void *site) {
+  for (size_t i = 0, slot = Hash(addr, 0); i < LOCK_SLOTS; i++, slot++) {
+    struct LockStat *s = &locks[slot & (LOCK_SLOTS - 1)];
+    uintptr_t cur = atomic_load_explicit(&s->addr, memory_order_acquire);
+    if (cur == addr) return s;
+    if (cur == 0) {
+      // место первого захвата пишет только поток, занявший слот
+      if (atomic_compare_exchange_strong(&s->addr, &cur, addr)) {
+        s->first_site = site;
+        return s;
+      }
+      if (cur == addr) return s;
+    }
+  }
+  atomic_store(&tables_full, 1);
+  return NULL;
+}
+
+// Добавляет ребро from -> to; 1 - ребро новое.
+static int AddEdge(uintptr_t from, uintptr_t to, void *from_site,
+                   void *to_site) {
+  for (size_t i = 0, slot = Hash(from, to); i < EDGE_SLOTS; i++, slot++) {
+    struct Edge *e = &edges[slot & (EDGE_SLOTS - 1)];
+    int state = atomic_load_explicit(&e->state, memory_order_acquire);
+    if (state == EDGE_EMPTY &&
+        atomic_compare_exchange_strong(&e->state, &state, EDGE_CLAIMED)) {
+      e->from = from;
+      e->to = to;
+      e->from_site = from_site;
+      e->to_site = to_site;
+      atomic_store_explicit(&e->state, EDGE_READY, memory_order_release);
+      return 1;
+    }
+    while (state == EDGE_CLAIMED)
+      state = atomic_load_explicit(&e->state, memory_order_acquire);
+    if (e->from == from && e->to == to) return 0;
+  }
+  atomic_store(&tables_full, 1);
+  return 0;
+}
+
+static void PrintSite(FILE *f, void *site) {
+  Dl_info info;
+  if (site != NULL && dladdr(site, &info) && info.dli_fname != NULL) {
+    const char *name = strrchr(info.dli_fname, '/');
+    name = name ? name + 1 : info.dli_fname;
+    if (info.dli_sname != NULL)
+      fprintf(f, "%s(%s+0x%lx)", name, info.dli_sname,
+              (unsigned long)((char *)site - (char *)info.dli_saddr));
+    else
+      fprintf(f, "%s+0x%lx", name,
+              (unsigned long)((char *)site - (char *)info.dli_fbase));
+  } else {
+    fprintf(f, "%p", site);
+  }
+}
+
+// Ищет путь from -> ... -> target по готовым рёбрам (поиск в глубину);
+// найденные рёбра складываются в path. Возвращает длину пути или 0.
+static int FindPath(uintptr_t from, uintptr_t target, const struct Edge **path,
+                    int depth, uintptr_t *visited, int *visited_count) {
+  if (depth >= MAX_HELD) return 0;
+  for (int i = 0; i < *visited_count; i++)
+    if (visited[i] == from) return 0;
+  if (*visited_count < LOCK_SLOTS) visited[(*visited_count)++] = from;
+  for (size_t i = 0; i < EDGE_SLOTS; i++) {
+    const struct Edge *e = &edges[i];
+    if (atomic_load_explicit(&e->state, memory_order_acquire) != EDGE_READY ||
+        e->from != from)
+      continue;
+    path[depth] = e;
+    if (e->to == target) return depth + 1;
+    int len = FindPath(e->to, target, path, depth + 1, visited, visited_count);
+    if (len > 0) return len;
+  }
+  return 0;
+}
+
+// Новое ребро held -> wanted: есть ли уже путь wanted -> ... -> held?
+static void CheckCycle(uintptr_t held_lock, uintptr_t wanted,
+                       void *held_at, void *wanted_at) {
+  const struct Edge *path[MAX_HELD];
+  int visited_count = 0;
+  int len = FindPath(wanted, held_lock, path, 0, cycle_visited, &visited_count);
+  if (len == 0) return;
+
+  fprintf(stderr, "lockprof: potential deadlock, lock order cycle:\n");
+  fprintf(stderr, "  thread %lu holds %p (locked at ", (unsigned long)pthread_self(),
+          (void *)held_lock);
+  PrintSite(stderr, held_at);
+  fprintf(stderr, ") and requests %p at ", (void *)wanted);
+  PrintSite(stderr, wanted_at);
+  fprintf(stderr, "\n");
+  for (int i = 0; i < len; i++) {
+    fprintf(stderr, "  earlier: %p (locked at ", (void *)path[i]->from);
+    PrintSite(stderr, path[i]->from_site);
+    fprintf(stderr, ") -> %p at ", (void *)path[i]->to);
+    PrintSite(stderr, path[i]->to_site);
+    fprintf(stderr, "\n");
+  }
+}
+
+static void PushHeld(uintptr_t addr, void *site) {
+  if (held_count < MAX_HELD) {
+    held[held_count] = addr;
+    held_site[held_count] = site;
+  }
+  held_count++;
+}
+
+static void PopHeld(uintptr_t addr) {
+  int top = held_count < MAX_HELD ? held_count : MAX_HELD;
+  for (int i = top - 1; i >= 0; i--) {
+    if (held[i] != addr) continue;
+    // мьютексы не обязаны освобождаться в обратном порядке
+    memmove(&held[i], &held[i + 1], (top - i - 1) * sizeof(held[0]));
+    memmove(&held_site[i], &held_site[i + 1], (top - i - 1) * sizeof(held_site[0]));
+    held_count--;
+    return;
+  }
+  if (held_count > top) held_count--;
+}
+
+int pthread_mutex_lock(pthread_mutex_t *mutex) {
+  if (real_lock == NULL) Resolve();
+  if (in_profiler) return real_lock(mutex);
+  in_profiler = 1;
+
+  void *site = __builtin_return_address(0);
+  uintptr_t addr = (uintptr_t)mutex;
+  struct LockStat *s = FindLock(addr, site);
+
+  // Рёбра добавляются до блокировки: если поток сейчас зависнет,
+  // предупреждение уже будет напечатано.
+  int top = held_count < MAX_HELD ? held_count : MAX_HELD;
+  for (int i = 0; i < top; i++) {
+    if (held[i] != addr && AddEdge(held[i], addr, held_site[i], site))
+      CheckCycle(held[i], addr, held_site[i], site);
+  }
+
+  uint64_t start = NowNs();
+  int rc = real_trylock(mutex);
+  int waited = rc == EBUSY;
+  if (waited) rc = real_lock(mutex);
+  uint64_t now = waited ? NowNs() : start;
+
+  if (rc == 0) {
+    if (s != NULL) {
+      atomic_fetch_add_explicit(&s->acquisitions, 1, memory_order_relaxed);
+      if (waited) {
+        atomic_fetch_add_explicit(&s->contended, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&s->wait_ns, now - start, memory_order_relaxed);
+        UpdateMax(&s->max_wait_ns, now - start);
+      }
+      s->acquired_at = now;
+    }
+    PushHeld(addr, site);
+  }
+  in_profiler = 0;
+  return rc;
+}
+
+int pthread_mutex_trylock(pthread_mutex_t *mutex) {
+  if (real_trylock == NULL) Resolve();
+  int rc = real_trylock(mutex);
+  if (rc != 0 || in_profiler) return rc;
+  in_profiler = 1;
+  void *site = __builtin_return_address(0);
+  struct LockStat *s = FindLock((uintptr_t)mutex, site);
+  if (s != NULL) {
+    atomic_fetch_add_explicit(&s->acquisitions, 1, memory_order_relaxed);
+    s->acquired_at = NowNs();
+  }
+  PushHeld((uintptr_t)mutex, site);
+  in_profiler = 0;
+  return rc;
+}
+
+int pthread_mutex_unlock(pthread_mutex_t *mutex) {
+  if (real_unlock == NULL) Resolve();
+  if (in_profiler) return real_unlock(mutex);
+  in_profiler = 1;
+  uintptr_t addr = (uintptr_t)mutex;
+  struct LockStat *s = FindLock(addr, __builtin_return_address(0));
+  if (s != NULL && s->acquired_at != 0) {
+    uint64_t hold = NowNs() - s->acquired_at;
+    s->acquired_at = 0;
+    atomic_fetch_add_explicit(&s->hold_ns, hold, memory_order_relaxed);
+    UpdateMax(&s->max_hold_ns, hold);
+  }
+  PopHeld(addr);
+  in_profiler = 0;
+  return real_unlock(mutex);
+}
+
+static int CompareWait(const void *a, const void *b) {
+  unsigned long x = atomic_load(&(*(struct LockStat *const *)a)->wait_ns);
+  unsigned long y = atomic_load(&(*(struct LockStat *const *)b)->wait_ns);
+  return (x < y) - (x > y);
+}
+
+__attribute__((destructor)) static void Report(void) {
+  in_profiler = 1;
+  FILE *f = stderr;
+  const char *path = getenv("LOCKPROF_OUT");
+  if (path != NULL && (f = fopen(path, "w")) == NULL) f = stderr;
+
+  static struct LockStat *sorted[LOCK_SLOTS];
+  int n = 0;
+  for (size_t i = 0; i < LOCK_SLOTS; i++)
+    if (atomic_load(&locks[i].addr) != 0 && atomic_load(&locks[i].acquisitions) > 0)
+      sorted[n++] = &locks[i];
+  qsort(sorted, n, sizeof(sorted[0]), CompareWait);
+
+  fprintf(f, "lockprof: %d mutexes\n", n);
+  fprintf(f, "%-16s %10s %10s %12s %12s %12s %12s  %s\n", "mutex", "acquired",
+          "contended", "wait ms", "max wait us", "hold ms", "max hold us",
+          "first locked at");
+  for (int i = 0; i < n && i < MAX_REPORT; i++) {
+    struct LockStat *s = sorted[i];
+    fprintf(f, "%-16p %10lu %10lu %12.3f %12.1f %12.3f %12.1f  ",
+            (void *)atomic_load(&s->addr), atomic_load(&s->acquisitions),
+            atomic_load(&s->contended), atomic_load(&s->wait_ns) / 1e6,
+            atomic_load(&s->max_wait_ns) / 1e3, atomic_load(&s->hold_ns) / 1e6,
+            atomic_load(&s->max_hold_ns) / 1e3);
+    PrintSite(f, s->first_site);
+    fprintf(f, "\n");
+  }
+  if (atomic_load(&tables_full))
+    fprintf(f, "lockprof: tables overflowed, some mutexes were not tracked\n");
+  if (f != stderr) fclose(f);
+}
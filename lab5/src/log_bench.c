@@ -0,0 +1,188 @@
+#define _GNU_SOURCE
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "async_log.h"
+
+// Цена строки лога в рабочем потоке. threads потоков делают по records
+// вызовов с четырьмя аргументами; для каждого режима печатается время
+// процессора на один вызов в самом потоке (CLOCK_THREAD_CPUTIME_ID: на
+// одном ядре настенное время включало бы работу потока записи), такое же
+// настенное время и пропускная способность до полного вывода (для async -
+// включая работу потока записи, AsyncLogFlush).
+//   compiled - LOG_TRACE, выброшенный при сборке (LOG_MIN_LEVEL);
+//   filtered - LOG_DEBUG, отсечённый уровнем во время работы;
+//   async    - LOG_INFO через кольца и поток записи;
+//   stdio    - fprintf в тот же файл под блокировкой stdio.
+
+enum Mode { MODE_COMPILED, MODE_FILTERED, MODE_ASYNC, MODE_STDIO, MODES };
+
+static const char *kModeNames[] = {"compiled", "filtered", "async", "stdio"};
+
+struct Shared {
+  enum Mode mode;
+  long records;
+  FILE *out;
+  atomic_int ready;
+  atomic_int start;
+};
+
+struct Worker {
+  struct Shared *shared;
+  int id;
+  double cpu_ns;
+  double wall_ns;
+};
+
+static double NowSec(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void *Run(void *arg) {
+  struct Worker *w = arg;
+  struct Shared *s = w->shared;
+  const char *name = kModeNames[s->mode];
+  // первая запись создаёт кольцо потока - до замера
+  if (s->mode == MODE_ASYNC) LOG_INFO("worker %d ready\n", w->id);
+  atomic_fetch_add(&s->ready, 1);
+  while (!atomic_load(&s->start))
+    ;
+  double cpu_begin = NowSec(CLOCK_THREAD_CPUTIME_ID);
+  double begin = NowSec(CLOCK_MONOTONIC);
+  for (long i = 0; i < s->records; i++) {
+    double value = (double)i * 0.5;
+    switch (s->mode) {
+      case MODE_COMPILED:
+        LOG_TRACE("worker %d iteration %ld value %.3f mode %s\n", w->id, i,
+                  value, name);
+        break;
+      case MODE_FILTERED:
+        LOG_DEBUG("worker %d iteration %ld value %.3f mode %s\n", w->id, i,
+                  value, name);
+        break;
+      case MODE_ASYNC:
+        LOG_INFO("worker %d iteration %ld value %.3f mode %s\n", w->id, i,
+                 value, name);
+        break;
+      default:
+        fprintf(s->out, "worker %d iteration %ld value %.3f mode %s\n", w->id,
+                i, value, name);
+        break;
+    }
+  }
+  w->wall_ns = (NowSec(CLOCK_MONOTONIC) - begin) * 1e9 / (double)s->records;
+  w->cpu_ns =
+      (NowSec(CLOCK_THREAD_CPUTIME_ID) - cpu_begin) * 1e9 / (double)s->records;
+  return NULL;
+}
+
+static void Measure(enum Mode mode, int threads, long records, FILE *out) {
+  struct Shared shared = {mode, records, out, 0, 0};
+  pthread_t tids[threads];
+  struct Worker workers[threads];
+  int started = 0;
+  for (int i = 0; i < threads; i++) {
+    workers[i].shared = &shared;
+    workers[i].id = i;
+    workers[i].cpu_ns = 0;
+    workers[i].wall_ns = 0;
+    if (pthread_create(&tids[i], NULL, Run, &workers[i]) != 0) {
+      perror("pthread_create");
+      break;
+    }
+    started++;
+  }
+  while (atomic_load(&shared.ready) < started)
+    ;
+  uint64_t dropped = AsyncLogDropped();
+  double begin = NowSec(CLOCK_MONOTONIC);
+  atomic_store(&shared.start, 1);
+  for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+  if (mode == MODE_ASYNC) AsyncLogFlush();
+  fflush(out);
+  double elapsed = NowSec(CLOCK_MONOTONIC) - begin;
+  dropped = AsyncLogDropped() - dropped;
+
+  double cpu_ns = 0, wall_ns = 0;
+  for (int i = 0; i < started; i++) {
+    cpu_ns += workers[i].cpu_ns;
+    wall_ns += workers[i].wall_ns;
+  }
+  cpu_ns /= started ? started : 1;
+  wall_ns /= started ? started : 1;
+  double total = (double)records * started;
+  printf("%10s %10.1f %10.1f %14.0f %10llu\n", kModeNames[mode], cpu_ns, wall_ns,
+         (total - (double)dropped) / elapsed, (unsigned long long)dropped);
+}
+
+int main(int argc, char **argv) {
+  int threads = 4;
+  long records = 1000000;
+  const char *out_path = "/dev/null";
+  struct AsyncLogOptions opts;
+  AsyncLogDefaultOptions(&opts);
+  opts.level = LOG_LEVEL_INFO;
+  opts.flags = LOG_FLAG_BLOCK;
+
+  static struct option options[] = {{"threads", required_argument, 0, 0},
+                                    {"records", required_argument, 0, 0},
+                                    {"out", required_argument, 0, 0},
+                                    {"ring_kb", required_argument, 0, 0},
+                                    {"drop", no_argument, 0, 0},
+                                    {0, 0, 0, 0}};
+  int option_index = 0;
+  int c;
+  while ((c = getopt_long(argc, argv, "", options, &option_index)) != -1) {
+    if (c != 0) {
+      fprintf(stderr,
+              "Usage: %s [--threads 4] [--records 1000000] [--out /dev/null] "
+              "[--ring_kb 64] [--drop]\n",
+              argv[0]);
+      return 1;
+    }
+    switch (option_index) {
+      case 0: threads = atoi(optarg); break;
+      case 1: records = atol(optarg); break;
+      case 2: out_path = optarg; break;
+      case 3: opts.ring_bytes = (size_t)atol(optarg) * 1024; break;
+      case 4: opts.flags &= ~(unsigned)LOG_FLAG_BLOCK; break;
+    }
+  }
+  if (threads <= 0 || records <= 0 || opts.ring_bytes == 0) {
+    fprintf(stderr, "threads > 0, records > 0, ring_kb > 0\n");
+    return 1;
+  }
+
+  FILE *out = fopen(out_path, "w");
+  if (out == NULL) {
+    perror(out_path);
+    return 1;
+  }
+  opts.out = out;
+  if (AsyncLogStart(&opts) != 0) {
+    fprintf(stderr, "Can not start the log writer\n");
+    fclose(out);
+    return 1;
+  }
+
+  printf("%d threads x %ld records -> %s, %zu KiB ring, %s when full\n",
+         threads, records, out_path, opts.ring_bytes / 1024,
+         (opts.flags & LOG_FLAG_BLOCK) ? "wait" : "drop");
+  printf("%10s %10s %10s %14s %10s\n", "mode", "cpu ns", "wall ns",
+         "records/s", "dropped");
+  for (int m = 0; m < MODES; m++) {
+    Measure((enum Mode)m, threads, records, out);
+    fflush(stdout);
+  }
+
+  AsyncLogStop();
+  fclose(out);
+  return 0;
+}
@@ -15,6 +15,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "async_log.h"
+
 void *do_one_thing(void *);
 void *do_another_thing(void *);
 void do_wrap_up(int);
@@ -25,6 +27,13 @@ pthread_mutex_t mut = PTHREAD_MUTEX_INITIALIZER;
 
 int main() {
   pthread_t thread1, thread2;
+  struct AsyncLogOptions log_opts;
+
+  // печать из потоков идёт через асинхронный лог: printf под блокировкой
+  // stdio сам упорядочивал бы потоки и искажал картину гонки
+  AsyncLogDefaultOptions(&log_opts);
+  if (AsyncLogStart(&log_opts) != 0)
+    fprintf(stderr, "async log unavailable, printing synchronously\n");
 
   if (pthread_create(&thread1, NULL, do_one_thing, (void *)&common) != 0) {
     perror("pthread_create");
@@ -46,6 +55,7 @@ int main() {
     exit(1);
   }
 
+  AsyncLogStop();
   do_wrap_up(common);
 
   return 0;
@@ -61,9 +71,9 @@ void *do_one_thing(void *arg) {
     pthread_mutex_lock(&mut);
 #endif
     // критическая секция защищается мьютексом при наличии макроса use_mutex
-    printf("doing one thing\n");
+    LOG_INFO("doing one thing\n");
     work = *pnum_times;
-    printf("counter = %d\n", work);
+    LOG_INFO("counter = %d\n", work);
     work++; /* increment, but not write */
     for (k = 0; k < 500000; k++)
       ;                 /* long cycle */
@@ -85,9 +95,9 @@ void *do_another_thing(void *arg) {
     pthread_mutex_lock(&mut);
 #endif
     // здесь второй поток выполняет те же действия, что и первый, создавая состязание без блокировки
-    printf("doing another thing\n");
+    LOG_INFO("doing another thing\n");
     work = *pnum_times;
-    printf("counter = %d\n", work);
+    LOG_INFO("counter = %d\n", work);
     work++; /* increment, but not write */
     for (k = 0; k < 500000; k++)
       ;                 /* long cycle */
@@ -0,0 +1,318 @@
+#define _GNU_SOURCE
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lockfree_queue.h"
+
+// Стресс-тест и сравнение очередей под нагрузкой: кольцо под мьютексом с
+// условными переменными против MpmcQueue (поштучно и пакетами) и
+// SpscQueue. Развёртка начинается с одного потока, который сам кладёт
+// и забирает (цена операций без конкуренции), дальше число пар
+// производитель/потребитель растёт от 1 до max_threads / 2; каждый прогон
+// проверяет, что все элементы дошли ровно по одному разу (количество и
+// контрольная сумма).
+
+enum QueueKind { QUEUE_MUTEX, QUEUE_MPMC, QUEUE_MPMC_BATCH, QUEUE_SPSC };
+
+static const char *kKindNames[] = {"mutex+cond", "mpmc", "mpmc-batch", "spsc"};
+
+struct MutexQueue {
+  pthread_mutex_t lock;
+  pthread_cond_t not_empty;
+  pthread_cond_t not_full;
+  void **slots;
+  size_t capacity;
+  size_t head;
+  size_t count;
+  int closed;
+};
+
+struct Bench {
+  enum QueueKind kind;
+  struct MutexQueue mq;
+  struct MpmcQueue mpmc;
+  struct SpscQueue spsc;
+  size_t items;  // на производителя
+  size_t batch;
+  atomic_int closed;
+  atomic_int order_ok;
+};
+
+struct Worker {
+  struct Bench *bench;
+  int id;
+  uint64_t count;
+  uint64_t sum;
+};
+
+static void MutexQueuePush(struct MutexQueue *q, void *item) {
+  pthread_mutex_lock(&q->lock);
+  while (q->count == q->capacity) pthread_cond_wait(&q->not_full, &q->lock);
+  q->slots[(q->head + q->count++) % q->capacity] = item;
+  pthread_cond_signal(&q->not_empty);
+  pthread_mutex_unlock(&q->lock);
+}
+
+// -1 - очередь закрыта и пуста.
+static int MutexQueuePop(struct MutexQueue *q, void **item) {
+  pthread_mutex_lock(&q->lock);
+  while (q->count == 0 && !q->closed)
+    pthread_cond_wait(&q->not_empty, &q->lock);
+  if (q->count == 0) {
+    pthread_mutex_unlock(&q->lock);
+    return -1;
+  }
+  *item = q->slots[q->head];
+  q->head = (q->head + 1) % q->capacity;
+  q->count--;
+  pthread_cond_signal(&q->not_full);
+  pthread_mutex_unlock(&q->lock);
+  return 0;
+}
+
+// Значение элемента: номер производителя в старших битах, порядковый
+// номер - в младших; +1, чтобы не было NULL.
+static void *MakeItem(int producer, size_t seq) {
+  return (void *)(uintptr_t)(((uint64_t)producer << 40 | seq) + 1);
+}
+
+static void *Produce(void *arg) {
+  struct Worker *w = arg;
+  struct Bench *b = w->bench;
+  void *buf[64];
+  size_t i = 0;
+  while (i < b->items) {
+    if (b->kind == QUEUE_MUTEX) {
+      MutexQueuePush(&b->mq, MakeItem(w->id, i++));
+      continue;
+    }
+    size_t n = b->kind == QUEUE_MPMC_BATCH ? b->batch : 1;
+    if (n > b->items - i) n = b->items - i;
+    for (size_t k = 0; k < n; k++) buf[k] = MakeItem(w->id, i + k);
+    size_t pushed = b->kind == QUEUE_SPSC ? SpscPushBatch(&b->spsc, buf, n)
+                                          : MpmcPushBatch(&b->mpmc, buf, n);
+    if (pushed == 0) sched_yield();
+    i += pushed;
+  }
+  return NULL;
+}
+
+static void Account(struct Worker *w, void **buf, size_t n,
+                    uint64_t *expected_next) {
+  for (size_t k = 0; k < n; k++) {
+    uint64_t v = (uint64_t)(uintptr_t)buf[k];
+    if (w->bench->kind == QUEUE_SPSC && v != (*expected_next)++)
+      atomic_store(&w->bench->order_ok, 0);
+    w->count++;
+    w->sum += v;
+  }
+}
+
+static void *Consume(void *arg) {
+  struct Worker *w = arg;
+  struct Bench *b = w->bench;
+  void *buf[64];
+  uint64_t expected_next = 1;  // для SPSC порядок должен сохраняться
+  for (;;) {
+    size_t n;
+    if (b->kind == QUEUE_MUTEX) {
+      if (MutexQueuePop(&b->mq, buf) != 0) return NULL;
+      n = 1;
+    } else {
+      int closed = atomic_load(&b->closed);
+      size_t want = b->kind == QUEUE_MPMC ? 1 : b->batch;
+      n = b->kind == QUEUE_SPSC ? SpscPopBatch(&b->spsc, buf, want)
+                                : MpmcPopBatch(&b->mpmc, buf, want);
+      if (n == 0) {
+        // closed прочитан до попытки: все элементы уже были в очереди
+        if (closed) return NULL;
+        sched_yield();
+        continue;
+      }
+    }
+    Account(w, buf, n, &expected_next);
+  }
+}
+
+// Один поток: кладёт элемент (пакет для mpmc-batch) и сразу забирает
+// всё, что лежит в очереди. Никто не ждёт и не конкурирует - нижняя
+// точка развёртки.
+static void *Solo(void *arg) {
+  struct Worker *w = arg;
+  struct Bench *b = w->bench;
+  void *buf[64];
+  uint64_t expected_next = 1;
+  size_t i = 0;
+  while (i < b->items) {
+    if (b->kind == QUEUE_MUTEX) {
+      MutexQueuePush(&b->mq, MakeItem(w->id, i++));
+      MutexQueuePop(&b->mq, buf);
+      Account(w, buf, 1, &expected_next);
+      continue;
+    }
+    size_t n = b->kind == QUEUE_MPMC_BATCH ? b->batch : 1;
+    if (n > b->items - i) n = b->items - i;
+    for (size_t k = 0; k < n; k++) buf[k] = MakeItem(w->id, i + k);
+    i += b->kind == QUEUE_SPSC ? SpscPushBatch(&b->spsc, buf, n)
+                               : MpmcPushBatch(&b->mpmc, buf, n);
+    size_t got;
+    while ((got = b->kind == QUEUE_SPSC ? SpscPopBatch(&b->spsc, buf, n)
+                                        : MpmcPopBatch(&b->mpmc, buf, n)) > 0)
+      Account(w, buf, got, &expected_next);
+  }
+  return NULL;
+}
+
+static double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Один прогон: pairs производителей и столько же потребителей, pairs == 0 -
+// один поток Solo. Возвращает миллионы операций в секунду или -1 при
+// ошибке проверки.
+static double Run(enum QueueKind kind, int pairs, size_t items,
+                  size_t capacity, size_t batch) {
+  struct Bench b = {0};
+  b.kind = kind;
+  b.items = items;
+  b.batch = batch;
+  atomic_init(&b.closed, 0);
+  atomic_init(&b.order_ok, 1);
+  if (kind == QUEUE_MUTEX) {
+    pthread_mutex_init(&b.mq.lock, NULL);
+    pthread_cond_init(&b.mq.not_empty, NULL);
+    pthread_cond_init(&b.mq.not_full, NULL);
+    b.mq.capacity = capacity;
+    b.mq.slots = malloc(sizeof(void *) * capacity);
+    if (b.mq.slots == NULL) return -1;
+  } else if (kind == QUEUE_SPSC) {
+    if (SpscInit(&b.spsc, capacity) != 0) return -1;
+  } else if (MpmcInit(&b.mpmc, capacity) != 0) {
+    return -1;
+  }
+
+  // без пар один поток и производит, и потребляет
+  int producers = pairs > 0 ? pairs : 1;
+  int consumer0 = pairs > 0 ? pairs : 0;
+  pthread_t threads[2 * producers];
+  struct Worker workers[2 * producers];
+  double start = Now();
+  if (pairs == 0) {
+    workers[0] = (struct Worker){&b, 0, 0, 0};
+    if (pthread_create(&threads[0], NULL, Solo, &workers[0]) != 0) {
+      perror("pthread_create");
+      exit(1);
+    }
+  }
+  for (int i = 0; i < 2 * pairs; i++) {
+    workers[i] = (struct Worker){&b, i % pairs, 0, 0};
+    if (pthread_create(&threads[i], NULL, i < pairs ? Produce : Consume,
+                       &workers[i]) != 0) {
+      perror("pthread_create");
+      exit(1);
+    }
+  }
+  for (int i = 0; i < producers; i++) pthread_join(threads[i], NULL);
+  if (kind == QUEUE_MUTEX) {
+    pthread_mutex_lock(&b.mq.lock);
+    b.mq.closed = 1;
+    pthread_cond_broadcast(&b.mq.not_empty);
+    pthread_mutex_unlock(&b.mq.lock);
+  }
+  atomic_store(&b.closed, 1);
+  for (int i = pairs; i < 2 * pairs; i++) pthread_join(threads[i], NULL);
+  double elapsed = Now() - start;
+
+  uint64_t count = 0, sum = 0, expected = 0;
+  for (int i = consumer0; i < consumer0 + producers; i++) {
+    count += workers[i].count;
+    sum += workers[i].sum;
+  }
+  for (int p = 0; p < producers; p++)
+    for (size_t i = 0; i < items; i++)
+      expected += (uint64_t)(uintptr_t)MakeItem(p, i);
+
+  if (kind == QUEUE_MUTEX) {
+    free(b.mq.slots);
+    pthread_mutex_destroy(&b.mq.lock);
+    pthread_cond_destroy(&b.mq.not_empty);
+    pthread_cond_destroy(&b.mq.not_full);
+  } else if (kind == QUEUE_SPSC) {
+    SpscDestroy(&b.spsc);
+  } else {
+    MpmcDestroy(&b.mpmc);
+  }
+
+  if (count != (uint64_t)producers * items || sum != expected ||
+      !atomic_load(&b.order_ok)) {
+    fprintf(stderr, "%s, %d pairs: lost or duplicated items (%llu of %llu)\n",
+            kKindNames[kind], pairs, (unsigned long long)count,
+            (unsigned long long)producers * items);
+    return -1;
+  }
+  return count / elapsed / 1e6;
+}
+
+int main(int argc, char **argv) {
+  size_t items = 200000;
+  int max_threads = 64;
+  size_t capacity = 1024;
+  size_t batch = 16;
+
+  static struct option options[] = {{"items", required_argument, 0, 0},
+                                    {"max_threads", required_argument, 0, 0},
+                                    {"capacity", required_argument, 0, 0},
+                                    {"batch", required_argument, 0, 0},
+                                    {0, 0, 0, 0}};
+  int option_index = 0;
+  int c;
+  while ((c = getopt_long(argc, argv, "", options, &option_index)) != -1) {
+    if (c != 0) {
+      fprintf(stderr,
+              "Usage: %s [--items per_producer] [--max_threads 64] "
+              "[--capacity 1024] [--batch 16]\n",
+              argv[0]);
+      return 1;
+    }
+    switch (option_index) {
+      case 0: items = strtoull(optarg, NULL, 10); break;
+      case 1: max_threads = atoi(optarg); break;
+      case 2: capacity = strtoull(optarg, NULL, 10); break;
+      case 3: batch = strtoull(optarg, NULL, 10); break;
+    }
+  }
+  if (items == 0 || max_threads < 1 || capacity < 2 || batch == 0 ||
+      batch > 64) {
+    fprintf(stderr, "items > 0, max_threads >= 1, capacity >= 2, batch 1..64\n");
+    return 1;
+  }
+
+  int failed = 0;
+  printf("%8s %8s %12s %12s %12s %12s\n", "threads", "pairs", kKindNames[0],
+         kKindNames[1], kKindNames[2], kKindNames[3]);
+  for (int threads = 1; threads <= max_threads;
+       threads = threads == 1 ? 2 : threads * 2) {
+    int pairs = threads / 2;
+    printf("%8d %8d", threads, pairs);
+    for (int kind = QUEUE_MUTEX; kind <= QUEUE_SPSC; kind++) {
+      if (kind == QUEUE_SPSC && pairs > 1) {
+        printf(" %12s", "-");
+        continue;
+      }
+      double mops = Run(kind, pairs, items, capacity, batch);
+      if (mops < 0) failed = 1;
+      printf(" %12.2f", mops);
+      fflush(stdout);
+    }
+    printf("   Mops/s\n");
+  }
+  return failed;
+}
@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,12 +10,40 @@
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 
+#include "coro.h"
+
+#define REQUEST_SIZE (sizeof(uint64_t) * 3)
+#define DEFAULT_TIMEOUT_MS 5000
+#define FD_RESERVE 32  // дескрипторы, которые не отдаём кускам (stdio, epoll...)
+
 struct Server {
-  char ip[255];
+  char ip[255];  // hostname по RFC 1035 не длиннее 253 символов
   int port;
+  struct sockaddr_in addr;
+};
+
+struct ShardQueue;
+
+// Кусок [begin, end] произведения на одном сервере. Всё состояние
+// сопрограммы лежит здесь: на тысячу кусков - тысяча таких структур,
+// без потоков; сокетов открыто не больше, чем кусков в полёте.
+struct ShardTask {
+  struct Coro co;
+  struct ShardQueue *queue;
+  const struct Server *server;
+  uint64_t begin;
+  uint64_t end;
+  uint64_t mod;
+  uint64_t timeout_ms;
+  int fd;
+  bool ok;
+  uint64_t answer;
+  char request[REQUEST_SIZE];
+  char response[sizeof(uint64_t)];
 };
 
 uint64_t MultModulo(uint64_t a, uint64_t b, uint64_t mod) {
@@ -32,30 +61,179 @@ uint64_t MultModulo(uint64_t a, uint64_t b, uint64_t mod) {
 
 bool ConvertStringToUI64(const char *str, uint64_t *val) {
   char *end = NULL;
+  errno = 0;
   unsigned long long i = strtoull(str, &end, 10);
   if (errno == ERANGE) {
     fprintf(stderr, "Out of uint64_t range: %s\n", str);
     return false;
   }
 
-  if (errno != 0)
+  if (errno != 0 || end == str || *end != '\0')
     return false;
 
   *val = i;
   return true;
 }
 
+// Файл серверов: по одному "ip:port" в строке, пустые строки и "#" - мимо.
+static struct Server *ReadServers(const char *path, unsigned int *count) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) {
+    perror(path);
+    return NULL;
+  }
+
+  struct Server *servers = NULL;
+  unsigned int cap = 0;
+  unsigned int n = 0;
+  char line[512];
+  unsigned int line_no = 0;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    line_no++;
+    char *s = line + strspn(line, " \t");
+    s[strcspn(s, "\r\n#")] = '\0';
+    if (*s == '\0')
+      continue;
+
+    char *colon = strrchr(s, ':');
+    int port = colon != NULL ? atoi(colon + 1) : 0;
+    if (colon == NULL || colon == s || (size_t)(colon - s) >= sizeof(servers->ip) ||
+        port <= 0 || port > 65535) {
+      fprintf(stderr, "%s:%u: expected ip:port, got \"%s\"\n", path, line_no, s);
+      free(servers);
+      fclose(f);
+      return NULL;
+    }
+
+    if (n == cap) {
+      cap = cap ? cap * 2 : 16;
+      struct Server *grown = realloc(servers, sizeof(*servers) * cap);
+      if (grown == NULL) {
+        perror("realloc");
+        free(servers);
+        fclose(f);
+        return NULL;
+      }
+      servers = grown;
+    }
+    memcpy(servers[n].ip, s, (size_t)(colon - s));
+    servers[n].ip[colon - s] = '\0';
+    servers[n].port = port;
+    n++;
+  }
+  fclose(f);
+
+  if (n == 0) {
+    fprintf(stderr, "%s: no servers\n", path);
+    free(servers);
+    return NULL;
+  }
+  *count = n;
+  return servers;
+}
+
+static bool ResolveServer(struct Server *server) {
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo *res = NULL;
+  int err = getaddrinfo(server->ip, NULL, &hints, &res);
+  if (err != 0) {
+    fprintf(stderr, "getaddrinfo failed with %s: %s\n", server->ip,
+            gai_strerror(err));
+    return false;
+  }
+  memcpy(&server->addr, res->ai_addr, sizeof(server->addr));
+  server->addr.sin_port = htons((uint16_t)server->port);
+  freeaddrinfo(res);
+  return true;
+}
+
+// Куски в полёте ограничены пределом дескрипторов: остальные ждут,
+// завершившийся кусок запускает следующий.
+struct ShardQueue {
+  struct CoroLoop *loop;
+  struct ShardTask *tasks;
+  uint64_t count;
+  uint64_t next;  // первый ещё не запущенный
+};
+
+static int ShardRun(struct Coro *co);
+
+static void SpawnNextShard(struct ShardQueue *queue) {
+  if (queue->next < queue->count)
+    CoroSpawn(queue->loop, &queue->tasks[queue->next++].co, ShardRun);
+}
+
+// Каждый кусок - отдельное соединение: подключиться, отправить
+// (begin, end, mod), дождаться 8 байт ответа. Все куски в полёте сразу.
+static int ShardRun(struct Coro *co) {
+  struct ShardTask *t = CORO_OWNER(co, struct ShardTask, co);
+  CORO_BEGIN(co);
+  CoroSetTimeout(co, t->timeout_ms);
+  t->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (t->fd < 0) {
+    co->err = errno;
+    SpawnNextShard(t->queue);
+    CORO_EXIT(co);
+  }
+
+  CORO_AWAIT(co, CoroConnect(co, t->fd, (const struct sockaddr *)&t->server->addr,
+                             sizeof(t->server->addr)));
+  if (co->result < 0)
+    goto done;
+
+  memcpy(t->request, &t->begin, sizeof(uint64_t));
+  memcpy(t->request + sizeof(uint64_t), &t->end, sizeof(uint64_t));
+  memcpy(t->request + 2 * sizeof(uint64_t), &t->mod, sizeof(uint64_t));
+  CORO_AWAIT(co, CoroSend(co, t->fd, t->request, sizeof(t->request)));
+  if (co->result < 0)
+    goto done;
+
+  CORO_AWAIT(co, CoroRecv(co, t->fd, t->response, sizeof(t->response)));
+  if (co->result == (long)sizeof(t->response)) {
+    memcpy(&t->answer, t->response, sizeof(uint64_t));
+    t->ok = true;
+  } else if (co->result >= 0) {
+    co->err = ECONNRESET; // сервер закрыл соединение без ответа
+  }
+
+done:
+  close(t->fd);
+  SpawnNextShard(t->queue);
+  CORO_END(co);
+}
+
+// По сокету на кусок в полёте: мягкий предел дескрипторов (часто 1024)
+// поднимаем до жёсткого. Возвращает, сколько кусков держать в полёте.
+static uint64_t RaiseFileLimit(void) {
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return 1024 - FD_RESERVE;
+  if (limit.rlim_cur < limit.rlim_max) {
+    rlim_t soft = limit.rlim_cur;
+    limit.rlim_cur = limit.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &limit) != 0) limit.rlim_cur = soft;
+  }
+  if (limit.rlim_cur == RLIM_INFINITY) return UINT64_MAX;
+  return limit.rlim_cur > 2 * FD_RESERVE ? (uint64_t)limit.rlim_cur - FD_RESERVE
+                                         : (uint64_t)(limit.rlim_cur + 1) / 2;
+}
+
 int main(int argc, char **argv) {
-  uint64_t k = -1;
-  uint64_t mod = -1;
-  char servers[255] = {'\0'}; // TODO: explain why 255
+  uint64_t k = 0;
+  uint64_t mod = 0;
+  uint64_t shards_num = 0;
+  uint64_t timeout_ms = DEFAULT_TIMEOUT_MS;
+  bool have_k = false;
+  const char *servers_path = NULL;
 
   while (true) {
-    int current_optind = optind ? optind : 1;
-
     static struct option options[] = {{"k", required_argument, 0, 0},
                                       {"mod", required_argument, 0, 0},
                                       {"servers", required_argument, 0, 0},
+                                      {"shards", required_argument, 0, 0},
+                                      {"timeout", required_argument, 0, 0},
                                       {0, 0, 0, 0}};
 
     int option_index = 0;
@@ -68,16 +246,30 @@ int main(int argc, char **argv) {
     case 0: {
       switch (option_index) {
       case 0:
-        ConvertStringToUI64(optarg, &k);
-        // TODO: your code here
+        have_k = ConvertStringToUI64(optarg, &k);
+        if (!have_k)
+          fprintf(stderr, "k must be a non-negative integer\n");
         break;
       case 1:
-        ConvertStringToUI64(optarg, &mod);
-        // TODO: your code here
+        if (!ConvertStringToUI64(optarg, &mod) || mod == 0) {
+          fprintf(stderr, "mod must be a positive integer\n");
+          mod = 0;
+        }
         break;
       case 2:
-        // TODO: your code here
-        memcpy(servers, optarg, strlen(optarg));
+        servers_path = optarg;
+        break;
+      case 3:
+        if (!ConvertStringToUI64(optarg, &shards_num) || shards_num == 0) {
+          fprintf(stderr, "shards must be a positive integer\n");
+          return 1;
+        }
+        break;
+      case 4:
+        if (!ConvertStringToUI64(optarg, &timeout_ms)) {
+          fprintf(stderr, "timeout must be a non-negative integer (ms)\n");
+          return 1;
+        }
         break;
       default:
         printf("Index %d is out of options\n", option_index);
@@ -92,73 +284,93 @@ int main(int argc, char **argv) {
     }
   }
 
-  if (k == -1 || mod == -1 || !strlen(servers)) {
-    fprintf(stderr, "Using: %s --k 1000 --mod 5 --servers /path/to/file\n",
-            argv[0]);
+  if (!have_k || mod == 0 || servers_path == NULL) {
+    fprintf(stderr,
+            "Using: %s --k 1000 --mod 5 --servers /path/to/file "
+            "[--shards N] [--timeout ms]\n"
+            "       servers file: one ip:port per line\n"
+            "       shards in flight are capped by the open file limit "
+            "(ulimit -n) minus %d,\n"
+            "       the rest start as earlier ones finish\n",
+            argv[0], FD_RESERVE);
     return 1;
   }
 
-  // TODO: for one server here, rewrite with servers from file
-  unsigned int servers_num = 1;
-  struct Server *to = malloc(sizeof(struct Server) * servers_num);
-  // TODO: delete this and parallel work between servers
-  to[0].port = 20001;
-  memcpy(to[0].ip, "127.0.0.1", sizeof("127.0.0.1"));
-
-  // TODO: work continiously, rewrite to make parallel
-  for (int i = 0; i < servers_num; i++) {
-    struct hostent *hostname = gethostbyname(to[i].ip);
-    if (hostname == NULL) {
-      fprintf(stderr, "gethostbyname failed with %s\n", to[i].ip);
-      exit(1);
-    }
-
-    struct sockaddr_in server;
-    server.sin_family = AF_INET;
-    server.sin_port = htons(to[i].port);
-    server.sin_addr.s_addr = *((unsigned long *)hostname->h_addr);
-
-    int sck = socket(AF_INET, SOCK_STREAM, 0);
-    if (sck < 0) {
-      fprintf(stderr, "Socket creation failed!\n");
-      exit(1);
+  unsigned int servers_num = 0;
+  struct Server *to = ReadServers(servers_path, &servers_num);
+  if (to == NULL)
+    return 1;
+  for (unsigned int i = 0; i < servers_num; i++) {
+    if (!ResolveServer(&to[i])) {
+      free(to);
+      return 1;
     }
+  }
 
-    if (connect(sck, (struct sockaddr *)&server, sizeof(server)) < 0) {
-      fprintf(stderr, "Connection failed\n");
-      exit(1);
-    }
+  // По умолчанию кусок на сервер; --shards N режет [1, k] мельче,
+  // куски раздаются серверам по кругу.
+  if (shards_num == 0)
+    shards_num = servers_num;
+  if (shards_num > k)
+    shards_num = k; // 0! = 1: при k = 0 запросов нет
+  if (shards_num > SIZE_MAX / sizeof(struct ShardTask)) {
+    fprintf(stderr, "too many shards\n");
+    free(to);
+    return 1;
+  }
 
-    // TODO: for one server
-    // parallel between servers
-    uint64_t begin = 1;
-    uint64_t end = k;
+  struct ShardTask *tasks = calloc(shards_num ? shards_num : 1, sizeof(*tasks));
+  struct CoroLoop loop;
+  if (tasks == NULL || CoroLoopInit(&loop) != 0) {
+    perror("client init");
+    free(tasks);
+    free(to);
+    return 1;
+  }
+  uint64_t in_flight = RaiseFileLimit();
+  struct ShardQueue queue = {&loop, tasks, shards_num, 0};
 
-    char task[sizeof(uint64_t) * 3];
-    memcpy(task, &begin, sizeof(uint64_t));
-    memcpy(task + sizeof(uint64_t), &end, sizeof(uint64_t));
-    memcpy(task + 2 * sizeof(uint64_t), &mod, sizeof(uint64_t));
+  uint64_t base = shards_num ? k / shards_num : 0;
+  uint64_t remainder = shards_num ? k % shards_num : 0;
+  uint64_t begin = 1;
+  for (uint64_t i = 0; i < shards_num; i++) {
+    uint64_t len = base + (i < remainder ? 1 : 0);
+    tasks[i].queue = &queue;
+    tasks[i].server = &to[i % servers_num];
+    tasks[i].begin = begin;
+    tasks[i].end = begin + len - 1;
+    tasks[i].mod = mod;
+    tasks[i].timeout_ms = timeout_ms;
+    begin += len;
+  }
+  while (queue.next < shards_num && queue.next < in_flight)
+    SpawnNextShard(&queue);
 
-    if (send(sck, task, sizeof(task), 0) < 0) {
-      fprintf(stderr, "Send failed\n");
-      exit(1);
-    }
+  int rc = 0;
+  if (CoroLoopRun(&loop) != 0) {
+    perror("epoll_wait");
+    shards_num = 0;
+    rc = 1;
+  }
 
-    char response[sizeof(uint64_t)];
-    if (recv(sck, response, sizeof(response), 0) < 0) {
-      fprintf(stderr, "Recieve failed\n");
-      exit(1);
+  // Объединяем ответы: произведение частей по модулю.
+  uint64_t answer = 1 % mod;
+  for (uint64_t i = 0; i < shards_num; i++) {
+    if (!tasks[i].ok) {
+      fprintf(stderr, "%s:%d [%llu, %llu]: %s\n", tasks[i].server->ip,
+              tasks[i].server->port, (unsigned long long)tasks[i].begin,
+              (unsigned long long)tasks[i].end, strerror(tasks[i].co.err));
+      rc = 1;
+      continue;
     }
-
-    // TODO: from one server
-    // unite results
-    uint64_t answer = 0;
-    memcpy(&answer, response, sizeof(uint64_t));
-    printf("answer: %llu\n", answer);
-
-    close(sck);
+    answer = MultModulo(answer, tasks[i].answer, mod);
   }
+  if (rc == 0)
+    printf("answer: %llu\n", (unsigned long long)answer);
+
+  CoroLoopDestroy(&loop);
+  free(tasks);
   free(to);
 
-  return 0;
+  return rc;
 }
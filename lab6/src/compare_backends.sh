@@ -0,0 +1,22 @@
+#!/bin/bash
+# Сравнение бэкендов сервера: пропускная способность и системные вызовы
+# на запрос при большом числе соединений.
+# Использование: ./compare_backends.sh [соединений] [запросов_на_соединение]
+
+conns=${1:-1000}
+requests=${2:-200}
+port=20101
+
+ulimit -n $((conns + 64)) 2>/dev/null
+
+for backend in epoll uring; do
+    ./server --port $port --tnum 1 --backend $backend >/dev/null 2>server_$backend.log &
+    pid=$!
+    sleep 0.5
+    echo "== $backend"
+    ./loop_bench --port $port --conns "$conns" --requests "$requests" --depth 4
+    kill -INT $pid
+    wait $pid
+    cat server_$backend.log
+    rm -f server_$backend.log
+done
@@ -0,0 +1,185 @@
+// Нагрузочный клиент для сравнения бэкендов сервера (epoll / io_uring).
+// Открывает --conns соединений, по каждому гоняет --requests маленьких
+// запросов (по --depth в полёте) и печатает пропускную способность.
+// Число системных вызовов на запрос печатает сам сервер при SIGINT,
+// см. compare_backends.sh.
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+
+#define REQUEST_SIZE (sizeof(uint64_t) * 3)
+#define RESPONSE_SIZE sizeof(uint64_t)
+
+struct BenchConn {
+  int fd;
+  uint64_t sent;
+  uint64_t received;
+  size_t partial;  // байты недочитанного ответа
+};
+
+static double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int SendRequests(struct BenchConn *c, uint64_t count, uint64_t k) {
+  char task[REQUEST_SIZE * 64];
+  while (count > 0) {
+    uint64_t batch = count > 64 ? 64 : count;
+    for (uint64_t i = 0; i < batch; i++) {
+      uint64_t begin = 1;
+      uint64_t end = k;
+      uint64_t mod = 1000000007ULL;
+      memcpy(task + i * REQUEST_SIZE, &begin, sizeof(uint64_t));
+      memcpy(task + i * REQUEST_SIZE + 8, &end, sizeof(uint64_t));
+      memcpy(task + i * REQUEST_SIZE + 16, &mod, sizeof(uint64_t));
+    }
+    size_t len = batch * REQUEST_SIZE;
+    size_t off = 0;
+    while (off < len) {
+      ssize_t n = send(c->fd, task + off, len - off, MSG_NOSIGNAL);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        return -1;
+      }
+      off += (size_t)n;
+    }
+    c->sent += batch;
+    count -= batch;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  const char *host = "127.0.0.1";
+  int port = 20001;
+  int conns = 100;
+  uint64_t requests = 1000;
+  uint64_t depth = 1;
+  uint64_t k = 10;
+
+  static struct option options[] = {{"host", required_argument, 0, 'h'},
+                                    {"port", required_argument, 0, 'p'},
+                                    {"conns", required_argument, 0, 'c'},
+                                    {"requests", required_argument, 0, 'r'},
+                                    {"depth", required_argument, 0, 'd'},
+                                    {"k", required_argument, 0, 'k'},
+                                    {0, 0, 0, 0}};
+  int c;
+  while ((c = getopt_long(argc, argv, "", options, NULL)) != -1) {
+    switch (c) {
+      case 'h': host = optarg; break;
+      case 'p': port = atoi(optarg); break;
+      case 'c': conns = atoi(optarg); break;
+      case 'r': requests = strtoull(optarg, NULL, 10); break;
+      case 'd': depth = strtoull(optarg, NULL, 10); break;
+      case 'k': k = strtoull(optarg, NULL, 10); break;
+      default:
+        fprintf(stderr,
+                "Using: %s [--host 127.0.0.1] [--port 20001] [--conns 100] "
+                "[--requests 1000] [--depth 1] [--k 10]\n",
+                argv[0]);
+        return 1;
+    }
+  }
+  if (conns <= 0 || requests == 0 || depth == 0) {
+    fprintf(stderr, "conns, requests and depth must be positive\n");
+    return 1;
+  }
+  if (depth > requests) depth = requests;
+
+  struct sockaddr_in server;
+  memset(&server, 0, sizeof(server));
+  server.sin_family = AF_INET;
+  server.sin_port = htons((uint16_t)port);
+  if (inet_pton(AF_INET, host, &server.sin_addr) <= 0) {
+    fprintf(stderr, "bad address %s\n", host);
+    return 1;
+  }
+
+  struct BenchConn *cs = calloc((size_t)conns, sizeof(*cs));
+  int ep = epoll_create1(0);
+  if (cs == NULL || ep < 0) {
+    perror("setup");
+    return 1;
+  }
+
+  for (int i = 0; i < conns; i++) {
+    cs[i].fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (cs[i].fd < 0 ||
+        connect(cs[i].fd, (struct sockaddr *)&server, sizeof(server)) < 0) {
+      fprintf(stderr, "connection %d failed: %s\n", i, strerror(errno));
+      return 1;
+    }
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = &cs[i]};
+    epoll_ctl(ep, EPOLL_CTL_ADD, cs[i].fd, &ev);
+  }
+
+  double start = Now();
+  for (int i = 0; i < conns; i++) {
+    if (SendRequests(&cs[i], depth, k) != 0) {
+      perror("send");
+      return 1;
+    }
+  }
+
+  uint64_t total = (uint64_t)conns * requests;
+  uint64_t done = 0;
+  struct epoll_event events[256];
+  while (done < total) {
+    int n = epoll_wait(ep, events, 256, 5000);
+    if (n == 0) {
+      fprintf(stderr, "timeout: %llu of %llu responses received\n",
+              (unsigned long long)done, (unsigned long long)total);
+      return 1;
+    }
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      perror("epoll_wait");
+      return 1;
+    }
+    for (int i = 0; i < n; i++) {
+      struct BenchConn *bc = events[i].data.ptr;
+      char buf[4096];
+      ssize_t got = recv(bc->fd, buf, sizeof(buf), MSG_DONTWAIT);
+      if (got <= 0) {
+        if (got < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+        fprintf(stderr, "server closed connection\n");
+        return 1;
+      }
+      uint64_t answers = (bc->partial + (size_t)got) / RESPONSE_SIZE;
+      bc->partial = (bc->partial + (size_t)got) % RESPONSE_SIZE;
+      bc->received += answers;
+      done += answers;
+      uint64_t in_flight = bc->sent - bc->received;
+      uint64_t left = requests - bc->sent;
+      uint64_t refill = depth - in_flight;
+      if (refill > left) refill = left;
+      if (refill > 0 && SendRequests(bc, refill, k) != 0) {
+        perror("send");
+        return 1;
+      }
+    }
+  }
+  double elapsed = Now() - start;
+
+  printf("connections: %d, requests: %llu, elapsed: %.3f s, %.0f req/s\n",
+         conns, (unsigned long long)total, elapsed, total / elapsed);
+
+  for (int i = 0; i < conns; i++) close(cs[i].fd);
+  close(ep);
+  free(cs);
+  return 0;
+}
@@ -0,0 +1,339 @@
+#define _GNU_SOURCE
+#include "metrics.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <netinet/in.h>
+
+#include "async_log.h"
+
+#define METRIC_CACHE_LINE 64
+#define HIST_SUB_BITS 4
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS (64 * HIST_SUB)
+#define STATS_REQUEST_MAX 4096
+
+struct Hist {
+  atomic_uint_fast64_t buckets[HIST_BUCKETS];
+  atomic_uint_fast64_t sum;
+};
+
+// Запись одного потока. Писатель всегда один, поэтому вместо fetch_add
+// хватает relaxed load + store; атомарность нужна только читателю.
+struct MetricSlot {
+  _Alignas(METRIC_CACHE_LINE) atomic_uint_fast64_t counters[METRIC_COUNTER_COUNT];
+  struct Hist hist[METRIC_HIST_COUNT];
+  atomic_int in_use;
+  struct MetricSlot *next;
+};
+
+// Записи не освобождаются: поток, завершаясь, отдаёт свою следующему,
+// и накопленные значения продолжают входить в сумму.
+static _Atomic(struct MetricSlot *) g_slots;
+static __thread struct MetricSlot *t_slot;
+static pthread_key_t g_slot_key;
+static pthread_once_t g_slot_once = PTHREAD_ONCE_INIT;
+static uint64_t g_start_ns;
+
+static const char *const kCounterNames[METRIC_COUNTER_COUNT] = {
+    "factorial_requests_total", "factorial_bad_requests_total",
+    "factorial_bytes_received_total", "factorial_bytes_sent_total"};
+static const char *const kCounterHelp[METRIC_COUNTER_COUNT] = {
+    "Requests answered", "Requests rejected (mod == 0)",
+    "Request bytes parsed", "Response bytes queued"};
+static const char *const kHistNames[METRIC_HIST_COUNT] = {
+    "factorial_queue_wait_seconds", "factorial_compute_seconds",
+    "factorial_recv_batch_bytes", "factorial_send_batch_bytes"};
+static const char *const kHistHelp[METRIC_HIST_COUNT] = {
+    "Time a range part waits for a worker", "Time to compute one request",
+    "Request bytes parsed per handler call (pipelining depth)",
+    "Response bytes queued per handler call"};
+// Делитель при выводе: задержки копятся в нс, выводятся в секундах.
+static const double kHistScale[METRIC_HIST_COUNT] = {1e9, 1e9, 1, 1};
+
+uint64_t MetricNowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void ReleaseSlot(void *slot) {
+  atomic_store_explicit(&((struct MetricSlot *)slot)->in_use, 0,
+                        memory_order_release);
+}
+
+static void InitSlots(void) {
+  pthread_key_create(&g_slot_key, ReleaseSlot);
+  g_start_ns = MetricNowNs();
+}
+
+static struct MetricSlot *AcquireSlot(void) {
+  pthread_once(&g_slot_once, InitSlots);
+  struct MetricSlot *slot;
+  for (slot = atomic_load_explicit(&g_slots, memory_order_acquire);
+       slot != NULL; slot = slot->next) {
+    int expected = 0;
+    if (atomic_compare_exchange_strong_explicit(&slot->in_use, &expected, 1,
+                                                memory_order_acquire,
+                                                memory_order_relaxed))
+      break;
+  }
+  if (slot == NULL) {
+    slot = aligned_alloc(METRIC_CACHE_LINE, sizeof(*slot));
+    if (slot == NULL) return NULL;
+    memset(slot, 0, sizeof(*slot));
+    atomic_init(&slot->in_use, 1);
+    slot->next = atomic_load_explicit(&g_slots, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(
+        &g_slots, &slot->next, slot, memory_order_release,
+        memory_order_relaxed)) {
+    }
+  }
+  pthread_setspecific(g_slot_key, slot);
+  return slot;
+}
+
+static inline struct MetricSlot *Slot(void) {
+  if (t_slot == NULL) t_slot = AcquireSlot();
+  return t_slot;
+}
+
+static inline void Bump(atomic_uint_fast64_t *value, uint64_t delta) {
+  atomic_store_explicit(
+      value, atomic_load_explicit(value, memory_order_relaxed) + delta,
+      memory_order_relaxed);
+}
+
+// Значения < 16 - точные корзины, дальше по 16 корзин на степень двойки.
+static unsigned HistIndex(uint64_t v) {
+  if (v < HIST_SUB) return (unsigned)v;
+  unsigned exp = 63 - (unsigned)__builtin_clzll(v);
+  unsigned sub = (unsigned)(v >> (exp - HIST_SUB_BITS)) & (HIST_SUB - 1);
+  return (exp - HIST_SUB_BITS + 1) * HIST_SUB + sub;
+}
+
+// Середина корзины - оценка значения при расчёте квантилей.
+static double HistValue(unsigned index) {
+  if (index < HIST_SUB) return index;
+  unsigned exp = index / HIST_SUB + HIST_SUB_BITS - 1;
+  uint64_t low = (uint64_t)(HIST_SUB + index % HIST_SUB) << (exp - HIST_SUB_BITS);
+  uint64_t width = 1ull << (exp - HIST_SUB_BITS);
+  if (width == 1) return (double)low;  // 16..31 - корзины тоже точные
+  return (double)low + (double)width / 2;
+}
+
+void MetricAdd(enum MetricCounter counter, uint64_t value) {
+  struct MetricSlot *slot = Slot();
+  if (slot != NULL) Bump(&slot->counters[counter], value);
+}
+
+void MetricRecordNs(enum MetricHist hist, uint64_t ns) {
+  struct MetricSlot *slot = Slot();
+  if (slot == NULL) return;
+  struct Hist *h = &slot->hist[hist];
+  Bump(&h->buckets[HistIndex(ns)], 1);
+  Bump(&h->sum, ns);
+}
+
+void MetricRecordBytes(enum MetricHist hist, uint64_t bytes) {
+  MetricRecordNs(hist, bytes);  // та же гистограмма, другая единица
+}
+
+static void WriteSummary(FILE *out, enum MetricHist hist) {
+  static const double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+  uint64_t *buckets = calloc(HIST_BUCKETS, sizeof(*buckets));
+  if (buckets == NULL) return;
+  uint64_t count = 0, sum = 0;
+  for (struct MetricSlot *slot = atomic_load_explicit(&g_slots, memory_order_acquire);
+       slot != NULL; slot = slot->next) {
+    const struct Hist *h = &slot->hist[hist];
+    for (unsigned i = 0; i < HIST_BUCKETS; i++)
+      buckets[i] += atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+    sum += atomic_load_explicit(&h->sum, memory_order_relaxed);
+  }
+  // count берётся из корзин, чтобы квантили не разошлись с ним при
+  // одновременной записи
+  for (unsigned i = 0; i < HIST_BUCKETS; i++) count += buckets[i];
+
+  const char *name = kHistNames[hist];
+  double scale = kHistScale[hist];
+  fprintf(out, "# HELP %s %s\n# TYPE %s summary\n", name, kHistHelp[hist],
+          name);
+  unsigned index = 0;
+  uint64_t seen = 0;
+  for (size_t q = 0; q < sizeof(kQuantiles) / sizeof(kQuantiles[0]); q++) {
+    uint64_t rank = (uint64_t)(kQuantiles[q] * (double)count);
+    if (rank == 0) rank = 1;
+    while (index < HIST_BUCKETS && seen + buckets[index] < rank)
+      seen += buckets[index++];
+    if (count == 0 || index == HIST_BUCKETS)
+      fprintf(out, "%s{quantile=\"%g\"} NaN\n", name, kQuantiles[q]);
+    else
+      fprintf(out, "%s{quantile=\"%g\"} %.*f\n", name, kQuantiles[q],
+              scale > 1 ? 9 : 1, HistValue(index) / scale);
+  }
+  fprintf(out, "%s_sum %.*f\n%s_count %llu\n", name, scale > 1 ? 9 : 0,
+          (double)sum / scale, name, (unsigned long long)count);
+  free(buckets);
+}
+
+void MetricsWrite(FILE *out) {
+  pthread_once(&g_slot_once, InitSlots);
+  for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+    uint64_t total = 0;
+    for (struct MetricSlot *slot = atomic_load_explicit(&g_slots, memory_order_acquire);
+         slot != NULL; slot = slot->next)
+      total += atomic_load_explicit(&slot->counters[c], memory_order_relaxed);
+    fprintf(out, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+            kCounterNames[c], kCounterHelp[c], kCounterNames[c],
+            kCounterNames[c], (unsigned long long)total);
+  }
+  for (int h = 0; h < METRIC_HIST_COUNT; h++) WriteSummary(out, (enum MetricHist)h);
+
+  int threads = 0;
+  for (struct MetricSlot *slot = atomic_load_explicit(&g_slots, memory_order_acquire);
+       slot != NULL; slot = slot->next)
+    threads++;
+  fprintf(out,
+          "# HELP factorial_metric_slots Per-thread metric records\n"
+          "# TYPE factorial_metric_slots gauge\nfactorial_metric_slots %d\n",
+          threads);
+  fprintf(out,
+          "# HELP factorial_log_dropped_total Log records dropped on a full ring\n"
+          "# TYPE factorial_log_dropped_total counter\n"
+          "factorial_log_dropped_total %llu\n",
+          (unsigned long long)AsyncLogDropped());
+  fprintf(out,
+          "# HELP factorial_uptime_seconds Seconds since the first metric\n"
+          "# TYPE factorial_uptime_seconds gauge\nfactorial_uptime_seconds %.3f\n",
+          (double)(MetricNowNs() - g_start_ns) / 1e9);
+}
+
+static struct {
+  int fd;
+  pthread_t thread;
+  atomic_int running;
+  char unix_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+} g_stats = {.fd = -1};
+
+// Тело собирается в памяти заранее, чтобы отдать Content-Length.
+static void ServeOne(int client) {
+  struct timeval timeout = {1, 0};
+  setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  // Читаем заголовки запроса (путь не важен) до пустой строки.
+  char request[STATS_REQUEST_MAX];
+  size_t got = 0;
+  while (got < sizeof(request) - 1) {
+    ssize_t n = recv(client, request + got, sizeof(request) - 1 - got, 0);
+    if (n <= 0) break;
+    got += (size_t)n;
+    request[got] = '\0';
+    if (strstr(request, "\r\n\r\n") != NULL || strstr(request, "\n\n") != NULL)
+      break;
+  }
+
+  char *body = NULL;
+  size_t body_len = 0;
+  FILE *out = open_memstream(&body, &body_len);
+  if (out == NULL) return;
+  MetricsWrite(out);
+  fclose(out);
+
+  char header[160];
+  int header_len = snprintf(header, sizeof(header),
+                            "HTTP/1.0 200 OK\r\n"
+                            "Content-Type: text/plain; version=0.0.4\r\n"
+                            "Content-Length: %zu\r\n\r\n",
+                            body_len);
+  send(client, header, (size_t)header_len, MSG_NOSIGNAL);
+  for (size_t sent = 0; sent < body_len;) {
+    ssize_t n = send(client, body + sent, body_len - sent, MSG_NOSIGNAL);
+    if (n <= 0) break;
+    sent += (size_t)n;
+  }
+  free(body);
+}
+
+static void *StatsMain(void *arg) {
+  (void)arg;
+  while (atomic_load(&g_stats.running)) {
+    int client = accept(g_stats.fd, NULL, NULL);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      break;  // сокет закрыт в MetricsStop
+    }
+    ServeOne(client);
+    close(client);
+  }
+  return NULL;
+}
+
+int MetricsServe(int port, const char *unix_path) {
+  pthread_once(&g_slot_once, InitSlots);
+  int fd;
+  if (unix_path != NULL) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(unix_path) >= sizeof(addr.sun_path)) {
+      fprintf(stderr, "Stats socket path is too long\n");
+      return -1;
+    }
+    strcpy(addr.sun_path, unix_path);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    unlink(unix_path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+      perror("bind stats socket");
+      close(fd);
+      return -1;
+    }
+    strcpy(g_stats.unix_path, unix_path);
+  } else {
+    struct sockaddr_in addr = {.sin_family = AF_INET};
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // только локально
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int opt_val = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt_val, sizeof(opt_val));
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+      perror("bind stats port");
+      close(fd);
+      return -1;
+    }
+  }
+  if (listen(fd, 16) < 0) {
+    perror("listen stats");
+    close(fd);
+    return -1;
+  }
+
+  g_stats.fd = fd;
+  atomic_store(&g_stats.running, 1);
+  if (pthread_create(&g_stats.thread, NULL, StatsMain, NULL) != 0) {
+    atomic_store(&g_stats.running, 0);
+    close(fd);
+    g_stats.fd = -1;
+    return -1;
+  }
+  return 0;
+}
+
+void MetricsStop(void) {
+  if (!atomic_load(&g_stats.running)) return;
+  atomic_store(&g_stats.running, 0);
+  // shutdown будит accept в потоке статистики
+  shutdown(g_stats.fd, SHUT_RDWR);
+  pthread_join(g_stats.thread, NULL);
+  close(g_stats.fd);
+  g_stats.fd = -1;
+  if (g_stats.unix_path[0] != '\0') unlink(g_stats.unix_path);
+}
@@ -0,0 +1,42 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Метрики сервера факториалов. Каждый поток пишет только в свою запись
+// (без атомарных RMW и общих кэш-линий), чтение суммирует записи всех
+// потоков в момент запроса. Задержки и размеры копятся в
+// HDR-гистограммах: 16 корзин на каждую степень двойки, относительная
+// ошибка < 1/16.
+
+enum MetricCounter {
+  METRIC_REQUESTS,
+  METRIC_BAD_REQUESTS,
+  METRIC_BYTES_IN,
+  METRIC_BYTES_OUT,
+  METRIC_COUNTER_COUNT
+};
+
+enum MetricHist {
+  METRIC_QUEUE_WAIT,  // от постановки части диапазона до начала счёта
+  METRIC_COMPUTE,     // счёт всего запроса
+  METRIC_RECV_BYTES,  // байт запросов, разобранных за один вызов обработчика
+  METRIC_SEND_BYTES,  // байт ответов, поставленных за тот же вызов
+  METRIC_HIST_COUNT
+};
+
+uint64_t MetricNowNs(void);
+void MetricAdd(enum MetricCounter counter, uint64_t value);
+void MetricRecordNs(enum MetricHist hist, uint64_t ns);
+void MetricRecordBytes(enum MetricHist hist, uint64_t bytes);
+
+// Сводка всех потоков в текстовом формате Prometheus.
+void MetricsWrite(FILE *out);
+
+// Поток, отдающий MetricsWrite по HTTP на 127.0.0.1:port (port > 0)
+// или на Unix-сокете unix_path (не NULL).
+int MetricsServe(int port, const char *unix_path);
+void MetricsStop(void);
+
+#endif
@@ -1,10 +1,12 @@
 #include <limits.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include <arpa/inet.h>
 #include <getopt.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
@@ -13,10 +15,19 @@
 
 #include "pthread.h"
 
+#include "async_log.h"
+#include "event_loop.h"
+#include "metrics.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+#define REQUEST_SIZE (sizeof(uint64_t) * 3)
+
 struct FactorialArgs {
   uint64_t begin;
   uint64_t end;
   uint64_t mod;
+  uint64_t submitted_ns;  // момент постановки в очередь/создания потока
 };
 
 uint64_t MultModulo(uint64_t a, uint64_t b, uint64_t mod) {
@@ -35,25 +46,217 @@ uint64_t MultModulo(uint64_t a, uint64_t b, uint64_t mod) {
 uint64_t Factorial(const struct FactorialArgs *args) {
   uint64_t ans = 1;
 
-  // TODO: your code here
+  for (uint64_t i = args->begin ? args->begin : 1; i <= args->end; i++) {
+    ans = MultModulo(ans, i, args->mod);
+    if (ans == 0 || i == UINT64_MAX)
+      break;
+  }
+
+  return ans % args->mod;
+}
+
+struct ServerConfig {
+  int tnum;
+  struct ThreadPool *pool;  // NULL - потоки на каждый запрос
+};
+
+struct FactorialTask {
+  struct PoolTask task;  // первым полем: пул передаёт указатель на него
+  struct FactorialArgs args;
+  uint64_t result;
+};
 
-  return ans;
+static void PoolFactorial(struct PoolTask *task) {
+  struct FactorialTask *ftask = (struct FactorialTask *)task;
+  MetricRecordNs(METRIC_QUEUE_WAIT, MetricNowNs() - ftask->args.submitted_ns);
+  TraceBegin("factorial part");
+  ftask->result = Factorial(&ftask->args);
+  TraceEnd("factorial part");
 }
 
 void *ThreadFactorial(void *args) {
   struct FactorialArgs *fargs = (struct FactorialArgs *)args;
-  return (void *)(uint64_t *)Factorial(fargs);
+  MetricRecordNs(METRIC_QUEUE_WAIT, MetricNowNs() - fargs->submitted_ns);
+  TraceBegin("factorial part");
+  uint64_t result = Factorial(fargs);
+  TraceEnd("factorial part");
+  return (void *)(uint64_t *)result;
+}
+
+// Части диапазона отдаются постоянным потокам пула через очередь без
+// блокировок; поток цикла событий тоже считает, пока ждёт.
+static void ComputeRangePool(uint64_t begin, uint64_t end, uint64_t mod,
+                             int tnum, struct ThreadPool *pool,
+                             uint64_t *total) {
+  struct FactorialTask tasks[tnum];
+  struct TaskGroup group;
+  TaskGroupInit(&group);
+  uint64_t length = end - begin + 1;
+  uint64_t chunk = length / tnum;
+  uint64_t remainder = length % tnum;
+  uint64_t current = begin;
+  for (int i = 0; i < tnum; i++) {
+    uint64_t len = chunk + ((uint64_t)i < remainder ? 1 : 0);
+    tasks[i].args.begin = len ? current : 1;
+    tasks[i].args.end = len ? current + len - 1 : 0;
+    tasks[i].args.mod = mod;
+    tasks[i].args.submitted_ns = MetricNowNs();
+    current += len;
+    ThreadPoolSubmit(pool, &group, &tasks[i].task, PoolFactorial);
+  }
+  ThreadPoolWait(pool, &group);
+
+  *total = 1 % mod;
+  for (int i = 0; i < tnum; i++)
+    *total = MultModulo(*total, tasks[i].result, mod);
+}
+
+// Считает произведение [begin, end] по модулю mod, деля диапазон на tnum
+// потоков. При tnum == 1 считает прямо в потоке цикла событий.
+static int ComputeRange(uint64_t begin, uint64_t end, uint64_t mod, int tnum,
+                        struct ThreadPool *pool, uint64_t *total) {
+  if (tnum == 1 || begin > end) {
+    struct FactorialArgs args = {begin, end, mod, 0};
+    *total = begin > end ? 1 % mod : Factorial(&args);
+    return 0;
+  }
+  if (pool != NULL) {
+    ComputeRangePool(begin, end, mod, tnum, pool, total);
+    return 0;
+  }
+
+  pthread_t threads[tnum];
+  struct FactorialArgs args[tnum];
+  uint64_t length = end - begin + 1;
+  uint64_t chunk = length / tnum;
+  uint64_t remainder = length % tnum;
+  uint64_t current = begin;
+  for (int i = 0; i < tnum; i++) {
+    uint64_t len = chunk + ((uint64_t)i < remainder ? 1 : 0);
+    args[i].begin = len ? current : 1;
+    args[i].end = len ? current + len - 1 : 0;
+    args[i].mod = mod;
+    args[i].submitted_ns = MetricNowNs();
+    current += len;
+
+    if (pthread_create(&threads[i], NULL, ThreadFactorial, (void *)&args[i])) {
+      LOG_ERROR("Error: pthread_create failed!\n");
+      for (int j = 0; j < i; j++)
+        pthread_join(threads[j], NULL);
+      return -1;
+    }
+  }
+
+  *total = 1 % mod;
+  for (int i = 0; i < tnum; i++) {
+    uint64_t result = 0;
+    pthread_join(threads[i], (void **)&result);
+    *total = MultModulo(*total, result, mod);
+  }
+  return 0;
+}
+
+// Разбирает все полные запросы из буфера соединения и ставит ответы в очередь.
+static size_t HandleRequests(struct LoopConn *conn, const char *data,
+                             size_t len, void *user) {
+  const struct ServerConfig *config = user;
+  size_t consumed = 0;
+  size_t sent = 0;
+
+  while (len - consumed >= REQUEST_SIZE) {
+    const char *from_client = data + consumed;
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    uint64_t mod = 0;
+    memcpy(&begin, from_client, sizeof(uint64_t));
+    memcpy(&end, from_client + sizeof(uint64_t), sizeof(uint64_t));
+    memcpy(&mod, from_client + 2 * sizeof(uint64_t), sizeof(uint64_t));
+    consumed += REQUEST_SIZE;
+
+    MetricAdd(METRIC_BYTES_IN, REQUEST_SIZE);
+
+    // Лог пишет отдельный поток: путь запроса не ждёт stdout.
+    LOG_INFO("Receive: %llu %llu %llu\n", (unsigned long long)begin,
+             (unsigned long long)end, (unsigned long long)mod);
+
+    // На mod == 0 ответа нет: закрываем соединение, иначе клиент ждал бы
+    // вечно, а следующие ответы сдвинулись бы на один запрос.
+    if (mod == 0) {
+      MetricAdd(METRIC_BAD_REQUESTS, 1);
+      LOG_WARN("Client send wrong data format\n");
+      LoopClose(conn);
+      break;
+    }
+
+    uint64_t total = 1;
+    uint64_t started = MetricNowNs();
+    TraceBeginArg("compute", "end", (int64_t)end);
+    int computed =
+        ComputeRange(begin, end, mod, config->tnum, config->pool, &total);
+    TraceEnd("compute");
+    if (computed != 0) continue;
+    MetricRecordNs(METRIC_COMPUTE, MetricNowNs() - started);
+    MetricAdd(METRIC_REQUESTS, 1);
+    MetricAdd(METRIC_BYTES_OUT, sizeof(total));
+
+    LOG_INFO("Total: %llu\n", (unsigned long long)total);
+
+    char buffer[sizeof(total)];
+    memcpy(buffer, &total, sizeof(total));
+    LoopSend(conn, buffer, sizeof(total));
+    sent += sizeof(total);
+  }
+
+  // Сколько запросов клиент прислал одной порцией - видно по размерам
+  if (consumed > 0) {
+    MetricRecordBytes(METRIC_RECV_BYTES, consumed);
+    MetricRecordBytes(METRIC_SEND_BYTES, sent);
+  }
+  return consumed;
+}
+
+// Строка на каждое соединение, как у сервера до цикла событий, - тоже
+// через асинхронный лог.
+static void LogConnection(struct LoopConn *conn, int opened, void *user) {
+  (void)user;
+  int fd = LoopConnFd(conn);
+  if (!opened) {
+    LOG_INFO("Connection %d closed\n", fd);
+    return;
+  }
+  struct sockaddr_in peer;
+  socklen_t peer_len = sizeof(peer);
+  char host[INET_ADDRSTRLEN] = "?";
+  unsigned port = 0;
+  if (getpeername(fd, (struct sockaddr *)&peer, &peer_len) == 0) {
+    inet_ntop(AF_INET, &peer.sin_addr, host, sizeof(host));
+    port = ntohs(peer.sin_port);
+  }
+  LOG_INFO("Connection %d from %s:%u\n", fd, host, port);
+}
+
+static void OnSignal(int sig) {
+  (void)sig;
+  LoopStop();
 }
 
 int main(int argc, char **argv) {
   int tnum = -1;
   int port = -1;
+  enum LoopBackend backend = LOOP_BACKEND_EPOLL;
+  bool use_pool = true;
+  int stats_port = -1;
+  const char *stats_socket = NULL;
 
   while (true) {
     int current_optind = optind ? optind : 1;
 
     static struct option options[] = {{"port", required_argument, 0, 0},
                                       {"tnum", required_argument, 0, 0},
+                                      {"backend", required_argument, 0, 0},
+                                      {"dispatch", required_argument, 0, 0},
+                                      {"stats_port", required_argument, 0, 0},
+                                      {"stats_socket", required_argument, 0, 0},
                                       {0, 0, 0, 0}};
 
     int option_index = 0;
@@ -73,6 +276,32 @@ int main(int argc, char **argv) {
         tnum = atoi(optarg);
         // TODO: your code here
         break;
+      case 2:
+        if (ParseLoopBackend(optarg, &backend) != 0) {
+          fprintf(stderr, "Unknown backend %s, use epoll or uring\n", optarg);
+          return 1;
+        }
+        break;
+      case 3:
+        if (strcmp(optarg, "pool") == 0) {
+          use_pool = true;
+        } else if (strcmp(optarg, "threads") == 0) {
+          use_pool = false;
+        } else {
+          fprintf(stderr, "Unknown dispatch %s, use pool or threads\n", optarg);
+          return 1;
+        }
+        break;
+      case 4:
+        stats_port = atoi(optarg);
+        if (stats_port <= 0 || stats_port > 65535) {
+          fprintf(stderr, "stats_port must be in 1..65535\n");
+          return 1;
+        }
+        break;
+      case 5:
+        stats_socket = optarg;
+        break;
       default:
         printf("Index %d is out of options\n", option_index);
       }
@@ -86,8 +315,12 @@ int main(int argc, char **argv) {
     }
   }
 
-  if (port == -1 || tnum == -1) {
-    fprintf(stderr, "Using: %s --port 20001 --tnum 4\n", argv[0]);
+  if (port == -1 || tnum <= 0) {
+    fprintf(stderr,
+            "Using: %s --port 20001 --tnum 4 [--backend epoll|uring] "
+            "[--dispatch pool|threads]\n"
+            "       [--stats_port N | --stats_socket path]\n",
+            argv[0]);
     return 1;
   }
 
@@ -111,86 +344,56 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  err = listen(server_fd, 128);
+  err = listen(server_fd, SOMAXCONN);
   if (err < 0) {
     fprintf(stderr, "Could not listen on socket\n");
     return 1;
   }
 
-  printf("Server listening at %d\n", port);
-
-  while (true) {
-    struct sockaddr_in client;
-    socklen_t client_len = sizeof(client);
-    int client_fd = accept(server_fd, (struct sockaddr *)&client, &client_len);
-
-    if (client_fd < 0) {
-      fprintf(stderr, "Could not establish new connection\n");
-      continue;
-    }
-
-    while (true) {
-      unsigned int buffer_size = sizeof(uint64_t) * 3;
-      char from_client[buffer_size];
-      int read = recv(client_fd, from_client, buffer_size, 0);
-
-      if (!read)
-        break;
-      if (read < 0) {
-        fprintf(stderr, "Client read failed\n");
-        break;
-      }
-      if (read < buffer_size) {
-        fprintf(stderr, "Client send wrong data format\n");
-        break;
-      }
-
-      pthread_t threads[tnum];
-
-      uint64_t begin = 0;
-      uint64_t end = 0;
-      uint64_t mod = 0;
-      memcpy(&begin, from_client, sizeof(uint64_t));
-      memcpy(&end, from_client + sizeof(uint64_t), sizeof(uint64_t));
-      memcpy(&mod, from_client + 2 * sizeof(uint64_t), sizeof(uint64_t));
-
-      fprintf(stdout, "Receive: %llu %llu %llu\n", begin, end, mod);
-
-      struct FactorialArgs args[tnum];
-      for (uint32_t i = 0; i < tnum; i++) {
-        // TODO: parallel somehow
-        args[i].begin = 1;
-        args[i].end = 1;
-        args[i].mod = mod;
-
-        if (pthread_create(&threads[i], NULL, ThreadFactorial,
-                           (void *)&args[i])) {
-          printf("Error: pthread_create failed!\n");
-          return 1;
-        }
-      }
-
-      uint64_t total = 1;
-      for (uint32_t i = 0; i < tnum; i++) {
-        uint64_t result = 0;
-        pthread_join(threads[i], (void **)&result);
-        total = MultModulo(total, result, mod);
-      }
-
-      printf("Total: %llu\n", total);
-
-      char buffer[sizeof(total)];
-      memcpy(buffer, &total, sizeof(total));
-      err = send(client_fd, buffer, sizeof(total), 0);
-      if (err < 0) {
-        fprintf(stderr, "Can't send data to client\n");
-        break;
-      }
-    }
+  if ((stats_port > 0 || stats_socket != NULL) &&
+      MetricsServe(stats_port, stats_socket) != 0) {
+    fprintf(stderr, "Can not start stats endpoint\n");
+    return 1;
+  }
 
-    shutdown(client_fd, SHUT_RDWR);
-    close(client_fd);
+  printf("Server listening at %d (%s)\n", port, LoopBackendName(backend));
+  if (stats_socket != NULL)
+    printf("Metrics at unix:%s\n", stats_socket);
+  else if (stats_port > 0)
+    printf("Metrics at http://127.0.0.1:%d/metrics\n", stats_port);
+  fflush(stdout);
+
+  // TRACE_FILE=trace.json: фазы запросов для Perfetto, пишутся при выходе
+  TraceInitFromEnv("factorial server");
+
+  struct AsyncLogOptions log_opts;
+  AsyncLogDefaultOptions(&log_opts);
+  if (AsyncLogStart(&log_opts) != 0)
+    fprintf(stderr, "Async log unavailable, logging synchronously\n");
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = OnSignal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  // Пул создаётся один раз; поток цикла событий тоже считает, поэтому
+  // рабочих на один меньше, чем tnum.
+  struct ServerConfig config = {tnum, NULL};
+  if (use_pool && tnum > 1) {
+    config.pool = ThreadPoolCreate(tnum - 1, 4 * (size_t)tnum);
+    if (config.pool == NULL)
+      fprintf(stderr, "Thread pool unavailable, using per-request threads\n");
   }
 
-  return 0;
+  LoopSetConnHandler(LogConnection, NULL);
+  err = RunStreamServer(server_fd, backend, HandleRequests, &config);
+  LoopPrintStats(LoopBackendName(backend));
+  ThreadPoolDestroy(config.pool);
+  MetricsStop();
+  AsyncLogStop();
+  close(server_fd);
+
+  return err < 0 ? 1 : 0;
 }
@@ -0,0 +1,484 @@
+#define _GNU_SOURCE
+#include "rudp.h"
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+enum { PKT_DATA = 1, PKT_ACK = 2 };
+#define FLAG_FIN 1
+
+#define SACK_BITS 64
+#define DUP_THRESH 3
+#define INITIAL_CWND 10.0
+#define MD_FACTOR 0.7  // во сколько раз уменьшать окно при потере
+#define MIN_RTO_NS 2000000ULL
+#define MAX_RTO_NS 1000000000ULL
+#define GIVE_UP_NS 10000000000ULL
+#define LINGER_NS 1000000000ULL
+
+struct DataHeader {
+  uint8_t type;
+  uint8_t flags;
+  uint16_t len;
+  uint32_t session;
+  uint32_t seq;
+  uint32_t reserved;
+  uint64_t ts;  // время отправки, возвращается в ACK как есть
+};
+
+struct AckPacket {
+  uint8_t type;
+  uint8_t reserved[3];
+  uint32_t session;
+  uint32_t cum;  // все пакеты < cum получены
+  uint32_t reserved2;
+  uint64_t sack;  // бит i - получен пакет cum + 1 + i
+  uint64_t ts_echo;
+};
+
+#define PACKET_MAX (sizeof(struct DataHeader) + RUDP_PAYLOAD)
+
+static uint64_t NowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void RudpDefaultOptions(struct RudpOptions *opts) {
+  opts->loss = 0.0;
+  opts->reorder = 0.0;
+  opts->window = RUDP_MAX_WINDOW;
+}
+
+void RudpPrintStats(const char *role, const struct RudpStats *stats) {
+  double mb = stats->bytes / (1024.0 * 1024.0);
+  printf("%s: %llu bytes in %.3f s (%.2f MiB/s), packets: %llu, "
+         "retransmits: %llu, simulated drops: %llu\n",
+         role, (unsigned long long)stats->bytes, stats->seconds,
+         stats->seconds > 0 ? mb / stats->seconds : 0.0,
+         (unsigned long long)stats->packets_sent,
+         (unsigned long long)stats->retransmits,
+         (unsigned long long)stats->dropped);
+}
+
+// --- канал с симуляцией потерь и перестановок ---
+
+struct Link {
+  int fd;
+  const struct RudpOptions *opts;
+  struct RudpStats *stats;
+  unsigned seed;
+  char held[PACKET_MAX];
+  size_t held_len;
+  struct sockaddr_in held_to;
+};
+
+static double LinkRand(struct Link *link) {
+  return rand_r(&link->seed) / ((double)RAND_MAX + 1.0);
+}
+
+static void LinkFlush(struct Link *link) {
+  if (link->held_len == 0) return;
+  sendto(link->fd, link->held, link->held_len, 0,
+         (struct sockaddr *)&link->held_to, sizeof(link->held_to));
+  link->held_len = 0;
+}
+
+static void LinkSend(struct Link *link, const void *buf, size_t len,
+                     const struct sockaddr_in *to) {
+  link->stats->packets_sent++;
+  if (link->opts->loss > 0 && LinkRand(link) < link->opts->loss) {
+    link->stats->dropped++;
+    return;
+  }
+  if (link->opts->reorder > 0 && link->held_len == 0 &&
+      LinkRand(link) < link->opts->reorder) {
+    memcpy(link->held, buf, len);
+    link->held_len = len;
+    link->held_to = *to;
+    return;
+  }
+  if (sendto(link->fd, buf, len, 0, (const struct sockaddr *)to,
+             sizeof(*to)) < 0 &&
+      errno != ENOBUFS && errno != EAGAIN)
+    perror("sendto");
+  LinkFlush(link);
+}
+
+static void LinkInit(struct Link *link, int fd, const struct RudpOptions *opts,
+                     struct RudpStats *stats) {
+  memset(link, 0, sizeof(*link));
+  link->fd = fd;
+  link->opts = opts;
+  link->stats = stats;
+  link->seed = (unsigned)(NowNs() ^ (uint64_t)getpid());
+}
+
+// --- отправитель ---
+
+struct Slot {
+  uint64_t sent_at;
+  uint16_t len;
+  uint8_t sacked;
+  uint8_t lost;  // уже перепослан быстрым повтором
+  char pkt[PACKET_MAX];
+};
+
+struct Sender {
+  struct Link link;
+  const struct sockaddr_in *peer;
+  int file_fd;
+  uint32_t session;
+  struct Slot *slots;
+  uint32_t window;
+  uint32_t total;  // число пакетов в файле
+  uint32_t base;   // первый неподтверждённый
+  uint32_t next;   // следующий новый
+  uint32_t high_sack;
+  uint32_t fr_scan;  // до куда проверены кандидаты на быстрый повтор
+  uint32_t recovery_until;
+  double cwnd;
+  double ssthresh;
+  uint64_t srtt;
+  uint64_t rttvar;
+  uint64_t rto;
+  uint64_t last_progress;
+  uint64_t last_timeout;
+};
+
+static struct Slot *SlotOf(struct Sender *s, uint32_t seq) {
+  return &s->slots[seq & (RUDP_MAX_WINDOW - 1)];
+}
+
+static void Transmit(struct Sender *s, uint32_t seq, uint64_t now) {
+  struct Slot *slot = SlotOf(s, seq);
+  struct DataHeader *hdr = (struct DataHeader *)slot->pkt;
+  hdr->ts = now;
+  slot->sent_at = now;
+  LinkSend(&s->link, slot->pkt, sizeof(*hdr) + slot->len, s->peer);
+}
+
+static void Retransmit(struct Sender *s, uint32_t seq, uint64_t now) {
+  s->link.stats->retransmits++;
+  Transmit(s, seq, now);
+}
+
+static int LoadSlot(struct Sender *s, uint32_t seq) {
+  struct Slot *slot = SlotOf(s, seq);
+  struct DataHeader *hdr = (struct DataHeader *)slot->pkt;
+  ssize_t n = pread(s->file_fd, slot->pkt + sizeof(*hdr), RUDP_PAYLOAD,
+                    (off_t)seq * RUDP_PAYLOAD);
+  if (n < 0) {
+    perror("pread");
+    return -1;
+  }
+  memset(hdr, 0, sizeof(*hdr));
+  hdr->type = PKT_DATA;
+  hdr->flags = (seq == s->total - 1) ? FLAG_FIN : 0;
+  hdr->len = htons((uint16_t)n);
+  hdr->session = htonl(s->session);
+  hdr->seq = htonl(seq);
+  slot->len = (uint16_t)n;
+  slot->sacked = 0;
+  slot->lost = 0;
+  s->link.stats->bytes += (uint64_t)n;
+  return 0;
+}
+
+static void OnLoss(struct Sender *s, uint32_t seq) {
+  // окно уменьшается один раз на окно данных
+  if (seq < s->recovery_until) return;
+  s->ssthresh = s->cwnd * MD_FACTOR;
+  if (s->ssthresh < 2) s->ssthresh = 2;
+  s->cwnd = s->ssthresh;
+  s->recovery_until = s->next;
+}
+
+static void UpdateRtt(struct Sender *s, uint64_t sample) {
+  if (s->srtt == 0) {
+    s->srtt = sample;
+    s->rttvar = sample / 2;
+  } else {
+    uint64_t diff = sample > s->srtt ? sample - s->srtt : s->srtt - sample;
+    s->rttvar = (3 * s->rttvar + diff) / 4;
+    s->srtt = (7 * s->srtt + sample) / 8;
+  }
+  s->rto = s->srtt + 4 * s->rttvar;
+  if (s->rto < MIN_RTO_NS) s->rto = MIN_RTO_NS;
+  if (s->rto > MAX_RTO_NS) s->rto = MAX_RTO_NS;
+}
+
+static void OnAck(struct Sender *s, const struct AckPacket *ack,
+                  uint64_t now) {
+  if (ack->type != PKT_ACK || ntohl(ack->session) != s->session) return;
+  uint32_t cum = ntohl(ack->cum);
+  uint64_t sack = be64toh(ack->sack);
+  if (cum > s->next) return;
+
+  if (ack->ts_echo != 0 && ack->ts_echo <= now) UpdateRtt(s, now - ack->ts_echo);
+
+  uint32_t newly = 0;
+  while (s->base < cum) {
+    if (!SlotOf(s, s->base)->sacked) newly++;
+    s->base++;
+  }
+  for (int i = 0; i < SACK_BITS && sack != 0; i++) {
+    uint32_t seq = cum + 1 + (uint32_t)i;
+    if (!(sack & (1ULL << i)) || seq >= s->next) continue;
+    struct Slot *slot = SlotOf(s, seq);
+    if (!slot->sacked) {
+      slot->sacked = 1;
+      newly++;
+    }
+    if (seq + 1 > s->high_sack) s->high_sack = seq + 1;
+  }
+
+  if (newly > 0) {
+    s->last_progress = now;
+    for (uint32_t i = 0; i < newly; i++)
+      s->cwnd += s->cwnd < s->ssthresh ? 1.0 : 1.0 / s->cwnd;
+    if (s->cwnd > s->window) s->cwnd = s->window;
+  }
+
+  // Быстрый повтор: пакет считается потерянным, если после него
+  // подтверждено не меньше DUP_THRESH пакетов.
+  if (s->fr_scan < s->base) s->fr_scan = s->base;
+  while (s->high_sack >= DUP_THRESH && s->fr_scan < s->high_sack - DUP_THRESH) {
+    struct Slot *slot = SlotOf(s, s->fr_scan);
+    if (!slot->sacked && !slot->lost) {
+      slot->lost = 1;
+      OnLoss(s, s->fr_scan);
+      Retransmit(s, s->fr_scan, now);
+    }
+    s->fr_scan++;
+  }
+}
+
+// Повтор по таймеру для пакетов, на которые так и не пришло подтверждение.
+static void CheckTimeouts(struct Sender *s, uint64_t now) {
+  int fired = 0;
+  for (uint32_t seq = s->base; seq < s->next; seq++) {
+    struct Slot *slot = SlotOf(s, seq);
+    if (slot->sacked || now - slot->sent_at < s->rto) continue;
+    fired = 1;
+    Retransmit(s, seq, now);
+  }
+  if (fired && now - s->last_timeout >= s->rto) {
+    s->last_timeout = now;
+    s->ssthresh = s->cwnd / 2 < 2 ? 2 : s->cwnd / 2;
+    s->cwnd = 2;
+    s->recovery_until = s->next;
+    s->rto = s->rto * 2 > MAX_RTO_NS ? MAX_RTO_NS : s->rto * 2;
+  }
+}
+
+int RudpSendFile(int sockfd, const struct sockaddr_in *peer, int file_fd,
+                 const struct RudpOptions *opts, struct RudpStats *stats) {
+  struct stat st;
+  if (fstat(file_fd, &st) < 0) {
+    perror("fstat");
+    return -1;
+  }
+
+  memset(stats, 0, sizeof(*stats));
+  struct Sender s;
+  memset(&s, 0, sizeof(s));
+  LinkInit(&s.link, sockfd, opts, stats);
+  s.peer = peer;
+  s.file_fd = file_fd;
+  s.session = (uint32_t)(NowNs() ^ ((uint64_t)getpid() << 16)) | 1;
+  s.window = opts->window > 0 && opts->window <= RUDP_MAX_WINDOW
+                 ? (uint32_t)opts->window
+                 : RUDP_MAX_WINDOW;
+  uint64_t packets = ((uint64_t)st.st_size + RUDP_PAYLOAD - 1) / RUDP_PAYLOAD;
+  if (packets == 0) packets = 1;  // пустой файл - один пакет с FIN
+  if (packets > UINT32_MAX) {
+    fprintf(stderr, "file is too large\n");
+    return -1;
+  }
+  s.total = (uint32_t)packets;
+  s.cwnd = INITIAL_CWND;
+  s.ssthresh = s.window;
+  s.rto = 200000000ULL;
+  s.slots = malloc(sizeof(struct Slot) * RUDP_MAX_WINDOW);
+  if (s.slots == NULL) {
+    perror("malloc");
+    return -1;
+  }
+
+  uint64_t start = NowNs();
+  s.last_progress = start;
+  uint64_t next_scan = start;
+  int rc = 0;
+
+  while (s.base < s.total) {
+    uint64_t now = NowNs();
+    uint32_t limit = (uint32_t)s.cwnd;
+    while (s.next < s.total && s.next - s.base < limit) {
+      if (LoadSlot(&s, s.next) != 0) {
+        rc = -1;
+        goto out;
+      }
+      Transmit(&s, s.next, now);
+      s.next++;
+    }
+
+    struct pollfd pfd = {sockfd, POLLIN, 0};
+    int timeout_ms = (int)(s.rto / 4000000ULL) + 1;
+    int ready = poll(&pfd, 1, timeout_ms);
+    if (ready < 0 && errno != EINTR) {
+      perror("poll");
+      rc = -1;
+      break;
+    }
+    if (ready == 0) LinkFlush(&s.link);
+
+    now = NowNs();
+    while (1) {
+      struct AckPacket ack;
+      ssize_t n = recvfrom(sockfd, &ack, sizeof(ack), MSG_DONTWAIT, NULL, NULL);
+      if (n < 0) break;
+      if ((size_t)n == sizeof(ack)) OnAck(&s, &ack, now);
+    }
+
+    if (now >= next_scan) {
+      CheckTimeouts(&s, now);
+      next_scan = now + s.rto / 4;
+    }
+    if (now - s.last_progress > GIVE_UP_NS) {
+      fprintf(stderr, "peer is not responding, giving up\n");
+      rc = -1;
+      break;
+    }
+  }
+
+out:
+  LinkFlush(&s.link);
+  stats->seconds = (NowNs() - start) / 1e9;
+  free(s.slots);
+  return rc;
+}
+
+// --- получатель ---
+
+int RudpRecvFile(int sockfd, int file_fd, const struct RudpOptions *opts,
+                 struct RudpStats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  struct Link link;
+  LinkInit(&link, sockfd, opts, stats);
+
+  uint8_t *got = NULL;  // got[seq] - пакет уже записан
+  size_t cap = 0;
+  uint32_t cum = 0;
+  uint32_t fin_seq = UINT32_MAX;
+  uint32_t session = 0;
+  struct sockaddr_in peer;
+  uint64_t start = 0;
+  uint64_t done_at = 0;
+  char pkt[PACKET_MAX];
+  int rc = 0;
+
+  while (1) {
+    struct pollfd pfd = {sockfd, POLLIN, 0};
+    int timeout_ms = -1;
+    if (done_at) timeout_ms = (int)(LINGER_NS / 1000000ULL);
+    else if (start) timeout_ms = (int)(GIVE_UP_NS / 1000000ULL);
+    int ready = poll(&pfd, 1, timeout_ms);
+    if (ready < 0) {
+      if (errno == EINTR) continue;
+      perror("poll");
+      rc = -1;
+      break;
+    }
+    if (ready == 0) {
+      LinkFlush(&link);
+      if (!done_at) {
+        fprintf(stderr, "sender is not responding, giving up\n");
+        rc = -1;
+      }
+      break;
+    }
+
+    struct sockaddr_in from;
+    socklen_t from_len = sizeof(from);
+    ssize_t n = recvfrom(sockfd, pkt, sizeof(pkt), 0, (struct sockaddr *)&from,
+                         &from_len);
+    if (n < (ssize_t)sizeof(struct DataHeader)) continue;
+    struct DataHeader *hdr = (struct DataHeader *)pkt;
+    uint16_t len = ntohs(hdr->len);
+    if (hdr->type != PKT_DATA || len > RUDP_PAYLOAD ||
+        (size_t)n != sizeof(*hdr) + len)
+      continue;
+
+    if (session == 0) {
+      session = ntohl(hdr->session);
+      peer = from;
+      start = NowNs();
+    } else if (ntohl(hdr->session) != session) {
+      continue;
+    }
+
+    // Отправитель не уходит дальше окна от подтверждённого и не шлёт
+    // ничего после FIN: остальное - мусор, под который нельзя растить got.
+    uint32_t seq = ntohl(hdr->seq);
+    if ((uint64_t)seq >= (uint64_t)cum + RUDP_MAX_WINDOW ||
+        (fin_seq != UINT32_MAX && seq > fin_seq))
+      continue;
+    if (seq >= cap) {
+      size_t new_cap = cap ? cap : 1024;
+      while (new_cap <= seq) new_cap *= 2;
+      uint8_t *p = realloc(got, new_cap);
+      if (p == NULL) {
+        perror("realloc");
+        rc = -1;
+        break;
+      }
+      memset(p + cap, 0, new_cap - cap);
+      got = p;
+      cap = new_cap;
+    }
+    if (!got[seq]) {
+      if (pwrite(file_fd, pkt + sizeof(*hdr), len, (off_t)seq * RUDP_PAYLOAD) !=
+          (ssize_t)len) {
+        perror("pwrite");
+        rc = -1;
+        break;
+      }
+      got[seq] = 1;
+      stats->bytes += len;
+      if (hdr->flags & FLAG_FIN) fin_seq = seq;
+    }
+    while (cum < cap && got[cum]) cum++;
+
+    struct AckPacket ack;
+    memset(&ack, 0, sizeof(ack));
+    ack.type = PKT_ACK;
+    ack.session = htonl(session);
+    ack.cum = htonl(cum);
+    uint64_t sack = 0;
+    for (int i = 0; i < SACK_BITS; i++) {
+      size_t s = (size_t)cum + 1 + (size_t)i;
+      if (s < cap && got[s]) sack |= 1ULL << i;
+    }
+    ack.sack = htobe64(sack);
+    ack.ts_echo = hdr->ts;
+    LinkSend(&link, &ack, sizeof(ack), &peer);
+
+    if (!done_at && fin_seq != UINT32_MAX && cum > fin_seq) {
+      done_at = NowNs();
+      stats->seconds = (done_at - start) / 1e9;
+    }
+  }
+
+  free(got);
+  return rc;
+}
@@ -0,0 +1,44 @@
+#ifndef RUDP_H
+#define RUDP_H
+
+#include <netinet/in.h>
+#include <stdint.h>
+
+// Надёжная передача файла поверх UDP: номера пакетов, скользящее окно,
+// выборочные подтверждения (SACK), таймер повторной передачи по RTT
+// и AIMD-управление окном перегрузки.
+//
+// Потери можно проверить локально встроенным симулятором (loss/reorder)
+// или через netem на loopback:
+//   sudo tc qdisc add dev lo root netem loss 2% reorder 5% delay 1ms
+
+#define RUDP_PAYLOAD 1400
+#define RUDP_MAX_WINDOW 4096  // пакетов, степень двойки
+
+struct RudpOptions {
+  double loss;     // вероятность потерять исходящий пакет
+  double reorder;  // вероятность придержать пакет и отправить после следующего
+  int window;      // верхняя граница окна в пакетах
+};
+
+struct RudpStats {
+  uint64_t bytes;
+  uint64_t packets_sent;
+  uint64_t retransmits;
+  uint64_t dropped;  // отброшено симулятором
+  double seconds;
+};
+
+void RudpDefaultOptions(struct RudpOptions *opts);
+
+// Отправляет содержимое file_fd на peer. 0 - успех, -1 - ошибка/таймаут.
+int RudpSendFile(int sockfd, const struct sockaddr_in *peer, int file_fd,
+                 const struct RudpOptions *opts, struct RudpStats *stats);
+
+// Принимает один файл от первого обратившегося отправителя в file_fd.
+int RudpRecvFile(int sockfd, int file_fd, const struct RudpOptions *opts,
+                 struct RudpStats *stats);
+
+void RudpPrintStats(const char *role, const struct RudpStats *stats);
+
+#endif
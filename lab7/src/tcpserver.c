@@ -1,4 +1,5 @@
 #include <netinet/in.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,18 +8,37 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "event_loop.h"
+
 #define SERV_PORT 10050
 #define BUFSIZE 100
 #define SADDR struct sockaddr
 
-int main() {
+// Всё принятое от клиентов печатается в stdout, как и раньше.
+static size_t EchoToStdout(struct LoopConn *conn, const char *data, size_t len,
+                           void *user) {
+  (void)conn;
+  (void)user;
+  write(1, data, len);
+  return len;
+}
+
+static void OnSignal(int sig) {
+  (void)sig;
+  LoopStop();
+}
+
+int main(int argc, char *argv[]) {
   const size_t kSize = sizeof(struct sockaddr_in);
 
-  int lfd, cfd;
-  int nread;
-  char buf[BUFSIZE];
+  int lfd;
   struct sockaddr_in servaddr;
-  struct sockaddr_in cliaddr;
+  enum LoopBackend backend = LOOP_BACKEND_EPOLL;
+
+  if (argc > 1 && ParseLoopBackend(argv[1], &backend) != 0) {
+    printf("usage: %s [epoll|uring]\n", argv[0]);
+    exit(1);
+  }
 
   if ((lfd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
     perror("socket");
@@ -35,28 +55,19 @@ int main() {
     exit(1);
   }
 
-  if (listen(lfd, 5) < 0) {
+  if (listen(lfd, SOMAXCONN) < 0) {
     perror("listen");
     exit(1);
   }
 
-  while (1) {
-    unsigned int clilen = kSize;
-
-    if ((cfd = accept(lfd, (SADDR *)&cliaddr, &clilen)) < 0) {
-      perror("accept");
-      exit(1);
-    }
-    printf("connection established\n");
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = OnSignal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
 
-    while ((nread = read(cfd, buf, BUFSIZE)) > 0) {
-      write(1, &buf, nread);
-    }
-
-    if (nread == -1) {
-      perror("read");
-      exit(1);
-    }
-    close(cfd);
-  }
+  int rc = RunStreamServer(lfd, backend, EchoToStdout, NULL);
+  LoopPrintStats(LoopBackendName(backend));
+  close(lfd);
+  exit(rc < 0 ? 1 : 0);
 }
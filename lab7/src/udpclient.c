@@ -3,12 +3,16 @@
 #include <stdlib.h>
 
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <getopt.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "rudp.h"
+
 #define SERV_PORT 20001
 #define BUFSIZE 1024
 #define SADDR struct sockaddr
@@ -18,10 +22,38 @@ int main(int argc, char **argv) {
   int sockfd, n;
   char sendline[BUFSIZE], recvline[BUFSIZE + 1];
   struct sockaddr_in servaddr;
-  struct sockaddr_in cliaddr;
+  const char *send_path = NULL;
+  struct RudpOptions opts;
+  RudpDefaultOptions(&opts);
+
+  static struct option options[] = {{"send", required_argument, 0, 's'},
+                                    {"loss", required_argument, 0, 'l'},
+                                    {"reorder", required_argument, 0, 'r'},
+                                    {"window", required_argument, 0, 'w'},
+                                    {0, 0, 0, 0}};
+  int c;
+  while ((c = getopt_long(argc, argv, "", options, NULL)) != -1) {
+    switch (c) {
+    case 's':
+      send_path = optarg;
+      break;
+    case 'l':
+      opts.loss = atof(optarg);
+      break;
+    case 'r':
+      opts.reorder = atof(optarg);
+      break;
+    case 'w':
+      opts.window = atoi(optarg);
+      break;
+    default:
+      exit(1);
+    }
+  }
 
-  if (argc != 2) {
-    printf("usage: client <IPaddress of server>\n");
+  if (optind != argc - 1) {
+    printf("usage: client <IPaddress of server> [--send file [--loss p] "
+           "[--reorder p] [--window packets]]\n");
     exit(1);
   }
 
@@ -29,7 +61,7 @@ int main(int argc, char **argv) {
   servaddr.sin_family = AF_INET;
   servaddr.sin_port = htons(SERV_PORT);
 
-  if (inet_pton(AF_INET, argv[1], &servaddr.sin_addr) < 0) {
+  if (inet_pton(AF_INET, argv[optind], &servaddr.sin_addr) <= 0) {
     perror("inet_pton problem");
     exit(1);
   }
@@ -38,6 +70,21 @@ int main(int argc, char **argv) {
     exit(1);
   }
 
+  // Режим передачи файла: надёжный протокол с окном вместо эха строк.
+  if (send_path != NULL) {
+    int file_fd = open(send_path, O_RDONLY);
+    if (file_fd < 0) {
+      perror("open");
+      exit(1);
+    }
+    struct RudpStats stats;
+    int rc = RudpSendFile(sockfd, &servaddr, file_fd, &opts, &stats);
+    RudpPrintStats("sent", &stats);
+    close(file_fd);
+    close(sockfd);
+    exit(rc < 0 ? 1 : 0);
+  }
+
   write(1, "Enter string\n", 13);
 
   while ((n = read(0, sendline, BUFSIZE)) > 0) {
@@ -1,5 +1,7 @@
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,16 +10,59 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "async_log.h"
+#include "event_loop.h"
+#include "rudp.h"
+
 #define SERV_PORT 20001
 #define BUFSIZE 1024
 #define SADDR struct sockaddr
 #define SLEN sizeof(struct sockaddr_in)
 
-int main() {
-  int sockfd, n;
-  char mesg[BUFSIZE], ipadr[16];
+// Печатает запрос и отправляет его обратно клиенту. Печать идёт через
+// асинхронный лог: датаграмма не ждёт stdout, текст копируется как есть,
+// без '\0' в конце.
+static size_t Echo(const char *mesg, size_t n, const struct sockaddr_in *cliaddr,
+                   char *reply, size_t reply_cap, void *user) {
+  char ipadr[16];
+  (void)user;
+  if (n > reply_cap)
+    n = reply_cap;
+
+  LOG_INFO("REQUEST %s      FROM %s : %d\n", LOG_STR(mesg, n),
+           inet_ntop(AF_INET, (void *)&cliaddr->sin_addr.s_addr, ipadr, 16),
+           ntohs(cliaddr->sin_port));
+
+  memcpy(reply, mesg, n);
+  return n;
+}
+
+static void OnSignal(int sig) {
+  (void)sig;
+  LoopStop();
+}
+
+int main(int argc, char **argv) {
+  int sockfd;
   struct sockaddr_in servaddr;
-  struct sockaddr_in cliaddr;
+  enum LoopBackend backend = LOOP_BACKEND_EPOLL;
+  const char *recv_path = NULL;
+  struct RudpOptions opts;
+  RudpDefaultOptions(&opts);
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--recv") == 0 && i + 1 < argc) {
+      recv_path = argv[++i];
+    } else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+      opts.loss = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--reorder") == 0 && i + 1 < argc) {
+      opts.reorder = atof(argv[++i]);
+    } else if (ParseLoopBackend(argv[i], &backend) != 0) {
+      printf("usage: %s [epoll|uring] | --recv file [--loss p] [--reorder p]\n",
+             argv[0]);
+      exit(1);
+    }
+  }
 
   if ((sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
     perror("socket problem");
@@ -35,22 +80,35 @@ int main() {
   }
   printf("SERVER starts...\n");
 
-  while (1) {
-    unsigned int len = SLEN;
-
-    if ((n = recvfrom(sockfd, mesg, BUFSIZE, 0, (SADDR *)&cliaddr, &len)) < 0) {
-      perror("recvfrom");
+  // Приём одного файла по надёжному протоколу, затем выход.
+  if (recv_path != NULL) {
+    int file_fd = open(recv_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file_fd < 0) {
+      perror("open");
       exit(1);
     }
-    mesg[n] = 0;
+    struct RudpStats stats;
+    int rc = RudpRecvFile(sockfd, file_fd, &opts, &stats);
+    RudpPrintStats("received", &stats);
+    close(file_fd);
+    close(sockfd);
+    exit(rc < 0 ? 1 : 0);
+  }
 
-    printf("REQUEST %s      FROM %s : %d\n", mesg,
-           inet_ntop(AF_INET, (void *)&cliaddr.sin_addr.s_addr, ipadr, 16),
-           ntohs(cliaddr.sin_port));
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = OnSignal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
 
-    if (sendto(sockfd, mesg, n, 0, (SADDR *)&cliaddr, len) < 0) {
-      perror("sendto");
-      exit(1);
-    }
-  }
+  struct AsyncLogOptions log_opts;
+  AsyncLogDefaultOptions(&log_opts);
+  if (AsyncLogStart(&log_opts) != 0)
+    fprintf(stderr, "async log unavailable, printing synchronously\n");
+
+  int rc = RunDatagramServer(sockfd, backend, Echo, NULL);
+  AsyncLogStop();
+  LoopPrintStats(LoopBackendName(backend));
+  close(sockfd);
+  exit(rc < 0 ? 1 : 0);
 }
@@ -0,0 +1,521 @@
+#define _GNU_SOURCE
+#include <CUnit/Basic.h>
+#include <arpa/inet.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "event_loop.h"
+#include "sum_lib.h"
+
+/*
+ * Нагрузочные и дифференциальные тесты параллельных программ lab3-lab5
+ * и цикла событий серверов lab6/lab7 (common/event_loop).
+ * Программы запускаются как есть (из <STRESS_ROOT>/labN/src, по умолчанию
+ * STRESS_ROOT=..), их ответ сравнивается с последовательным эталоном,
+ * посчитанным здесь же. Размеры массивов и число потоков случайные,
+ * плюс крайние случаи: размер 1, потоков больше, чем элементов,
+ * INT_MIN/INT_MAX во входе.
+ *
+ * Переменные окружения:
+ *   STRESS_SEED     - зерно случайных параметров (печатается при старте);
+ *   STRESS_ITERS    - запусков на тест, по умолчанию 24;
+ *   STRESS_SCALING  - 0 отключает замер ускорения (так делает make tsan);
+ *   STRESS_BUDGET   - секунд на замер ускорения, по умолчанию 10;
+ *   STRESS_SPEEDUP  - минимальная доля идеального ускорения, по умолчанию 0.5.
+ */
+
+#define MAX_THREADS 256
+#define LAB3_MAX_PROCESSES 100 /* MAX_PROCESSES в lab3/src/parallel_min_max.c */
+
+static const char *root = "..";
+static unsigned int seed = 1;
+static int iterations = 24;
+
+/* эталон GenerateArray из lab3/lab4: srand + rand той же libc */
+static void Generate(int *array, size_t size, unsigned int array_seed) {
+  srand(array_seed);
+  for (size_t i = 0; i < size; i++) array[i] = rand();
+}
+
+static long long ReferenceSum(const int *array, size_t begin, size_t end) {
+  long long sum = 0;
+  for (size_t i = begin; i < end; i++) sum += array[i];
+  return sum;
+}
+
+static void ReferenceMinMax(const int *array, size_t size, int *min, int *max) {
+  *min = INT_MAX;
+  *max = INT_MIN;
+  for (size_t i = 0; i < size; i++) {
+    if (array[i] < *min) *min = array[i];
+    if (array[i] > *max) *max = array[i];
+  }
+}
+
+static unsigned long long ReferenceFactorialMod(unsigned long long k,
+                                                unsigned long long mod) {
+  unsigned __int128 result = 1 % mod;
+  for (unsigned long long i = 2; i <= k && result != 0; i++)
+    result = result * (i % mod) % mod;
+  return (unsigned long long)result;
+}
+
+/* размер: четверть запусков - крайние случаи, остальное - до max_size */
+static size_t RandomSize(size_t max_size, int iter) {
+  switch (iter % 8) {
+    case 0: return 1;
+    case 1: return 1 + (size_t)rand_r(&seed) % 7; /* почти наверняка < потоков */
+    default: return 1 + (size_t)rand_r(&seed) % max_size;
+  }
+}
+
+/* потоки: 1, MAX_THREADS и случайные между ними */
+static int RandomThreads(int max_threads, int iter) {
+  if (iter % 5 == 0) return 1;
+  if (iter % 5 == 1) return max_threads;
+  return 1 + rand_r(&seed) % max_threads;
+}
+
+/*
+ * Запускает команду в каталоге <root>/<dir>, вывод (stdout и stderr) -
+ * в out. Возвращает код завершения, -1 - программа не завершилась сама
+ * (сигнал, в том числе от санитайзера).
+ */
+static int Run(char *out, size_t out_size, const char *dir, const char *fmt,
+               ...) {
+  char args[512];
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(args, sizeof(args), fmt, ap);
+  va_end(ap);
+  char command[1024];
+  snprintf(command, sizeof(command), "cd '%s/%s' && %s 2>&1", root, dir, args);
+
+  FILE *pipe = popen(command, "r");
+  if (pipe == NULL) return -1;
+  size_t len = fread(out, 1, out_size - 1, pipe);
+  out[len] = '\0';
+  /* дочитываем хвост, чтобы программа не встала на записи в pipe */
+  char rest[4096];
+  while (fread(rest, 1, sizeof(rest), pipe) > 0) {
+  }
+  int status = pclose(pipe);
+  if (status == -1 || !WIFEXITED(status)) return -1;
+  if (WEXITSTATUS(status) != 0) fprintf(stderr, "\n  %s:\n%s", command, out);
+  return WEXITSTATUS(status);
+}
+
+/* число после метки в выводе программы; 0 - метки нет */
+static int FindLongLong(const char *out, const char *label, long long *value) {
+  const char *at = strstr(out, label);
+  return at != NULL && sscanf(at + strlen(label), "%lld", value) == 1;
+}
+
+static int FindInt(const char *out, const char *label, int *value) {
+  long long v = 0;
+  if (!FindLongLong(out, label, &v)) return 0;
+  *value = (int)v;
+  return 1;
+}
+
+static double Seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int EnvInt(const char *name, int fallback) {
+  const char *value = getenv(name);
+  return value != NULL && *value != '\0' ? atoi(value) : fallback;
+}
+
+static double EnvDouble(const char *name, double fallback) {
+  const char *value = getenv(name);
+  return value != NULL && *value != '\0' ? atof(value) : fallback;
+}
+
+/* SumRange против простого цикла на произвольных границах и крайних значениях */
+void testSumRange(void) {
+  enum { kSize = 4099 };
+  int *array = malloc(kSize * sizeof(int));
+  CU_ASSERT_PTR_NOT_NULL_FATAL(array);
+  for (int i = 0; i < kSize; i++) {
+    int r = rand_r(&seed);
+    array[i] = r % 3 == 0 ? INT_MIN : r % 3 == 1 ? INT_MAX : r - RAND_MAX / 2;
+  }
+  for (int iter = 0; iter < 20000; iter++) {
+    size_t begin = (size_t)rand_r(&seed) % kSize;
+    size_t end = begin + (size_t)rand_r(&seed) % (kSize - begin + 1);
+    CU_ASSERT_EQUAL_FATAL(SumRange(array, begin, end),
+                          ReferenceSum(array, begin, end));
+  }
+  free(array);
+}
+
+void testParallelSum(void) {
+  char out[8192];
+  for (int iter = 0; iter < iterations; iter++) {
+    size_t size = RandomSize(300000, iter);
+    int threads = RandomThreads(MAX_THREADS, iter);
+    unsigned int array_seed = 1 + (unsigned int)rand_r(&seed) % 100000;
+    int *array = malloc(size * sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(array);
+    Generate(array, size, array_seed);
+    long long expected = ReferenceSum(array, 0, size);
+    free(array);
+
+    /* каждый третий запуск - мелкие куски вперемешку (--chunk),
+     * ещё каждый третий - генерация и сумма графом задач (--pipeline) */
+    char chunk[64] = "";
+    if (iter % 3 == 2)
+      snprintf(chunk, sizeof(chunk), " --chunk %d --layout %s",
+               1 + rand_r(&seed) % 512, iter % 2 ? "packed" : "padded");
+    else if (iter % 3 == 1)
+      snprintf(chunk, sizeof(chunk), " --pipeline");
+
+    int rc = Run(out, sizeof(out), "lab4/src",
+                 "./parallel_sum --threads_num %d --seed %u --array_size %zu%s",
+                 threads, array_seed, size, chunk);
+    long long total = 0;
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_FATAL(FindLongLong(out, "Total: ", &total));
+    if (total != expected)
+      fprintf(stderr, "\n  size %zu threads %d seed %u%s: %lld != %lld\n",
+              size, threads, array_seed, chunk, total, expected);
+    CU_ASSERT_EQUAL_FATAL(total, expected);
+  }
+}
+
+/* lab4: режим pipe (генерация внутри программы) */
+void testParallelMinMaxThreads(void) {
+  char out[8192];
+  for (int iter = 0; iter < iterations; iter++) {
+    size_t size = RandomSize(300000, iter);
+    int threads = RandomThreads(MAX_THREADS, iter);
+    unsigned int array_seed = 1 + (unsigned int)rand_r(&seed) % 100000;
+    int *array = malloc(size * sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(array);
+    Generate(array, size, array_seed);
+    int min = 0, max = 0;
+    ReferenceMinMax(array, size, &min, &max);
+    free(array);
+
+    int rc = Run(out, sizeof(out), "lab4/src", "./parallel_min_max pipe %u %zu %d",
+                 array_seed, size, threads);
+    int got_min = 0, got_max = 0;
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_FATAL(FindInt(out, "Глобальный минимум: ", &got_min));
+    CU_ASSERT_FATAL(FindInt(out, "Глобальный максимум: ", &got_max));
+    if (got_min != min || got_max != max)
+      fprintf(stderr, "\n  size %zu threads %d seed %u: %d/%d != %d/%d\n", size,
+              threads, array_seed, got_min, got_max, min, max);
+    CU_ASSERT_EQUAL_FATAL(got_min, min);
+    CU_ASSERT_EQUAL_FATAL(got_max, max);
+  }
+}
+
+/* lab4: режим files с INT_MIN/INT_MAX в случайных местах входа */
+void testParallelMinMaxExtremes(void) {
+  char out[8192];
+  char input[64], output[64];
+  snprintf(input, sizeof(input), "/tmp/stress_in_%d.bin", (int)getpid());
+  snprintf(output, sizeof(output), "/tmp/stress_out_%d.txt", (int)getpid());
+  for (int iter = 0; iter < iterations; iter++) {
+    size_t size = RandomSize(100000, iter);
+    int threads = RandomThreads(MAX_THREADS, iter);
+    int *array = malloc(size * sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(array);
+    for (size_t i = 0; i < size; i++) array[i] = rand_r(&seed) - RAND_MAX / 2;
+    if (iter % 3 != 0) array[(size_t)rand_r(&seed) % size] = INT_MIN;
+    if (iter % 3 != 1) array[(size_t)rand_r(&seed) % size] = INT_MAX;
+    int min = 0, max = 0;
+    ReferenceMinMax(array, size, &min, &max);
+
+    FILE *f = fopen(input, "wb");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+    CU_ASSERT_EQUAL_FATAL(fwrite(array, sizeof(int), size, f), size);
+    fclose(f);
+    free(array);
+
+    int rc = Run(out, sizeof(out), "lab4/src", "./parallel_min_max files %s %s %d",
+                 input, output, threads);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    int got_min = 0, got_max = 0;
+    f = fopen(output, "r");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+    int parsed = fscanf(f, "Min: %d\nMax: %d", &got_min, &got_max);
+    fclose(f);
+    CU_ASSERT_EQUAL_FATAL(parsed, 2);
+    if (got_min != min || got_max != max)
+      fprintf(stderr, "\n  size %zu threads %d: %d/%d != %d/%d\n", size,
+              threads, got_min, got_max, min, max);
+    CU_ASSERT_EQUAL_FATAL(got_min, min);
+    CU_ASSERT_EQUAL_FATAL(got_max, max);
+  }
+  unlink(input);
+  unlink(output);
+}
+
+/* lab3: процессы через pipe, файлы и разделяемую память против sequential_min_max */
+void testParallelMinMaxProcesses(void) {
+  static const char *kModes[] = {"pipe", "files", "shm"};
+  char out[8192];
+  for (int iter = 0; iter < iterations; iter++) {
+    size_t size = RandomSize(200000, iter);
+    int processes = RandomThreads(LAB3_MAX_PROCESSES, iter);
+    unsigned int array_seed = 1 + (unsigned int)rand_r(&seed) % 100000;
+    const char *mode = kModes[iter % 3];
+    int *array = malloc(size * sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(array);
+    Generate(array, size, array_seed);
+    int min = 0, max = 0;
+    ReferenceMinMax(array, size, &min, &max);
+    free(array);
+
+    int seq_min = 0, seq_max = 0;
+    CU_ASSERT_EQUAL_FATAL(Run(out, sizeof(out), "lab3/src",
+                              "./sequential_min_max %u %zu", array_seed, size),
+                          0);
+    CU_ASSERT_FATAL(FindInt(out, "min: ", &seq_min));
+    CU_ASSERT_FATAL(FindInt(out, "max: ", &seq_max));
+    CU_ASSERT_EQUAL_FATAL(seq_min, min);
+    CU_ASSERT_EQUAL_FATAL(seq_max, max);
+
+    int rc = Run(out, sizeof(out), "lab3/src", "./parallel_min_max %zu %u %d %s",
+                 size, array_seed, processes, mode);
+    int got_min = 0, got_max = 0;
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_FATAL(FindInt(out, "Min: ", &got_min));
+    CU_ASSERT_FATAL(FindInt(out, "Max: ", &got_max));
+    if (got_min != min || got_max != max)
+      fprintf(stderr, "\n  %s size %zu processes %d seed %u: %d/%d != %d/%d\n",
+              mode, size, processes, array_seed, got_min, got_max, min, max);
+    CU_ASSERT_EQUAL_FATAL(got_min, min);
+    CU_ASSERT_EQUAL_FATAL(got_max, max);
+  }
+}
+
+/* factorial_mod: малые и большие (до 2^64) модули, k меньше числа потоков */
+void testFactorialMod(void) {
+  static const unsigned long long kModuli[] = {
+      2, 97, 1000000007ull, 4294967311ull, 1ull << 62,
+      18446744073709551557ull /* наибольшее простое < 2^64 */};
+  char out[8192];
+  for (int iter = 0; iter < iterations; iter++) {
+    unsigned long long mod = kModuli[iter % 6];
+    if (iter % 4 == 3)
+      mod = 2 + (((unsigned long long)rand_r(&seed) << 31) ^
+                 (unsigned long long)rand_r(&seed));
+    unsigned long long k =
+        iter % 7 == 0 ? 1 : 1 + (unsigned long long)rand_r(&seed) % 50000;
+    int threads = RandomThreads(MAX_THREADS, iter);
+    unsigned long long expected = ReferenceFactorialMod(k, mod);
+
+    int rc = Run(out, sizeof(out), "lab5/src",
+                 "./factorial_mod -k %llu --pnum=%d --mod=%llu", k, threads, mod);
+    unsigned long long got = 0;
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_FATAL(sscanf(out, "%llu", &got) == 1);
+    if (got != expected)
+      fprintf(stderr, "\n  k %llu threads %d mod %llu: %llu != %llu\n", k,
+              threads, mod, got, expected);
+    CU_ASSERT_EQUAL_FATAL(got, expected);
+  }
+}
+
+/* лучшее из трёх "Elapsed time" parallel_sum; < 0 - ошибка */
+static double SumSeconds(int threads, size_t size) {
+  char out[8192];
+  double best = -1;
+  for (int run = 0; run < 3; run++) {
+    if (Run(out, sizeof(out), "lab4/src",
+            "./parallel_sum --threads_num %d --seed 1 --array_size %zu", threads,
+            size) != 0)
+      return -1;
+    const char *at = strstr(out, "Elapsed time: ");
+    double elapsed = 0;
+    if (at == NULL || sscanf(at + 14, "%lf", &elapsed) != 1) return -1;
+    if (best < 0 || elapsed < best) best = elapsed;
+  }
+  return best;
+}
+
+/*
+ * Ускорение parallel_sum на всех ядрах (до 8) против одного потока.
+ * Массив растёт, пока однопоточный проход не займёт хотя бы 20 мс, если
+ * это укладывается в STRESS_BUDGET; падает, если ускорение ниже
+ * STRESS_SPEEDUP * число потоков.
+ */
+void testScaling(void) {
+  if (!EnvInt("STRESS_SCALING", 1)) {
+    printf("skipped (STRESS_SCALING=0) ");
+    return;
+  }
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int threads = cpus > 8 ? 8 : (int)cpus;
+  if (threads < 2) {
+    printf("skipped (%ld cpu) ", cpus);
+    return;
+  }
+  double budget = EnvDouble("STRESS_BUDGET", 10);
+  double fraction = EnvDouble("STRESS_SPEEDUP", 0.5);
+  double deadline = Seconds() + budget;
+
+  size_t size = 1u << 20;
+  double one = SumSeconds(1, size);
+  CU_ASSERT_FATAL(one >= 0);
+  /* следующий шаг - три прогона вчетверо большего массива */
+  while (one < 0.02 && size < (64u << 20) && Seconds() + 12 * one < deadline) {
+    size *= 4;
+    one = SumSeconds(1, size);
+    CU_ASSERT_FATAL(one >= 0);
+  }
+  double many = SumSeconds(threads, size);
+  CU_ASSERT_FATAL(many > 0);
+  double speedup = one / many;
+  printf("%zu elements: %d threads x%.2f (need x%.2f) ", size, threads, speedup,
+         fraction * threads);
+  CU_ASSERT(speedup >= fraction * threads);
+}
+
+#define LOOP_REQUESTS 48
+#define LOOP_REPLY_SIZE (256 << 10)
+
+/* на каждый байт запроса - ответ LOOP_REPLY_SIZE байт этим же значением */
+static size_t BigReplyHandler(struct LoopConn *conn, const char *data,
+                              size_t len, void *user) {
+  char *reply = user;
+  for (size_t i = 0; i < len; i++) {
+    memset(reply, data[i], LOOP_REPLY_SIZE);
+    LoopSend(conn, reply, LOOP_REPLY_SIZE);
+  }
+  return len;
+}
+
+/*
+ * Сервер в дочернем процессе, клиент шлёт запросы по одному (ответы
+ * ставятся в очередь в разных пачках цикла) и читает медленно:
+ * большие ответы одного соединения не должны переставляться и
+ * перемешиваться. 0 - всё пришло по порядку.
+ */
+static int PipelinedReplies(enum LoopBackend backend) {
+  int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addr_len = sizeof(addr);
+  if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&addr, addr_len) != 0 ||
+      listen(listen_fd, 16) != 0 ||
+      getsockname(listen_fd, (struct sockaddr *)&addr, &addr_len) != 0)
+    return -1;
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    char *reply = malloc(LOOP_REPLY_SIZE);
+    _exit(reply != NULL &&
+                  RunStreamServer(listen_fd, backend, BigReplyHandler, reply) == 0
+              ? 0
+              : 1);
+  }
+  close(listen_fd);
+  if (pid < 0) return -1;
+
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  int rcvbuf = 16 << 10;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+  int bad = connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0;
+  /* по запросу на пачку: пока ответ висит в send, приходит следующий */
+  for (int i = 0; i < LOOP_REQUESTS && !bad; i++) {
+    char request = (char)('A' + i);
+    bad = send(fd, &request, 1, 0) != 1;
+    usleep(1000);
+  }
+
+  char chunk[16 << 10];
+  size_t received = 0;
+  size_t total = (size_t)LOOP_REQUESTS * LOOP_REPLY_SIZE;
+  while (!bad && received < total) {
+    size_t want = total - received < sizeof(chunk) ? total - received
+                                                   : sizeof(chunk);
+    ssize_t n = recv(fd, chunk, want, 0);
+    if (n <= 0) {
+      fprintf(stderr, "\n  %s: connection closed after %zu bytes\n",
+              LoopBackendName(backend), received);
+      bad = 1;
+      break;
+    }
+    for (ssize_t k = 0; k < n && !bad; k++, received++) {
+      char expected = (char)('A' + received / LOOP_REPLY_SIZE);
+      if (chunk[k] != expected) {
+        fprintf(stderr, "\n  %s: byte %zu is '%c', expected '%c'\n",
+                LoopBackendName(backend), received, chunk[k], expected);
+        bad = 1;
+      }
+    }
+    if (received % (1 << 20) < (size_t)n) usleep(2000); /* медленный читатель */
+  }
+  close(fd);
+  kill(pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+  return bad ? -1 : 0;
+}
+
+void testLoopPipelinedReplies(void) {
+  CU_ASSERT(PipelinedReplies(LOOP_BACKEND_EPOLL) == 0);
+  CU_ASSERT(PipelinedReplies(LOOP_BACKEND_URING) == 0);
+}
+
+int main() {
+  CU_pSuite pSuite = NULL;
+
+  const char *env_root = getenv("STRESS_ROOT");
+  if (env_root != NULL && *env_root != '\0') root = env_root;
+  seed = (unsigned int)EnvInt("STRESS_SEED", (int)time(NULL) & 0xffff);
+  iterations = EnvInt("STRESS_ITERS", iterations);
+  printf("STRESS_ROOT=%s STRESS_SEED=%u STRESS_ITERS=%d\n", root, seed,
+         iterations);
+
+  if (CUE_SUCCESS != CU_initialize_registry()) return CU_get_error();
+
+  pSuite = CU_add_suite("Stress", NULL, NULL);
+  if (NULL == pSuite) {
+    CU_cleanup_registry();
+    return CU_get_error();
+  }
+
+  if ((NULL == CU_add_test(pSuite, "SumRange against reference", testSumRange)) ||
+      (NULL == CU_add_test(pSuite, "parallel_sum against reference",
+                           testParallelSum)) ||
+      (NULL == CU_add_test(pSuite, "lab4 parallel_min_max, 1..256 threads",
+                           testParallelMinMaxThreads)) ||
+      (NULL == CU_add_test(pSuite, "lab4 parallel_min_max, INT_MIN/INT_MAX input",
+                           testParallelMinMaxExtremes)) ||
+      (NULL == CU_add_test(pSuite, "lab3 parallel_min_max against sequential",
+                           testParallelMinMaxProcesses)) ||
+      (NULL == CU_add_test(pSuite, "factorial_mod, large moduli",
+                           testFactorialMod)) ||
+      (NULL == CU_add_test(pSuite, "parallel_sum speedup", testScaling)) ||
+      (NULL == CU_add_test(pSuite, "event loop, pipelined large replies",
+                           testLoopPipelinedReplies))) {
+    CU_cleanup_registry();
+    return CU_get_error();
+  }
+
+  CU_basic_set_mode(CU_BRM_VERBOSE);
+  CU_basic_run_tests();
+  /* для make check: ненулевой код, если хоть одна проверка упала */
+  int failures = (int)CU_get_number_of_failures();
+  CU_cleanup_registry();
+  return failures != 0 ? 1 : CU_get_error();
+}